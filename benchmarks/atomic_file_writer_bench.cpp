@@ -0,0 +1,102 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Atomic_file_writer.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+	// state.range(0) small state files updated in one cycle
+	// set EMB_LIN_UTIL_BENCH_DIR to a directory on the filesystem of interest, /tmp is often tmpfs where syncs are free
+	class State_files_fixture : public benchmark::Fixture
+	{
+	public:
+		void SetUp(const benchmark::State&) override
+		{
+			m_tmp.create("emb-lin-util-atomic-bench", File_util::getenv_or_str("EMB_LIN_UTIL_BENCH_DIR", "/tmp"));
+			m_dir = m_tmp.get_path();
+
+			m_data.assign(512, 'x');
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		std::string get_path(const int64_t i) const
+		{
+			return m_dir + "/state" + std::to_string(i);
+		}
+
+		Temp_dir m_tmp;
+		std::string m_dir;
+		std::string m_data;
+	};
+}
+
+// not durable, the baseline cost of the data itself
+BENCHMARK_DEFINE_F(State_files_fixture, File_util_writeSmallFile)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		for(int64_t i = 0; i < state.range(0); i++)
+		{
+			File_util::writeSmallFile(get_path(i), m_data);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(State_files_fixture, File_util_writeSmallFile)->Arg(1)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+// one full sync cycle per file
+BENCHMARK_DEFINE_F(State_files_fixture, Atomic_write_file_each)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		for(int64_t i = 0; i < state.range(0); i++)
+		{
+			Atomic_file_writer::write_file(get_path(i), m_data);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_REGISTER_F(State_files_fixture, Atomic_write_file_each)->Arg(1)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+static void group_commit(benchmark::State& state, const std::string& dir, const std::string& data, const Atomic_file_writer::Sync_mode mode)
+{
+	Atomic_file_writer writer(mode);
+
+	for(auto _ : state)
+	{
+		for(int64_t i = 0; i < state.range(0); i++)
+		{
+			writer.stage(dir + "/state" + std::to_string(i), data);
+		}
+		writer.commit();
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(State_files_fixture, Atomic_group_fdatasync)(benchmark::State& state)
+{
+	group_commit(state, m_dir, m_data, Atomic_file_writer::Sync_mode::FDATASYNC_EACH);
+}
+BENCHMARK_REGISTER_F(State_files_fixture, Atomic_group_fdatasync)->Arg(1)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_DEFINE_F(State_files_fixture, Atomic_group_syncfs)(benchmark::State& state)
+{
+	group_commit(state, m_dir, m_data, Atomic_file_writer::Sync_mode::SYNCFS);
+}
+BENCHMARK_REGISTER_F(State_files_fixture, Atomic_group_syncfs)->Arg(1)->Arg(32)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,80 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Attr_batch.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <benchmark/benchmark.h>
+
+// a sweep of N procfs ints, the same file N times so the set exists on every system
+static constexpr char ATTR_DIR[]  = "/proc/sys/kernel";
+static constexpr char ATTR_NAME[] = "pid_max";
+
+static void File_util_sweep(benchmark::State& state)
+{
+	const std::string path = std::string(ATTR_DIR) + "/" + ATTR_NAME;
+
+	int val = 0;
+	for(auto _ : state)
+	{
+		for(int64_t i = 0; i < state.range(0); i++)
+		{
+			File_util::readSmallFileToInt(path, &val);
+			benchmark::DoNotOptimize(val);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(File_util_sweep)->Arg(50)->Arg(200);
+
+static void Attr_batch_sweep(benchmark::State& state, const bool use_io_uring)
+{
+	Attr_batch batch;
+
+	size_t dir_idx = 0;
+	if( ! batch.add_dir(ATTR_DIR, &dir_idx) )
+	{
+		state.SkipWithError("add_dir failed");
+		return;
+	}
+
+	for(int64_t i = 0; i < state.range(0); i++)
+	{
+		size_t attr_idx = 0;
+		if( ! batch.add_attr(dir_idx, ATTR_NAME, &attr_idx) )
+		{
+			state.SkipWithError("add_attr failed");
+			return;
+		}
+	}
+
+	if( ! batch.init(1024, 64, use_io_uring) )
+	{
+		state.SkipWithError("init failed");
+		return;
+	}
+
+	if(use_io_uring && ( ! batch.is_using_io_uring() ))
+	{
+		state.SkipWithError("io_uring not available");
+		return;
+	}
+
+	for(auto _ : state)
+	{
+		if(batch.get_sample_count() == batch.get_capacity())
+		{
+			batch.clear();
+		}
+		batch.sample();
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(Attr_batch_sweep, pread, false)->Arg(50)->Arg(200);
+BENCHMARK_CAPTURE(Attr_batch_sweep, io_uring, true)->Arg(50)->Arg(200);
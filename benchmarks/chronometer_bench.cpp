@@ -0,0 +1,158 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Chronometer.hpp>
+#include <emb-lin-util/Clock_correlator.hpp>
+#include <emb-lin-util/Fast_clock.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+static void Chronometer_get_time_ns(benchmark::State& state)
+{
+	std::chrono::nanoseconds t;
+	for(auto _ : state)
+	{
+		Chronometer::get_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Chronometer_get_time_ns);
+
+static void Chronometer_get_time_timespec(benchmark::State& state)
+{
+	timespec t;
+	for(auto _ : state)
+	{
+		Chronometer::get_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Chronometer_get_time_timespec);
+
+static void Chronometer_get_mono_time(benchmark::State& state)
+{
+	timespec t;
+	for(auto _ : state)
+	{
+		Chronometer::get_mono_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Chronometer_get_mono_time);
+
+static void Chronometer_get_real_time(benchmark::State& state)
+{
+	timespec t;
+	for(auto _ : state)
+	{
+		Chronometer::get_real_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Chronometer_get_real_time);
+
+static void Chronometer_get_tai_time(benchmark::State& state)
+{
+	timespec t;
+	for(auto _ : state)
+	{
+		Chronometer::get_tai_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Chronometer_get_tai_time);
+
+static void Fast_clock_get_time_ns(benchmark::State& state)
+{
+	Fast_clock clk;
+	if( ! clk.init() )
+	{
+		state.SkipWithError("Fast_clock::init failed");
+		return;
+	}
+	state.SetLabel(clk.is_counter_enabled() ? "counter" : "clock_gettime");
+
+	std::chrono::nanoseconds t;
+	for(auto _ : state)
+	{
+		clk.get_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Fast_clock_get_time_ns);
+
+static void Fast_clock_get_time_timespec(benchmark::State& state)
+{
+	Fast_clock clk;
+	if( ! clk.init() )
+	{
+		state.SkipWithError("Fast_clock::init failed");
+		return;
+	}
+	state.SetLabel(clk.is_counter_enabled() ? "counter" : "clock_gettime");
+
+	timespec t;
+	for(auto _ : state)
+	{
+		clk.get_time(&t);
+		benchmark::DoNotOptimize(t);
+	}
+}
+BENCHMARK(Fast_clock_get_time_timespec);
+
+static void Fast_clock_read_counter(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(Fast_clock::read_counter());
+	}
+}
+BENCHMARK(Fast_clock_read_counter);
+
+static void Clock_correlator_mono_to_tai(benchmark::State& state)
+{
+	Clock_correlator corr;
+	if( ! corr.update() )
+	{
+		state.SkipWithError("Clock_correlator::update failed");
+		return;
+	}
+
+	std::chrono::nanoseconds t_mono(0);
+	std::chrono::nanoseconds t_tai;
+	for(auto _ : state)
+	{
+		corr.mono_to_tai(t_mono, &t_tai);
+		benchmark::DoNotOptimize(t_tai);
+		t_mono++;
+	}
+}
+BENCHMARK(Clock_correlator_mono_to_tai);
+
+static void Clock_correlator_mono_to_tai_batch(benchmark::State& state)
+{
+	Clock_correlator corr;
+	if( ! corr.update() )
+	{
+		state.SkipWithError("Clock_correlator::update failed");
+		return;
+	}
+
+	std::vector<std::chrono::nanoseconds> t_mono(state.range(0), std::chrono::nanoseconds(1));
+	std::vector<std::chrono::nanoseconds> t_tai(t_mono.size());
+	for(auto _ : state)
+	{
+		corr.mono_to_tai(t_mono.data(), t_mono.size(), t_tai.data());
+		benchmark::DoNotOptimize(t_tai.data());
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * t_mono.size());
+}
+BENCHMARK(Clock_correlator_mono_to_tai_batch)->Arg(1024);
@@ -0,0 +1,88 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Chunk_reader.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <zlib.h>
+
+#include <vector>
+
+namespace
+{
+	// 64 MiB recording, crc32 stands in for per chunk processing
+	// set EMB_LIN_UTIL_BENCH_DIR to a directory on the disk of interest, and drop caches between runs to measure the disk rather than the page cache
+	class Recording_fixture : public benchmark::Fixture
+	{
+	public:
+		void SetUp(const benchmark::State&) override
+		{
+			m_tmp.create("emb-lin-util-chunk-bench", File_util::getenv_or_str("EMB_LIN_UTIL_BENCH_DIR", "/tmp"));
+			m_path = m_tmp.get_path("recording");
+
+			std::vector<uint8_t> data(64U * 1024U * 1024U);
+			for(size_t i = 0; i < data.size(); i++)
+			{
+				data[i] = uint8_t(i * 7U);
+			}
+			File_util::writeSmallFile(m_path, data);
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		void run(benchmark::State& state, const Chunk_reader::Prefetch prefetch, const bool direct)
+		{
+			Chunk_reader reader(1024U * 1024U, 2);
+			reader.set_prefetch(prefetch);
+			reader.set_direct(direct);
+
+			for(auto _ : state)
+			{
+				uLong crc = crc32(0L, Z_NULL, 0);
+				reader.read_file(m_path, [&crc](uint8_t const * const ptr, const size_t len)
+				{
+					crc = crc32(crc, ptr, uInt(len));
+					return true;
+				});
+				benchmark::DoNotOptimize(crc);
+			}
+
+			state.SetBytesProcessed(state.iterations() * int64_t(reader.get_bytes_read()));
+		}
+
+		Temp_dir m_tmp;
+		std::string m_path;
+	};
+}
+
+BENCHMARK_F(Recording_fixture, Chunk_reader_none)(benchmark::State& state)
+{
+	run(state, Chunk_reader::Prefetch::NONE, false);
+}
+BENCHMARK_F(Recording_fixture, Chunk_reader_thread)(benchmark::State& state)
+{
+	run(state, Chunk_reader::Prefetch::THREAD, false);
+}
+BENCHMARK_F(Recording_fixture, Chunk_reader_io_uring)(benchmark::State& state)
+{
+	run(state, Chunk_reader::Prefetch::IO_URING, false);
+}
+BENCHMARK_F(Recording_fixture, Chunk_reader_thread_direct)(benchmark::State& state)
+{
+	run(state, Chunk_reader::Prefetch::THREAD, true);
+}
+BENCHMARK_F(Recording_fixture, Chunk_reader_io_uring_direct)(benchmark::State& state)
+{
+	run(state, Chunk_reader::Prefetch::IO_URING, true);
+}
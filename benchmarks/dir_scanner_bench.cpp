@@ -0,0 +1,115 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Dir_scanner.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// recording directory with 20000 files, a quarter of them match the retention filter
+	// set EMB_LIN_UTIL_BENCH_DIR to a directory on the filesystem of interest
+	class Recording_dir_fixture : public benchmark::Fixture
+	{
+	public:
+		static constexpr int NUM_FILES = 20000;
+
+		void SetUp(const benchmark::State&) override
+		{
+			m_tmp.create("emb-lin-util-scan-bench", File_util::getenv_or_str("EMB_LIN_UTIL_BENCH_DIR", "/tmp"));
+			m_dir = m_tmp.get_path();
+
+			for(int i = 0; i < NUM_FILES; i++)
+			{
+				const int fd = open((m_dir + "/" + get_name(i)).c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+				if(fd >= 0)
+				{
+					close(fd);
+				}
+			}
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		static std::string get_name(const int i)
+		{
+			return "rec_" + std::to_string(i) + (((i % 4) == 0) ? ".mkv" : ".idx");
+		}
+
+		Temp_dir m_tmp;
+		std::string m_dir;
+	};
+}
+
+BENCHMARK_F(Recording_dir_fixture, Std_filesystem_filter_size)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		uint64_t total = 0;
+		for(const auto& ent : std::filesystem::directory_iterator(m_dir))
+		{
+			if(ent.is_regular_file() && (ent.path().extension() == ".mkv"))
+			{
+				total += ent.file_size();
+			}
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * NUM_FILES);
+}
+
+BENCHMARK_F(Recording_dir_fixture, Dir_scanner_filter_size)(benchmark::State& state)
+{
+	Dir_scanner scanner;
+	std::vector<Dir_scanner::Entry> entries;
+	for(auto _ : state)
+	{
+		entries.clear();
+		scanner.scan(m_dir, [](const Dir_scanner::Entry_view& ent)
+		{
+			return (ent.type == Dir_scanner::Type::REGULAR) && ent.name.ends_with(".mkv");
+		}, &entries);
+		Dir_scanner::stat_entries(m_dir, &entries, 4);
+
+		uint64_t total = 0;
+		for(const auto& e : entries)
+		{
+			total += e.size;
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * NUM_FILES);
+}
+
+BENCHMARK_F(Recording_dir_fixture, Dir_scanner_count)(benchmark::State& state)
+{
+	Dir_scanner scanner;
+	for(auto _ : state)
+	{
+		size_t n = 0;
+		scanner.for_each(m_dir, [&n](const Dir_scanner::Entry_view& ent)
+		{
+			n += ent.name.ends_with(".mkv") ? 1 : 0;
+			return true;
+		});
+		benchmark::DoNotOptimize(n);
+	}
+	state.SetItemsProcessed(state.iterations() * NUM_FILES);
+}
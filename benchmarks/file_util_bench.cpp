@@ -0,0 +1,79 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace
+{
+	// 64 MiB recording copied with each method, the CPU column is what the copy costs this process
+	// set EMB_LIN_UTIL_BENCH_DIR to a directory on the filesystem of interest
+	class Copy_fixture : public benchmark::Fixture
+	{
+	public:
+		void SetUp(const benchmark::State&) override
+		{
+			m_tmp.create("emb-lin-util-copy-bench", File_util::getenv_or_str("EMB_LIN_UTIL_BENCH_DIR", "/tmp"));
+			m_dir = m_tmp.get_path();
+
+			std::vector<uint8_t> data(64U * 1024U * 1024U);
+			for(size_t i = 0; i < data.size(); i++)
+			{
+				data[i] = uint8_t(i * 13U);
+			}
+			File_util::writeSmallFile(m_dir + "/src", data);
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		void run(benchmark::State& state, const File_util::Copy_method method)
+		{
+			File_util::Copy_options opt;
+			opt.first_method = method;
+			opt.sync         = false;
+
+			for(auto _ : state)
+			{
+				if( ! File_util::copy_file(m_dir + "/src", m_dir + "/dst", opt) )
+				{
+					state.SkipWithError("copy failed");
+					break;
+				}
+			}
+
+			state.SetBytesProcessed(state.iterations() * int64_t(64U * 1024U * 1024U));
+		}
+
+		Temp_dir m_tmp;
+		std::string m_dir;
+	};
+}
+
+BENCHMARK_F(Copy_fixture, Copy_file_clone)(benchmark::State& state)
+{
+	run(state, File_util::Copy_method::CLONE);
+}
+BENCHMARK_F(Copy_fixture, Copy_file_copy_file_range)(benchmark::State& state)
+{
+	run(state, File_util::Copy_method::COPY_FILE_RANGE);
+}
+BENCHMARK_F(Copy_fixture, Copy_file_sendfile)(benchmark::State& state)
+{
+	run(state, File_util::Copy_method::SENDFILE);
+}
+BENCHMARK_F(Copy_fixture, Copy_file_read_write)(benchmark::State& state)
+{
+	run(state, File_util::Copy_method::READ_WRITE);
+}
@@ -0,0 +1,88 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/File_view.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+	// a page cache resident blob, state.range(0) MiB
+	class Blob_fixture : public benchmark::Fixture
+	{
+	public:
+		void SetUp(const benchmark::State& state) override
+		{
+			m_tmp.create("emb-lin-util-file-view-bench");
+			m_path = m_tmp.get_path("blob");
+
+			std::vector<uint8_t> data(size_t(state.range(0)) << 20);
+			std::iota(data.begin(), data.end(), uint8_t(0));
+			File_util::writeSmallFile(m_path, data);
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		Temp_dir m_tmp;
+		std::string m_path;
+	};
+
+	// touch every byte, like a parser would
+	uint64_t sum_bytes(uint8_t const * const ptr, const size_t len)
+	{
+		return std::accumulate(ptr, ptr + len, uint64_t(0));
+	}
+}
+
+BENCHMARK_DEFINE_F(Blob_fixture, File_util_readSmallFile_vector)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		std::vector<uint8_t> data;
+		File_util::readSmallFile(m_path, &data);
+		benchmark::DoNotOptimize(sum_bytes(data.data(), data.size()));
+	}
+
+	state.SetBytesProcessed(state.iterations() * (state.range(0) << 20));
+}
+BENCHMARK_REGISTER_F(Blob_fixture, File_util_readSmallFile_vector)->Arg(1)->Arg(50)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(Blob_fixture, File_util_readSmallFile_stringstream)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		std::stringstream data;
+		File_util::readSmallFile(m_path, &data);
+		const std::string str = data.str();
+		benchmark::DoNotOptimize(sum_bytes(reinterpret_cast<uint8_t const *>(str.data()), str.size()));
+	}
+
+	state.SetBytesProcessed(state.iterations() * (state.range(0) << 20));
+}
+BENCHMARK_REGISTER_F(Blob_fixture, File_util_readSmallFile_stringstream)->Arg(1)->Arg(50)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(Blob_fixture, File_view_open)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		File_view view;
+		view.open(m_path);
+		benchmark::DoNotOptimize(sum_bytes(view.data(), view.size()));
+	}
+
+	state.SetBytesProcessed(state.iterations() * (state.range(0) << 20));
+}
+BENCHMARK_REGISTER_F(Blob_fixture, File_view_open)->Arg(1)->Arg(50)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,76 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Atomic_file_writer.hpp>
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/File_writer.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+	// a control loop persisting one small state file per iteration, time is what the control thread sees
+	// set EMB_LIN_UTIL_BENCH_DIR to a directory on the filesystem of interest, /tmp is often tmpfs where syncs are free
+	class State_file_fixture : public benchmark::Fixture
+	{
+	public:
+		void SetUp(const benchmark::State&) override
+		{
+			m_tmp.create("emb-lin-util-writer-bench", File_util::getenv_or_str("EMB_LIN_UTIL_BENCH_DIR", "/tmp"));
+
+			m_path = m_tmp.get_path("state");
+			m_data.assign(512, 'x');
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		Temp_dir m_tmp;
+		std::string m_path;
+		std::string m_data;
+	};
+}
+
+// blocks on the full sync cycle
+BENCHMARK_F(State_file_fixture, Atomic_write_file)(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		Atomic_file_writer::write_file(m_path, m_data);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+// blocks only on the queue, the writer coalesces whatever piles up during a sync
+BENCHMARK_F(State_file_fixture, File_writer_submit)(benchmark::State& state)
+{
+	File_writer writer(1024, 1024U * 1024U);
+	writer.launch();
+
+	const File_writer::Callback cb = [](const std::string&, const File_writer::Result){};
+
+	for(auto _ : state)
+	{
+		writer.submit(m_path, std::vector<uint8_t>(m_data.begin(), m_data.end()), cb);
+	}
+
+	// outside the timed loop
+	writer.flush().wait();
+	const File_writer::Stats stats = writer.get_stats();
+	writer.interrupt();
+	writer.join();
+
+	state.counters["written"]      = double(stats.written);
+	state.counters["superseded"]   = double(stats.superseded);
+	state.counters["backpressure"] = double(stats.backpressure_waits);
+	state.SetItemsProcessed(state.iterations());
+}
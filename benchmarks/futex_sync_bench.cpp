@@ -0,0 +1,83 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Futex_sync.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <mutex>
+
+// uncontended post + take, no waiters so no syscalls
+static void Futex_semaphore_post_wait(benchmark::State& state)
+{
+	Futex_semaphore sem;
+
+	for(auto _ : state)
+	{
+		sem.post();
+		benchmark::DoNotOptimize(sem.wait());
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Futex_semaphore_post_wait);
+
+// the mutex + condition_variable counter Interval_timer used before
+static void Mutex_cv_post_wait(benchmark::State& state)
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	int count = 0;
+
+	for(auto _ : state)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			count++;
+		}
+		cv.notify_one();
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&count](){ return count > 0; });
+			count--;
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Mutex_cv_post_wait);
+
+// shared semaphore, every thread posts then takes
+static void Futex_semaphore_contended(benchmark::State& state)
+{
+	static Futex_semaphore sem;
+
+	for(auto _ : state)
+	{
+		sem.post();
+		benchmark::DoNotOptimize(sem.wait());
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Futex_semaphore_contended)->ThreadRange(1, 16)->UseRealTime();
+
+// manual event that is already set, the Thread_base::wait_for_interruption fast path
+static void Futex_event_is_set(benchmark::State& state)
+{
+	Futex_event ev(Futex_event::Reset_mode::MANUAL, true);
+
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(ev.wait(std::chrono::nanoseconds::zero()));
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Futex_event_is_set);
@@ -0,0 +1,75 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Metrics.hpp>
+
+#include <benchmark/benchmark.h>
+
+// a shared std::atomic member, the cache line bounces between cores
+static void Atomic_counter_add(benchmark::State& state)
+{
+	static std::atomic<uint64_t> ctr(0);
+
+	for(auto _ : state)
+	{
+		ctr.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Atomic_counter_add)->ThreadRange(1, 16)->UseRealTime();
+
+static void Metric_counter_add(benchmark::State& state)
+{
+	static Metric_counter ctr;
+
+	for(auto _ : state)
+	{
+		ctr.add();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Metric_counter_add)->ThreadRange(1, 16)->UseRealTime();
+
+static void Metric_histogram_record(benchmark::State& state)
+{
+	static Metric_histogram hist;
+
+	uint64_t val = 1000;
+	for(auto _ : state)
+	{
+		hist.record(val);
+		val = (val * 7) & 0xFFFFF;
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Metric_histogram_record)->ThreadRange(1, 16)->UseRealTime();
+
+// registry of 100 counters and 10 histograms
+static void Metrics_registry_render(benchmark::State& state)
+{
+	Metrics_registry reg;
+	for(int i = 0; i < 100; i++)
+	{
+		reg.get_counter("bench_total", "", {{"idx", std::to_string(i)}})->add(i);
+	}
+	for(int i = 0; i < 10; i++)
+	{
+		reg.get_histogram("bench_ns", "", {{"idx", std::to_string(i)}})->record(i * 1000);
+	}
+
+	std::string text;
+	for(auto _ : state)
+	{
+		text.clear();
+		reg.render_prometheus(&text);
+		benchmark::DoNotOptimize(text.data());
+	}
+}
+BENCHMARK(Metrics_registry_render);
@@ -0,0 +1,79 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Mpmc_queue.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// even threads produce, odd threads consume, every thread runs the same number of iterations so the queue ends empty
+// Threads(4) is 2 producers and 2 consumers
+static void Mpmc_queue_push_pop(benchmark::State& state)
+{
+	static Mpmc_queue<uint64_t> queue(1024);
+
+	const bool producer = (state.thread_index() % 2) == 0;
+
+	uint64_t val = 0;
+	for(auto _ : state)
+	{
+		if(producer)
+		{
+			queue.push(val++);
+		}
+		else
+		{
+			queue.pop(&val);
+			benchmark::DoNotOptimize(val);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Mpmc_queue_push_pop)->Threads(4)->Threads(8)->Threads(16)->UseRealTime();
+
+// the same traffic through a bounded mutex guarded deque
+static void Mutex_deque_push_pop(benchmark::State& state)
+{
+	static std::mutex mutex;
+	static std::condition_variable not_empty;
+	static std::condition_variable not_full;
+	static std::deque<uint64_t> queue;
+
+	const bool producer = (state.thread_index() % 2) == 0;
+
+	uint64_t val = 0;
+	for(auto _ : state)
+	{
+		if(producer)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				not_full.wait(lock, [](){ return queue.size() < 1024; });
+				queue.push_back(val++);
+			}
+			not_empty.notify_one();
+		}
+		else
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				not_empty.wait(lock, [](){ return ! queue.empty(); });
+				val = queue.front();
+				queue.pop_front();
+			}
+			not_full.notify_one();
+			benchmark::DoNotOptimize(val);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Mutex_deque_push_pop)->Threads(4)->Threads(8)->Threads(16)->UseRealTime();
@@ -0,0 +1,53 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Rate_limiter.hpp>
+
+#include <benchmark/benchmark.h>
+
+// limiter never runs dry, measures the cost of a contended CAS
+static void Gcra_limiter_try_acquire_open(benchmark::State& state)
+{
+	static Gcra_limiter limiter(std::chrono::nanoseconds(1), 1000000000ULL);
+
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(limiter.try_acquire(1));
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Gcra_limiter_try_acquire_open)->ThreadRange(1, 16)->UseRealTime();
+
+// limiter is mostly dry, measures the cost of a rejection
+static void Gcra_limiter_try_acquire_throttled(benchmark::State& state)
+{
+	static Gcra_limiter limiter(std::chrono::milliseconds(1), 1);
+
+	int64_t acquired = 0;
+	for(auto _ : state)
+	{
+		acquired += limiter.try_acquire(1) ? 1 : 0;
+	}
+
+	state.counters["acquired"] = benchmark::Counter(double(acquired), benchmark::Counter::kIsRate);
+}
+BENCHMARK(Gcra_limiter_try_acquire_throttled)->ThreadRange(1, 16)->UseRealTime();
+
+// blocking acquire at 1M tokens/s shared by all threads
+static void Token_bucket_acquire(benchmark::State& state)
+{
+	static Token_bucket bucket(1.0e6, 64);
+
+	for(auto _ : state)
+	{
+		bucket.acquire(1);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Token_bucket_acquire)->ThreadRange(1, 16)->UseRealTime();
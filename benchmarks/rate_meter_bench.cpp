@@ -0,0 +1,23 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Rate_meter.hpp>
+
+#include <benchmark/benchmark.h>
+
+static void Rate_meter_mark(benchmark::State& state)
+{
+	static Rate_meter meter;
+
+	for(auto _ : state)
+	{
+		meter.mark(1);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Rate_meter_mark)->ThreadRange(1, 8);
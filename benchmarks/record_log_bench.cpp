@@ -0,0 +1,104 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/Record_log.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+	// one telemetry sample per iteration, time is what the sampling thread sees
+	// set EMB_LIN_UTIL_BENCH_DIR to a directory on the filesystem of interest, /tmp is often tmpfs
+	class Telemetry_fixture : public benchmark::Fixture
+	{
+	public:
+		void SetUp(const benchmark::State&) override
+		{
+			m_tmp.create("emb-lin-util-record-log-bench", File_util::getenv_or_str("EMB_LIN_UTIL_BENCH_DIR", "/tmp"));
+			m_dir  = m_tmp.get_path();
+			m_path = m_tmp.get_path("telem.bin");
+			m_sample.assign(64, 0x5A);
+		}
+
+		void TearDown(const benchmark::State&) override
+		{
+			m_tmp.remove();
+		}
+
+		Temp_dir m_tmp;
+		std::string m_dir;
+		std::string m_path;
+		std::vector<uint8_t> m_sample;
+	};
+}
+
+// the old way, rewrite the whole file each sample
+BENCHMARK_F(Telemetry_fixture, WriteSmallFile_rewrite)(benchmark::State& state)
+{
+	std::vector<uint8_t> all;
+	for(auto _ : state)
+	{
+		all.insert(all.end(), m_sample.begin(), m_sample.end());
+		if(all.size() > (64U * 1024U))
+		{
+			all.clear();
+		}
+		File_util::writeSmallFile(m_path, all);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+// producer cost, drops counted rather than blocking
+BENCHMARK_F(Telemetry_fixture, Record_log_append)(benchmark::State& state)
+{
+	Record_log log(65536);
+	log.open(m_dir, "telem");
+	log.launch();
+
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(log.append(m_sample));
+	}
+
+	log.flush();
+	state.counters["dropped"] = double(log.get_dropped_count());
+	state.SetItemsProcessed(state.iterations());
+
+	log.interrupt();
+	log.join();
+	log.close();
+}
+
+// end to end, every 64 samples waits for the writer
+BENCHMARK_F(Telemetry_fixture, Record_log_append_flush64)(benchmark::State& state)
+{
+	Record_log log(65536);
+	log.open(m_dir, "telem");
+	log.launch();
+
+	uint64_t i = 0;
+	for(auto _ : state)
+	{
+		log.append(m_sample);
+		if((++i % 64) == 0)
+		{
+			log.flush();
+		}
+	}
+
+	log.flush();
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * int64_t(m_sample.size() + Record_log::HEADER_SIZE));
+
+	log.interrupt();
+	log.join();
+	log.close();
+}
@@ -0,0 +1,88 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Seqlock.hpp>
+#include <emb-lin-util/Triple_buffer.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <shared_mutex>
+
+struct Pose
+{
+	std::array<double, 7> v;
+};
+
+// read the latest value from any number of threads
+static void Seqlock_load(benchmark::State& state)
+{
+	static Seqlock<Pose> lock(Pose{});
+
+	Pose p;
+	for(auto _ : state)
+	{
+		lock.load(&p);
+		benchmark::DoNotOptimize(p);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Seqlock_load)->ThreadRange(1, 8)->UseRealTime();
+
+// the writer side, never waits on readers
+static void Seqlock_store(benchmark::State& state)
+{
+	static Seqlock<Pose> lock;
+
+	Pose p{};
+	for(auto _ : state)
+	{
+		p.v[0] += 1.0;
+		lock.store(p);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Seqlock_store);
+
+static void Triple_buffer_write_read(benchmark::State& state)
+{
+	Triple_buffer<Pose> buf;
+
+	Pose p{};
+	for(auto _ : state)
+	{
+		p.v[0] += 1.0;
+		buf.write(p);
+		buf.read(&p);
+		benchmark::DoNotOptimize(p);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Triple_buffer_write_read);
+
+// what it replaces
+static void Shared_mutex_load(benchmark::State& state)
+{
+	static std::shared_mutex mutex;
+	static Pose shared{};
+
+	Pose p;
+	for(auto _ : state)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			p = shared;
+		}
+		benchmark::DoNotOptimize(p);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Shared_mutex_load)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,123 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Spsc_ring.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// one producer thread, the benchmark thread consumes, range(0) is the batch size
+static void Spsc_ring_transfer(benchmark::State& state)
+{
+	const size_t batch = size_t(state.range(0));
+
+	Spsc_ring<uint64_t> ring(4096);
+
+	std::atomic<bool> done(false);
+	std::thread producer([&ring, &done, batch]()
+	{
+		std::vector<uint64_t> buf(batch);
+		uint64_t seq = 0;
+		while( ! done.load(std::memory_order_relaxed) )
+		{
+			for(auto& val : buf)
+			{
+				val = seq++;
+			}
+
+			size_t sent = 0;
+			while(sent < batch)
+			{
+				const size_t n = ring.push_n(buf.data() + sent, batch - sent);
+				if(n == 0)
+				{
+					if( ! ring.wait_for_space() )
+					{
+						return;
+					}
+				}
+				sent += n;
+			}
+		}
+	});
+
+	std::vector<uint64_t> buf(batch);
+	int64_t items = 0;
+	for(auto _ : state)
+	{
+		ring.wait_for_data();
+		const size_t n = ring.pop_n(buf.data(), batch);
+		benchmark::DoNotOptimize(buf.data());
+		items += int64_t(n);
+	}
+
+	done = true;
+	ring.notify_cancel();
+	producer.join();
+
+	state.SetItemsProcessed(items);
+}
+BENCHMARK(Spsc_ring_transfer)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+// same handoff through the mutex guarded deque it replaces
+static void Mutex_deque_transfer(benchmark::State& state)
+{
+	const size_t batch = size_t(state.range(0));
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<uint64_t> queue;
+
+	std::atomic<bool> done(false);
+	std::thread producer([&, batch]()
+	{
+		uint64_t seq = 0;
+		while( ! done.load(std::memory_order_relaxed) )
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&](){ return (queue.size() + batch <= 4096) || done.load(); });
+				for(size_t i = 0; i < batch; i++)
+				{
+					queue.push_back(seq++);
+				}
+			}
+			cv.notify_all();
+		}
+	});
+
+	std::vector<uint64_t> buf(batch);
+	int64_t items = 0;
+	for(auto _ : state)
+	{
+		size_t n = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&](){ return ! queue.empty(); });
+			while((n < batch) && ! queue.empty())
+			{
+				buf[n++] = queue.front();
+				queue.pop_front();
+			}
+		}
+		cv.notify_all();
+		benchmark::DoNotOptimize(buf.data());
+		items += int64_t(n);
+	}
+
+	done = true;
+	cv.notify_all();
+	producer.join();
+
+	state.SetItemsProcessed(items);
+}
+BENCHMARK(Mutex_deque_transfer)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
@@ -0,0 +1,57 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/Sysfs_attr.hpp>
+
+#include <benchmark/benchmark.h>
+
+// present on every linux system, a seq_file backed int like most sysfs attributes
+static constexpr char ATTR_PATH[] = "/proc/sys/kernel/pid_max";
+
+// ifstream open, getline, lexical_cast, close per read
+static void File_util_readSmallFileToInt(benchmark::State& state)
+{
+	int val = 0;
+	for(auto _ : state)
+	{
+		if( ! File_util::readSmallFileToInt(ATTR_PATH, &val) )
+		{
+			state.SkipWithError("read failed");
+			break;
+		}
+		benchmark::DoNotOptimize(val);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(File_util_readSmallFileToInt);
+
+// one pread and from_chars per read
+static void Sysfs_attr_read_int(benchmark::State& state)
+{
+	Sysfs_attr attr;
+	if( ! attr.open(ATTR_PATH) )
+	{
+		state.SkipWithError("open failed");
+		return;
+	}
+
+	int val = 0;
+	for(auto _ : state)
+	{
+		if( ! attr.read_int(&val) )
+		{
+			state.SkipWithError("read failed");
+			break;
+		}
+		benchmark::DoNotOptimize(val);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Sysfs_attr_read_int);
@@ -0,0 +1,100 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Timespec_util.hpp>
+
+#include <benchmark/benchmark.h>
+
+static void Timespec_util_add(benchmark::State& state)
+{
+	timespec a{1, 900000000L};
+	timespec b{0, 200000000L};
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(b);
+		benchmark::DoNotOptimize(Timespec_util::add(a, b));
+	}
+}
+BENCHMARK(Timespec_util_add);
+
+static void Timespec_util_add_sat(benchmark::State& state)
+{
+	timespec a{1, 900000000L};
+	timespec b{0, 200000000L};
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(b);
+		benchmark::DoNotOptimize(Timespec_util::add_sat(a, b));
+	}
+}
+BENCHMARK(Timespec_util_add_sat);
+
+static void Timespec_util_from_chrono_ms(benchmark::State& state)
+{
+	std::chrono::milliseconds dt(1500);
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(dt);
+		benchmark::DoNotOptimize(Timespec_util::from_chrono(dt));
+	}
+}
+BENCHMARK(Timespec_util_from_chrono_ms);
+
+static void Timespec_util_from_chrono_double(benchmark::State& state)
+{
+	std::chrono::duration<double> dt(1.5);
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(dt);
+		benchmark::DoNotOptimize(Timespec_util::from_chrono(dt));
+	}
+}
+BENCHMARK(Timespec_util_from_chrono_double);
+
+static void Timespec_util_from_chrono_v(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(Timespec_util::from_chrono_v<std::chrono::milliseconds, 1500>);
+	}
+}
+BENCHMARK(Timespec_util_from_chrono_v);
+
+static void Timespec_util_to_chrono_ns(benchmark::State& state)
+{
+	timespec a{1, 900000000L};
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(Timespec_util::to_chrono<std::chrono::nanoseconds>(a));
+	}
+}
+BENCHMARK(Timespec_util_to_chrono_ns);
+
+static void Timespec_util_to_chrono_ms(benchmark::State& state)
+{
+	timespec a{1, 900000000L};
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(Timespec_util::to_chrono<std::chrono::milliseconds>(a));
+	}
+}
+BENCHMARK(Timespec_util_to_chrono_ms);
+
+static void Timespec_util_to_chrono_sat_ns(benchmark::State& state)
+{
+	timespec a{1, 900000000L};
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(Timespec_util::to_chrono_sat<std::chrono::nanoseconds>(a));
+	}
+}
+BENCHMARK(Timespec_util_to_chrono_sat_ns);
@@ -0,0 +1,112 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Crash safe whole file replacement
+// Data goes to a temp file in the same directory, is synced, and is renamed over the target, then the directory is synced
+// After a power cut a reader sees either the old or the new file, never a mix
+//
+// Group commit - stage any number of files, then commit them behind one sync barrier
+//   FDATASYNC_EACH - one fdatasync per file, one fsync per distinct directory
+//   SYNCFS         - one syncfs per filesystem before the renames and one after, regardless of file count
+//                    also flushes unrelated dirty data on that filesystem, best when this process owns it
+//
+class Atomic_file_writer
+{
+public:
+
+	enum class Sync_mode
+	{
+		FDATASYNC_EACH,
+		SYNCFS
+	};
+
+	explicit Atomic_file_writer(const Sync_mode mode = Sync_mode::FDATASYNC_EACH);
+	~Atomic_file_writer();
+
+	Atomic_file_writer(const Atomic_file_writer&) = delete;
+	Atomic_file_writer& operator=(const Atomic_file_writer&) = delete;
+
+	// NOT MT safe - call before staging
+	// Skips files whose current content already matches, saving a flash erase / program cycle
+	void set_skip_unchanged(const bool skip)
+	{
+		m_skip_unchanged = skip;
+	}
+
+	// MT safe
+	// Writes the temp file, nothing is visible or durable until commit
+	// Staging the same path twice in one cycle is fine, the last one wins and the earlier temp file is discarded
+	bool stage(const std::string& path, uint8_t const * const ptr, const size_t len, const mode_t mode = 0644);
+	bool stage(const std::string& path, const std::string& value, const mode_t mode = 0644)
+	{
+		return stage(path, reinterpret_cast<uint8_t const *>(value.data()), value.size(), mode);
+	}
+
+	// MT safe
+	// Syncs, renames and syncs the directories for everything staged so far
+	// On failure files that were not renamed keep their old content and their temp files are removed
+	bool commit();
+
+	// MT safe
+	// Drops everything staged so far
+	void abort();
+
+	// MT safe
+	size_t get_staged_count() const;
+
+	// one file, one cycle
+	static bool write_file(const std::string& path, uint8_t const * const ptr, const size_t len, const mode_t mode = 0644);
+	static bool write_file(const std::string& path, const std::string& value, const mode_t mode = 0644)
+	{
+		return write_file(path, reinterpret_cast<uint8_t const *>(value.data()), value.size(), mode);
+	}
+
+protected:
+
+	struct Staged
+	{
+		std::string path;
+		std::string tmp_path;
+		// open until commit so FDATASYNC_EACH does not need to reopen
+		int fd;
+	};
+
+	// discards anything staged for path
+	void drop_staged(const std::string& path);
+
+	static bool is_unchanged(const std::string& path, uint8_t const * const ptr, const size_t len);
+	static std::string get_dir(const std::string& path);
+	// fsync each directory, or syncfs once per filesystem
+	static bool sync_dirs(const std::set<std::string>& dirs, const bool use_syncfs);
+	static void discard(const Staged& s);
+
+	const Sync_mode m_mode;
+	bool m_skip_unchanged;
+
+	mutable std::mutex m_mutex;
+	std::vector<Staged> m_staged;
+
+	// serializes commits so renames land in stage order
+	std::mutex m_commit_mutex;
+};
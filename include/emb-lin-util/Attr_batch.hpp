@@ -0,0 +1,129 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Io_uring.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Reads a fixed set of sysfs / procfs attributes in one sweep
+// Attributes are opened once, relative to directory fds with openat
+// A sweep is a tight pread loop, or optionally one read per attribute queued on io_uring and submitted with one syscall
+//
+// Samples land in one preallocated buffer, laid out as arrays:
+//   time   - int64_t[capacity], CLOCK_MONOTONIC ns at the start of each sweep
+//   length - int32_t[capacity * attrs], bytes read or -errno
+//   data   - char[capacity * attrs * slot_size]
+//
+class Attr_batch
+{
+public:
+
+	Attr_batch();
+	~Attr_batch();
+
+	Attr_batch(const Attr_batch&) = delete;
+	Attr_batch& operator=(const Attr_batch&) = delete;
+
+	// NOT MT safe - setup, call before init
+	// Opens a directory that later paths are relative to
+	bool add_dir(const std::string& path, size_t* const out_dir_idx);
+
+	// NOT MT safe - setup, call before init
+	// Opens dir/rel_path, or rel_path if it is absolute
+	bool add_attr(const size_t dir_idx, const std::string& rel_path, size_t* const out_attr_idx);
+	bool add_attr(const std::string& path, size_t* const out_attr_idx);
+
+	// NOT MT safe
+	// Allocates room for capacity sweeps of slot_size bytes per attribute
+	// Values that do not fit in slot_size are recorded as -EOVERFLOW
+	// sysfs and procfs reads cannot complete inline on io_uring, each one is handed to a kernel worker,
+	// so for fast attributes the pread loop wins (see attr_batch_bench). io_uring pays off when attributes
+	// block in slow drivers, eg i2c hwmon sensors, since those reads then overlap
+	bool init(const size_t capacity, const size_t slot_size = 64, const bool use_io_uring = false);
+
+	// NOT MT safe
+	// Reads every attribute once into the next sample
+	// Per attribute errors are recorded in the sample, false if the buffer is full or the sweep could not run
+	bool sample();
+
+	// NOT MT safe
+	// Discards the samples, keeps the attributes and buffer
+	void clear()
+	{
+		m_num_samples = 0;
+	}
+
+	size_t get_attr_count() const
+	{
+		return m_attr_fds.size();
+	}
+	size_t get_sample_count() const
+	{
+		return m_num_samples;
+	}
+	size_t get_capacity() const
+	{
+		return m_capacity;
+	}
+	bool is_using_io_uring() const
+	{
+		return m_ring.is_open();
+	}
+
+	std::chrono::nanoseconds get_time(const size_t sample_idx) const
+	{
+		return std::chrono::nanoseconds(m_times[sample_idx]);
+	}
+
+	// bytes read or -errno
+	int32_t get_length(const size_t sample_idx, const size_t attr_idx) const
+	{
+		return m_lengths[(sample_idx * m_attr_fds.size()) + attr_idx];
+	}
+
+	// value with surrounding whitespace removed, false if the read failed
+	bool get_string(const size_t sample_idx, const size_t attr_idx, std::string_view* const out_value) const;
+
+	bool get_int64(const size_t sample_idx, const size_t attr_idx, int64_t* const out_value) const;
+	bool get_double(const size_t sample_idx, const size_t attr_idx, double* const out_value) const;
+
+protected:
+
+	void sample_pread(const size_t first_attr, char* const data, int32_t* const lengths);
+	bool sample_io_uring(char* const data, int32_t* const lengths);
+
+	void close_all();
+
+	std::vector<int> m_dir_fds;
+	std::vector<int> m_attr_fds;
+
+	Io_uring m_ring;
+
+	size_t m_capacity;
+	size_t m_slot_size;
+	size_t m_num_samples;
+
+	// one allocation, carved into the three arrays
+	std::unique_ptr<uint8_t[]> m_storage;
+	int64_t* m_times;
+	int32_t* m_lengths;
+	char*    m_data;
+};
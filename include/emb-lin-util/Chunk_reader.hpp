@@ -0,0 +1,128 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+//
+// Streams a file of any size through fixed size chunks with constant memory
+// Chunks are delivered in file order, every chunk but the last is exactly get_chunk_size() long
+//
+// Prefetch overlaps the read of the next chunks with the callback on the current one
+//   NONE     - read, then call back, on the calling thread
+//   THREAD   - a helper thread reads up to depth chunks ahead
+//   IO_URING - depth reads in flight on an Io_uring, falls back to THREAD if io_uring is unavailable
+//
+// Buffers are ALIGNMENT aligned and the chunk size is rounded up to a multiple of it, as O_DIRECT requires
+//
+class Chunk_reader
+{
+public:
+
+	// same shape as Zlib_util::Block_callback, return false to stop
+	typedef std::function<bool(uint8_t const * const ptr, const size_t len)> Block_callback;
+
+	enum class Prefetch
+	{
+		NONE,
+		THREAD,
+		IO_URING
+	};
+
+	static constexpr size_t ALIGNMENT = 4096;
+
+	Chunk_reader(const size_t chunk_size = 1024U * 1024U, const size_t depth = 2);
+	~Chunk_reader();
+
+	Chunk_reader(const Chunk_reader&) = delete;
+	Chunk_reader& operator=(const Chunk_reader&) = delete;
+
+	// NOT MT safe
+	void set_prefetch(const Prefetch prefetch)
+	{
+		m_prefetch = prefetch;
+	}
+
+	// NOT MT safe
+	// Bypass the page cache with O_DIRECT, falls back to buffered reads on filesystems that refuse it, eg tmpfs
+	void set_direct(const bool direct)
+	{
+		m_direct = direct;
+	}
+
+	// NOT MT safe
+	// Drop each chunk from the page cache once the callback is done with it,
+	// so one pass over a large recording does not evict everything else
+	void set_drop_behind(const bool drop_behind)
+	{
+		m_drop_behind = drop_behind;
+	}
+
+	size_t get_chunk_size() const
+	{
+		return m_chunk_size;
+	}
+
+	// NOT MT safe
+	// Returns false on a read error or if cb returned false
+	bool read_file(const std::string& path, const Block_callback& cb);
+
+	// bytes passed to the callback by the last read_file
+	uint64_t get_bytes_read() const
+	{
+		return m_bytes_read;
+	}
+
+protected:
+
+	struct Free_deleter
+	{
+		void operator()(uint8_t* const ptr) const
+		{
+			free(ptr);
+		}
+	};
+
+	uint8_t* get_buf(const size_t slot) const
+	{
+		return m_bufs.get() + (slot * m_chunk_size);
+	}
+
+	bool read_sync(const int fd, const Block_callback& cb);
+	bool read_thread(const int fd, const Block_callback& cb);
+	// out_unsupported is set if the ring could not be used and nothing was delivered yet
+	bool read_uring(const int fd, const Block_callback& cb, bool* const out_unsupported);
+
+	// pread until len bytes or EOF
+	bool read_full(const int fd, uint8_t* const buf, const size_t len, const uint64_t offset, size_t* const out_len) const;
+
+	bool deliver(const int fd, const Block_callback& cb, uint8_t const * const buf, const size_t len, const uint64_t offset);
+
+	const size_t m_chunk_size;
+	const size_t m_depth;
+	std::unique_ptr<uint8_t, Free_deleter> m_bufs;
+
+	Prefetch m_prefetch;
+	bool m_direct;
+	bool m_drop_behind;
+
+	// the open file really is O_DIRECT, set by read_file
+	bool m_is_direct_fd;
+
+	uint64_t m_bytes_read;
+};
@@ -0,0 +1,85 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Seqlock.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Keeps cached offsets from CLOCK_MONOTONIC to CLOCK_REALTIME and CLOCK_TAI
+// Converting a monotonic timestamp is then a load and an add instead of a syscall
+// Offsets are refreshed by update(), or periodically by the thread if launched
+//
+class Clock_correlator : public Thread_base
+{
+public:
+
+	struct Offsets
+	{
+		// CLOCK_REALTIME - CLOCK_MONOTONIC, relative to 1970-01-01 00:00:00
+		std::chrono::nanoseconds real;
+		// CLOCK_TAI - CLOCK_MONOTONIC, relative to 1958-01-01 00:00:00, same as Chronometer::get_tai_time
+		std::chrono::nanoseconds tai;
+	};
+
+	Clock_correlator();
+	~Clock_correlator() override;
+
+	// NOT MT safe
+	// Sets how often the thread refreshes offsets, call before launch
+	void set_update_period(const std::chrono::nanoseconds& dt)
+	{
+		m_update_period = dt;
+	}
+
+	// MT safe wrt readers, call from a single thread
+	// Measures the current offsets and publishes them
+	bool update();
+
+	// MT safe, never blocks
+	// false if update has not succeeded yet
+	bool get_offsets(Offsets* const out_offsets) const;
+
+	// MT safe, never blocks
+	bool mono_to_real(const std::chrono::nanoseconds& t_mono, std::chrono::nanoseconds* const out_t_real) const;
+	bool mono_to_tai(const std::chrono::nanoseconds& t_mono,  std::chrono::nanoseconds* const out_t_tai) const;
+
+	bool mono_to_real(const timespec& t_mono, timespec* const out_t_real) const;
+	bool mono_to_tai(const timespec& t_mono,  timespec* const out_t_tai) const;
+
+	// MT safe, never blocks
+	// Convert len timestamps with one offset snapshot, t_mono and out may alias
+	bool mono_to_real(std::chrono::nanoseconds const * const t_mono, const size_t len, std::chrono::nanoseconds* const out_t_real) const;
+	bool mono_to_tai(std::chrono::nanoseconds const * const t_mono,  const size_t len, std::chrono::nanoseconds* const out_t_tai) const;
+
+protected:
+
+	void work() override;
+
+	// measure offset of clock_fn vs CLOCK_MONOTONIC, keeping the tightest bracket of a few tries
+	static bool measure_offset(bool (*clock_fn)(timespec* const), std::chrono::nanoseconds* const out_offset);
+
+	static void add_offset(std::chrono::nanoseconds const * const in, const size_t len, const std::chrono::nanoseconds& offset, std::chrono::nanoseconds* const out);
+
+	std::chrono::nanoseconds m_update_period;
+
+	// empty until the first update
+	Seqlock<Offsets> m_offsets;
+};
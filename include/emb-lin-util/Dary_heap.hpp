@@ -0,0 +1,151 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+//
+// Min-heap with D children per node
+// A wider node makes the tree shallower, so push is cheaper and the children scanned in pop share cache lines
+// NOT MT safe
+//
+template<typename T, size_t D = 4, typename Compare = std::less<T>>
+class Dary_heap
+{
+public:
+
+	static_assert(D >= 2);
+
+	Dary_heap() = default;
+	explicit Dary_heap(const Compare& comp) : m_comp(comp)
+	{
+
+	}
+
+	bool empty() const
+	{
+		return m_data.empty();
+	}
+
+	size_t size() const
+	{
+		return m_data.size();
+	}
+
+	void reserve(const size_t n)
+	{
+		m_data.reserve(n);
+	}
+
+	void clear()
+	{
+		m_data.clear();
+	}
+
+	// smallest element, heap must not be empty
+	const T& top() const
+	{
+		return m_data.front();
+	}
+
+	void push(const T& val)
+	{
+		m_data.push_back(val);
+		sift_up(m_data.size() - 1);
+	}
+
+	void push(T&& val)
+	{
+		m_data.push_back(std::move(val));
+		sift_up(m_data.size() - 1);
+	}
+
+	// remove the smallest element, heap must not be empty
+	void pop()
+	{
+		if(m_data.size() > 1)
+		{
+			m_data.front() = std::move(m_data.back());
+			m_data.pop_back();
+			sift_down(0);
+		}
+		else
+		{
+			m_data.pop_back();
+		}
+	}
+
+protected:
+
+	void sift_up(size_t idx)
+	{
+		T val = std::move(m_data[idx]);
+
+		while(idx > 0)
+		{
+			const size_t parent = (idx - 1) / D;
+			if( ! m_comp(val, m_data[parent]) )
+			{
+				break;
+			}
+
+			m_data[idx] = std::move(m_data[parent]);
+			idx = parent;
+		}
+
+		m_data[idx] = std::move(val);
+	}
+
+	void sift_down(size_t idx)
+	{
+		const size_t n = m_data.size();
+		T val = std::move(m_data[idx]);
+
+		for(;;)
+		{
+			const size_t first_child = (idx * D) + 1;
+			if(first_child >= n)
+			{
+				break;
+			}
+
+			const size_t last_child = std::min(first_child + D, n);
+
+			size_t min_child = first_child;
+			for(size_t c = first_child + 1; c < last_child; c++)
+			{
+				if(m_comp(m_data[c], m_data[min_child]))
+				{
+					min_child = c;
+				}
+			}
+
+			if( ! m_comp(m_data[min_child], val) )
+			{
+				break;
+			}
+
+			m_data[idx] = std::move(m_data[min_child]);
+			idx = min_child;
+		}
+
+		m_data[idx] = std::move(val);
+	}
+
+	std::vector<T> m_data;
+	Compare m_comp;
+};
@@ -0,0 +1,99 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Directory listing straight from getdents64 into one reused buffer
+// Entries are handed out as views into that buffer with the d_type the filesystem already has, no stat and no allocation
+// Only entries the predicate accepts are copied out, and sizes are gathered afterwards with statx, optionally on several threads
+// . and .. are skipped
+//
+class Dir_scanner
+{
+public:
+
+	enum class Type : uint8_t
+	{
+		UNKNOWN, // the filesystem does not fill d_type, stat_entries resolves it
+		REGULAR,
+		DIRECTORY,
+		SYMLINK,
+		OTHER
+	};
+
+	// valid only for the duration of the callback
+	struct Entry_view
+	{
+		std::string_view name;
+		uint64_t ino;
+		Type type;
+	};
+
+	struct Entry
+	{
+		Entry() : ino(0), type(Type::UNKNOWN), has_stat(false), size(0), mtime_ns(0)
+		{
+
+		}
+
+		std::string name;
+		uint64_t ino;
+		Type type;
+
+		// filled by stat_entries
+		bool has_stat;
+		uint64_t size;
+		int64_t mtime_ns;
+	};
+
+	// return false to stop the scan
+	typedef std::function<bool(const Entry_view& ent)> Visitor;
+
+	// return true to keep the entry
+	typedef std::function<bool(const Entry_view& ent)> Predicate;
+
+	explicit Dir_scanner(const size_t buf_size = 256U * 1024U);
+	~Dir_scanner();
+
+	Dir_scanner(const Dir_scanner&) = delete;
+	Dir_scanner& operator=(const Dir_scanner&) = delete;
+
+	// NOT MT safe, the buffer is shared
+	// Returns false if the directory could not be read, stopping early from visit is not an error
+	bool for_each(const std::string& dir, const Visitor& visit);
+
+	// NOT MT safe, the buffer is shared
+	// Appends entries the predicate accepts, a null predicate accepts everything
+	bool scan(const std::string& dir, const Predicate& pred, std::vector<Entry>* const out_entries);
+
+	// MT safe
+	// statx each entry relative to dir without following symlinks, splitting the work over num_threads
+	// Entries that vanished since the scan keep has_stat false, that alone is not an error
+	static bool stat_entries(const std::string& dir, std::vector<Entry>* const entries, const size_t num_threads = 4);
+
+protected:
+
+	static Type from_d_type(const unsigned char d_type);
+	static Type from_mode(const uint32_t mode);
+
+	const size_t m_buf_size;
+	std::unique_ptr<uint64_t[]> m_buf;
+};
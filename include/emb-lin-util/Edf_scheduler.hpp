@@ -0,0 +1,141 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Dary_heap.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <cstdint>
+
+//
+// Earliest deadline first scheduler for periodic and one-shot tasks on a single thread
+// Released jobs run in order of absolute deadline, one timerfd is armed to the next release
+// With EMB_LIN_UTIL_VIRTUAL_CLOCK the timerfd is an eventfd posted by a Virtual_clock timer
+// Callbacks run on the scheduler thread without the task lock held, so they may add or remove tasks
+//
+class Edf_scheduler : public Thread_base
+{
+public:
+
+	typedef std::function<void()> Task_callback;
+	typedef uint64_t Task_id;
+
+	struct Task_stats
+	{
+		uint64_t run_count;
+		// job finished after its deadline
+		uint64_t deadline_misses;
+		// releases skipped because the task fell more than a deadline behind
+		uint64_t skipped_releases;
+
+		std::chrono::nanoseconds last_runtime;
+		std::chrono::nanoseconds max_runtime;
+		std::chrono::nanoseconds total_runtime;
+	};
+
+	Edf_scheduler();
+	~Edf_scheduler() override;
+
+	// NOT MT safe
+	bool init();
+
+	// MT safe
+	// Fails without adding anything if init has not succeeded
+	// First release is one period from now
+	// rel_deadline is relative to each release, zero means the deadline is the next release
+	bool add_periodic(const std::chrono::nanoseconds& period, const std::chrono::nanoseconds& rel_deadline, const Task_callback& cb, Task_id* const out_id);
+
+	// MT safe
+	// Released once after delay, then removed
+	bool add_oneshot(const std::chrono::nanoseconds& delay, const std::chrono::nanoseconds& rel_deadline, const Task_callback& cb, Task_id* const out_id);
+
+	// MT safe
+	// A job that is already running completes
+	bool remove(const Task_id id);
+
+	// MT safe
+	// false if the task does not exist, one-shot tasks are removed after they run
+	bool get_stats(const Task_id id, Task_stats* const out_stats) const;
+
+	// MT safe
+	void interrupt() override;
+
+protected:
+
+	struct Task
+	{
+		std::shared_ptr<Task_callback> cb;
+
+		int64_t period_ns; // 0 for one-shot
+		int64_t rel_deadline_ns;
+
+		// current job
+		int64_t release_ns;
+		int64_t deadline_ns;
+
+		Task_stats stats;
+	};
+
+	struct Heap_entry
+	{
+		int64_t key_ns;
+		Task_id id;
+		// release_ns of the job this entry was made for, entries for removed or rescheduled tasks are skipped
+		int64_t job_ns;
+
+		bool operator<(const Heap_entry& rhs) const
+		{
+			return key_ns < rhs.key_ns;
+		}
+	};
+
+	void work() override;
+
+	bool add_task(const int64_t first_release_ns, const int64_t period_ns, const std::chrono::nanoseconds& rel_deadline, const Task_callback& cb, Task_id* const out_id);
+
+	// NOT MT safe - call with m_task_mutex held
+	void release_jobs(const int64_t now_ns);
+	bool arm_timer();
+
+	bool wake();
+	void drain_fds();
+
+	// add 1 to an eventfd
+	static bool post_fd(const int fd);
+
+	static bool get_time(int64_t* const out_ns);
+
+	// timerfd, or on Virtual_clock an eventfd posted by m_vtimer_id and read like a timerfd
+	int m_timer_fd;
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int m_vtimer_id;
+#endif
+	int m_event_fd;
+	int m_epoll_fd;
+
+	mutable std::mutex m_task_mutex;
+	Task_id m_next_id;
+	std::unordered_map<Task_id, Task> m_tasks;
+
+	// keyed by release time
+	Dary_heap<Heap_entry> m_pending;
+	// keyed by absolute deadline
+	Dary_heap<Heap_entry> m_ready;
+
+	int64_t m_armed_ns;
+};
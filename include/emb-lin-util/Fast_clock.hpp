@@ -0,0 +1,153 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Chronometer.hpp"
+#include "emb-lin-util/Seqlock.hpp"
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+//
+// A fast CLOCK_MONOTONIC estimate from the cpu counter
+// Reads the TSC on x86 or CNTVCT_EL0 on aarch64 and scales it to CLOCK_MONOTONIC
+// If the counter is not invariant, falls back to clock_gettime
+//
+class Fast_clock
+{
+public:
+
+	Fast_clock();
+	~Fast_clock();
+
+	// NOT MT safe
+	// Detects the counter and calibrates it against CLOCK_MONOTONIC, blocks for about calibration_dt
+	bool init(const std::chrono::nanoseconds& calibration_dt = std::chrono::milliseconds(10));
+
+	// MT safe wrt readers, call from a single thread
+	// Call periodically, eg once per second
+	// Measures drift vs CLOCK_MONOTONIC and slews the scale so the error is removed over the next slew_dt, then runs at the measured rate
+	// Errors larger than step_limit are stepped instead of slewed, which may make time go backwards
+	// A slew is continuous, but a reader that reads the counter just before the new scale is published and loads the old one
+	// can be ahead of a later reader by the scale change times the publish latency, well under a ns unless this thread is preempted
+	bool recalibrate(const std::chrono::nanoseconds& slew_dt = std::chrono::seconds(1), const std::chrono::nanoseconds& step_limit = std::chrono::milliseconds(1));
+
+	// MT safe
+	// Returns an estimate of CLOCK_MONOTONIC
+	bool get_time(std::chrono::nanoseconds* const out_time) const
+	{
+		if( ! m_counter_enabled )
+		{
+			return Chronometer::get_time(out_time);
+		}
+
+		if(out_time)
+		{
+			*out_time = std::chrono::nanoseconds(counter_to_ns(read_counter()));
+		}
+
+		return true;
+	}
+	bool get_time(timespec* const out_time) const;
+
+	// MT safe
+	bool is_counter_enabled() const
+	{
+		return m_counter_enabled;
+	}
+
+	// counter frequency estimated by the last calibration
+	double get_counter_freq() const;
+
+	static uint64_t read_counter()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t ctr;
+		asm volatile("isb; mrs %0, cntvct_el0" : "=r"(ctr) :: "memory");
+		return ctr;
+#else
+		return 0;
+#endif
+	}
+
+	// true if the counter runs at a constant rate across p-states and sleep, and is used by the kernel
+	static bool is_counter_invariant();
+
+protected:
+
+	// ns = ns0 + ((ctr - ctr0) * mult) >> MULT_SHIFT
+	static constexpr unsigned MULT_SHIFT = 32;
+
+	// simultaneous sample of the counter and CLOCK_MONOTONIC
+	struct Sample
+	{
+		uint64_t ctr;
+		int64_t  ns;
+	};
+
+	static bool take_sample(Sample* const out_sample);
+
+	// scale parameters, published through a seqlock so readers never block recalibrate
+	// mult applies from ctr0 until the slew ends at ctr1, then mult1
+	struct Params
+	{
+		uint64_t ctr0;
+		int64_t  ns0;
+		uint64_t mult;
+
+		uint64_t ctr1;
+		int64_t  ns1;
+		uint64_t mult1;
+	};
+
+	// one rate, no slew
+	static Params make_params(const uint64_t ctr0, const int64_t ns0, const uint64_t mult)
+	{
+		return Params{ctr0, ns0, mult, ctr0, ns0, mult};
+	}
+
+	int64_t counter_to_ns(const uint64_t ctr) const
+	{
+		Params params = {0, 0, 0, 0, 0, 0};
+		m_params.load(&params);
+
+		if(int64_t(ctr - params.ctr1) >= 0)
+		{
+			return scale(ctr, params.ctr1, params.ns1, params.mult1);
+		}
+
+		return scale(ctr, params.ctr0, params.ns0, params.mult);
+	}
+
+	static int64_t scale(const uint64_t ctr, const uint64_t ctr0, const int64_t ns0, const uint64_t mult)
+	{
+		const __int128 dctr = int64_t(ctr - ctr0);
+		return ns0 + int64_t((dctr * __int128(mult)) >> MULT_SHIFT);
+	}
+
+	bool m_counter_enabled;
+
+	// last true sample, used to measure the counter rate during recalibration
+	Sample m_last_sample;
+
+	Seqlock<Params> m_params;
+};
@@ -11,14 +11,55 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include <cstddef>
+#include <cstdint>
+
+class Token_bucket;
+
 class File_util
 {
 public:
 
+	// Ways copy_file can move data, fastest first
+	enum class Copy_method
+	{
+		CLONE,           // FICLONE reflink, shares extents on btrfs, xfs etc, no data is moved
+		COPY_FILE_RANGE, // in kernel, may be offloaded by the filesystem or device
+		SENDFILE,        // in kernel through the page cache, works across most filesystems
+		READ_WRITE       // userspace buffer
+	};
+
+	// bytes_total is the source size when the copy started, return false to cancel
+	typedef std::function<bool(const uint64_t bytes_copied, const uint64_t bytes_total)> Copy_progress_callback;
+
+	struct Copy_options
+	{
+		Copy_options() : first_method(Copy_method::CLONE), chunk_size(1024U * 1024U), rate_limit(nullptr), sync(true)
+		{
+
+		}
+
+		// methods before this one are not tried, later ones are fallbacks
+		Copy_method first_method;
+
+		// bytes per syscall, also the granularity of progress and rate limiting
+		size_t chunk_size;
+
+		// not owned, one token per byte, may be shared by concurrent copies
+		// a clone moves no data and is not limited
+		Token_bucket* rate_limit;
+
+		Copy_progress_callback progress;
+
+		// fdatasync dst before returning
+		bool sync;
+	};
+
 
 	//read first line from file
 	static bool readSmallFileLine(char const * const filename, std::string* const out_value);
@@ -44,6 +85,7 @@ public:
 	//read up to max_to_read B from a file
 	static bool readSmallFile(const std::string& filename, const ssize_t max_to_read, std::vector<uint8_t>* const out_value);
 
+	//truncate and write in place, not crash safe - see Atomic_file_writer for state files
 	static bool writeSmallFile(const std::string& filename, const std::vector<uint8_t>& value)
 	{
 		return writeSmallFile(filename, value.data(), value.size());
@@ -54,6 +96,15 @@ public:
 	}
 	static bool writeSmallFile(const std::string& filename, uint8_t const * const ptr, const size_t len);
 
+	//write all of len to fd, retrying on EINTR and short writes
+	static bool write_all(const int fd, void const * const ptr, const size_t len);
+
+	//copy a regular file, dst is created or truncated with the mode of src
+	//data stays in the kernel unless every in kernel method is refused
+	//on failure or cancel the partial dst is removed
+	//out_method is the method that moved the data
+	static bool copy_file(const std::string& src, const std::string& dst, const Copy_options& opt = Copy_options(), Copy_method* const out_method = nullptr);
+
 	static std::string getenv_or_empty(char const * const env_name);
 	static std::string getenv_or_str(char const * const env_name, const std::string_view& def_str);
 
@@ -0,0 +1,89 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Read only view of a whole file
+// Regular files are mmaped, so parsing reads the page cache directly instead of a private copy
+// procfs, sysfs, pipes and other files that cannot be mapped are read into an owned buffer instead
+// The view is a snapshot only for the read fallback - a mapped file that is modified in place changes under the view,
+// and one that is truncated can SIGBUS, so use it on files that are replaced by rename
+//
+class File_view
+{
+public:
+
+	enum class Advice
+	{
+		NORMAL,
+		SEQUENTIAL,
+		RANDOM
+	};
+
+	File_view();
+	~File_view();
+
+	File_view(const File_view&) = delete;
+	File_view& operator=(const File_view&) = delete;
+
+	File_view(File_view&& other);
+	File_view& operator=(File_view&& other);
+
+	// NOT MT safe
+	// populate prefaults the whole mapping with MAP_POPULATE, so parsing does not stall on page faults
+	bool open(const std::string& path, const Advice advice = Advice::SEQUENTIAL, const bool populate = true);
+	void close();
+
+	bool is_open() const
+	{
+		return m_is_open;
+	}
+
+	// true if backed by mmap, false if read into a buffer
+	bool is_mapped() const
+	{
+		return m_map != nullptr;
+	}
+
+	std::span<const uint8_t> get_span() const
+	{
+		return std::span<const uint8_t>(data(), size());
+	}
+
+	uint8_t const * data() const
+	{
+		return is_mapped() ? static_cast<uint8_t const *>(m_map) : m_buf.data();
+	}
+
+	size_t size() const
+	{
+		return is_mapped() ? m_map_len : m_buf.size();
+	}
+
+protected:
+
+	bool read_all(const int fd);
+
+	bool m_is_open;
+
+	void*  m_map;
+	size_t m_map_len;
+
+	std::vector<uint8_t> m_buf;
+};
@@ -0,0 +1,228 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/File_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+//
+// One watched file and its last good parsed copy
+// The loop thread reloads it, any thread may read it
+//
+class Watched_file_base
+{
+	friend class File_watcher;
+public:
+
+	explicit Watched_file_base(const std::string& path) : m_path(path), m_generation(0), m_error_count(0), m_is_pending(false), m_due_ns(0)
+	{
+
+	}
+	virtual ~Watched_file_base()
+	{
+
+	}
+
+	const std::string& get_path() const
+	{
+		return m_path;
+	}
+
+	// MT safe
+	// Bumped after each successful reload, hot loops can compare this before taking a new copy
+	uint64_t get_generation() const
+	{
+		return m_generation.load(std::memory_order_acquire);
+	}
+
+	// MT safe
+	// Reloads that failed to read or parse, the previous copy is kept
+	uint64_t get_error_count() const
+	{
+		return m_error_count.load(std::memory_order_relaxed);
+	}
+
+protected:
+
+	// read, parse and publish, on the loop thread
+	virtual bool reload() = 0;
+
+	const std::string m_path;
+
+	std::atomic<uint64_t> m_generation;
+	std::atomic<uint64_t> m_error_count;
+
+	// debounce state, loop thread only
+	bool m_is_pending;
+	int64_t m_due_ns;
+};
+
+template <typename T>
+class Watched_file : public Watched_file_base
+{
+public:
+
+	// fill out from the whole file content, false to reject it
+	typedef std::function<bool(std::span<const uint8_t> data, T* const out)> Parser;
+
+	// called on the loop thread after each successful reload
+	typedef std::function<void(const std::shared_ptr<const T>& value)> Change_callback;
+
+	Watched_file(const std::string& path, const Parser& parser, const Change_callback& on_change) : Watched_file_base(path), m_parser(parser), m_on_change(on_change)
+	{
+
+	}
+
+	// MT safe
+	// The last good copy, null until the file has been parsed once
+	std::shared_ptr<const T> get() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_value;
+	}
+
+protected:
+
+	bool reload() override
+	{
+		std::vector<uint8_t> data;
+		if( ! File_util::readSmallFile(m_path, &data) )
+		{
+			m_error_count.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		std::shared_ptr<T> value = std::make_shared<T>();
+		if( ! m_parser(std::span<const uint8_t>(data.data(), data.size()), value.get()) )
+		{
+			m_error_count.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_value = value;
+		}
+		m_generation.fetch_add(1, std::memory_order_release);
+
+		if(m_on_change)
+		{
+			m_on_change(value);
+		}
+
+		return true;
+	}
+
+	const Parser m_parser;
+	const Change_callback m_on_change;
+
+	mutable std::mutex m_mutex;
+	std::shared_ptr<const T> m_value;
+};
+
+//
+// inotify based change notification with cached parsed copies
+// The parent directory is watched rather than the file, so replacement by rename is seen and files may be created later
+// Only IN_CLOSE_WRITE and IN_MOVED_TO trigger a reload, so a half written file is never parsed
+// Bursts are debounced, a file reloads once it has been quiet for the debounce time
+// A deleted file keeps its last good copy
+//
+// get_fd is an epoll fd that can join an outer epoll loop, call process_events when it is readable
+// Or run wait_and_process in a Thread_base loop, and override interrupt() to also call notify_cancel()
+//
+class File_watcher
+{
+public:
+
+	File_watcher();
+	~File_watcher();
+
+	File_watcher(const File_watcher&) = delete;
+	File_watcher& operator=(const File_watcher&) = delete;
+
+	// NOT MT safe
+	bool init(const std::chrono::nanoseconds& debounce = std::chrono::milliseconds(50));
+	void reset();
+
+	// NOT MT safe wrt process_events
+	// Loads the file now if it exists, the directory must exist
+	// Returns null on error
+	template <typename T>
+	std::shared_ptr<Watched_file<T>> watch(const std::string& path, const typename Watched_file<T>::Parser& parser, const typename Watched_file<T>::Change_callback& on_change = nullptr)
+	{
+		std::shared_ptr<Watched_file<T>> file = std::make_shared<Watched_file<T>>(path, parser, on_change);
+		if( ! add(file) )
+		{
+			return nullptr;
+		}
+		return file;
+	}
+
+	// NOT MT safe wrt process_events
+	bool unwatch(const std::shared_ptr<Watched_file_base>& file);
+
+	int get_fd() const
+	{
+		return m_epoll_fd;
+	}
+
+	// NOT MT safe, call from one loop thread
+	// Does not block, handles pending inotify events and reloads files whose debounce has expired
+	bool process_events();
+
+	// NOT MT safe, call from one loop thread
+	// Waits up to timeout for get_fd, then process_events
+	// out_canceled is set if notify_cancel was called
+	bool wait_and_process(const std::chrono::nanoseconds& timeout, bool* const out_canceled = nullptr);
+
+	// MT safe
+	// Wakes wait_and_process, this cancelation is latching
+	bool notify_cancel();
+
+protected:
+
+	struct Dir_watch
+	{
+		std::string dir;
+		std::multimap<std::string, std::shared_ptr<Watched_file_base>> files;
+	};
+
+	bool add(const std::shared_ptr<Watched_file_base>& file);
+
+	static void split_path(const std::string& path, std::string* const out_dir, std::string* const out_name);
+	static int64_t get_now_ns();
+
+	bool read_inotify(const int64_t now_ns);
+	bool reload_due(const int64_t now_ns);
+	bool arm_timer();
+
+	std::chrono::nanoseconds m_debounce;
+
+	int m_inotify_fd;
+	int m_timer_fd;
+	int m_cancel_fd;
+	int m_epoll_fd;
+
+	// by watch descriptor
+	std::map<int, Dir_watch> m_dirs;
+};
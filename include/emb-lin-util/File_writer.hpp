@@ -0,0 +1,169 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Atomic_file_writer.hpp"
+#include "emb-lin-util/Metrics.hpp"
+#include "emb-lin-util/Mpmc_queue.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Write-behind thread for whole file replacement, so control threads do not block on flash latency
+// Jobs go through an Mpmc_queue, the thread drains everything queued and writes it as one Atomic_file_writer group commit
+// Repeated writes to the same path within a batch coalesce, the latest one is written and the older ones complete as SUPERSEDED
+//
+// Memory is bounded by a job count and a byte budget, submit waits up to its timeout for room and is REJECTED after
+// A job larger than the whole byte budget is still admitted once nothing else is pending
+//
+// Completion callbacks run on the writer thread, keep them short
+// On interrupt the thread writes everything already queued before exiting, later submits are REJECTED
+// While idle the thread still beats its heartbeat every 250 ms, so a watchdog timeout above that is safe
+//
+class File_writer : public Thread_base
+{
+public:
+
+	enum class Result
+	{
+		WRITTEN,
+		SUPERSEDED, // a newer write to the same path was written instead
+		FAILED,
+		REJECTED    // no room before the timeout, or the writer is stopping
+	};
+
+	typedef std::function<void(const std::string& path, const Result result)> Callback;
+
+	struct Stats
+	{
+		uint64_t submitted;
+		uint64_t written;
+		uint64_t superseded;
+		uint64_t failed;
+		uint64_t rejected;
+		uint64_t backpressure_waits; // submits that had to wait for room
+		uint64_t pending_jobs;
+		uint64_t pending_bytes;
+	};
+
+	File_writer(const size_t max_jobs = 64, const size_t max_bytes = 4U * 1024U * 1024U, const Atomic_file_writer::Sync_mode mode = Atomic_file_writer::Sync_mode::FDATASYNC_EACH);
+	~File_writer() override;
+
+	// NOT MT safe - call before launch
+	// Waits this long after the first job of a batch so bursts coalesce, zero writes as soon as possible
+	// Jobs that arrive while a batch is being written coalesce either way
+	void set_coalesce_window(const std::chrono::nanoseconds& dt)
+	{
+		m_coalesce_window = dt;
+	}
+
+	// NOT MT safe - call before launch
+	void set_skip_unchanged(const bool skip)
+	{
+		m_writer.set_skip_unchanged(skip);
+	}
+
+	// NOT MT safe - call before launch
+	// Registers prefix_submitted_total, prefix_pending_bytes, prefix_commit_ns etc and counts into them from now on
+	bool bind_metrics(Metrics_registry* const registry, const std::string& prefix);
+
+	// MT safe
+	// Takes ownership of data, the future is ready with REJECTED if the job was not queued
+	std::future<Result> submit(const std::string& path, std::vector<uint8_t>&& data, const mode_t mode = 0644, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max());
+
+	// MT safe
+	// Returns false if the job was not queued, cb is not called in that case
+	bool submit(const std::string& path, std::vector<uint8_t>&& data, const Callback& cb, const mode_t mode = 0644, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max());
+
+	// MT safe
+	// Ready with WRITTEN once every job submitted before it has completed
+	std::future<Result> flush(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max());
+
+	// MT safe
+	Stats get_stats() const;
+
+	// MT safe
+	void interrupt() override;
+
+protected:
+
+	struct Job
+	{
+		Job() : mode(0644), is_barrier(false)
+		{
+
+		}
+
+		std::string path;
+		std::vector<uint8_t> data;
+		mode_t mode;
+
+		bool is_barrier;
+
+		// one of these is set
+		std::promise<Result> promise;
+		Callback cb;
+	};
+
+	void work() override;
+
+	bool enqueue(std::unique_ptr<Job>&& job, const std::chrono::nanoseconds& timeout);
+
+	// Claims a job slot and len bytes of the budget, false if there is no room
+	bool try_reserve(const size_t len);
+	void release(const size_t jobs, const size_t bytes);
+
+	void write_batch(std::vector<Job*>* const batch);
+	void complete(Job* const job, const Result result);
+
+	// drain what is left after the thread exits
+	void drain();
+
+	const size_t m_max_jobs;
+	const size_t m_max_bytes;
+
+	std::chrono::nanoseconds m_coalesce_window;
+
+	// sized to m_max_jobs, the reservation guarantees a push never finds it full
+	Mpmc_queue<Job*> m_queue;
+
+	Atomic_file_writer m_writer;
+
+	std::atomic<uint64_t> m_pending_jobs;
+	std::atomic<uint64_t> m_pending_bytes;
+
+	// bumped on every release, submits blocked on the budget sleep on it
+	std::atomic<uint32_t> m_space_seq;
+	std::atomic<uint32_t> m_space_waiters;
+
+	// standalone until bind_metrics swaps in registered ones
+	std::shared_ptr<Metric_counter>   m_submitted;
+	std::shared_ptr<Metric_counter>   m_written;
+	std::shared_ptr<Metric_counter>   m_superseded;
+	std::shared_ptr<Metric_counter>   m_failed;
+	std::shared_ptr<Metric_counter>   m_rejected;
+	std::shared_ptr<Metric_counter>   m_backpressure_waits;
+	std::shared_ptr<Metric_gauge>     m_pending_bytes_gauge;
+	std::shared_ptr<Metric_histogram> m_commit_ns;
+};
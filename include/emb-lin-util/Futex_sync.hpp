@@ -0,0 +1,319 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Futex_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+
+#include <cstdint>
+
+//
+// Lightweight futex backed synchronization
+// Uncontended set / post / count_down is an atomic op, a fence and a load, syscalls only happen when someone sleeps
+// Timed waits take a relative timeout measured on CLOCK_MONOTONIC, nanoseconds::max() waits forever
+//
+
+//
+// Binary event
+// AUTO   - a successful wait consumes the event and wakes at most one waiter per set
+// MANUAL - stays set and wakes every waiter until reset
+//
+class Futex_event
+{
+public:
+
+	enum class Reset_mode
+	{
+		AUTO,
+		MANUAL
+	};
+
+	explicit Futex_event(const Reset_mode mode = Reset_mode::AUTO, const bool initially_set = false) : m_mode(mode), m_state(initially_set ? 1U : 0U), m_waiters(0)
+	{
+
+	}
+
+	Futex_event(const Futex_event&) = delete;
+	Futex_event& operator=(const Futex_event&) = delete;
+
+	// MT safe
+	void set()
+	{
+		m_state.store(1U, std::memory_order_release);
+		Futex_util::wake_waiters(&m_state, &m_waiters, (m_mode == Reset_mode::AUTO) ? 1 : INT_MAX);
+	}
+
+	// MT safe
+	void reset()
+	{
+		m_state.store(0U, std::memory_order_relaxed);
+	}
+
+	// MT safe
+	bool is_set() const
+	{
+		return m_state.load(std::memory_order_acquire) != 0;
+	}
+
+	// MT safe
+	// Returns true if the event was set (and consumed if AUTO), false on timeout
+	bool try_wait()
+	{
+		if(m_mode == Reset_mode::AUTO)
+		{
+			uint32_t expected = 1U;
+			return m_state.compare_exchange_strong(expected, 0U, std::memory_order_acquire, std::memory_order_relaxed);
+		}
+
+		return is_set();
+	}
+
+	bool wait(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		if(try_wait())
+		{
+			return true;
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		return Futex_util::wait_for_state(&m_state, &m_waiters, [this](const uint32_t){ return try_wait() ? 1 : 0; }, has_deadline ? &deadline : nullptr);
+	}
+
+protected:
+
+	const Reset_mode m_mode;
+
+	std::atomic<uint32_t> m_state;
+	std::atomic<uint32_t> m_waiters;
+};
+
+//
+// Counting semaphore
+// notify_cancel latches and wakes every waiter, like the interval timers and queues
+//
+class Futex_semaphore
+{
+public:
+
+	explicit Futex_semaphore(const uint32_t initial = 0) : m_word(initial & COUNT_MASK), m_waiters(0)
+	{
+
+	}
+
+	Futex_semaphore(const Futex_semaphore&) = delete;
+	Futex_semaphore& operator=(const Futex_semaphore&) = delete;
+
+	// MT safe
+	void post(const uint32_t n = 1)
+	{
+		m_word.fetch_add(n, std::memory_order_release);
+		Futex_util::wake_waiters(&m_word, &m_waiters, int(std::min<uint32_t>(n, INT_MAX)));
+	}
+
+	// MT safe
+	bool try_wait()
+	{
+		uint32_t word = m_word.load(std::memory_order_relaxed);
+		while((word & COUNT_MASK) != 0)
+		{
+			if(m_word.compare_exchange_weak(word, word - 1U, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// MT safe
+	// Returns true if a count was taken, even after cancelation, so waiters can drain
+	// Returns false on timeout, or on cancelation with nothing left
+	bool wait(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		if(try_wait())
+		{
+			return true;
+		}
+		if(is_cancel_requested())
+		{
+			return false;
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		return Futex_util::wait_for_state(&m_word, &m_waiters,
+			[this](const uint32_t word)
+			{
+				if(try_wait())
+				{
+					return 1;
+				}
+				return (word & CANCEL_BIT) ? -1 : 0;
+			},
+			has_deadline ? &deadline : nullptr
+		);
+	}
+
+	// MT safe
+	uint32_t get_count() const
+	{
+		return m_word.load(std::memory_order_relaxed) & COUNT_MASK;
+	}
+
+	// MT safe
+	// This cancelation is latching, call reset to reuse
+	void notify_cancel()
+	{
+		m_word.fetch_or(CANCEL_BIT, std::memory_order_release);
+		Futex_util::wake_waiters(&m_word, &m_waiters, INT_MAX);
+	}
+	bool is_cancel_requested() const
+	{
+		return (m_word.load(std::memory_order_acquire) & CANCEL_BIT) != 0;
+	}
+
+	// NOT MT safe
+	// Clears the count and cancelation
+	void reset(const uint32_t initial = 0)
+	{
+		m_word.store(initial & COUNT_MASK, std::memory_order_relaxed);
+	}
+
+protected:
+
+	static constexpr uint32_t CANCEL_BIT = 0x80000000U;
+	static constexpr uint32_t COUNT_MASK = 0x7FFFFFFFU;
+
+	std::atomic<uint32_t> m_word;
+	std::atomic<uint32_t> m_waiters;
+};
+
+//
+// Single use countdown, waiters are released once the count reaches zero
+//
+class Futex_latch
+{
+public:
+
+	explicit Futex_latch(const uint32_t count) : m_count(count), m_waiters(0)
+	{
+
+	}
+
+	Futex_latch(const Futex_latch&) = delete;
+	Futex_latch& operator=(const Futex_latch&) = delete;
+
+	// MT safe
+	// n must not exceed the remaining count
+	void count_down(const uint32_t n = 1)
+	{
+		const uint32_t prev = m_count.fetch_sub(n, std::memory_order_acq_rel);
+		if(prev == n)
+		{
+			Futex_util::wake_waiters(&m_count, &m_waiters, INT_MAX);
+		}
+	}
+
+	// MT safe
+	bool try_wait() const
+	{
+		return m_count.load(std::memory_order_acquire) == 0;
+	}
+
+	// MT safe
+	// false on timeout
+	bool wait(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		if(try_wait())
+		{
+			return true;
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		return Futex_util::wait_for_state(&m_count, &m_waiters, [](const uint32_t count){ return (count == 0) ? 1 : 0; }, has_deadline ? &deadline : nullptr);
+	}
+
+	bool arrive_and_wait(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		count_down(1);
+		return wait(timeout);
+	}
+
+protected:
+
+	std::atomic<uint32_t> m_count;
+	std::atomic<uint32_t> m_waiters;
+};
+
+//
+// Reusable barrier for a fixed number of threads
+//
+class Futex_barrier
+{
+public:
+
+	explicit Futex_barrier(const uint32_t count) : m_count(count), m_arrived(0), m_phase(0), m_waiters(0)
+	{
+
+	}
+
+	Futex_barrier(const Futex_barrier&) = delete;
+	Futex_barrier& operator=(const Futex_barrier&) = delete;
+
+	// MT safe
+	// Returns true once all count threads have arrived in this phase
+	// On timeout returns false, but the arrival still counts towards the phase, like std::barrier there is no way to withdraw
+	bool arrive_and_wait(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		const uint32_t phase = m_phase.load(std::memory_order_acquire);
+
+		if((m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1U) == m_count)
+		{
+			// last to arrive, open the next phase
+			m_arrived.store(0, std::memory_order_relaxed);
+			m_phase.fetch_add(1, std::memory_order_release);
+			Futex_util::wake_waiters(&m_phase, &m_waiters, INT_MAX);
+			return true;
+		}
+
+		if(m_phase.load(std::memory_order_acquire) != phase)
+		{
+			return true;
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		return Futex_util::wait_for_state(&m_phase, &m_waiters, [phase](const uint32_t cur_phase){ return (cur_phase != phase) ? 1 : 0; }, has_deadline ? &deadline : nullptr);
+	}
+
+	uint32_t get_phase() const
+	{
+		return m_phase.load(std::memory_order_acquire);
+	}
+
+protected:
+
+	const uint32_t m_count;
+
+	std::atomic<uint32_t> m_arrived;
+	std::atomic<uint32_t> m_phase;
+	std::atomic<uint32_t> m_waiters;
+};
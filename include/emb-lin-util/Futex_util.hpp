@@ -0,0 +1,179 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+#endif
+
+//
+// Thin wrappers over the linux futex syscall
+// Deadlines are absolute CLOCK_MONOTONIC as seen by the kernel
+//
+class Futex_util
+{
+public:
+
+	// Sleeps while *addr == expected
+	// Returns false on timeout, true otherwise - which may be a spurious wake, callers must recheck their condition
+	// A null deadline waits forever
+	static bool wait(std::atomic<uint32_t>* const addr, const uint32_t expected, const timespec* const deadline = nullptr);
+
+	// Returns number of waiters woken
+	static int wake(std::atomic<uint32_t>* const addr, const int count);
+	static int wake_all(std::atomic<uint32_t>* const addr);
+
+	// deadline = CLOCK_MONOTONIC + dt, dt == nanoseconds::max() gives false so callers can wait forever
+	static bool get_deadline(const std::chrono::nanoseconds& dt, timespec* const out_deadline);
+
+	// true once CLOCK_MONOTONIC has reached deadline, a null deadline never expires
+	static bool is_expired(const timespec* const deadline);
+
+	// Slow path shared by the Futex_sync primitives
+	// try_fn(observed word) returns 1 when done, -1 to give up, 0 to sleep until the word changes
+	// Returns true if try_fn returned 1, false on give up or timeout
+	template <typename Try>
+	static bool wait_for_state(std::atomic<uint32_t>* const word, std::atomic<uint32_t>* const waiters, const Try& try_fn, const timespec* const deadline)
+	{
+		waiters->fetch_add(1, std::memory_order_seq_cst);
+
+		int state = 0;
+		for(;;)
+		{
+			const uint32_t val = word->load(std::memory_order_acquire);
+			state = try_fn(val);
+			if(state != 0)
+			{
+				break;
+			}
+
+			if( ! wait(word, val, deadline) )
+			{
+				state = try_fn(word->load(std::memory_order_acquire));
+				break;
+			}
+		}
+
+		waiters->fetch_sub(1, std::memory_order_relaxed);
+
+		return state > 0;
+	}
+
+	// Notifier side of wait_for_state, call after changing word
+	// pairs with the seq_cst increment of waiters, either the waiter sees the new word or we see the waiter
+	static void wake_waiters(std::atomic<uint32_t>* const word, const std::atomic<uint32_t>* const waiters, const int count)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(waiters->load(std::memory_order_relaxed) != 0)
+		{
+			wake(word, count);
+		}
+	}
+
+	// spin loop hint
+	static void cpu_relax()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#elif defined(__aarch64__)
+		asm volatile("yield" ::: "memory");
+#endif
+	}
+};
+
+//
+// Event count for blocking on a condition held elsewhere in atomics
+// Bit 0 of the futex word marks a sleeper, so notify is a fence and a load when nobody waits,
+// and notify_all clears it so back to back notifies only make one syscall
+//
+// Waiter:
+//   while( ! cond() ) {
+//     uint32_t key = ec.prepare_wait();
+//     if(cond()) { ec.cancel_wait(); break; }
+//     ec.commit_wait(key, deadline);
+//   }
+// Notifier:
+//   publish(); ec.notify_all();
+//
+class Futex_event_count
+{
+public:
+
+	Futex_event_count() : m_epoch(0)
+	{
+
+	}
+
+	uint32_t prepare_wait()
+	{
+		return m_epoch.fetch_or(1U, std::memory_order_seq_cst) | 1U;
+	}
+
+	void cancel_wait()
+	{
+		// leave the sleeper bit, at worst the next notify makes one extra syscall
+	}
+
+	// Returns false on timeout
+	bool commit_wait(const uint32_t key, const timespec* const deadline = nullptr)
+	{
+		return Futex_util::wait(&m_epoch, key, deadline);
+	}
+
+	// Leaves the sleeper bit set since other waiters may still be asleep
+	void notify_one()
+	{
+		if(has_waiters())
+		{
+			m_epoch.fetch_add(2U, std::memory_order_release);
+			Futex_util::wake(&m_epoch, 1);
+		}
+	}
+
+	void notify_all()
+	{
+		uint32_t epoch = 0;
+		if(has_waiters(&epoch))
+		{
+			// odd -> even, clears the sleeper bit and changes the word so sleepers that have not slept yet do not
+			// if this fails another notifier got here first
+			if(m_epoch.compare_exchange_strong(epoch, epoch + 1U, std::memory_order_release, std::memory_order_relaxed))
+			{
+				Futex_util::wake_all(&m_epoch);
+			}
+		}
+	}
+
+protected:
+
+	// pairs with the seq_cst fetch_or in prepare_wait, either the waiter sees the published state or we see the waiter
+	bool has_waiters(uint32_t* const out_epoch = nullptr) const
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const uint32_t epoch = m_epoch.load(std::memory_order_relaxed);
+		if(out_epoch)
+		{
+			*out_epoch = epoch;
+		}
+		return (epoch & 1U) != 0;
+	}
+
+	std::atomic<uint32_t> m_epoch;
+};
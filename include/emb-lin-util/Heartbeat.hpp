@@ -0,0 +1,102 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Chronometer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <string>
+
+#include <cstdint>
+
+//
+// Last sign of life from a worker, written by the worker and read by Watchdog
+// A beat is a clock read and a relaxed store
+// Starts paused, a paused heartbeat is never reported as stalled
+//
+class Heartbeat
+{
+public:
+
+	Heartbeat(const std::string& name, const std::chrono::nanoseconds& timeout) : m_name(name), m_timeout(timeout), m_last_beat_ns(PAUSED)
+	{
+
+	}
+
+	Heartbeat(const Heartbeat&) = delete;
+	Heartbeat& operator=(const Heartbeat&) = delete;
+
+	// MT safe
+	void beat()
+	{
+		std::chrono::nanoseconds now;
+		if(Chronometer::get_time(&now))
+		{
+			beat(now);
+		}
+	}
+
+	// MT safe
+	// now is CLOCK_MONOTONIC, for callers that already have a timestamp
+	void beat(const std::chrono::nanoseconds& now)
+	{
+		m_last_beat_ns.store(now.count(), std::memory_order_relaxed);
+	}
+
+	// MT safe
+	// eg before a long blocking wait that is expected, the next beat resumes checking
+	void pause()
+	{
+		m_last_beat_ns.store(PAUSED, std::memory_order_relaxed);
+	}
+
+	bool is_paused() const
+	{
+		return m_last_beat_ns.load(std::memory_order_relaxed) == PAUSED;
+	}
+
+	// MT safe
+	// false if paused
+	bool get_age(const std::chrono::nanoseconds& now, std::chrono::nanoseconds* const out_age) const
+	{
+		const int64_t last = m_last_beat_ns.load(std::memory_order_relaxed);
+		if(last == PAUSED)
+		{
+			return false;
+		}
+
+		*out_age = now - std::chrono::nanoseconds(last);
+		return true;
+	}
+
+	const std::string& get_name() const
+	{
+		return m_name;
+	}
+
+	const std::chrono::nanoseconds& get_timeout() const
+	{
+		return m_timeout;
+	}
+
+protected:
+
+	static constexpr int64_t PAUSED = std::numeric_limits<int64_t>::min();
+
+	const std::string              m_name;
+	const std::chrono::nanoseconds m_timeout;
+
+	// own cache line, workers beat from hot loops
+	alignas(64) std::atomic<int64_t> m_last_beat_ns;
+};
@@ -11,16 +11,13 @@
 
 #pragma once
 
+#include "Futex_sync.hpp"
 #include "Timespec_util.hpp"
 
 #include <signal.h>
 #include <time.h>
 
-#include <atomic>
 #include <chrono>
-
-#include <condition_variable>
-#include <mutex>
 #include <optional>
 
 //
@@ -56,13 +53,13 @@ public:
 	// MT safe
 	bool is_cancel_requested() const
 	{
-		return m_pending_cancel;
+		return m_events.is_cancel_requested();
 	}
 
 	// MT safe
 	int pending_event_count() const
 	{
-		return m_pending_event_count;
+		return int(m_events.get_count());
 	}
 
 	// MT safe
@@ -72,29 +69,19 @@ public:
 	// After calling this, call reset -> init -> start to reuse
 	void notify_cancel()
 	{
-		m_pending_cancel = true;
-		m_cond_var.notify_all();
+		m_events.notify_cancel();
 	}
 
 protected:
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	std::optional<int>     m_timer;
+#else
 	std::optional<timer_t> m_timer;
+#endif
 
-	std::atomic<int> m_pending_event_count;
-	std::atomic<bool> m_pending_cancel;
-	
-	std::mutex              m_mutex;
-	std::condition_variable m_cond_var;
-
-	bool should_wake() const
-	{
-		return (m_pending_event_count > 0) || is_cancel_requested();
-	}
-
-	bool has_event() const
-	{
-		return m_pending_event_count > 0;
-	}
+	// one count per expiration, the cancel bit lives in the same futex word
+	Futex_semaphore m_events;
 
 	static void dispatch_event(sigval sig)
 	{
@@ -102,8 +89,7 @@ protected:
 	}
 	void handle_event(sigval sig)
 	{
-		m_pending_event_count++;
-		m_cond_var.notify_one();
+		m_events.post();
 	}
 
 };
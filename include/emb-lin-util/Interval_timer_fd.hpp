@@ -71,7 +71,12 @@ public:
 
 protected:
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int m_timer_fd; // eventfd posted by a Virtual_clock timer, read like a timerfd
+	int m_vtimer_id;
+#else
 	int m_timer_fd; // timer fd
+#endif
 	int m_epoll_fd; // epoll fd
 	std::array<int, 2> m_pipe_fd; // cancelation fd, read from [0], write to [1]
 
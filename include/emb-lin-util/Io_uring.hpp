@@ -0,0 +1,88 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Minimal io_uring on the raw syscalls, so there is no dependency on liburing
+// Single threaded - one thread queues, submits and reaps
+// init fails on kernels without io_uring or where it is disabled, callers are expected to fall back to plain syscalls
+//
+class Io_uring
+{
+public:
+
+	Io_uring();
+	~Io_uring();
+
+	Io_uring(const Io_uring&) = delete;
+	Io_uring& operator=(const Io_uring&) = delete;
+
+	// entries is rounded up to a power of two by the kernel
+	bool init(const unsigned entries);
+	void reset();
+
+	bool is_open() const
+	{
+		return m_ring_fd >= 0;
+	}
+
+	unsigned get_sq_entries() const
+	{
+		return m_sq_entries;
+	}
+
+	// Returns a zeroed SQE to fill in, or null if the submission queue is full
+	io_uring_sqe* get_sqe();
+
+	// Submits all queued SQEs and waits until at least wait_nr completions are available
+	bool submit_and_wait(const unsigned wait_nr);
+
+	// Copies out and consumes one completion, false if none are ready
+	bool pop_cqe(io_uring_cqe* const out_cqe);
+
+	// Waits for and consumes one completion
+	bool wait_cqe(io_uring_cqe* const out_cqe);
+
+	static void prep_read(io_uring_sqe* const sqe, const int fd, void* const buf, const unsigned len, const uint64_t offset, const uint64_t user_data);
+	static void prep_write(io_uring_sqe* const sqe, const int fd, void const * const buf, const unsigned len, const uint64_t offset, const uint64_t user_data);
+
+protected:
+
+	int m_ring_fd;
+
+	void*  m_sq_ring_ptr;
+	size_t m_sq_ring_size;
+	void*  m_cq_ring_ptr;
+	size_t m_cq_ring_size;
+	io_uring_sqe* m_sqes;
+	size_t        m_sqes_size;
+
+	unsigned  m_sq_entries;
+	uint32_t* m_sq_khead;
+	uint32_t* m_sq_ktail;
+	uint32_t  m_sq_mask;
+	uint32_t* m_sq_array;
+
+	// SQEs handed out, and SQEs the kernel has accepted
+	uint32_t m_sqe_tail;
+	uint32_t m_sqe_submitted;
+
+	uint32_t*     m_cq_khead;
+	uint32_t*     m_cq_ktail;
+	uint32_t      m_cq_mask;
+	io_uring_cqe* m_cqes;
+};
@@ -11,7 +11,8 @@
 
 #pragma once
 
-#include <emb-lin-util/File_util.hpp>
+#include "emb-lin-util/Atomic_file_writer.hpp"
+#include "emb-lin-util/File_util.hpp"
 #include "emb-lin-util/Zlib_util.hpp"
 
 #include <nlohmann/json.hpp>
@@ -116,6 +117,7 @@ public:
 		return true;
 	}
 
+	// read, not mapped - config and state files may be truncated in place by other writers, and a mapping would SIGBUS
 	virtual bool read_cbor(const std::string& p, const bool decompress)
 	{
 		std::vector<uint8_t> file_data;
@@ -128,8 +130,14 @@ public:
 		{
 			std::deque<uint8_t> file_data_dec;
 
+			auto inflate_cb = [&file_data_dec](uint8_t const * const ptr, const size_t len)->bool
+			{
+				file_data_dec.insert(file_data_dec.end(), ptr, ptr+len);
+				return true;
+			};
+
 			Zlib_util zlib;
-			if( ! zlib.inflate_oneshot(file_data, &file_data_dec) )
+			if( ! zlib.inflate(file_data.data(), file_data.size(), inflate_cb) )
 			{
 				return false;
 			}
@@ -138,11 +146,13 @@ public:
 		}
 		else
 		{
-			from_cbor(file_data);
+			const nlohmann::json j(nlohmann::json::from_cbor(file_data.data(), file_data.data() + file_data.size()));
+			from_json(j, *dynamic_cast<T*>(this));
 		}
 
 		return true;
 	}
+	// replaced by rename so a reader never sees a partial file, mode matches what writeSmallFile used to create
 	virtual bool write_cbor(const std::string& p, const bool compress) const
 	{
 		std::vector<uint8_t> file_data = to_cbor();
@@ -159,11 +169,11 @@ public:
 				return false;
 			}
 
-			ret = File_util::writeSmallFile(p, file_data_comp);
+			ret = Atomic_file_writer::write_file(p, file_data_comp.data(), file_data_comp.size(), 0640);
 		}
 		else
 		{
-			ret = File_util::writeSmallFile(p, file_data);
+			ret = Atomic_file_writer::write_file(p, file_data.data(), file_data.size(), 0640);
 		}
 
 		return ret;
@@ -185,6 +195,7 @@ public:
 		return j.dump(4);
 	}
 
+	// read, not mapped, see read_cbor
 	virtual bool read_json(const std::string& p)
 	{
 		std::vector<uint8_t> file_data;
@@ -193,18 +204,19 @@ public:
 			return false;
 		}
 
-		const nlohmann::json j = nlohmann::json::parse(file_data);
+		const nlohmann::json j = nlohmann::json::parse(file_data.data(), file_data.data() + file_data.size());
 		from_json(j, *dynamic_cast<T*>(this));
 
 		return true;
 	}
+	// replaced by rename, see write_cbor
 	virtual bool write_json(const std::string& p) const
 	{
-		return File_util::writeSmallFile(p, to_json_string());
+		return Atomic_file_writer::write_file(p, to_json_string(), 0640);
 	}
 
 	virtual bool write_json_pretty(const std::string& p) const
 	{
-		return File_util::writeSmallFile(p, to_json_string_pretty());
+		return Atomic_file_writer::write_file(p, to_json_string_pretty(), 0640);
 	}
 };
@@ -0,0 +1,84 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Log_linear_histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+
+#include <cstdint>
+
+//
+// Fixed size, lock-free latency statistics
+// Filled by Stopwatch::lap and Stopwatch::split, or by record directly
+//
+class Lap_stats
+{
+public:
+
+	// 16 buckets per power of two, about 6% resolution
+	typedef Log_linear_histogram<4> Histogram;
+
+	struct Snapshot
+	{
+		uint64_t count;
+
+		std::chrono::nanoseconds min;
+		std::chrono::nanoseconds max;
+		std::chrono::nanoseconds mean;
+
+		// sample variance, in ns^2
+		double variance;
+
+		std::chrono::nanoseconds p50;
+		std::chrono::nanoseconds p90;
+		std::chrono::nanoseconds p99;
+		std::chrono::nanoseconds p999;
+	};
+
+	Lap_stats();
+	~Lap_stats();
+
+	// MT safe, lock-free, no allocation
+	// Negative durations are recorded as 0
+	void record(const std::chrono::nanoseconds& dt);
+
+	// MT safe
+	// Fields are read individually, so a snapshot taken while laps are recorded may be off by the in-flight laps
+	bool get_snapshot(Snapshot* const out_snapshot) const;
+
+	// MT safe
+	const Histogram& get_histogram() const
+	{
+		return m_hist;
+	}
+
+	// NOT MT safe wrt record
+	void reset();
+
+protected:
+
+	static constexpr int64_t SHIFT_UNSET = INT64_MIN;
+
+	std::atomic<uint64_t> m_count;
+
+	std::atomic<int64_t> m_min;
+	std::atomic<int64_t> m_max;
+
+	// sums are taken around the first sample to keep the variance well conditioned
+	std::atomic<int64_t> m_shift;
+	std::atomic<double>  m_sum;
+	std::atomic<double>  m_sum_sq;
+
+	Histogram m_hist;
+};
@@ -0,0 +1,161 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// HDR style histogram of uint64_t values with fixed storage
+// Values below 2^SUB_BITS get exact buckets, above that each power of two is split in 2^SUB_BITS linear buckets
+// so the relative bucket width is at most 2^-SUB_BITS
+// Recording is a relaxed atomic add, there is no allocation
+//
+template<unsigned SUB_BITS>
+class Log_linear_histogram
+{
+public:
+
+	static_assert((SUB_BITS > 0) && (SUB_BITS < 16));
+
+	static constexpr size_t NUM_SUB     = size_t(1) << SUB_BITS;
+	static constexpr size_t NUM_BUCKETS = NUM_SUB * (64 - SUB_BITS + 1);
+
+	typedef std::array<uint64_t, NUM_BUCKETS> Counts;
+
+	Log_linear_histogram()
+	{
+		reset();
+	}
+
+	// MT safe
+	void record(const uint64_t val, const uint64_t count = 1)
+	{
+		m_buckets[bucket_index(val)].fetch_add(count, std::memory_order_relaxed);
+	}
+
+	// NOT MT safe wrt record
+	void reset()
+	{
+		for(auto& b : m_buckets)
+		{
+			b.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// MT safe
+	uint64_t get_count(const size_t idx) const
+	{
+		return m_buckets[idx].load(std::memory_order_relaxed);
+	}
+
+	// MT safe
+	// Adds this histogram's buckets to out_counts
+	void accumulate(Counts* const out_counts) const
+	{
+		for(size_t i = 0; i < NUM_BUCKETS; i++)
+		{
+			(*out_counts)[i] += m_buckets[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	// MT safe
+	// Returns the upper bound of the bucket holding quantile q in [0, 1], or 0 if empty
+	uint64_t value_at_quantile(const double q) const
+	{
+		Counts counts = {};
+		accumulate(&counts);
+		return value_at_quantile(counts, q);
+	}
+
+	static uint64_t value_at_quantile(const Counts& counts, const double q)
+	{
+		uint64_t total = 0;
+		for(const uint64_t c : counts)
+		{
+			total += c;
+		}
+
+		if(total == 0)
+		{
+			return 0;
+		}
+
+		const double q_clamp = (q < 0.0) ? 0.0 : ((q > 1.0) ? 1.0 : q);
+		uint64_t rank = uint64_t(q_clamp * double(total) + 0.5);
+		if(rank == 0)
+		{
+			rank = 1;
+		}
+
+		uint64_t cum = 0;
+		for(size_t i = 0; i < NUM_BUCKETS; i++)
+		{
+			cum += counts[i];
+			if(cum >= rank)
+			{
+				return bucket_upper(i);
+			}
+		}
+
+		return bucket_upper(NUM_BUCKETS - 1);
+	}
+
+	static constexpr size_t bucket_index(const uint64_t val)
+	{
+		if(val < NUM_SUB)
+		{
+			return size_t(val);
+		}
+
+		const unsigned e   = 63U - unsigned(std::countl_zero(val));
+		const unsigned shr = e - SUB_BITS;
+		const size_t   sub = size_t(val >> shr) - NUM_SUB;
+
+		return NUM_SUB + (size_t(shr) * NUM_SUB) + sub;
+	}
+
+	// smallest value in bucket idx
+	static constexpr uint64_t bucket_lower(const size_t idx)
+	{
+		if(idx < NUM_SUB)
+		{
+			return idx;
+		}
+
+		const size_t shr = (idx - NUM_SUB) / NUM_SUB;
+		const size_t sub = (idx - NUM_SUB) % NUM_SUB;
+
+		return uint64_t(NUM_SUB + sub) << shr;
+	}
+
+	// largest value in bucket idx
+	static constexpr uint64_t bucket_upper(const size_t idx)
+	{
+		if(idx < NUM_SUB)
+		{
+			return idx;
+		}
+
+		const size_t shr = (idx - NUM_SUB) / NUM_SUB;
+
+		return bucket_lower(idx) + ((uint64_t(1) << shr) - 1U);
+	}
+
+protected:
+
+	std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets;
+};
@@ -0,0 +1,78 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Counters, histograms and Rate_meter add to a per thread stripe, so hot paths on different cores do not share a cache line
+// Reads sum the stripes and are only as consistent as a relaxed snapshot
+//
+class Metric_stripes
+{
+public:
+
+	static constexpr size_t NUM_STRIPES = 8;
+
+	static size_t get_stripe_index()
+	{
+		static std::atomic<size_t> next_index(0);
+		thread_local const size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+		return index;
+	}
+};
+
+//
+// Monotonic counter
+//
+class Metric_counter
+{
+public:
+
+	Metric_counter()
+	{
+		for(auto& s : m_stripes)
+		{
+			s.count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// MT safe, lock-free
+	void add(const uint64_t n = 1)
+	{
+		m_stripes[Metric_stripes::get_stripe_index()].count.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	// MT safe
+	uint64_t get() const
+	{
+		uint64_t sum = 0;
+		for(const auto& s : m_stripes)
+		{
+			sum += s.count.load(std::memory_order_relaxed);
+		}
+		return sum;
+	}
+
+protected:
+
+	struct alignas(64) Stripe
+	{
+		std::atomic<uint64_t> count;
+	};
+
+	std::array<Stripe, Metric_stripes::NUM_STRIPES> m_stripes;
+};
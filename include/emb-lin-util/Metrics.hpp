@@ -0,0 +1,179 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Log_linear_histogram.hpp"
+#include "emb-lin-util/Metric_counter.hpp"
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Value that can go up and down
+// A set has no meaningful per thread split, so this is a single atomic on its own cache line
+//
+class Metric_gauge
+{
+public:
+
+	Metric_gauge() : m_val(0.0)
+	{
+
+	}
+
+	// MT safe, lock-free
+	void set(const double val)
+	{
+		m_val.store(val, std::memory_order_relaxed);
+	}
+
+	// MT safe, lock-free
+	void add(const double delta)
+	{
+		double val = m_val.load(std::memory_order_relaxed);
+		while( ! m_val.compare_exchange_weak(val, val + delta, std::memory_order_relaxed) )
+		{
+
+		}
+	}
+
+	// MT safe
+	double get() const
+	{
+		return m_val.load(std::memory_order_relaxed);
+	}
+
+protected:
+
+	alignas(64) std::atomic<double> m_val;
+};
+
+//
+// Distribution of uint64_t values, eg latency in ns, on a Log_linear_histogram per stripe
+// Exported as a Prometheus summary with quantiles, the log linear buckets are too many to export as a histogram
+//
+class Metric_histogram
+{
+public:
+
+	typedef Log_linear_histogram<3> Histogram;
+
+	Metric_histogram() : m_stripes(std::make_unique<std::array<Stripe, Metric_stripes::NUM_STRIPES>>())
+	{
+		for(auto& s : *m_stripes)
+		{
+			s.sum.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// MT safe, lock-free
+	void record(const uint64_t val)
+	{
+		Stripe& s = (*m_stripes)[Metric_stripes::get_stripe_index()];
+		s.hist.record(val);
+		s.sum.fetch_add(val, std::memory_order_relaxed);
+	}
+
+	// MT safe
+	// Adds all stripes to out_counts and returns the sum of recorded values
+	uint64_t accumulate(Histogram::Counts* const out_counts) const
+	{
+		uint64_t sum = 0;
+		for(const auto& s : *m_stripes)
+		{
+			s.hist.accumulate(out_counts);
+			sum += s.sum.load(std::memory_order_relaxed);
+		}
+		return sum;
+	}
+
+protected:
+
+	struct alignas(64) Stripe
+	{
+		Histogram hist;
+		alignas(64) std::atomic<uint64_t> sum;
+	};
+
+	// several KiB, keep it off the stack and out of the registry map nodes
+	std::unique_ptr<std::array<Stripe, Metric_stripes::NUM_STRIPES>> m_stripes;
+};
+
+//
+// Named metrics, rendered in the Prometheus text exposition format
+// Registration takes a lock, updates through the returned pointers do not
+//
+class Metrics_registry
+{
+public:
+
+	typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+	Metrics_registry();
+	~Metrics_registry();
+
+	// MT safe
+	// Returns the existing metric if name and labels were already registered with the same type
+	// Returns null if the name is registered with another type, or a name or label key is not a valid Prometheus name
+	std::shared_ptr<Metric_counter>   get_counter(const std::string& name,   const std::string& help, const Labels& labels = Labels());
+	std::shared_ptr<Metric_gauge>     get_gauge(const std::string& name,     const std::string& help, const Labels& labels = Labels());
+	std::shared_ptr<Metric_histogram> get_histogram(const std::string& name, const std::string& help, const Labels& labels = Labels());
+
+	// MT safe
+	void remove(const std::string& name, const Labels& labels = Labels());
+
+	// MT safe
+	// Appends a snapshot of every metric to out_text
+	void render_prometheus(std::string* const out_text) const;
+
+	static bool is_valid_name(const std::string& name);
+
+protected:
+
+	enum class Type
+	{
+		COUNTER,
+		GAUGE,
+		HISTOGRAM
+	};
+
+	struct Family
+	{
+		Type type;
+		std::string help;
+
+		// rendered label set -> metric, only the member matching type is set
+		struct Member
+		{
+			std::shared_ptr<Metric_counter>   counter;
+			std::shared_ptr<Metric_gauge>     gauge;
+			std::shared_ptr<Metric_histogram> histogram;
+		};
+		std::map<std::string, Member> members;
+	};
+
+	Family::Member* get_member(const std::string& name, const std::string& help, const Labels& labels, const Type type);
+
+	static bool render_labels(const Labels& labels, std::string* const out_text);
+
+	mutable std::mutex m_mutex;
+	std::map<std::string, Family> m_families;
+};
@@ -0,0 +1,72 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Interval_timer_fd.hpp"
+#include "emb-lin-util/Metrics.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+//
+// Background thread that periodically renders a Metrics_registry in the Prometheus text format
+// File output is written to path.tmp and renamed over path, so readers like the node_exporter textfile collector never see a partial file
+// Socket output connects to a SOCK_STREAM unix socket, writes one snapshot and closes, eg for a local collector
+//
+class Metrics_exporter : public Thread_base
+{
+public:
+
+	Metrics_exporter();
+	~Metrics_exporter() override;
+
+	// NOT MT safe - only call if the thread is not running
+	// Arms the export timer, must be called before each launch since interrupt cancels it
+	bool init(const std::shared_ptr<const Metrics_registry>& registry, const std::chrono::nanoseconds& period);
+
+	// NOT MT safe - only call if the thread is not running
+	// Either or both may be set, an empty path disables that output
+	void set_file_path(const std::string& path)
+	{
+		m_file_path = path;
+	}
+	void set_socket_path(const std::string& path)
+	{
+		m_socket_path = path;
+	}
+
+	// NOT MT safe wrt the thread
+	// Render and write one snapshot now
+	bool export_now();
+
+	// MT safe
+	void interrupt() override;
+
+protected:
+
+	void work() override;
+
+	bool write_file(const std::string& text) const;
+	bool write_socket(const std::string& text) const;
+
+	std::shared_ptr<const Metrics_registry> m_registry;
+
+	Interval_timer_fd m_timer;
+
+	std::string m_file_path;
+	std::string m_socket_path;
+
+	// reused between exports
+	std::string m_text;
+};
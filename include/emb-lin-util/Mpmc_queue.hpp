@@ -0,0 +1,406 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Futex_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Bounded lock free multi producer multi consumer queue, after Dmitry Vyukov's array queue
+// Each cell carries a sequence number, so producers and consumers only contend on their own index CAS
+// Capacity is rounded up to a power of two, storage is allocated once in the constructor
+//
+// When full, push follows the Overflow_policy
+// Blocking waits spin for get_spin_count() iterations then sleep on a futex
+// To stop a blocked Thread_base, override interrupt() to also call notify_cancel()
+//
+template <typename T>
+class Mpmc_queue
+{
+public:
+
+	enum class Overflow_policy
+	{
+		BLOCK,       // push waits for space
+		DROP_OLDEST, // push discards the head of the queue to make room
+		DROP_NEWEST  // push discards the new element
+	};
+
+	static constexpr uint32_t DEFAULT_SPIN_COUNT = 256;
+
+	Mpmc_queue(const size_t capacity, const Overflow_policy policy = Overflow_policy::BLOCK) : m_mask(round_up_pow2(capacity) - 1U), m_cells(new Cell[m_mask + 1U]), m_policy(policy), m_spin_count(get_default_spin_count()), m_enq_pos(0), m_deq_pos(0), m_dropped(0), m_pending_cancel(false)
+	{
+		for(size_t i = 0; i <= m_mask; i++)
+		{
+			m_cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	Mpmc_queue(const Mpmc_queue&) = delete;
+	Mpmc_queue& operator=(const Mpmc_queue&) = delete;
+
+	// spinning only helps if the other side can run at the same time
+	static uint32_t get_default_spin_count()
+	{
+		return (std::thread::hardware_concurrency() > 1) ? DEFAULT_SPIN_COUNT : 0;
+	}
+
+	size_t capacity() const
+	{
+		return m_mask + 1U;
+	}
+
+	Overflow_policy get_policy() const
+	{
+		return m_policy;
+	}
+
+	// NOT MT safe, set before use
+	void set_spin_count(const uint32_t spin_count)
+	{
+		m_spin_count = spin_count;
+	}
+	uint32_t get_spin_count() const
+	{
+		return m_spin_count;
+	}
+
+	// MT safe, approximate under contention
+	size_t size() const
+	{
+		const size_t enq = m_enq_pos.load(std::memory_order_acquire);
+		const size_t deq = m_deq_pos.load(std::memory_order_acquire);
+		return (enq > deq) ? (enq - deq) : 0;
+	}
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	// MT safe
+	// Pushes that have claimed a slot so far, elements are popped in this order
+	// So once n elements have been popped, every push counted in an earlier get_enqueue_count() == n has been popped
+	uint64_t get_enqueue_count() const
+	{
+		return m_enq_pos.load(std::memory_order_acquire);
+	}
+
+	// MT safe
+	// Elements discarded by DROP_OLDEST / DROP_NEWEST
+	uint64_t get_dropped_count() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+	// MT safe
+	// Never blocks or drops, returns false if full
+	bool try_push(const T& val)
+	{
+		return emplace_one([&val](T* const slot){ *slot = val; });
+	}
+	bool try_push(T&& val)
+	{
+		return emplace_one([&val](T* const slot){ *slot = std::move(val); });
+	}
+
+	// MT safe
+	// BLOCK       - waits for space, false on timeout or cancelation
+	// DROP_OLDEST - always enqueues, discarding from the head as needed
+	// DROP_NEWEST - false if full and val was discarded
+	bool push(const T& val, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		return push_impl([&val](T* const slot){ *slot = val; }, timeout);
+	}
+	bool push(T&& val, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		return push_impl([&val](T* const slot){ *slot = std::move(val); }, timeout);
+	}
+
+	// MT safe
+	bool try_pop(T* const out_val)
+	{
+		size_t pos = m_deq_pos.load(std::memory_order_relaxed);
+		Cell* cell = nullptr;
+		for(;;)
+		{
+			cell = &m_cells[pos & m_mask];
+			const size_t seq = cell->seq.load(std::memory_order_acquire);
+			const intptr_t dif = intptr_t(seq) - intptr_t(pos + 1U);
+			if(dif == 0)
+			{
+				if(m_deq_pos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(dif < 0)
+			{
+				// cell not written yet - empty
+				return false;
+			}
+			else
+			{
+				pos = m_deq_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		*out_val = std::move(cell->val);
+		cell->seq.store(pos + m_mask + 1U, std::memory_order_release);
+
+		if(m_policy == Overflow_policy::BLOCK)
+		{
+			m_not_full.notify_all();
+		}
+
+		return true;
+	}
+
+	// MT safe
+	// Waits while empty
+	// Returns false on timeout, or on cancelation once the queue is empty
+	bool pop(T* const out_val, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		if(try_pop(out_val))
+		{
+			return true;
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		const timespec* const deadline_ptr = has_deadline ? &deadline : nullptr;
+		for(;;)
+		{
+			// wait on the head cell, not size() - a claimed but unpublished push makes size() nonzero while try_pop fails
+			if( ! wait_until(m_not_empty, [this](){ return is_head_readable(); }, deadline_ptr) )
+			{
+				return try_pop(out_val);
+			}
+
+			if(try_pop(out_val))
+			{
+				return true;
+			}
+
+			// lost the head to another consumer
+			if(Futex_util::is_expired(deadline_ptr) || is_cancel_requested())
+			{
+				return try_pop(out_val);
+			}
+		}
+	}
+
+	// MT safe
+	// Wakes all waiters, later waits return false instead of blocking
+	// This cancelation is latching
+	void notify_cancel()
+	{
+		m_pending_cancel.store(true, std::memory_order_release);
+		m_not_empty.notify_all();
+		m_not_full.notify_all();
+	}
+	bool is_cancel_requested() const
+	{
+		return m_pending_cancel.load(std::memory_order_acquire);
+	}
+
+protected:
+
+	struct Cell
+	{
+		std::atomic<size_t> seq;
+		T val;
+	};
+
+	static size_t round_up_pow2(const size_t n)
+	{
+		size_t out = 2;
+		while(out < n)
+		{
+			out <<= 1;
+		}
+		return out;
+	}
+
+	template <typename Fill>
+	bool emplace_one(const Fill& fill)
+	{
+		size_t pos = m_enq_pos.load(std::memory_order_relaxed);
+		Cell* cell = nullptr;
+		for(;;)
+		{
+			cell = &m_cells[pos & m_mask];
+			const size_t seq = cell->seq.load(std::memory_order_acquire);
+			const intptr_t dif = intptr_t(seq) - intptr_t(pos);
+			if(dif == 0)
+			{
+				if(m_enq_pos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(dif < 0)
+			{
+				// cell not consumed from the last lap yet - full
+				return false;
+			}
+			else
+			{
+				pos = m_enq_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		fill(&cell->val);
+		cell->seq.store(pos + 1U, std::memory_order_release);
+
+		m_not_empty.notify_all();
+
+		return true;
+	}
+
+	template <typename Fill>
+	bool push_impl(const Fill& fill, const std::chrono::nanoseconds& timeout)
+	{
+		if(emplace_one(fill))
+		{
+			return true;
+		}
+
+		switch(m_policy)
+		{
+			case Overflow_policy::DROP_NEWEST:
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			case Overflow_policy::DROP_OLDEST:
+			{
+				T discard;
+				do
+				{
+					if(try_pop(&discard))
+					{
+						m_dropped.fetch_add(1, std::memory_order_relaxed);
+					}
+				} while( ! emplace_one(fill) );
+				return true;
+			}
+			case Overflow_policy::BLOCK:
+			default:
+			{
+				break;
+			}
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		const timespec* const deadline_ptr = has_deadline ? &deadline : nullptr;
+		for(;;)
+		{
+			// wait on the tail cell, not size() - a claimed but unfinished pop makes size() < capacity() while emplace_one fails
+			if( ! wait_until(m_not_full, [this](){ return is_tail_writable(); }, deadline_ptr) )
+			{
+				return false;
+			}
+
+			if(emplace_one(fill))
+			{
+				return true;
+			}
+
+			// lost the tail to another producer
+			if(Futex_util::is_expired(deadline_ptr) || is_cancel_requested())
+			{
+				return false;
+			}
+		}
+	}
+
+	// the next pop's cell has been published
+	bool is_head_readable() const
+	{
+		const size_t pos = m_deq_pos.load(std::memory_order_acquire);
+		return m_cells[pos & m_mask].seq.load(std::memory_order_acquire) == (pos + 1U);
+	}
+
+	// the next push's cell has been released by its last consumer
+	bool is_tail_writable() const
+	{
+		const size_t pos = m_enq_pos.load(std::memory_order_acquire);
+		return m_cells[pos & m_mask].seq.load(std::memory_order_acquire) == pos;
+	}
+
+	// Returns true when ready() holds, false on timeout or cancelation
+	template <typename Pred>
+	bool wait_until(Futex_event_count& ec, const Pred& ready, const timespec* const deadline)
+	{
+		for(uint32_t i = 0; i < m_spin_count; i++)
+		{
+			if(ready())
+			{
+				return true;
+			}
+			if(is_cancel_requested())
+			{
+				return false;
+			}
+			Futex_util::cpu_relax();
+		}
+
+		for(;;)
+		{
+			if(ready())
+			{
+				return true;
+			}
+			if(is_cancel_requested())
+			{
+				return false;
+			}
+
+			const uint32_t key = ec.prepare_wait();
+			if(ready() || is_cancel_requested())
+			{
+				ec.cancel_wait();
+				continue;
+			}
+
+			if( ! ec.commit_wait(key, deadline) )
+			{
+				return ready();
+			}
+		}
+	}
+
+	// read only after construction
+	const size_t m_mask;
+	const std::unique_ptr<Cell[]> m_cells;
+	const Overflow_policy m_policy;
+	uint32_t m_spin_count;
+
+	alignas(64) std::atomic<size_t> m_enq_pos;
+	alignas(64) std::atomic<size_t> m_deq_pos;
+
+	alignas(64) Futex_event_count m_not_empty;
+	Futex_event_count m_not_full;
+	std::atomic<uint64_t> m_dropped;
+	std::atomic<bool> m_pending_cancel;
+};
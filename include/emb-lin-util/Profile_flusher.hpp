@@ -0,0 +1,90 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Profiler.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+
+//
+// Background thread that drains the Profiler buffers to a file
+//
+// CHROME_JSON is the chrome://tracing / Perfetto JSON trace format
+// BINARY is a compact stream:
+//   header  - "EMBPROF" '\0', u32 version
+//   name    - u8 0, u32 name_id, u16 len, char[len]
+//   event   - u8 1, u8 type, u32 tid, u32 name_id, i64 t_ns
+// all integers are native endian
+//
+class Profile_flusher : public Thread_base
+{
+public:
+
+	enum class Format
+	{
+		CHROME_JSON,
+		BINARY
+	};
+
+	Profile_flusher();
+	~Profile_flusher() override;
+
+	// NOT MT safe
+	void set_flush_period(const std::chrono::nanoseconds& dt)
+	{
+		m_flush_period = dt;
+	}
+
+	// NOT MT safe
+	bool open(const std::string& path, const Format format);
+
+	// NOT MT safe - only call if the thread is not running
+	// Drain all buffers to the file
+	bool flush();
+
+	// NOT MT safe - only call if the thread is not running
+	// Flush, finish the file and close it
+	bool close();
+
+	// MT safe
+	// Events dropped because a thread's buffer was full, see Profiler::get_dropped_count
+	uint64_t get_dropped_count() const;
+
+protected:
+
+	void work() override;
+
+	void format_event(const Profile_event& ev, const uint32_t tid);
+	uint32_t get_name_id(char const * const name);
+
+	bool write_out();
+
+	int    m_fd;
+	Format m_format;
+	bool   m_first_event;
+	int    m_pid;
+
+	std::chrono::nanoseconds m_flush_period;
+
+	// reused between flushes
+	std::vector<std::shared_ptr<Profile_buffer>> m_buffers;
+	std::vector<Profile_event> m_events;
+	std::string m_out;
+
+	std::unordered_map<char const *, uint32_t> m_name_ids;
+};
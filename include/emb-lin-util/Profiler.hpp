@@ -0,0 +1,198 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+struct Profile_event
+{
+	enum class Type : uint8_t
+	{
+		BEGIN = 0,
+		END   = 1
+	};
+
+	// must be a string with static storage, eg a literal
+	char const * name;
+	// CLOCK_MONOTONIC
+	int64_t      t_ns;
+	Type         type;
+};
+
+//
+// Per thread event ring
+// Written only by the owning thread, read only by the flusher
+//
+class Profile_buffer
+{
+public:
+
+	static constexpr size_t CAPACITY = 16384;
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0);
+
+	explicit Profile_buffer(const uint32_t tid) : m_tid(tid), m_head(0), m_tail(0), m_dropped(0), m_thread_exited(false)
+	{
+
+	}
+
+	// owning thread only
+	// drops the event if full
+	void push(const Profile_event& ev)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		const size_t tail = m_tail.load(std::memory_order_acquire);
+
+		if((head - tail) >= CAPACITY)
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		m_events[head & (CAPACITY - 1)] = ev;
+		m_head.store(head + 1, std::memory_order_release);
+	}
+
+	// flusher only
+	// appends pending events to out_events, returns number appended
+	size_t drain(std::vector<Profile_event>* const out_events)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		const size_t head = m_head.load(std::memory_order_acquire);
+
+		for(size_t i = tail; i != head; i++)
+		{
+			out_events->push_back(m_events[i & (CAPACITY - 1)]);
+		}
+
+		m_tail.store(head, std::memory_order_release);
+
+		return head - tail;
+	}
+
+	bool is_empty() const
+	{
+		return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+	}
+
+	uint32_t get_tid() const
+	{
+		return m_tid;
+	}
+
+	uint64_t get_dropped() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+	bool has_thread_exited() const
+	{
+		return m_thread_exited.load(std::memory_order_acquire);
+	}
+	void set_thread_exited()
+	{
+		m_thread_exited.store(true, std::memory_order_release);
+	}
+
+protected:
+
+	const uint32_t m_tid;
+
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+
+	alignas(64) std::atomic<uint64_t> m_dropped;
+	std::atomic<bool> m_thread_exited;
+
+	std::array<Profile_event, CAPACITY> m_events;
+};
+
+//
+// Process wide registry of per thread buffers
+//
+class Profiler
+{
+public:
+
+	// MT safe
+	// Recording is disabled by default
+	static void set_enabled(const bool enable)
+	{
+		m_enabled.store(enable, std::memory_order_relaxed);
+	}
+	static bool is_enabled()
+	{
+		return m_enabled.load(std::memory_order_relaxed);
+	}
+
+	// MT safe
+	// No locks or allocation, except the first event on a thread allocates and registers its buffer
+	static void record(char const * const name, const Profile_event::Type type);
+
+	// MT safe
+	// Copies the list of registered buffers
+	static void get_buffers(std::vector<std::shared_ptr<Profile_buffer>>* const out_buffers);
+
+	// MT safe
+	// Unregisters empty buffers whose thread has exited, keeping their dropped counts
+	static void prune_buffers();
+
+	// MT safe
+	// Events dropped because a thread's buffer was full, over all threads including pruned ones
+	static uint64_t get_dropped_count();
+
+protected:
+
+	static std::atomic<bool> m_enabled;
+
+	// dropped counts of pruned buffers, written under the registry lock
+	static std::atomic<uint64_t> m_pruned_dropped;
+
+	static Profile_buffer* register_thread();
+};
+
+//
+// RAII zone, records a begin event on construction and an end event on destruction
+//
+class Profile_zone
+{
+public:
+	explicit Profile_zone(char const * const name) : m_name(name)
+	{
+		Profiler::record(m_name, Profile_event::Type::BEGIN);
+	}
+	~Profile_zone()
+	{
+		Profiler::record(m_name, Profile_event::Type::END);
+	}
+
+	Profile_zone(const Profile_zone&) = delete;
+	Profile_zone& operator=(const Profile_zone&) = delete;
+
+protected:
+	char const * const m_name;
+};
+
+#define EMB_PROFILE_CONCAT_INNER(a, b) a ## b
+#define EMB_PROFILE_CONCAT(a, b) EMB_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef EMB_LIN_UTIL_DISABLE_PROFILING
+	#define EMB_PROFILE_ZONE(name)
+#else
+	// name must be a string literal
+	#define EMB_PROFILE_ZONE(name) const Profile_zone EMB_PROFILE_CONCAT(emb_profile_zone_, __LINE__)(name)
+#endif
@@ -0,0 +1,132 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <ratio>
+
+#include <cstdint>
+
+//
+// Generic cell rate algorithm, a leaky bucket as a meter
+// State is one theoretical arrival time (TAT) updated by CAS, so the limiter may be shared by threads without a lock
+// A request for n tokens conforms if it would not put the TAT more than tolerance + n * emission_interval ahead of now
+//
+class Gcra_limiter
+{
+public:
+
+	static constexpr int64_t INTERVAL_UNITS_PER_NS = 65536;
+
+	// time per token in 1/65536 ns, so rates that are not a whole ns per token, eg bytes at 400 MB/s, stay exact
+	// nanoseconds and coarser durations convert implicitly, up to about 39 hours
+	typedef std::chrono::duration<int64_t, std::ratio<1, 1000000000LL * INTERVAL_UNITS_PER_NS>> Interval;
+
+	// emission_interval - time per token, at least 1 unit
+	// burst             - tokens that may be taken at once after being idle, at least 1
+	Gcra_limiter(const Interval& emission_interval, const uint64_t burst);
+	~Gcra_limiter();
+
+	// MT safe, lock-free
+	// true if n tokens were taken
+	bool try_acquire(const uint64_t n = 1);
+
+	// MT safe, lock-free
+	// Reserves n tokens and sleeps until they are available
+	// Reservations are served in the order they are made, n may exceed burst
+	// false on clock error
+	bool acquire(const uint64_t n = 1);
+
+	// MT safe
+	// Time until n tokens would be available, zero if available now
+	bool get_wait_time(const uint64_t n, std::chrono::nanoseconds* const out_dt) const;
+
+	// MT safe
+	// Tokens that could be taken now
+	bool get_available(double* const out_tokens) const;
+
+	Interval get_emission_interval() const
+	{
+		return m_emission_interval;
+	}
+
+	uint64_t get_burst() const
+	{
+		return m_burst;
+	}
+
+protected:
+
+	// keeps max(tat, now) + cost from overflowing
+	static constexpr int64_t MAX_COST_NS = std::numeric_limits<int64_t>::max() / 4;
+
+	static bool get_time(int64_t* const out_ns);
+	static bool sleep_until(const int64_t t_ns);
+
+	// time for n tokens in whole ns, rounded up so the rate is never exceeded, saturates at MAX_COST_NS
+	// a call costs at least 1 ns, so above 1e9 tokens/s take several tokens per call
+	int64_t get_cost_ns(const uint64_t n) const;
+
+	const Interval m_emission_interval;
+	const uint64_t m_burst;
+
+	// get_cost_ns(burst)
+	const int64_t m_limit_ns;
+
+	// CLOCK_MONOTONIC ns
+	std::atomic<int64_t> m_tat;
+};
+
+//
+// Token bucket, filled at rate tokens per second up to capacity
+// This is the same algorithm as Gcra_limiter with token bucket parameters
+//
+class Token_bucket
+{
+public:
+	// rate tokens per second, NaN, <= 0 or slower than one token per Interval::max() gets the slowest rate
+	explicit Token_bucket(const double rate, const uint64_t capacity) : m_gcra(rate_to_interval(rate), capacity)
+	{
+
+	}
+
+	static Gcra_limiter::Interval rate_to_interval(const double rate);
+
+	// MT safe, lock-free
+	bool try_acquire(const uint64_t n = 1)
+	{
+		return m_gcra.try_acquire(n);
+	}
+
+	// MT safe, lock-free
+	bool acquire(const uint64_t n = 1)
+	{
+		return m_gcra.acquire(n);
+	}
+
+	// MT safe
+	bool get_available(double* const out_tokens) const
+	{
+		return m_gcra.get_available(out_tokens);
+	}
+
+	// MT safe
+	bool get_wait_time(const uint64_t n, std::chrono::nanoseconds* const out_dt) const
+	{
+		return m_gcra.get_wait_time(n, out_dt);
+	}
+
+protected:
+	Gcra_limiter m_gcra;
+};
@@ -0,0 +1,120 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Metric_counter.hpp"
+#include "emb-lin-util/Stopwatch.hpp"
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Event rate meter with exponentially weighted 1s, 10s and 60s averages
+// Any number of threads may mark, a single reader takes snapshots
+// Averages are updated when a snapshot is taken, using the actual time since the last snapshot
+//
+class Rate_meter
+{
+public:
+
+	struct Snapshot
+	{
+		// marked since construction or the last reset
+		uint64_t count;
+
+		// events per second
+		double rate_1s;
+		double rate_10s;
+		double rate_60s;
+		double mean_rate;
+	};
+
+	Rate_meter();
+	~Rate_meter();
+
+	// MT safe, lock-free
+	// Adds to a per thread stripe so producers on different cores do not share a cache line
+	void mark(const uint64_t n = 1)
+	{
+		m_count.add(n);
+	}
+
+	// MT safe
+	// total marked since construction, reset does not clear it
+	uint64_t get_count() const
+	{
+		return m_count.get();
+	}
+
+	// NOT MT safe wrt other snapshot / reset calls
+	bool snapshot(Snapshot* const out_snapshot);
+
+	// NOT MT safe wrt other snapshot / reset calls
+	// Restarts the averages and the snapshot count, get_count is not affected
+	bool reset();
+
+protected:
+
+	Metric_counter m_count;
+
+	// reader state
+	Stopwatch m_total_sw;
+	Stopwatch m_tick_sw;
+	uint64_t  m_count_at_reset;
+	uint64_t  m_last_count;
+	bool      m_primed;
+	std::array<double, 3> m_rates;
+};
+
+//
+// Messages and bytes per second
+//
+class Throughput_meter
+{
+public:
+
+	struct Snapshot
+	{
+		Rate_meter::Snapshot msgs;
+		Rate_meter::Snapshot bytes;
+	};
+
+	// MT safe, lock-free
+	void mark(const uint64_t num_msgs, const uint64_t num_bytes)
+	{
+		m_msgs.mark(num_msgs);
+		m_bytes.mark(num_bytes);
+	}
+
+	// NOT MT safe wrt other snapshot / reset calls
+	bool snapshot(Snapshot* const out_snapshot)
+	{
+		if( ! out_snapshot )
+		{
+			return false;
+		}
+
+		return m_msgs.snapshot(&out_snapshot->msgs) && m_bytes.snapshot(&out_snapshot->bytes);
+	}
+
+	// NOT MT safe wrt other snapshot / reset calls
+	bool reset()
+	{
+		return m_msgs.reset() && m_bytes.reset();
+	}
+
+protected:
+	Rate_meter m_msgs;
+	Rate_meter m_bytes;
+};
@@ -0,0 +1,182 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Mpmc_queue.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Append-only record log for high rate telemetry
+// Each record is framed as [u32 len][u32 crc32 of len and payload][payload], host byte order
+// Producers frame and crc their record and hand it to an Mpmc_queue, the writer thread drains it and writes each batch with one pwritev
+//
+// Records go to segments named prefix.NNNNNNNNNN.log in dir, preallocated with fallocate to the segment size
+// A segment is sealed by truncating it to its data, on rotation by size or age and on close
+// So on open only the newest segment needs scanning, up to the first zero, short or bad crc frame
+// Anything after that is a torn write and is zeroed so later appends cannot run into stale frames
+//
+// If a new segment cannot be created the batch is dropped and the next batch tries again, past any stale file in the way
+//
+// A record is durable once flush returns if set_sync is on, otherwise once the page cache writes it back
+//
+class Record_log : public Thread_base
+{
+public:
+
+	static constexpr size_t HEADER_SIZE = 8;
+
+	// return false to stop the scan
+	typedef std::function<bool(uint8_t const * const ptr, const size_t len)> Record_callback;
+
+	explicit Record_log(const size_t queue_capacity = 4096);
+	~Record_log() override;
+
+	// NOT MT safe - call before open
+	// Rotate once a segment reaches this many bytes, a record larger than this gets a segment of its own
+	void set_segment_size(const uint64_t bytes)
+	{
+		m_segment_size = bytes;
+	}
+
+	// NOT MT safe - call before open
+	// Rotate a segment with data once it is this old, zero disables
+	void set_rotate_period(const std::chrono::nanoseconds& dt)
+	{
+		m_rotate_period = dt;
+	}
+
+	// NOT MT safe - call before open
+	// Delete the oldest segments beyond this count, zero keeps everything
+	void set_max_segments(const size_t n)
+	{
+		m_max_segments = n;
+	}
+
+	// NOT MT safe - call before open
+	// fdatasync after each batch, so one sync covers every record drained together
+	void set_sync(const bool sync)
+	{
+		m_sync = sync;
+	}
+
+	// NOT MT safe - call before open
+	void set_max_record_size(const size_t bytes)
+	{
+		m_max_record_size = bytes;
+	}
+
+	// NOT MT safe - call before launch
+	// Recovers the newest segment of prefix in dir and appends to it, or starts the first one
+	bool open(const std::string& dir, const std::string& prefix);
+
+	// NOT MT safe - call after join
+	// Writes anything still queued and seals the segment
+	void close();
+
+	// MT safe, lock free
+	// Returns false if the record is empty, too large, or the staging queue is full, the record is dropped in that case
+	bool append(uint8_t const * const ptr, const size_t len);
+	bool append(const std::vector<uint8_t>& data)
+	{
+		return append(data.data(), data.size());
+	}
+
+	// MT safe
+	// Waits until everything appended before the call is written, false on timeout or if the writer stopped
+	bool flush(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max());
+
+	// MT safe
+	uint64_t get_written_count() const
+	{
+		return m_written.load(std::memory_order_relaxed);
+	}
+	// rejected by append, or abandoned because no segment could be opened
+	uint64_t get_dropped_count() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+	uint64_t get_write_error_count() const
+	{
+		return m_write_errors.load(std::memory_order_relaxed);
+	}
+
+	// MT safe
+	void interrupt() override;
+
+	// MT safe
+	// Segment paths of prefix in dir, oldest first
+	static bool list_segments(const std::string& dir, const std::string& prefix, std::vector<std::string>* const out_paths);
+
+	// MT safe, including on the live segment
+	// Calls cb for each valid record in order, out_valid_len is the length of the valid prefix
+	// payload pointers are only valid during the callback
+	// Stopping at a bad frame is not an error, only failing to read the file is
+	static bool scan_segment(const std::string& path, const Record_callback& cb, uint64_t* const out_valid_len = nullptr, const size_t max_record_size = 1024U * 1024U);
+
+protected:
+
+	void work() override;
+
+	void write_batch(std::vector<std::vector<uint8_t>>* const batch);
+	bool write_iov(const struct iovec* iov, size_t iovcnt);
+
+	bool open_segment(const uint64_t index);
+	bool recover_segment(const uint64_t index);
+	bool rotate();
+	bool open_next_segment();
+	void seal_segment();
+	void apply_retention();
+
+	std::string get_segment_path(const uint64_t index) const;
+
+	static int64_t get_now_ns();
+
+	uint64_t m_segment_size;
+	std::chrono::nanoseconds m_rotate_period;
+	size_t m_max_segments;
+	bool m_sync;
+	size_t m_max_record_size;
+
+	std::string m_dir;
+	std::string m_prefix;
+
+	// writer thread only after launch
+	int m_fd;
+	uint64_t m_offset;
+	int64_t m_segment_start_ns;
+	std::deque<uint64_t> m_segments;
+
+	// whole frames, header included
+	Mpmc_queue<std::vector<uint8_t>> m_queue;
+
+	// records popped from m_queue whose batch finished, written or not
+	std::atomic<uint64_t> m_processed;
+	std::atomic<uint64_t> m_written;
+	std::atomic<uint64_t> m_dropped;
+	std::atomic<uint64_t> m_write_errors;
+
+	// bumped after each batch, flush sleeps on it
+	std::atomic<uint32_t> m_written_seq;
+	std::atomic<uint32_t> m_written_waiters;
+};
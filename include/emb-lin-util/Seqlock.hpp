@@ -0,0 +1,205 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Futex_util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//
+// Codec for trivially copyable types, the value is stored as its bytes
+//
+template <typename T>
+struct Seqlock_trivial_codec
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Seqlock_trivial_codec needs a trivially copyable type, use another codec");
+
+	static constexpr size_t MAX_SIZE   = sizeof(T);
+	static constexpr bool   FIXED_SIZE = true;
+
+	static bool encode(const T& val, uint8_t* const out_buf, size_t* const out_len)
+	{
+		memcpy(out_buf, &val, sizeof(T));
+		*out_len = sizeof(T);
+		return true;
+	}
+
+	static bool decode(uint8_t const * const buf, const size_t len, T* const out_val)
+	{
+		if(len != sizeof(T))
+		{
+			return false;
+		}
+
+		memcpy(out_val, buf, sizeof(T));
+		return true;
+	}
+};
+
+//
+// Latest value cell for one writer and any number of readers
+// The writer never waits for readers, readers retry if they overlap a write and never see a torn value
+//
+// The value is kept as codec encoded bytes in atomic words, so the racing copy is well defined
+// Readers decode only after the copy is validated, so codecs for non trivial types (eg Seqlock_cbor_codec) never see partial data
+//
+template <typename T, typename Codec = Seqlock_trivial_codec<T>>
+class Seqlock
+{
+public:
+
+	Seqlock() : m_seq(0), m_len(0)
+	{
+		for(auto& w : m_words)
+		{
+			w.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	explicit Seqlock(const T& val) : Seqlock()
+	{
+		store(val);
+	}
+
+	Seqlock(const Seqlock&) = delete;
+	Seqlock& operator=(const Seqlock&) = delete;
+
+	// Single writer
+	// false if the codec fails, eg the encoding is larger than Codec::MAX_SIZE
+	bool store(const T& val)
+	{
+		size_t len = 0;
+		if( ! Codec::encode(val, reinterpret_cast<uint8_t*>(m_scratch.data()), &len) )
+		{
+			return false;
+		}
+
+		const uint64_t seq = m_seq.load(std::memory_order_relaxed);
+
+		m_seq.store(seq + 1U, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		if constexpr( ! Codec::FIXED_SIZE )
+		{
+			m_len.store(len, std::memory_order_relaxed);
+		}
+
+		const size_t num_words = (len + sizeof(uint64_t) - 1U) / sizeof(uint64_t);
+		for(size_t i = 0; i < num_words; i++)
+		{
+			m_words[i].store(m_scratch[i], std::memory_order_relaxed);
+		}
+
+		m_seq.store(seq + 2U, std::memory_order_release);
+
+		return true;
+	}
+
+	// MT safe, retries while a write is in progress
+	// false if nothing was stored yet or the codec fails
+	bool load(T* const out_val) const
+	{
+		std::array<uint64_t, NUM_WORDS> buf;
+		size_t len = 0;
+		while( ! try_copy(&buf, &len) )
+		{
+			Futex_util::cpu_relax();
+		}
+
+		if(len == 0)
+		{
+			return false;
+		}
+
+		return Codec::decode(reinterpret_cast<uint8_t const *>(buf.data()), len, out_val);
+	}
+
+	// MT safe, a single attempt
+	// false if nothing was stored yet, a write overlapped, or the codec fails
+	bool try_load(T* const out_val) const
+	{
+		std::array<uint64_t, NUM_WORDS> buf;
+		size_t len = 0;
+		if( ! try_copy(&buf, &len) || (len == 0) )
+		{
+			return false;
+		}
+
+		return Codec::decode(reinterpret_cast<uint8_t const *>(buf.data()), len, out_val);
+	}
+
+	// MT safe
+	// Incremented by each store, readers can poll this to skip unchanged values
+	uint64_t get_version() const
+	{
+		return m_seq.load(std::memory_order_acquire) / 2U;
+	}
+
+protected:
+
+	static constexpr size_t NUM_WORDS = (Codec::MAX_SIZE + sizeof(uint64_t) - 1U) / sizeof(uint64_t);
+
+	bool try_copy(std::array<uint64_t, NUM_WORDS>* const out_buf, size_t* const out_len) const
+	{
+		const uint64_t seq0 = m_seq.load(std::memory_order_acquire);
+		if(seq0 & 1U)
+		{
+			return false;
+		}
+
+		if(seq0 == 0)
+		{
+			*out_len = 0;
+			return true;
+		}
+
+		size_t len = Codec::MAX_SIZE;
+		if constexpr( ! Codec::FIXED_SIZE )
+		{
+			// may be torn, clamp so the copy stays in bounds, the seq check below rejects it
+			len = std::min<size_t>(m_len.load(std::memory_order_relaxed), Codec::MAX_SIZE);
+		}
+
+		const size_t num_words = (len + sizeof(uint64_t) - 1U) / sizeof(uint64_t);
+		for(size_t i = 0; i < num_words; i++)
+		{
+			(*out_buf)[i] = m_words[i].load(std::memory_order_relaxed);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t seq1 = m_seq.load(std::memory_order_relaxed);
+		if(seq0 != seq1)
+		{
+			return false;
+		}
+
+		*out_len = len;
+		return true;
+	}
+
+	// odd while a store is in progress, 0 only before the first store
+	// 64 bit so it never wraps back to 0, a 32 bit count would after 2^31 stores
+	static_assert(std::atomic<uint64_t>::is_always_lock_free);
+	std::atomic<uint64_t> m_seq;
+	std::atomic<size_t>   m_len;
+	std::array<std::atomic<uint64_t>, NUM_WORDS> m_words;
+
+	// writer only
+	std::array<uint64_t, NUM_WORDS> m_scratch;
+};
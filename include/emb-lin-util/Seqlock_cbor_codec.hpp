@@ -0,0 +1,59 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/JSON_CBOR_helper.hpp"
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//
+// Seqlock codec for JSON_CBOR_helper types, the value is stored as CBOR of at most MAX_BYTES
+// Usage: Seqlock<Battery_state, Seqlock_cbor_codec<Battery_state, 1024>>
+//
+template <typename T, size_t MAX_BYTES = 4096>
+struct Seqlock_cbor_codec
+{
+	static constexpr size_t MAX_SIZE   = MAX_BYTES;
+	static constexpr bool   FIXED_SIZE = false;
+
+	static bool encode(const T& val, uint8_t* const out_buf, size_t* const out_len)
+	{
+		const std::vector<uint8_t> cbor = JSON_CBOR_helper<T>::to_cbor(val);
+		if(cbor.empty() || (cbor.size() > MAX_SIZE))
+		{
+			return false;
+		}
+
+		memcpy(out_buf, cbor.data(), cbor.size());
+		*out_len = cbor.size();
+
+		return true;
+	}
+
+	static bool decode(uint8_t const * const buf, const size_t len, T* const out_val)
+	{
+		try
+		{
+			JSON_CBOR_helper<T>::from_cbor(std::vector<uint8_t>(buf, buf + len), *out_val);
+		}
+		catch(const std::exception&)
+		{
+			return false;
+		}
+
+		return true;
+	}
+};
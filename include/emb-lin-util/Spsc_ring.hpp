@@ -0,0 +1,339 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Futex_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Bounded lock free single producer single consumer ring
+// Capacity is rounded up to a power of two, storage is allocated once in the constructor
+// Producer and consumer indices live on separate cache lines, each side caches the other's index and only reloads it when the ring looks full / empty
+//
+// Blocking waits spin for get_spin_count() iterations then sleep on a futex
+// To stop a blocked Thread_base, override interrupt() to also call notify_cancel()
+//
+template <typename T>
+class Spsc_ring
+{
+public:
+
+	explicit Spsc_ring(const size_t capacity) : m_mask(round_up_pow2(capacity) - 1U), m_buf(new T[m_mask + 1U]), m_spin_count(get_default_spin_count()), m_head(0), m_tail_cache(0), m_tail(0), m_head_cache(0), m_pending_cancel(false)
+	{
+
+	}
+
+	Spsc_ring(const Spsc_ring&) = delete;
+	Spsc_ring& operator=(const Spsc_ring&) = delete;
+
+	static constexpr uint32_t DEFAULT_SPIN_COUNT = 256;
+
+	// spinning only helps if the other side can run at the same time
+	static uint32_t get_default_spin_count()
+	{
+		return (std::thread::hardware_concurrency() > 1) ? DEFAULT_SPIN_COUNT : 0;
+	}
+
+	size_t capacity() const
+	{
+		return m_mask + 1U;
+	}
+
+	// NOT MT safe, set before starting the producer and consumer
+	// 0 goes straight to the futex
+	void set_spin_count(const uint32_t spin_count)
+	{
+		m_spin_count = spin_count;
+	}
+	uint32_t get_spin_count() const
+	{
+		return m_spin_count;
+	}
+
+	// NOT MT safe
+	// Drops all elements and clears cancelation
+	void reset()
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+		m_tail_cache = 0;
+		m_head_cache = 0;
+		m_pending_cancel.store(false, std::memory_order_relaxed);
+	}
+
+	// MT safe, approximate while the other side is running
+	size_t size() const
+	{
+		return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+	}
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	// Producer only
+	bool try_push(const T& val)
+	{
+		return emplace_one([&val](T* const slot){ *slot = val; });
+	}
+	bool try_push(T&& val)
+	{
+		return emplace_one([&val](T* const slot){ *slot = std::move(val); });
+	}
+
+	// Producer only
+	// Copies as many of vals as fit with a single publish
+	// Returns the number pushed
+	size_t push_n(const T* const vals, const size_t n)
+	{
+		const size_t head  = m_head.load(std::memory_order_relaxed);
+		const size_t count = std::min(n, free_space(head, n));
+		if(count == 0)
+		{
+			return 0;
+		}
+
+		// up to two contiguous runs, before and after the wrap
+		const size_t first = std::min(count, capacity() - (head & m_mask));
+		std::copy(vals,         vals + first, m_buf.get() + (head & m_mask));
+		std::copy(vals + first, vals + count, m_buf.get());
+
+		m_head.store(head + count, std::memory_order_release);
+		m_not_empty.notify_all();
+
+		return count;
+	}
+
+	// Producer only
+	// Blocks while full
+	// Returns false on timeout or cancelation
+	bool push(const T& val, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		while( ! try_push(val) )
+		{
+			if( ! wait_for_space(timeout) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Producer only
+	// Returns true once at least one slot is free, false on timeout or cancelation
+	bool wait_for_space(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		return wait_until(m_not_full, [this](){ return free_space(m_head.load(std::memory_order_relaxed), 1) > 0; }, timeout);
+	}
+
+	// Consumer only
+	bool try_pop(T* const out_val)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if(used_space(tail, 1) == 0)
+		{
+			return false;
+		}
+
+		*out_val = std::move(m_buf[tail & m_mask]);
+
+		m_tail.store(tail + 1U, std::memory_order_release);
+		m_not_full.notify_all();
+
+		return true;
+	}
+
+	// Consumer only
+	// Moves up to n elements out with a single release
+	// Returns the number popped
+	size_t pop_n(T* const out_vals, const size_t n)
+	{
+		const size_t tail  = m_tail.load(std::memory_order_relaxed);
+		const size_t count = std::min(n, used_space(tail, n));
+		if(count == 0)
+		{
+			return 0;
+		}
+
+		T* const buf = m_buf.get();
+		const size_t first = std::min(count, capacity() - (tail & m_mask));
+		std::move(buf + (tail & m_mask), buf + (tail & m_mask) + first, out_vals);
+		std::move(buf,                   buf + (count - first),         out_vals + first);
+
+		m_tail.store(tail + count, std::memory_order_release);
+		m_not_full.notify_all();
+
+		return count;
+	}
+
+	// Consumer only
+	// Blocks while empty
+	// Returns false on timeout or on cancelation once the ring is empty
+	bool pop(T* const out_val, const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		while( ! try_pop(out_val) )
+		{
+			if( ! wait_for_data(timeout) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Consumer only
+	// Returns true once at least one element is ready, even if canceled, so the consumer can drain
+	// Returns false on timeout, or on cancelation with nothing left
+	bool wait_for_data(const std::chrono::nanoseconds& timeout = std::chrono::nanoseconds::max())
+	{
+		return wait_until(m_not_empty, [this](){ return used_space(m_tail.load(std::memory_order_relaxed), 1) > 0; }, timeout);
+	}
+
+	// MT safe
+	// Wakes all waiters, later waits return false instead of blocking
+	// This cancelation is latching, call reset to reuse
+	void notify_cancel()
+	{
+		m_pending_cancel.store(true, std::memory_order_release);
+		m_not_empty.notify_all();
+		m_not_full.notify_all();
+	}
+	bool is_cancel_requested() const
+	{
+		return m_pending_cancel.load(std::memory_order_acquire);
+	}
+
+protected:
+
+	static size_t round_up_pow2(const size_t n)
+	{
+		size_t out = 2;
+		while(out < n)
+		{
+			out <<= 1;
+		}
+		return out;
+	}
+
+	template <typename Fill>
+	bool emplace_one(const Fill& fill)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if(free_space(head, 1) == 0)
+		{
+			return false;
+		}
+
+		fill(&m_buf[head & m_mask]);
+
+		m_head.store(head + 1U, std::memory_order_release);
+		m_not_empty.notify_all();
+
+		return true;
+	}
+
+	// producer side, only reloads m_tail if the cached copy says there are fewer than want slots
+	size_t free_space(const size_t head, const size_t want)
+	{
+		size_t free = capacity() - (head - m_tail_cache);
+		if(free < want)
+		{
+			m_tail_cache = m_tail.load(std::memory_order_acquire);
+			free = capacity() - (head - m_tail_cache);
+		}
+		return free;
+	}
+
+	// consumer side, only reloads m_head if the cached copy says there are fewer than want elements
+	size_t used_space(const size_t tail, const size_t want)
+	{
+		size_t used = m_head_cache - tail;
+		if(used < want)
+		{
+			m_head_cache = m_head.load(std::memory_order_acquire);
+			used = m_head_cache - tail;
+		}
+		return used;
+	}
+
+	template <typename Pred>
+	bool wait_until(Futex_event_count& ec, const Pred& ready, const std::chrono::nanoseconds& timeout)
+	{
+		for(uint32_t i = 0; i < m_spin_count; i++)
+		{
+			if(ready())
+			{
+				return true;
+			}
+			if(is_cancel_requested())
+			{
+				return false;
+			}
+			Futex_util::cpu_relax();
+		}
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		for(;;)
+		{
+			if(ready())
+			{
+				return true;
+			}
+			if(is_cancel_requested())
+			{
+				return false;
+			}
+
+			const uint32_t key = ec.prepare_wait();
+			if(ready() || is_cancel_requested())
+			{
+				ec.cancel_wait();
+				continue;
+			}
+
+			if( ! ec.commit_wait(key, has_deadline ? &deadline : nullptr) )
+			{
+				return ready();
+			}
+		}
+	}
+
+	// read only after construction
+	const size_t m_mask;
+	const std::unique_ptr<T[]> m_buf;
+	uint32_t m_spin_count;
+
+	// producer
+	alignas(64) std::atomic<size_t> m_head;
+	size_t m_tail_cache;
+
+	// consumer
+	alignas(64) std::atomic<size_t> m_tail;
+	size_t m_head_cache;
+
+	alignas(64) Futex_event_count m_not_empty;
+	Futex_event_count m_not_full;
+	std::atomic<bool> m_pending_cancel;
+};
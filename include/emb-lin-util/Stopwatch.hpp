@@ -14,6 +14,8 @@
 #include <atomic>
 #include <chrono>
 
+class Lap_stats;
+
 class Stopwatch
 {
 public:
@@ -30,6 +32,17 @@ public:
 	// MT safe
 	bool is_expired(const std::chrono::nanoseconds& alarm_dt, bool* const is_exp);
 
+	// MT safe
+	// Time since the previous lap, or since start if this is the first lap
+	// Concurrent laps never overlap or go negative, together they cover the time since start exactly once
+	// If stats is not null, the lap time is recorded to it
+	bool lap(Lap_stats* const stats, std::chrono::nanoseconds* const out_dt);
+
+	// MT safe
+	// Time since start, does not end the current lap
+	// If stats is not null, the split time is recorded to it
+	bool split(Lap_stats* const stats, std::chrono::nanoseconds* const out_dt);
+
 protected:
 
 	static_assert(std::is_trivially_copyable_v<std::chrono::nanoseconds>);
@@ -37,4 +50,7 @@ protected:
 
 	// ABS time of start
 	std::atomic<std::chrono::nanoseconds> m_t0;
+
+	// ABS time of end of last lap
+	std::atomic<std::chrono::nanoseconds> m_t_lap;
 };
@@ -0,0 +1,111 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Handle to a sysfs or procfs attribute that is opened once and re-read with pread at offset 0
+// sysfs and seq_file regenerate the value on each read from offset 0, so this sees fresh data without reopening
+// Reads go to a stack buffer and parse with std::from_chars, there is no allocation except read_string
+// Leading and trailing whitespace, including the newline, is ignored
+//
+class Sysfs_attr
+{
+public:
+
+	// sysfs attributes are at most a page
+	static constexpr size_t MAX_SIZE = 4096;
+
+	Sysfs_attr();
+	~Sysfs_attr();
+
+	Sysfs_attr(const Sysfs_attr&) = delete;
+	Sysfs_attr& operator=(const Sysfs_attr&) = delete;
+
+	Sysfs_attr(Sysfs_attr&& other);
+	Sysfs_attr& operator=(Sysfs_attr&& other);
+
+	// NOT MT safe
+	bool open(const std::string& path, const bool writable = false);
+	bool close();
+
+	bool is_open() const
+	{
+		return m_fd >= 0;
+	}
+
+	// for poll on attributes that support sysfs_notify, eg gpio value with an edge set
+	// wait for POLLPRI | POLLERR, then re-read
+	int get_fd() const
+	{
+		return m_fd;
+	}
+
+	const std::string& get_path() const
+	{
+		return m_path;
+	}
+
+	// MT safe, each call does its own pread
+	bool read_int(int* const out_value) const;
+	bool read_int64(int64_t* const out_value) const;
+	bool read_double(double* const out_value) const;
+	bool read_string(std::string* const out_value) const;
+
+	// MT safe
+	// Maps the trimmed value through table, eg {{"in", Dir::IN}, {"out", Dir::OUT}}
+	// false if the value is not in the table
+	template<typename Enum, size_t N>
+	bool read_enum(const std::array<std::pair<std::string_view, Enum>, N>& table, Enum* const out_value) const
+	{
+		std::array<char, 64> buf;
+		std::string_view val;
+		if( ! read_trimmed(buf.data(), buf.size(), &val) )
+		{
+			return false;
+		}
+
+		for(const auto& [name, e] : table)
+		{
+			if(val == name)
+			{
+				*out_value = e;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// MT safe
+	// pwrite at offset 0, sysfs takes the whole value in one write
+	bool write(const std::string_view& value) const;
+
+protected:
+
+	// pread up to len - 1 bytes and trim whitespace
+	// false if the attribute did not fit, so values are never silently truncated
+	bool read_trimmed(char* const buf, const size_t len, std::string_view* const out_value) const;
+
+	template<typename T>
+	bool read_number(T* const out_value) const;
+
+	int m_fd;
+	std::string m_path;
+};
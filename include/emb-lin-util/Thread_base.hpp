@@ -11,16 +11,20 @@
 
 #pragma once
 
+#include "emb-lin-util/Futex_sync.hpp"
+#include "emb-lin-util/Heartbeat.hpp"
+
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
 
 class Thread_base
 {
 public:
-	Thread_base() : m_keep_running(false)
+	Thread_base() : m_keep_running(false), m_interrupted_event(Futex_event::Reset_mode::MANUAL)
 	{
 
 	}
@@ -44,11 +48,22 @@ public:
 
 	void wait_for_interruption();
 
+	// returns true if interrupted, false on timeout
 	template <typename Rep, typename Period >
 	bool wait_for_interruption(const std::chrono::duration<Rep, Period>& dt)
 	{
-		std::unique_lock<std::mutex> lock(m_mutex);
-		return m_keep_running_cv.wait_for(lock, dt, std::bind(&Thread_base::is_interrupted, this));
+		// saturate so eg hours::max() waits forever instead of overflowing
+		const bool is_forever = dt >= std::chrono::duration_cast<std::chrono::duration<Rep, Period>>(std::chrono::nanoseconds::max());
+		const std::chrono::nanoseconds dt_ns = is_forever ? std::chrono::nanoseconds::max() : std::chrono::duration_cast<std::chrono::nanoseconds>(dt);
+
+		return m_interrupted_event.wait(dt_ns) || is_interrupted();
+	}
+
+	// NOT MT safe - call before launch, see Watchdog::add_thread
+	// The heartbeat beats when work starts and pauses when it returns
+	void set_heartbeat(const std::shared_ptr<Heartbeat>& hb)
+	{
+		m_heartbeat = hb;
 	}
 
 protected:
@@ -58,9 +73,22 @@ protected:
 
 	void dispatch_work();
 
+	// Call from work often enough to stay within the heartbeat timeout, no-op if no heartbeat is set
+	void heartbeat()
+	{
+		if(m_heartbeat)
+		{
+			m_heartbeat->beat();
+		}
+	}
+
 	std::atomic<bool> m_keep_running;
-	std::condition_variable m_keep_running_cv;
+	Futex_event m_interrupted_event;
+
+	// not used by Thread_base, kept for derived classes
 	std::mutex m_mutex;
 
+	std::shared_ptr<Heartbeat> m_heartbeat;
+
 	std::thread m_thread;
 };
@@ -15,69 +15,334 @@
 #include <time.h>
 
 #include <chrono>
+#include <compare>
+#include <limits>
+#include <ratio>
+#include <type_traits>
 
+#include <cstdint>
+
+//
+// timespec arithmetic
+// Functions expect normalized input, 0 <= tv_nsec < NSEC_PER_SEC, and return normalized output
+// Everything is constexpr, so conversions of constants fold at compile time
+//
 class Timespec_util
 {
 public:
-	static timespec add(const timespec& a, timespec& b)
+
+	static constexpr long NSEC_PER_SEC = 1000000000L;
+
+	// bring tv_nsec into [0, NSEC_PER_SEC), for any tv_nsec
+	static constexpr timespec normalize(const timespec& a) noexcept
 	{
-		timespec out;
+		timespec out{};
+
+		out.tv_sec  = a.tv_sec + (a.tv_nsec / NSEC_PER_SEC);
+		out.tv_nsec = a.tv_nsec % NSEC_PER_SEC;
+
+		if(out.tv_nsec < 0L)
+		{
+			out.tv_sec--;
+			out.tv_nsec += NSEC_PER_SEC;
+		}
+
+		return out;
+	}
+
+	// a + b, the result must fit in time_t - use add_sat otherwise, signed overflow is undefined
+	static constexpr timespec add(const timespec& a, const timespec& b) noexcept
+	{
+		timespec out{};
 
 		out.tv_sec  = a.tv_sec  + b.tv_sec;
 		out.tv_nsec = a.tv_nsec + b.tv_nsec;
 
-		if(out.tv_nsec > 1000000000L)
+		if(out.tv_nsec >= NSEC_PER_SEC)
 		{
 			out.tv_sec++;
-			out.tv_nsec -= 1000000000L;
+			out.tv_nsec -= NSEC_PER_SEC;
 		}
 
 		return out;
 	}
-	static timespec sub(const timespec& a, timespec& b)
+	// a - b, the result must fit in time_t - use sub_sat otherwise, signed overflow is undefined
+	static constexpr timespec sub(const timespec& a, const timespec& b) noexcept
 	{
-		timespec out;
-		
+		timespec out{};
+
 		out.tv_sec  = a.tv_sec  - b.tv_sec;
 		out.tv_nsec = a.tv_nsec - b.tv_nsec;
 
 		if(out.tv_nsec < 0L)
 		{
 			out.tv_sec--;
-			out.tv_nsec += 1000000000L;
+			out.tv_nsec += NSEC_PER_SEC;
+		}
+
+		return out;
+	}
+
+	static constexpr timespec max_value() noexcept
+	{
+		timespec out{};
+		out.tv_sec  = std::numeric_limits<time_t>::max();
+		out.tv_nsec = NSEC_PER_SEC - 1L;
+		return out;
+	}
+	static constexpr timespec min_value() noexcept
+	{
+		timespec out{};
+		out.tv_sec  = std::numeric_limits<time_t>::min();
+		out.tv_nsec = 0L;
+		return out;
+	}
+
+	// a + b, clamped to [min_value, max_value]
+	static constexpr timespec add_sat(const timespec& a, const timespec& b) noexcept
+	{
+		time_t sec = 0;
+		if(__builtin_add_overflow(a.tv_sec, b.tv_sec, &sec))
+		{
+			return (b.tv_sec > 0) ? max_value() : min_value();
+		}
+
+		long nsec = a.tv_nsec + b.tv_nsec;
+		if(nsec >= NSEC_PER_SEC)
+		{
+			if(__builtin_add_overflow(sec, time_t(1), &sec))
+			{
+				return max_value();
+			}
+			nsec -= NSEC_PER_SEC;
+		}
+
+		timespec out{};
+		out.tv_sec  = sec;
+		out.tv_nsec = nsec;
+		return out;
+	}
+	// a - b, clamped to [min_value, max_value]
+	static constexpr timespec sub_sat(const timespec& a, const timespec& b) noexcept
+	{
+		time_t sec = 0;
+		if(__builtin_sub_overflow(a.tv_sec, b.tv_sec, &sec))
+		{
+			return (b.tv_sec < 0) ? max_value() : min_value();
+		}
+
+		long nsec = a.tv_nsec - b.tv_nsec;
+		if(nsec < 0L)
+		{
+			if(__builtin_sub_overflow(sec, time_t(1), &sec))
+			{
+				return min_value();
+			}
+			nsec += NSEC_PER_SEC;
+		}
+
+		timespec out{};
+		out.tv_sec  = sec;
+		out.tv_nsec = nsec;
+		return out;
+	}
+
+	// -1, 0, 1
+	static constexpr int compare(const timespec& a, const timespec& b) noexcept
+	{
+		if(a.tv_sec != b.tv_sec)
+		{
+			return (a.tv_sec < b.tv_sec) ? -1 : 1;
+		}
+		if(a.tv_nsec != b.tv_nsec)
+		{
+			return (a.tv_nsec < b.tv_nsec) ? -1 : 1;
+		}
+		return 0;
+	}
+
+	// exact for any timespec
+	static constexpr __int128 to_ns_i128(const timespec& a) noexcept
+	{
+		return (__int128(a.tv_sec) * NSEC_PER_SEC) + a.tv_nsec;
+	}
+	// exact if the seconds fit in time_t
+	static constexpr timespec from_ns_i128(const __int128 ns) noexcept
+	{
+		__int128 sec  = ns / NSEC_PER_SEC;
+		__int128 nsec = ns % NSEC_PER_SEC;
+		if(nsec < 0)
+		{
+			sec--;
+			nsec += NSEC_PER_SEC;
 		}
 
+		timespec out{};
+		out.tv_sec  = time_t(sec);
+		out.tv_nsec = long(nsec);
 		return out;
 	}
 
+	// int64 ns clamped to [INT64_MIN, INT64_MAX], about +/- 292 years
+	static constexpr int64_t to_ns_sat(const timespec& a) noexcept
+	{
+		const __int128 ns = to_ns_i128(a);
+
+		if(ns > __int128(std::numeric_limits<int64_t>::max()))
+		{
+			return std::numeric_limits<int64_t>::max();
+		}
+		if(ns < __int128(std::numeric_limits<int64_t>::min()))
+		{
+			return std::numeric_limits<int64_t>::min();
+		}
+
+		return int64_t(ns);
+	}
+
+	// rounds toward negative infinity
 	template <typename Rep, typename Period>
-	static timespec from_chrono(const std::chrono::duration<Rep, Period>& dt)
+	static constexpr timespec from_chrono(const std::chrono::duration<Rep, Period>& dt) noexcept
 	{
-		const std::chrono::seconds     t_sec  = std::chrono::floor<std::chrono::seconds>(dt);
-		const std::chrono::nanoseconds t_nsec = std::chrono::floor<std::chrono::nanoseconds>(dt - t_sec);
+		timespec out{};
+
+		if constexpr(std::is_integral_v<Rep> && (Period::num == 1) && ((NSEC_PER_SEC % Period::den) == 0))
+		{
+			// s, ms, us, ns - one div and mod, no intermediate ns count that could overflow
+			constexpr long NSEC_PER_TICK = NSEC_PER_SEC / Period::den;
+
+			Rep sec  = dt.count() / Period::den;
+			Rep tick = dt.count() % Period::den;
+			if(tick < 0)
+			{
+				sec--;
+				tick += Period::den;
+			}
+
+			out.tv_sec  = time_t(sec);
+			out.tv_nsec = long(tick) * NSEC_PER_TICK;
+		}
+		else if constexpr(std::is_integral_v<Rep> && (Period::den == 1))
+		{
+			// minutes, hours, days
+			out.tv_sec  = time_t(dt.count()) * time_t(Period::num);
+			out.tv_nsec = 0L;
+		}
+		else
+		{
+			const std::chrono::seconds     t_sec  = std::chrono::floor<std::chrono::seconds>(dt);
+			const std::chrono::nanoseconds t_nsec = std::chrono::floor<std::chrono::nanoseconds>(dt - t_sec);
 
-		timespec out;		
-		out.tv_sec  = t_sec.count();
-		out.tv_nsec = t_nsec.count();
+			out.tv_sec  = t_sec.count();
+			out.tv_nsec = t_nsec.count();
+		}
 
 		return out;
 	}
 
+	// compile time constant conversion, eg from_chrono_v<std::chrono::milliseconds, 500>
+	template <typename Duration, typename Duration::rep COUNT>
+	static constexpr timespec from_chrono_v = from_chrono(Duration(COUNT));
+
+	// rounds toward negative infinity
+	// nanosecond results are limited to +/- 292 years, use to_chrono_sat if the input may be out of that range
 	template <typename T>
-	static T to_chrono(const timespec& dt)
+	static constexpr T to_chrono(const timespec& dt) noexcept
 	{
-		std::chrono::seconds     t_sec(dt.tv_sec);
-		std::chrono::nanoseconds t_nsec(dt.tv_nsec); // TODO: this is limited to +/- 584 years
+		typedef typename T::rep    Rep;
+		typedef typename T::period Period;
+
+		if constexpr(std::is_floating_point_v<Rep>)
+		{
+			return std::chrono::duration_cast<T>(std::chrono::duration<Rep>(Rep(dt.tv_sec)) + std::chrono::duration<Rep, std::nano>(Rep(dt.tv_nsec)));
+		}
+		else if constexpr(std::is_same_v<Period, std::nano>)
+		{
+			return T(Rep(dt.tv_sec) * Rep(NSEC_PER_SEC) + Rep(dt.tv_nsec));
+		}
+		else if constexpr((Period::num == 1) && ((NSEC_PER_SEC % Period::den) == 0))
+		{
+			// tv_nsec >= 0 so integer division floors
+			constexpr long NSEC_PER_TICK = NSEC_PER_SEC / Period::den;
+			return T(Rep(dt.tv_sec) * Rep(Period::den) + Rep(dt.tv_nsec / NSEC_PER_TICK));
+		}
+		else
+		{
+			// ns * den / (num * 1e9), in 128 bit
+			constexpr __int128 DIV = __int128(Period::num) * NSEC_PER_SEC;
+
+			const __int128 num = to_ns_i128(dt) * Period::den;
+			__int128 q = num / DIV;
+			if(((num % DIV) != 0) && (num < 0))
+			{
+				q--;
+			}
 
-		return std::chrono::floor< T >(t_sec + t_nsec); // TODO: this is limited to +/- 584 years
+			return T(Rep(q));
+		}
 	}
 
 	template <typename Rep, typename Period>
-	static std::chrono::duration<Rep, Period> to_chrono(const timespec& dt)
+	static constexpr std::chrono::duration<Rep, Period> to_chrono(const timespec& dt) noexcept
 	{
-		std::chrono::seconds     t_sec(dt.tv_sec);
-		std::chrono::nanoseconds t_nsec(dt.tv_nsec); // TODO: this is limited to +/- 584 years
+		return to_chrono< std::chrono::duration<Rep, Period> >(dt);
+	}
+
+	// rounds toward negative infinity, clamps to the range of T
+	template <typename T>
+	static constexpr T to_chrono_sat(const timespec& dt) noexcept
+	{
+		typedef typename T::rep    Rep;
+		typedef typename T::period Period;
+
+		static_assert(std::is_integral_v<Rep>);
+
+		constexpr __int128 DIV = __int128(Period::num) * NSEC_PER_SEC;
+
+		const __int128 ns = to_ns_i128(dt);
+
+		// avoid overflowing the multiply for very fine periods
+		constexpr __int128 NS_LIMIT = std::numeric_limits<__int128>::max() / Period::den;
+		if(ns > NS_LIMIT)
+		{
+			return T::max();
+		}
+		if(ns < -NS_LIMIT)
+		{
+			return T::min();
+		}
+
+		const __int128 num = ns * Period::den;
+		__int128 q = num / DIV;
+		if(((num % DIV) != 0) && (num < 0))
+		{
+			q--;
+		}
+
+		if(q > __int128(std::numeric_limits<Rep>::max()))
+		{
+			return T::max();
+		}
+		if(q < __int128(std::numeric_limits<Rep>::min()))
+		{
+			return T::min();
+		}
 
-		return std::chrono::floor< std::chrono::duration<Rep, Period> >(t_sec + t_nsec); // TODO: this is limited to +/- 584 years
+		return T(Rep(q));
 	}
 };
+
+constexpr bool operator==(const timespec& a, const timespec& b) noexcept
+{
+	return (a.tv_sec == b.tv_sec) && (a.tv_nsec == b.tv_nsec);
+}
+
+constexpr std::strong_ordering operator<=>(const timespec& a, const timespec& b) noexcept
+{
+	if(a.tv_sec != b.tv_sec)
+	{
+		return a.tv_sec <=> b.tv_sec;
+	}
+
+	return a.tv_nsec <=> b.tv_nsec;
+}
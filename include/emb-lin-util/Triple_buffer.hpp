@@ -0,0 +1,135 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstdint>
+
+//
+// Default Triple_buffer copy hook, plain assignment
+// Works for trivially copyable types and value types such as JSON_CBOR_helper types
+// Supply another hook to copy only part of a large value, or to reuse the destination's allocations
+//
+template <typename T>
+struct Triple_buffer_assign
+{
+	static void copy(const T& src, T* const dst)
+	{
+		*dst = src;
+	}
+};
+
+//
+// Wait free latest value handoff from one writer to one reader
+// The writer fills a back buffer and swaps it with the middle one, the reader swaps the middle one with its front buffer
+// Neither side ever waits, the reader always sees the last fully published value
+// Unlike Seqlock, T can be any copyable type and nothing is copied under contention, but there is only one reader
+//
+template <typename T, typename Copy_hook = Triple_buffer_assign<T>>
+class Triple_buffer
+{
+public:
+
+	Triple_buffer() : m_middle(1), m_back(0), m_front(2)
+	{
+
+	}
+
+	Triple_buffer(const Triple_buffer&) = delete;
+	Triple_buffer& operator=(const Triple_buffer&) = delete;
+
+	// Writer only
+	// Copies val in with the hook and publishes it
+	void write(const T& val)
+	{
+		Copy_hook::copy(val, &get_write_buffer());
+		publish();
+	}
+
+	// Writer only
+	// For in place updates, fill this then call publish
+	// The contents are whatever was swapped in last, not necessarily the last written value
+	T& get_write_buffer()
+	{
+		return m_bufs[m_back].val;
+	}
+
+	// Writer only
+	void publish()
+	{
+		m_back = m_middle.exchange(m_back | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// Reader only
+	// Copies out the newest value with the hook
+	// Returns true if it is newer than the last read, false if unchanged or nothing was published yet
+	bool read(T* const out_val)
+	{
+		const bool is_new = update();
+		if(m_has_data)
+		{
+			Copy_hook::copy(m_bufs[m_front].val, out_val);
+		}
+		return is_new;
+	}
+
+	// Reader only
+	// Swaps in the newest value if there is one, returns true if it did
+	bool update()
+	{
+		if( ! (m_middle.load(std::memory_order_relaxed) & NEW_DATA) )
+		{
+			return false;
+		}
+
+		m_front    = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+		m_has_data = true;
+
+		return true;
+	}
+
+	// Reader only
+	// Valid until the next update / read, check has_data first
+	const T& get_read_buffer() const
+	{
+		return m_bufs[m_front].val;
+	}
+	bool has_data() const
+	{
+		return m_has_data;
+	}
+
+protected:
+
+	static constexpr uint8_t INDEX_MASK = 0x03U;
+	static constexpr uint8_t NEW_DATA   = 0x04U;
+
+	// buffers are touched by different threads, keep them on separate lines
+	struct alignas(64) Slot
+	{
+		T val;
+	};
+
+	std::array<Slot, 3> m_bufs;
+
+	// index of the middle buffer, NEW_DATA if the writer published since the reader last took it
+	alignas(64) std::atomic<uint8_t> m_middle;
+
+	// writer only
+	alignas(64) uint8_t m_back;
+
+	// reader only
+	alignas(64) uint8_t m_front;
+	bool m_has_data = false;
+};
@@ -0,0 +1,104 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include <cstdint>
+
+//
+// A simulated clock for tests
+// When the library is built with EMB_LIN_UTIL_VIRTUAL_CLOCK, Chronometer, Stopwatch, Interval_timer, Interval_timer_fd,
+// Edf_scheduler, Gcra_limiter and Record_log read, sleep and arm timers against this clock instead of the kernel,
+// and time only moves when advance is called
+// Plain timeouts, Futex_util deadlines and Mpmc_queue::pop, stay on the kernel clock
+// Only built into the emb-lin-util-vclock test library, normal builds never reference it
+//
+class Virtual_clock
+{
+public:
+
+	typedef std::function<void()> Timer_callback;
+
+	// MT safe
+	// Drop-in for clock_gettime, supports CLOCK_MONOTONIC, CLOCK_REALTIME and CLOCK_TAI
+	// REALTIME and TAI are fixed offsets from MONOTONIC
+	static int clock_gettime(const clockid_t clk, timespec* const out_time);
+
+	// MT safe
+	static std::chrono::nanoseconds now()
+	{
+		return std::chrono::nanoseconds(m_now_ns.load(std::memory_order_acquire));
+	}
+
+	// MT safe, but calls to advance are serialized
+	// Moves time forward, stopping at each timer expiration in order and calling its callback from this thread
+	// Returns after all expirations up to now() + dt have been delivered
+	static void advance(const std::chrono::nanoseconds& dt);
+
+	// MT safe
+	// Drop-in for an absolute CLOCK_MONOTONIC clock_nanosleep, returns once advance has moved now() to t or past it
+	static void sleep_until(const std::chrono::nanoseconds& t);
+
+	// MT safe
+	// The callback is called once per expiration from the thread calling advance
+	// The callback must not call timer_delete
+	static bool timer_create(const Timer_callback& cb, int* const out_id);
+
+	// MT safe
+	// Same semantics as a relative timer_settime, value == 0 disarms the timer
+	static bool timer_settime(const int id, const std::chrono::nanoseconds& value, const std::chrono::nanoseconds& interval);
+
+	// MT safe
+	// Waits for any in progress advance to finish, so the callback will not run after this returns
+	static bool timer_delete(const int id);
+
+protected:
+
+	struct Timer
+	{
+		Timer_callback cb;
+		bool armed;
+		int64_t deadline_ns;
+		int64_t interval_ns;
+	};
+
+	// REALTIME == MONOTONIC + REALTIME_OFFSET, 2024-01-01 00:00:00
+	static constexpr int64_t REALTIME_OFFSET_S = 1704067200LL;
+
+	// TAI - UTC as of 2017-01-01
+	static constexpr int64_t TAI_OFFSET_S = 37LL;
+
+	static std::atomic<int64_t> m_now_ns;
+
+	// stores m_now_ns and wakes sleep_until
+	static void set_now(const int64_t t_ns);
+
+	// sleep_until waits on m_sleep_cv for m_now_ns to change
+	static std::mutex m_sleep_mutex;
+	static std::condition_variable m_sleep_cv;
+
+	// held for the duration of advance and timer_delete
+	static std::mutex m_advance_mutex;
+
+	// protects m_timers and m_next_id
+	static std::mutex m_timer_mutex;
+	static std::map<int, Timer> m_timers;
+	static int m_next_id;
+};
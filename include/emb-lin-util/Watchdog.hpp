@@ -0,0 +1,113 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#pragma once
+
+#include "emb-lin-util/Heartbeat.hpp"
+#include "emb-lin-util/Interval_timer_fd.hpp"
+#include "emb-lin-util/Thread_base.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// Checks registered heartbeats on a single Interval_timer_fd and reports workers that stop beating
+// A stall is reported once when a heartbeat first exceeds its timeout, and again only after it recovers
+// Optionally pets a hardware watchdog, eg /dev/watchdog, but only while every heartbeat is healthy
+// so a wedged worker, or a wedged Watchdog thread, ends in a hardware reset
+//
+class Watchdog : public Thread_base
+{
+public:
+
+	// name of the stalled heartbeat and the time since its last beat
+	typedef std::function<void(const std::string& name, const std::chrono::nanoseconds& age)> Stall_callback;
+
+	Watchdog();
+	~Watchdog() override;
+
+	// NOT MT safe - only call if the thread is not running
+	// Arms the check timer, must be called before each launch since interrupt cancels it
+	bool init(const std::chrono::nanoseconds& check_period);
+
+	// NOT MT safe - only call if the thread is not running
+	// If not set stalls are logged
+	void set_stall_callback(const Stall_callback& cb)
+	{
+		m_stall_cb = cb;
+	}
+
+	// NOT MT safe - only call if the thread is not running
+	// Opening the device arms it, the driver resets the system if it is not petted within its timeout
+	// timeout of zero keeps the driver default
+	bool open_device(const std::string& path, const std::chrono::seconds& timeout);
+
+	// NOT MT safe - only call if the thread is not running
+	// Sends the magic close so the driver disarms, unless it was built with nowayout
+	bool close_device();
+
+	// MT safe
+	std::shared_ptr<Heartbeat> add_heartbeat(const std::string& name, const std::chrono::nanoseconds& timeout);
+
+	// MT safe wrt the Watchdog, NOT MT safe wrt thread - call before thread is launched
+	// thread beats once at start of work and pauses when work returns, call Thread_base::heartbeat from work to stay healthy
+	std::shared_ptr<Heartbeat> add_thread(Thread_base* const thread, const std::string& name, const std::chrono::nanoseconds& timeout);
+
+	// MT safe
+	void remove_heartbeat(const std::shared_ptr<Heartbeat>& hb);
+
+	// MT safe
+	// Checks every heartbeat once and reports new stalls
+	// Returns true if all are healthy
+	bool check();
+
+	// MT safe
+	size_t get_stalled_count() const
+	{
+		return m_stalled_count.load(std::memory_order_relaxed);
+	}
+
+	// MT safe
+	void interrupt() override;
+
+protected:
+
+	void work() override;
+
+	bool pet_device();
+
+	struct Entry
+	{
+		std::shared_ptr<Heartbeat> hb;
+		bool is_stalled;
+	};
+
+	struct Stall
+	{
+		std::shared_ptr<Heartbeat> hb;
+		std::chrono::nanoseconds age;
+	};
+
+	Interval_timer_fd        m_timer;
+	std::chrono::nanoseconds m_check_period;
+
+	Stall_callback m_stall_cb;
+
+	int m_device_fd;
+
+	// m_mutex guards m_entries
+	std::vector<Entry> m_entries;
+
+	std::atomic<size_t> m_stalled_count;
+};
@@ -46,7 +46,11 @@ public:
 	}
 
 	bool deflate(uint8_t* in_data, const size_t in_data_len, const Block_callback& cb);
-	bool inflate(uint8_t* in_data, const size_t in_data_len, const Block_callback& cb);
+	bool inflate(uint8_t const * in_data, const size_t in_data_len, const Block_callback& cb);
+
+	// MT safe
+	// zlib crc32, pass the previous result as crc to continue over several buffers
+	static uint32_t crc32(uint8_t const * const ptr, const size_t len, const uint32_t crc = 0);
 protected:
 	// chunk size for callback deflate/inflate
 	const size_t deflate_block_size = 64*1024;
@@ -0,0 +1,300 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Atomic_file_writer.hpp"
+
+#include "emb-lin-util/File_util.hpp"
+#include "emb-lin-util/File_view.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+Atomic_file_writer::Atomic_file_writer(const Sync_mode mode) : m_mode(mode), m_skip_unchanged(false)
+{
+
+}
+
+Atomic_file_writer::~Atomic_file_writer()
+{
+	abort();
+}
+
+bool Atomic_file_writer::stage(const std::string& path, uint8_t const * const ptr, const size_t len, const mode_t mode)
+{
+	// the last stage wins, so drop an earlier one for this path before the unchanged check can skip this one
+	drop_staged(path);
+
+	if(m_skip_unchanged && is_unchanged(path, ptr, len))
+	{
+		return true;
+	}
+
+	const std::string dir = get_dir(path);
+	const size_t name_pos = path.find_last_of('/');
+	const std::string name = (name_pos == std::string::npos) ? path : path.substr(name_pos + 1);
+
+	// hidden and in the same directory, so the rename cannot cross filesystems
+	Staged s;
+	s.tmp_path = dir + "/." + name + ".tmp.XXXXXX";
+	s.path     = path;
+	s.fd       = mkostemp(s.tmp_path.data(), O_CLOEXEC);
+	if(s.fd < 0)
+	{
+		SPDLOG_WARN("Atomic_file_writer::stage - Could not create a temp file for {:s}", path);
+		return false;
+	}
+
+	if((fchmod(s.fd, mode) != 0) || ( ! File_util::write_all(s.fd, ptr, len) ))
+	{
+		SPDLOG_WARN("Atomic_file_writer::stage - Could not write {:s}", s.tmp_path);
+		discard(s);
+		return false;
+	}
+
+	// SYNCFS does not need the fd, do not hold one per staged file
+	if(m_mode == Sync_mode::SYNCFS)
+	{
+		if(::close(s.fd) != 0)
+		{
+			s.fd = -1;
+			discard(s);
+			return false;
+		}
+		s.fd = -1;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_staged.push_back(std::move(s));
+
+	return true;
+}
+
+bool Atomic_file_writer::commit()
+{
+	std::lock_guard<std::mutex> commit_lock(m_commit_mutex);
+
+	std::vector<Staged> staged;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		staged.swap(m_staged);
+	}
+
+	if(staged.empty())
+	{
+		return true;
+	}
+
+	const bool use_syncfs = (m_mode == Sync_mode::SYNCFS);
+
+	std::set<std::string> dirs;
+	for(const Staged& s : staged)
+	{
+		dirs.insert(get_dir(s.path));
+	}
+
+	// data barrier, nothing may be renamed before its data is durable
+	bool data_ok = true;
+	if(use_syncfs)
+	{
+		data_ok = sync_dirs(dirs, true);
+	}
+	else
+	{
+		for(Staged& s : staged)
+		{
+			int ret = 0;
+			do
+			{
+				ret = fdatasync(s.fd);
+			} while((ret != 0) && (errno == EINTR));
+
+			data_ok = (ret == 0) && data_ok;
+
+			if(::close(s.fd) != 0)
+			{
+				data_ok = false;
+			}
+			s.fd = -1;
+		}
+	}
+
+	if( ! data_ok )
+	{
+		SPDLOG_WARN("Atomic_file_writer::commit - sync failed, keeping old files");
+		for(const Staged& s : staged)
+		{
+			discard(s);
+		}
+		return false;
+	}
+
+	// in stage order, so a path staged twice ends with the last version
+	bool ret = true;
+	for(const Staged& s : staged)
+	{
+		if(rename(s.tmp_path.c_str(), s.path.c_str()) != 0)
+		{
+			SPDLOG_WARN("Atomic_file_writer::commit - Could not rename {:s}", s.tmp_path);
+			discard(s);
+			ret = false;
+		}
+	}
+
+	// make the renames durable
+	ret = sync_dirs(dirs, use_syncfs) && ret;
+
+	return ret;
+}
+
+void Atomic_file_writer::abort()
+{
+	std::vector<Staged> staged;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		staged.swap(m_staged);
+	}
+
+	for(const Staged& s : staged)
+	{
+		discard(s);
+	}
+}
+
+void Atomic_file_writer::drop_staged(const std::string& path)
+{
+	std::vector<Staged> dropped;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = std::stable_partition(m_staged.begin(), m_staged.end(), [&path](const Staged& s){ return s.path != path; });
+		std::move(it, m_staged.end(), std::back_inserter(dropped));
+		m_staged.erase(it, m_staged.end());
+	}
+
+	for(const Staged& s : dropped)
+	{
+		discard(s);
+	}
+}
+
+size_t Atomic_file_writer::get_staged_count() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_staged.size();
+}
+
+bool Atomic_file_writer::write_file(const std::string& path, uint8_t const * const ptr, const size_t len, const mode_t mode)
+{
+	Atomic_file_writer writer(Sync_mode::FDATASYNC_EACH);
+	return writer.stage(path, ptr, len, mode) && writer.commit();
+}
+
+bool Atomic_file_writer::is_unchanged(const std::string& path, uint8_t const * const ptr, const size_t len)
+{
+	struct stat st;
+	if((stat(path.c_str(), &st) != 0) || ( ! S_ISREG(st.st_mode) ) || (size_t(st.st_size) != len))
+	{
+		return false;
+	}
+
+	File_view view;
+	if( ! view.open(path, File_view::Advice::SEQUENTIAL, false) )
+	{
+		return false;
+	}
+
+	return (view.size() == len) && ((len == 0) || (memcmp(view.data(), ptr, len) == 0));
+}
+
+std::string Atomic_file_writer::get_dir(const std::string& path)
+{
+	const size_t pos = path.find_last_of('/');
+	if(pos == std::string::npos)
+	{
+		return ".";
+	}
+	if(pos == 0)
+	{
+		return "/";
+	}
+	return path.substr(0, pos);
+}
+
+bool Atomic_file_writer::sync_dirs(const std::set<std::string>& dirs, const bool use_syncfs)
+{
+	bool ret = true;
+
+	// syncfs once per filesystem
+	std::set<dev_t> devs;
+
+	for(const std::string& dir : dirs)
+	{
+		const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(fd < 0)
+		{
+			ret = false;
+			continue;
+		}
+
+		if(use_syncfs)
+		{
+			struct stat st;
+			if(fstat(fd, &st) != 0)
+			{
+				ret = false;
+				::close(fd);
+				continue;
+			}
+
+			if( ! devs.insert(st.st_dev).second )
+			{
+				::close(fd);
+				continue;
+			}
+		}
+
+		int sync_ret = 0;
+		do
+		{
+			sync_ret = use_syncfs ? syncfs(fd) : fsync(fd);
+		} while((sync_ret != 0) && (errno == EINTR));
+
+		if(sync_ret != 0)
+		{
+			SPDLOG_WARN("Atomic_file_writer::sync_dirs - sync failed on {:s}", dir);
+			ret = false;
+		}
+
+		::close(fd);
+	}
+
+	return ret;
+}
+
+void Atomic_file_writer::discard(const Staged& s)
+{
+	if(s.fd >= 0)
+	{
+		::close(s.fd);
+	}
+	unlink(s.tmp_path.c_str());
+}
@@ -0,0 +1,324 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Attr_batch.hpp"
+
+#include "emb-lin-util/Chronometer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include <cerrno>
+
+namespace
+{
+	bool is_space(const char c)
+	{
+		return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r');
+	}
+
+	// read results above slot_size - 1 may have been truncated
+	int32_t to_length(const ssize_t ret, const size_t slot_size)
+	{
+		if(ret < 0)
+		{
+			return -int32_t(errno);
+		}
+		if(size_t(ret) >= slot_size)
+		{
+			return -EOVERFLOW;
+		}
+		return int32_t(ret);
+	}
+
+	template<typename T>
+	bool parse_number(std::string_view val, T* const out_value)
+	{
+		if( ( ! val.empty() ) && (val.front() == '+') )
+		{
+			val.remove_prefix(1);
+		}
+
+		T tmp;
+		const std::from_chars_result res = std::from_chars(val.data(), val.data() + val.size(), tmp);
+		if((res.ec != std::errc()) || (res.ptr != (val.data() + val.size())))
+		{
+			return false;
+		}
+
+		*out_value = tmp;
+		return true;
+	}
+}
+
+Attr_batch::Attr_batch() : m_capacity(0), m_slot_size(0), m_num_samples(0), m_times(nullptr), m_lengths(nullptr), m_data(nullptr)
+{
+
+}
+
+Attr_batch::~Attr_batch()
+{
+	m_ring.reset();
+	close_all();
+}
+
+bool Attr_batch::add_dir(const std::string& path, size_t* const out_dir_idx)
+{
+	const int fd = ::open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_WARN("Attr_batch::add_dir - Could not open {:s}", path);
+		return false;
+	}
+
+	m_dir_fds.push_back(fd);
+	*out_dir_idx = m_dir_fds.size() - 1;
+
+	return true;
+}
+
+bool Attr_batch::add_attr(const size_t dir_idx, const std::string& rel_path, size_t* const out_attr_idx)
+{
+	if(dir_idx >= m_dir_fds.size())
+	{
+		return false;
+	}
+
+	const int fd = openat(m_dir_fds[dir_idx], rel_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_WARN("Attr_batch::add_attr - Could not open {:s}", rel_path);
+		return false;
+	}
+
+	m_attr_fds.push_back(fd);
+	*out_attr_idx = m_attr_fds.size() - 1;
+
+	return true;
+}
+
+bool Attr_batch::add_attr(const std::string& path, size_t* const out_attr_idx)
+{
+	const int fd = openat(AT_FDCWD, path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_WARN("Attr_batch::add_attr - Could not open {:s}", path);
+		return false;
+	}
+
+	m_attr_fds.push_back(fd);
+	*out_attr_idx = m_attr_fds.size() - 1;
+
+	return true;
+}
+
+bool Attr_batch::init(const size_t capacity, const size_t slot_size, const bool use_io_uring)
+{
+	if((capacity == 0) || (slot_size < 2) || (slot_size > size_t(std::numeric_limits<int32_t>::max())) || m_attr_fds.empty())
+	{
+		return false;
+	}
+
+	const size_t n_attr = m_attr_fds.size();
+
+	// int64 times first so every array is naturally aligned
+	const size_t times_bytes   = capacity * sizeof(int64_t);
+	const size_t lengths_bytes = capacity * n_attr * sizeof(int32_t);
+	const size_t data_bytes    = capacity * n_attr * slot_size;
+
+	m_storage.reset(new uint8_t[times_bytes + lengths_bytes + data_bytes]);
+	m_times   = reinterpret_cast<int64_t*>(m_storage.get());
+	m_lengths = reinterpret_cast<int32_t*>(m_storage.get() + times_bytes);
+	m_data    = reinterpret_cast<char*>(m_storage.get() + times_bytes + lengths_bytes);
+
+	m_capacity    = capacity;
+	m_slot_size   = slot_size;
+	m_num_samples = 0;
+
+	m_ring.reset();
+	if(use_io_uring)
+	{
+		// one sweep in flight, larger sets are submitted in chunks
+		const unsigned entries = unsigned(std::min<size_t>(n_attr, 256));
+		if( ! m_ring.init(entries) )
+		{
+			SPDLOG_DEBUG("Attr_batch::init - io_uring not available, using pread");
+		}
+	}
+
+	return true;
+}
+
+bool Attr_batch::sample()
+{
+	if(m_num_samples >= m_capacity)
+	{
+		return false;
+	}
+
+	std::chrono::nanoseconds now;
+	if( ! Chronometer::get_time(&now) )
+	{
+		return false;
+	}
+
+	const size_t n_attr = m_attr_fds.size();
+
+	char*    const data    = m_data    + (m_num_samples * n_attr * m_slot_size);
+	int32_t* const lengths = m_lengths + (m_num_samples * n_attr);
+
+	if(m_ring.is_open())
+	{
+		if( ! sample_io_uring(data, lengths) )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		sample_pread(0, data, lengths);
+	}
+
+	m_times[m_num_samples] = now.count();
+	m_num_samples++;
+
+	return true;
+}
+
+void Attr_batch::sample_pread(const size_t first_attr, char* const data, int32_t* const lengths)
+{
+	for(size_t i = first_attr; i < m_attr_fds.size(); i++)
+	{
+		ssize_t ret = 0;
+		do
+		{
+			ret = pread(m_attr_fds[i], data + (i * m_slot_size), m_slot_size, 0);
+		} while((ret < 0) && (errno == EINTR));
+
+		lengths[i] = to_length(ret, m_slot_size);
+	}
+}
+
+bool Attr_batch::sample_io_uring(char* const data, int32_t* const lengths)
+{
+	const size_t n_attr = m_attr_fds.size();
+
+	size_t next = 0;
+	while(next < n_attr)
+	{
+		size_t queued = 0;
+		for(io_uring_sqe* sqe = nullptr; (next < n_attr) && ((sqe = m_ring.get_sqe()) != nullptr); next++, queued++)
+		{
+			Io_uring::prep_read(sqe, m_attr_fds[next], data + (next * m_slot_size), unsigned(m_slot_size), 0, next);
+		}
+
+		if( ! m_ring.submit_and_wait(unsigned(queued)) )
+		{
+			return false;
+		}
+
+		bool op_unsupported = false;
+		for(size_t i = 0; i < queued; i++)
+		{
+			io_uring_cqe cqe;
+			if( ! m_ring.wait_cqe(&cqe) )
+			{
+				return false;
+			}
+
+			const size_t idx = size_t(cqe.user_data);
+			if(cqe.res < 0)
+			{
+				lengths[idx] = cqe.res;
+				op_unsupported = op_unsupported || (cqe.res == -EINVAL) || (cqe.res == -EOPNOTSUPP);
+			}
+			else
+			{
+				lengths[idx] = (size_t(cqe.res) >= m_slot_size) ? -EOVERFLOW : cqe.res;
+			}
+		}
+
+		// IORING_OP_READ is 5.6+, on older kernels drop the ring and redo the sweep with pread
+		if(op_unsupported)
+		{
+			SPDLOG_DEBUG("Attr_batch::sample - io_uring read not supported, using pread");
+			m_ring.reset();
+			sample_pread(0, data, lengths);
+			return true;
+		}
+	}
+
+	return true;
+}
+
+bool Attr_batch::get_string(const size_t sample_idx, const size_t attr_idx, std::string_view* const out_value) const
+{
+	if((sample_idx >= m_num_samples) || (attr_idx >= m_attr_fds.size()))
+	{
+		return false;
+	}
+
+	const int32_t len = get_length(sample_idx, attr_idx);
+	if(len < 0)
+	{
+		return false;
+	}
+
+	char const * const ptr = m_data + (((sample_idx * m_attr_fds.size()) + attr_idx) * m_slot_size);
+
+	size_t begin = 0;
+	size_t end   = size_t(len);
+	while((begin < end) && is_space(ptr[begin]))
+	{
+		begin++;
+	}
+	while((end > begin) && is_space(ptr[end - 1]))
+	{
+		end--;
+	}
+
+	*out_value = std::string_view(ptr + begin, end - begin);
+
+	return true;
+}
+
+bool Attr_batch::get_int64(const size_t sample_idx, const size_t attr_idx, int64_t* const out_value) const
+{
+	std::string_view val;
+	return get_string(sample_idx, attr_idx, &val) && parse_number(val, out_value);
+}
+
+bool Attr_batch::get_double(const size_t sample_idx, const size_t attr_idx, double* const out_value) const
+{
+	std::string_view val;
+	return get_string(sample_idx, attr_idx, &val) && parse_number(val, out_value);
+}
+
+void Attr_batch::close_all()
+{
+	for(const int fd : m_attr_fds)
+	{
+		close(fd);
+	}
+	m_attr_fds.clear();
+
+	for(const int fd : m_dir_fds)
+	{
+		close(fd);
+	}
+	m_dir_fds.clear();
+}
@@ -14,6 +14,23 @@
 
 #include <date/date.h>
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	#include <emb-lin-util/Virtual_clock.hpp>
+#endif
+
+namespace
+{
+	// all Chronometer reads go through here so test builds can swap in Virtual_clock
+	inline int read_clock(const clockid_t clk, timespec* const out_time)
+	{
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+		return Virtual_clock::clock_gettime(clk, out_time);
+#else
+		return clock_gettime(clk, out_time);
+#endif
+	}
+}
+
 bool Chronometer::get_time(std::chrono::nanoseconds* const out_time)
 {
 	timespec t0;
@@ -31,18 +48,18 @@ bool Chronometer::get_time(std::chrono::nanoseconds* const out_time)
 }
 bool Chronometer::get_time(timespec*                 const out_time)
 {
-	int ret = clock_gettime(CLOCK_MONOTONIC, out_time);
+	int ret = read_clock(CLOCK_MONOTONIC, out_time);
 	return ret == 0;
 }
 
 bool Chronometer::get_real_time(timespec*                 const out_time)
 {
-	int ret = clock_gettime(CLOCK_REALTIME, out_time);
+	int ret = read_clock(CLOCK_REALTIME, out_time);
 	return ret == 0;
 }
 bool Chronometer::get_tai_time(timespec*                 const out_time)
 {
-	int ret = clock_gettime(CLOCK_TAI, out_time);
+	int ret = read_clock(CLOCK_TAI, out_time);
 
 	if((ret == 0) && out_time)
 	{
@@ -60,6 +77,6 @@ bool Chronometer::get_tai_time(timespec*                 const out_time)
 }
 bool Chronometer::get_mono_time(timespec*                 const out_time)
 {
-	int ret = clock_gettime(CLOCK_MONOTONIC, out_time);
+	int ret = read_clock(CLOCK_MONOTONIC, out_time);
 	return ret == 0;
 }
\ No newline at end of file
@@ -0,0 +1,399 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Chunk_reader.hpp"
+
+#include "emb-lin-util/Futex_sync.hpp"
+#include "emb-lin-util/Io_uring.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+	size_t round_up_aligned(const size_t n)
+	{
+		const size_t a = Chunk_reader::ALIGNMENT;
+		return std::max<size_t>(((n + a - 1U) / a) * a, a);
+	}
+}
+
+Chunk_reader::Chunk_reader(const size_t chunk_size, const size_t depth) :
+	m_chunk_size(round_up_aligned(chunk_size)),
+	m_depth(std::max<size_t>(depth, 2)),
+	m_bufs(static_cast<uint8_t*>(aligned_alloc(ALIGNMENT, m_chunk_size * m_depth))),
+	m_prefetch(Prefetch::THREAD),
+	m_direct(false),
+	m_drop_behind(false),
+	m_is_direct_fd(false),
+	m_bytes_read(0)
+{
+
+}
+
+Chunk_reader::~Chunk_reader()
+{
+
+}
+
+bool Chunk_reader::read_file(const std::string& path, const Block_callback& cb)
+{
+	m_bytes_read = 0;
+
+	if( ! m_bufs )
+	{
+		return false;
+	}
+
+	int fd = -1;
+	if(m_direct)
+	{
+		fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+		if((fd < 0) && (errno == EINVAL))
+		{
+			SPDLOG_DEBUG("Chunk_reader::read_file - O_DIRECT not supported for {:s}, using buffered reads", path);
+		}
+	}
+	m_is_direct_fd = (fd >= 0);
+	if(fd < 0)
+	{
+		fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+	if(fd < 0)
+	{
+		SPDLOG_ERROR("Chunk_reader::read_file - could not open {:s}: {:s}", path, strerror(errno));
+		return false;
+	}
+
+	// doubles the kernel readahead window on most filesystems, ignored with O_DIRECT
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	bool ret = false;
+	switch(m_prefetch)
+	{
+		case Prefetch::NONE:
+		{
+			ret = read_sync(fd, cb);
+			break;
+		}
+		case Prefetch::IO_URING:
+		{
+			bool unsupported = false;
+			ret = read_uring(fd, cb, &unsupported);
+			if(unsupported)
+			{
+				SPDLOG_DEBUG("Chunk_reader::read_file - io_uring not available, using a prefetch thread");
+				ret = read_thread(fd, cb);
+			}
+			break;
+		}
+		case Prefetch::THREAD:
+		default:
+		{
+			ret = read_thread(fd, cb);
+			break;
+		}
+	}
+
+	close(fd);
+
+	return ret;
+}
+
+bool Chunk_reader::read_sync(const int fd, const Block_callback& cb)
+{
+	uint64_t offset = 0;
+	for(;;)
+	{
+		size_t len = 0;
+		if( ! read_full(fd, get_buf(0), m_chunk_size, offset, &len) )
+		{
+			return false;
+		}
+
+		if( ! deliver(fd, cb, get_buf(0), len, offset) )
+		{
+			return false;
+		}
+
+		if(len < m_chunk_size)
+		{
+			return true;
+		}
+
+		offset += len;
+	}
+}
+
+bool Chunk_reader::read_thread(const int fd, const Block_callback& cb)
+{
+	// slot i % m_depth holds chunk i, the semaphores hand slots back and forth
+	Futex_semaphore free_slots(static_cast<uint32_t>(m_depth));
+	Futex_semaphore full_slots(0);
+	std::atomic<bool> stop(false);
+
+	// chunk length, or -1 on error
+	std::vector<ssize_t> lens(m_depth, 0);
+
+	std::thread producer([this, fd, &free_slots, &full_slots, &stop, &lens]()
+	{
+		uint64_t offset = 0;
+		for(size_t i = 0; ; i++)
+		{
+			if(( ! free_slots.wait() ) || stop.load(std::memory_order_relaxed))
+			{
+				break;
+			}
+
+			const size_t slot = i % m_depth;
+
+			size_t len = 0;
+			const bool ok = read_full(fd, get_buf(slot), m_chunk_size, offset, &len);
+			lens[slot] = ok ? ssize_t(len) : -1;
+
+			full_slots.post();
+
+			if(( ! ok ) || (len < m_chunk_size))
+			{
+				break;
+			}
+
+			offset += len;
+		}
+	});
+
+	bool ret = true;
+	uint64_t offset = 0;
+	for(size_t i = 0; ; i++)
+	{
+		full_slots.wait();
+
+		const size_t slot = i % m_depth;
+		const ssize_t len = lens[slot];
+		if(len < 0)
+		{
+			ret = false;
+			break;
+		}
+
+		if( ! deliver(fd, cb, get_buf(slot), size_t(len), offset) )
+		{
+			ret = false;
+			break;
+		}
+
+		if(size_t(len) < m_chunk_size)
+		{
+			break;
+		}
+
+		offset += size_t(len);
+		free_slots.post();
+	}
+
+	stop.store(true, std::memory_order_relaxed);
+	free_slots.notify_cancel();
+	producer.join();
+
+	return ret;
+}
+
+bool Chunk_reader::read_uring(const int fd, const Block_callback& cb, bool* const out_unsupported)
+{
+	*out_unsupported = false;
+
+	Io_uring ring;
+	if( ! ring.init(unsigned(m_depth)) )
+	{
+		*out_unsupported = true;
+		return false;
+	}
+
+	std::vector<int32_t> results(m_depth, 0);
+	std::vector<bool> is_done(m_depth, false);
+	size_t in_flight = 0;
+
+	// chunk i is read into slot i % m_depth at offset i * m_chunk_size
+	auto queue_read = [&](const size_t chunk_idx)
+	{
+		io_uring_sqe* const sqe = ring.get_sqe();
+		if( ! sqe )
+		{
+			return false;
+		}
+
+		const size_t slot = chunk_idx % m_depth;
+		Io_uring::prep_read(sqe, fd, get_buf(slot), unsigned(m_chunk_size), uint64_t(chunk_idx) * m_chunk_size, slot);
+		in_flight++;
+		return true;
+	};
+
+	bool ret = true;
+	for(size_t i = 0; i < m_depth; i++)
+	{
+		if( ! queue_read(i) )
+		{
+			ret = false;
+			break;
+		}
+	}
+	if(ret && ( ! ring.submit_and_wait(0) ))
+	{
+		ret = false;
+	}
+
+	for(size_t i = 0; ret; i++)
+	{
+		const size_t slot = i % m_depth;
+
+		while( ! is_done[slot] )
+		{
+			io_uring_cqe cqe;
+			if( ! ring.wait_cqe(&cqe) )
+			{
+				ret = false;
+				break;
+			}
+			in_flight--;
+			is_done[cqe.user_data] = true;
+			results[cqe.user_data] = cqe.res;
+		}
+		if( ! ret )
+		{
+			break;
+		}
+		is_done[slot] = false;
+
+		const uint64_t offset = uint64_t(i) * m_chunk_size;
+		int32_t res = results[slot];
+		if(res < 0)
+		{
+			// IORING_OP_READ is 5.6+, let the caller redo it with the thread if nothing went out yet
+			if((i == 0) && ((res == -EINVAL) || (res == -EOPNOTSUPP)))
+			{
+				*out_unsupported = true;
+			}
+			else
+			{
+				SPDLOG_ERROR("Chunk_reader::read_uring - read failed: {:s}", strerror(-res));
+			}
+			ret = false;
+			break;
+		}
+
+		// short reads are normally EOF, top up in case one was not
+		size_t len = size_t(res);
+		if((len < m_chunk_size) && ( ! m_is_direct_fd ))
+		{
+			size_t extra = 0;
+			if( ! read_full(fd, get_buf(slot) + len, m_chunk_size - len, offset + len, &extra) )
+			{
+				ret = false;
+				break;
+			}
+			len += extra;
+		}
+
+		if( ! deliver(fd, cb, get_buf(slot), len, offset) )
+		{
+			ret = false;
+			break;
+		}
+
+		if(len < m_chunk_size)
+		{
+			break;
+		}
+
+		if(( ! queue_read(i + m_depth) ) || ( ! ring.submit_and_wait(0) ))
+		{
+			ret = false;
+			break;
+		}
+	}
+
+	// the buffers are reused by the next call, wait out any reads past EOF or after an early stop
+	while(in_flight > 0)
+	{
+		io_uring_cqe cqe;
+		if( ! ring.wait_cqe(&cqe) )
+		{
+			break;
+		}
+		in_flight--;
+	}
+
+	return ret;
+}
+
+bool Chunk_reader::read_full(const int fd, uint8_t* const buf, const size_t len, const uint64_t offset, size_t* const out_len) const
+{
+	size_t total = 0;
+	while(total < len)
+	{
+		const ssize_t ret = pread(fd, buf + total, len - total, off_t(offset + total));
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			SPDLOG_ERROR("Chunk_reader::read_full - read failed: {:s}", strerror(errno));
+			return false;
+		}
+		if(ret == 0)
+		{
+			break;
+		}
+		total += size_t(ret);
+
+		// O_DIRECT only returns short at EOF, and the next offset would be misaligned anyway
+		if(m_is_direct_fd && (total < len))
+		{
+			break;
+		}
+	}
+
+	*out_len = total;
+	return true;
+}
+
+bool Chunk_reader::deliver(const int fd, const Block_callback& cb, uint8_t const * const buf, const size_t len, const uint64_t offset)
+{
+	if(len == 0)
+	{
+		return true;
+	}
+
+	if( ! cb(buf, len) )
+	{
+		return false;
+	}
+
+	m_bytes_read += len;
+
+	if(m_drop_behind)
+	{
+		posix_fadvise(fd, off_t(offset), off_t(len), POSIX_FADV_DONTNEED);
+	}
+
+	return true;
+}
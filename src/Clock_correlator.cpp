@@ -0,0 +1,219 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Clock_correlator.hpp"
+
+#include "emb-lin-util/Chronometer.hpp"
+#include "emb-lin-util/Timespec_util.hpp"
+
+#include <spdlog/spdlog.h>
+
+Clock_correlator::Clock_correlator() : m_update_period(std::chrono::seconds(1))
+{
+
+}
+
+Clock_correlator::~Clock_correlator()
+{
+	interrupt();
+	join();
+}
+
+bool Clock_correlator::update()
+{
+	Offsets offsets;
+
+	if( ! measure_offset(&Chronometer::get_real_time, &offsets.real) )
+	{
+		SPDLOG_WARN("Clock_correlator::update - could not measure CLOCK_REALTIME offset");
+		return false;
+	}
+
+	if( ! measure_offset(&Chronometer::get_tai_time, &offsets.tai) )
+	{
+		SPDLOG_WARN("Clock_correlator::update - could not measure CLOCK_TAI offset");
+		return false;
+	}
+
+	m_offsets.store(offsets);
+
+	return true;
+}
+
+bool Clock_correlator::get_offsets(Offsets* const out_offsets) const
+{
+	Offsets offsets;
+	if( ! m_offsets.load(&offsets) )
+	{
+		return false;
+	}
+
+	if(out_offsets)
+	{
+		*out_offsets = offsets;
+	}
+
+	return true;
+}
+
+bool Clock_correlator::mono_to_real(const std::chrono::nanoseconds& t_mono, std::chrono::nanoseconds* const out_t_real) const
+{
+	Offsets offsets;
+	if( ! get_offsets(&offsets) )
+	{
+		return false;
+	}
+
+	if(out_t_real)
+	{
+		*out_t_real = t_mono + offsets.real;
+	}
+
+	return true;
+}
+bool Clock_correlator::mono_to_tai(const std::chrono::nanoseconds& t_mono, std::chrono::nanoseconds* const out_t_tai) const
+{
+	Offsets offsets;
+	if( ! get_offsets(&offsets) )
+	{
+		return false;
+	}
+
+	if(out_t_tai)
+	{
+		*out_t_tai = t_mono + offsets.tai;
+	}
+
+	return true;
+}
+
+bool Clock_correlator::mono_to_real(const timespec& t_mono, timespec* const out_t_real) const
+{
+	std::chrono::nanoseconds t_real;
+	if( ! mono_to_real(Timespec_util::to_chrono<std::chrono::nanoseconds>(t_mono), &t_real) )
+	{
+		return false;
+	}
+
+	if(out_t_real)
+	{
+		*out_t_real = Timespec_util::from_chrono(t_real);
+	}
+
+	return true;
+}
+bool Clock_correlator::mono_to_tai(const timespec& t_mono, timespec* const out_t_tai) const
+{
+	std::chrono::nanoseconds t_tai;
+	if( ! mono_to_tai(Timespec_util::to_chrono<std::chrono::nanoseconds>(t_mono), &t_tai) )
+	{
+		return false;
+	}
+
+	if(out_t_tai)
+	{
+		*out_t_tai = Timespec_util::from_chrono(t_tai);
+	}
+
+	return true;
+}
+
+bool Clock_correlator::mono_to_real(std::chrono::nanoseconds const * const t_mono, const size_t len, std::chrono::nanoseconds* const out_t_real) const
+{
+	if( (len > 0) && ( ( ! t_mono ) || ( ! out_t_real ) ) )
+	{
+		return false;
+	}
+
+	Offsets offsets;
+	if( ! get_offsets(&offsets) )
+	{
+		return false;
+	}
+
+	add_offset(t_mono, len, offsets.real, out_t_real);
+
+	return true;
+}
+bool Clock_correlator::mono_to_tai(std::chrono::nanoseconds const * const t_mono, const size_t len, std::chrono::nanoseconds* const out_t_tai) const
+{
+	if( (len > 0) && ( ( ! t_mono ) || ( ! out_t_tai ) ) )
+	{
+		return false;
+	}
+
+	Offsets offsets;
+	if( ! get_offsets(&offsets) )
+	{
+		return false;
+	}
+
+	add_offset(t_mono, len, offsets.tai, out_t_tai);
+
+	return true;
+}
+
+void Clock_correlator::work()
+{
+	while( ! is_interrupted() )
+	{
+		update();
+
+		wait_for_interruption(m_update_period);
+	}
+}
+
+bool Clock_correlator::measure_offset(bool (*clock_fn)(timespec* const), std::chrono::nanoseconds* const out_offset)
+{
+	std::chrono::nanoseconds best_width = std::chrono::nanoseconds::max();
+
+	for(int i = 0; i < 5; i++)
+	{
+		timespec m0;
+		timespec t;
+		timespec m1;
+
+		if( ! Chronometer::get_mono_time(&m0) )
+		{
+			return false;
+		}
+		if( ! clock_fn(&t) )
+		{
+			return false;
+		}
+		if( ! Chronometer::get_mono_time(&m1) )
+		{
+			return false;
+		}
+
+		const std::chrono::nanoseconds m0_ns = Timespec_util::to_chrono<std::chrono::nanoseconds>(m0);
+		const std::chrono::nanoseconds m1_ns = Timespec_util::to_chrono<std::chrono::nanoseconds>(m1);
+		const std::chrono::nanoseconds t_ns  = Timespec_util::to_chrono<std::chrono::nanoseconds>(t);
+
+		const std::chrono::nanoseconds width = m1_ns - m0_ns;
+		if(width < best_width)
+		{
+			best_width  = width;
+			*out_offset = t_ns - (m0_ns + (width / 2));
+		}
+	}
+
+	return true;
+}
+
+void Clock_correlator::add_offset(std::chrono::nanoseconds const * const in, const size_t len, const std::chrono::nanoseconds& offset, std::chrono::nanoseconds* const out)
+{
+	// plain add over the array so the compiler can vectorize it
+	for(size_t i = 0; i < len; i++)
+	{
+		out[i] = in[i] + offset;
+	}
+}
@@ -0,0 +1,248 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Dir_scanner.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+	// the kernel's record, glibc only wraps getdents64 from 2.30
+	struct linux_dirent64
+	{
+		uint64_t       d_ino;
+		int64_t        d_off;
+		unsigned short d_reclen;
+		unsigned char  d_type;
+		char           d_name[];
+	};
+}
+
+Dir_scanner::Dir_scanner(const size_t buf_size) :
+	m_buf_size(std::max<size_t>(buf_size, 4096U) & ~size_t(7U)),
+	m_buf(std::make_unique<uint64_t[]>(m_buf_size / sizeof(uint64_t)))
+{
+
+}
+
+Dir_scanner::~Dir_scanner()
+{
+
+}
+
+bool Dir_scanner::for_each(const std::string& dir, const Visitor& visit)
+{
+	const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_WARN("Dir_scanner::for_each - could not open {:s}: {:s}", dir, strerror(errno));
+		return false;
+	}
+
+	char* const buf = reinterpret_cast<char*>(m_buf.get());
+
+	bool ret = true;
+	bool keep_going = true;
+	while(keep_going)
+	{
+		const long len = syscall(SYS_getdents64, fd, buf, m_buf_size);
+		if(len < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			SPDLOG_WARN("Dir_scanner::for_each - could not read {:s}: {:s}", dir, strerror(errno));
+			ret = false;
+			break;
+		}
+		if(len == 0)
+		{
+			break;
+		}
+
+		for(long off = 0; off < len; )
+		{
+			const linux_dirent64* const d = reinterpret_cast<const linux_dirent64*>(buf + off);
+			off += d->d_reclen;
+
+			const std::string_view name(d->d_name);
+			if((name == ".") || (name == ".."))
+			{
+				continue;
+			}
+
+			Entry_view ent;
+			ent.name = name;
+			ent.ino  = d->d_ino;
+			ent.type = from_d_type(d->d_type);
+
+			if( ! visit(ent) )
+			{
+				keep_going = false;
+				break;
+			}
+		}
+	}
+
+	close(fd);
+
+	return ret;
+}
+
+bool Dir_scanner::scan(const std::string& dir, const Predicate& pred, std::vector<Entry>* const out_entries)
+{
+	return for_each(dir, [&pred, out_entries](const Entry_view& ent)
+	{
+		if( ( ! pred ) || pred(ent) )
+		{
+			Entry& e = out_entries->emplace_back();
+			e.name = ent.name;
+			e.ino  = ent.ino;
+			e.type = ent.type;
+		}
+		return true;
+	});
+}
+
+bool Dir_scanner::stat_entries(const std::string& dir, std::vector<Entry>* const entries, const size_t num_threads)
+{
+	const int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(dir_fd < 0)
+	{
+		SPDLOG_WARN("Dir_scanner::stat_entries - could not open {:s}: {:s}", dir, strerror(errno));
+		return false;
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<bool> is_error(false);
+
+	// entries are claimed in blocks so the shared counter is not hit per entry
+	constexpr size_t BLOCK = 16;
+	auto worker = [dir_fd, entries, &next, &is_error]()
+	{
+		for(;;)
+		{
+			const size_t begin = next.fetch_add(BLOCK, std::memory_order_relaxed);
+			if(begin >= entries->size())
+			{
+				break;
+			}
+			const size_t end = std::min(begin + BLOCK, entries->size());
+
+			for(size_t i = begin; i < end; i++)
+			{
+				Entry& e = (*entries)[i];
+
+				struct statx stx;
+				if(statx(dir_fd, e.name.c_str(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_MTIME, &stx) != 0)
+				{
+					// deleted since the scan is expected during retention cleanup
+					if(errno != ENOENT)
+					{
+						is_error.store(true, std::memory_order_relaxed);
+					}
+					continue;
+				}
+
+				e.has_stat = true;
+				e.size     = stx.stx_size;
+				e.mtime_ns = (int64_t(stx.stx_mtime.tv_sec) * 1000000000LL) + stx.stx_mtime.tv_nsec;
+				if(e.type == Type::UNKNOWN)
+				{
+					e.type = from_mode(stx.stx_mode);
+				}
+			}
+		}
+	};
+
+	// not worth a thread for a handful of entries
+	const size_t n_threads = std::min(std::max<size_t>(num_threads, 1), (entries->size() + BLOCK - 1) / BLOCK);
+	if(n_threads <= 1)
+	{
+		worker();
+	}
+	else
+	{
+		std::vector<std::thread> threads;
+		threads.reserve(n_threads - 1);
+		for(size_t i = 1; i < n_threads; i++)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+	}
+
+	close(dir_fd);
+
+	return ! is_error.load();
+}
+
+Dir_scanner::Type Dir_scanner::from_d_type(const unsigned char d_type)
+{
+	switch(d_type)
+	{
+		case DT_REG:
+		{
+			return Type::REGULAR;
+		}
+		case DT_DIR:
+		{
+			return Type::DIRECTORY;
+		}
+		case DT_LNK:
+		{
+			return Type::SYMLINK;
+		}
+		case DT_UNKNOWN:
+		{
+			return Type::UNKNOWN;
+		}
+		default:
+		{
+			return Type::OTHER;
+		}
+	}
+}
+
+Dir_scanner::Type Dir_scanner::from_mode(const uint32_t mode)
+{
+	if(S_ISREG(mode))
+	{
+		return Type::REGULAR;
+	}
+	if(S_ISDIR(mode))
+	{
+		return Type::DIRECTORY;
+	}
+	if(S_ISLNK(mode))
+	{
+		return Type::SYMLINK;
+	}
+	return Type::OTHER;
+}
@@ -0,0 +1,489 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Edf_scheduler.hpp"
+
+#include "emb-lin-util/Chronometer.hpp"
+#include "emb-lin-util/Timespec_util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	#include "emb-lin-util/Virtual_clock.hpp"
+#endif
+
+#include <algorithm>
+#include <array>
+
+#include <cerrno>
+#include <cstring>
+
+Edf_scheduler::Edf_scheduler() : m_timer_fd(-1), m_event_fd(-1), m_epoll_fd(-1), m_next_id(1), m_armed_ns(-1)
+{
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	m_vtimer_id = -1;
+#endif
+}
+
+Edf_scheduler::~Edf_scheduler()
+{
+	interrupt();
+	join();
+
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	// before closing the eventfd the callback writes to
+	if(m_vtimer_id >= 0)
+	{
+		Virtual_clock::timer_delete(m_vtimer_id);
+		m_vtimer_id = -1;
+	}
+#endif
+
+	if(m_timer_fd >= 0)
+	{
+		close(m_timer_fd);
+		m_timer_fd = -1;
+	}
+
+	if(m_event_fd >= 0)
+	{
+		close(m_event_fd);
+		m_event_fd = -1;
+	}
+
+	if(m_epoll_fd >= 0)
+	{
+		close(m_epoll_fd);
+		m_epoll_fd = -1;
+	}
+}
+
+bool Edf_scheduler::init()
+{
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	m_timer_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(m_timer_fd < 0)
+	{
+		SPDLOG_ERROR("Edf_scheduler::init - eventfd failed");
+		return false;
+	}
+
+	const int timer_fd = m_timer_fd;
+	if( ! Virtual_clock::timer_create([timer_fd](){ post_fd(timer_fd); }, &m_vtimer_id) )
+	{
+		SPDLOG_ERROR("Edf_scheduler::init - Virtual_clock::timer_create failed");
+		return false;
+	}
+#else
+	m_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if(m_timer_fd < 0)
+	{
+		SPDLOG_ERROR("Edf_scheduler::init - timerfd_create failed");
+		return false;
+	}
+#endif
+
+	m_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(m_event_fd < 0)
+	{
+		SPDLOG_ERROR("Edf_scheduler::init - eventfd failed");
+		return false;
+	}
+
+	m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(m_epoll_fd < 0)
+	{
+		SPDLOG_ERROR("Edf_scheduler::init - epoll_create1 failed");
+		return false;
+	}
+
+	for(const int fd : {m_timer_fd, m_event_fd})
+	{
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events  = EPOLLIN;
+		ev.data.fd = fd;
+		if(epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+		{
+			SPDLOG_ERROR("Edf_scheduler::init - epoll_ctl failed");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Edf_scheduler::add_periodic(const std::chrono::nanoseconds& period, const std::chrono::nanoseconds& rel_deadline, const Task_callback& cb, Task_id* const out_id)
+{
+	if(period <= std::chrono::nanoseconds::zero())
+	{
+		return false;
+	}
+
+	int64_t now;
+	if( ! get_time(&now) )
+	{
+		return false;
+	}
+
+	return add_task(now + period.count(), period.count(), (rel_deadline > std::chrono::nanoseconds::zero()) ? rel_deadline : period, cb, out_id);
+}
+
+bool Edf_scheduler::add_oneshot(const std::chrono::nanoseconds& delay, const std::chrono::nanoseconds& rel_deadline, const Task_callback& cb, Task_id* const out_id)
+{
+	int64_t now;
+	if( ! get_time(&now) )
+	{
+		return false;
+	}
+
+	return add_task(now + std::max<int64_t>(delay.count(), 0), 0, std::max(rel_deadline, std::chrono::nanoseconds::zero()), cb, out_id);
+}
+
+bool Edf_scheduler::remove(const Task_id id)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_task_mutex);
+		if(m_tasks.erase(id) == 0)
+		{
+			return false;
+		}
+	}
+
+	// stale heap entries are skipped lazily
+	return true;
+}
+
+bool Edf_scheduler::get_stats(const Task_id id, Task_stats* const out_stats) const
+{
+	std::lock_guard<std::mutex> lock(m_task_mutex);
+
+	auto it = m_tasks.find(id);
+	if(it == m_tasks.end())
+	{
+		return false;
+	}
+
+	if(out_stats)
+	{
+		*out_stats = it->second.stats;
+	}
+
+	return true;
+}
+
+void Edf_scheduler::interrupt()
+{
+	Thread_base::interrupt();
+	wake();
+}
+
+bool Edf_scheduler::add_task(const int64_t first_release_ns, const int64_t period_ns, const std::chrono::nanoseconds& rel_deadline, const Task_callback& cb, Task_id* const out_id)
+{
+	if( ! cb )
+	{
+		return false;
+	}
+
+	// without init there is no thread to wake, do not leave a task behind that never runs
+	if(m_event_fd < 0)
+	{
+		SPDLOG_ERROR("Edf_scheduler::add_task - not initialised");
+		return false;
+	}
+
+	Task task;
+	task.cb              = std::make_shared<Task_callback>(cb);
+	task.period_ns       = period_ns;
+	task.rel_deadline_ns = rel_deadline.count();
+	task.release_ns      = first_release_ns;
+	task.deadline_ns     = first_release_ns + task.rel_deadline_ns;
+	task.stats           = {};
+
+	Task_id id;
+	{
+		std::lock_guard<std::mutex> lock(m_task_mutex);
+
+		id = m_next_id++;
+		m_tasks.emplace(id, task);
+		m_pending.push({task.release_ns, id, task.release_ns});
+	}
+
+	if(out_id)
+	{
+		*out_id = id;
+	}
+
+	// let the thread re-arm if this is now the earliest release
+	return wake();
+}
+
+void Edf_scheduler::work()
+{
+	std::array<epoll_event, 2> evs;
+
+	while( ! is_interrupted() )
+	{
+		std::shared_ptr<Task_callback> cb;
+		Task_id id       = 0;
+		int64_t job_ns   = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(m_task_mutex);
+
+			int64_t now;
+			if( ! get_time(&now) )
+			{
+				SPDLOG_ERROR("Edf_scheduler::work - clock error");
+				break;
+			}
+
+			release_jobs(now);
+
+			// earliest deadline among released jobs, skipping stale entries
+			while( ! m_ready.empty() )
+			{
+				const Heap_entry ent = m_ready.top();
+				m_ready.pop();
+
+				auto it = m_tasks.find(ent.id);
+				if((it != m_tasks.end()) && (it->second.release_ns == ent.job_ns))
+				{
+					cb     = it->second.cb;
+					id     = ent.id;
+					job_ns = ent.job_ns;
+					break;
+				}
+			}
+
+			if( ! cb )
+			{
+				if( ! arm_timer() )
+				{
+					SPDLOG_ERROR("Edf_scheduler::work - timerfd_settime failed");
+					break;
+				}
+			}
+		}
+
+		if(cb)
+		{
+			int64_t t_start = 0;
+			get_time(&t_start);
+
+			(*cb)();
+
+			int64_t t_end = 0;
+			get_time(&t_end);
+
+			std::lock_guard<std::mutex> lock(m_task_mutex);
+
+			auto it = m_tasks.find(id);
+			if((it == m_tasks.end()) || (it->second.release_ns != job_ns))
+			{
+				// removed while running
+				continue;
+			}
+
+			Task& task = it->second;
+
+			const std::chrono::nanoseconds runtime(t_end - t_start);
+			task.stats.run_count++;
+			task.stats.last_runtime   = runtime;
+			task.stats.max_runtime    = std::max(task.stats.max_runtime, runtime);
+			task.stats.total_runtime += runtime;
+
+			if(t_end > task.deadline_ns)
+			{
+				task.stats.deadline_misses++;
+			}
+
+			if(task.period_ns == 0)
+			{
+				m_tasks.erase(it);
+				continue;
+			}
+
+			// next release, skipping any whose deadline has already passed
+			task.release_ns += task.period_ns;
+			while((task.release_ns + task.rel_deadline_ns) < t_end)
+			{
+				task.release_ns += task.period_ns;
+				task.stats.skipped_releases++;
+			}
+			task.deadline_ns = task.release_ns + task.rel_deadline_ns;
+
+			m_pending.push({task.release_ns, id, task.release_ns});
+
+			continue;
+		}
+
+		int ret = 0;
+		do
+		{
+			ret = epoll_wait(m_epoll_fd, evs.data(), evs.size(), -1);
+		} while((ret < 0) && (errno == EINTR));
+
+		if(ret < 0)
+		{
+			SPDLOG_ERROR("Edf_scheduler::work - epoll_wait failed");
+			break;
+		}
+
+		drain_fds();
+	}
+}
+
+void Edf_scheduler::release_jobs(const int64_t now_ns)
+{
+	while( ( ! m_pending.empty() ) && (m_pending.top().key_ns <= now_ns) )
+	{
+		const Heap_entry ent = m_pending.top();
+		m_pending.pop();
+
+		auto it = m_tasks.find(ent.id);
+		if((it == m_tasks.end()) || (it->second.release_ns != ent.job_ns))
+		{
+			continue;
+		}
+
+		m_ready.push({it->second.deadline_ns, ent.id, ent.job_ns});
+	}
+}
+
+bool Edf_scheduler::arm_timer()
+{
+	// drop stale entries so we do not wake for removed tasks
+	while( ! m_pending.empty() )
+	{
+		auto it = m_tasks.find(m_pending.top().id);
+		if((it != m_tasks.end()) && (it->second.release_ns == m_pending.top().job_ns))
+		{
+			break;
+		}
+
+		m_pending.pop();
+	}
+
+	const int64_t next_ns = m_pending.empty() ? 0 : m_pending.top().key_ns;
+	if(next_ns == m_armed_ns)
+	{
+		return true;
+	}
+
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	// Virtual_clock timers are relative, a release that is already due posts the fd directly
+	const int64_t dt_ns = (next_ns == 0) ? 0 : std::max<int64_t>(next_ns - Virtual_clock::now().count(), 0);
+	if((next_ns != 0) && (dt_ns == 0))
+	{
+		if( ! post_fd(m_timer_fd) )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if( ! Virtual_clock::timer_settime(m_vtimer_id, std::chrono::nanoseconds(dt_ns), std::chrono::nanoseconds::zero()) )
+		{
+			return false;
+		}
+
+		// an advance between reading now and arming moved past the release without seeing the timer
+		if((next_ns != 0) && (Virtual_clock::now().count() >= next_ns))
+		{
+			if( ! post_fd(m_timer_fd) )
+			{
+				return false;
+			}
+		}
+	}
+#else
+	itimerspec new_val;
+	memset(&new_val, 0, sizeof(new_val));
+
+	// zero it_value disarms
+	new_val.it_value = Timespec_util::from_chrono(std::chrono::nanoseconds(next_ns));
+
+	if(timerfd_settime(m_timer_fd, TFD_TIMER_ABSTIME, &new_val, nullptr) != 0)
+	{
+		return false;
+	}
+#endif
+
+	m_armed_ns = next_ns;
+
+	return true;
+}
+
+bool Edf_scheduler::wake()
+{
+	return post_fd(m_event_fd);
+}
+
+bool Edf_scheduler::post_fd(const int fd)
+{
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	const uint64_t val = 1;
+
+	ssize_t ret = 0;
+	do
+	{
+		ret = write(fd, &val, sizeof(val));
+	} while((ret < 0) && (errno == EINTR));
+
+	// EAGAIN means the counter is saturated, which is still a pending wake
+	return (ret == sizeof(val)) || ((ret < 0) && (errno == EAGAIN));
+}
+
+void Edf_scheduler::drain_fds()
+{
+	uint64_t val = 0;
+
+	ssize_t ret = 0;
+	do
+	{
+		ret = read(m_event_fd, &val, sizeof(val));
+	} while((ret < 0) && (errno == EINTR));
+
+	do
+	{
+		ret = read(m_timer_fd, &val, sizeof(val));
+	} while((ret < 0) && (errno == EINTR));
+
+	if(ret == sizeof(val))
+	{
+		// the timer fired and is now disarmed
+		std::lock_guard<std::mutex> lock(m_task_mutex);
+		m_armed_ns = 0;
+	}
+}
+
+bool Edf_scheduler::get_time(int64_t* const out_ns)
+{
+	std::chrono::nanoseconds t;
+	if( ! Chronometer::get_time(&t) )
+	{
+		return false;
+	}
+
+	*out_ns = t.count();
+
+	return true;
+}
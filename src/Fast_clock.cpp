@@ -0,0 +1,251 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Fast_clock.hpp"
+
+#include "emb-lin-util/File_util.hpp"
+#include "emb-lin-util/Timespec_util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <cpuid.h>
+#endif
+
+#include <cstdlib>
+#include <limits>
+#include <thread>
+
+Fast_clock::Fast_clock() : m_counter_enabled(false), m_last_sample({0, 0})
+{
+
+}
+
+Fast_clock::~Fast_clock()
+{
+
+}
+
+bool Fast_clock::init(const std::chrono::nanoseconds& calibration_dt)
+{
+	m_counter_enabled = false;
+
+	if( ! is_counter_invariant() )
+	{
+		SPDLOG_DEBUG("Fast_clock::init - counter is not invariant, using clock_gettime");
+		return true;
+	}
+
+	Sample s0;
+	if( ! take_sample(&s0) )
+	{
+		return false;
+	}
+
+	std::this_thread::sleep_for(calibration_dt);
+
+	Sample s1;
+	if( ! take_sample(&s1) )
+	{
+		return false;
+	}
+
+	if((s1.ctr <= s0.ctr) || (s1.ns <= s0.ns))
+	{
+		SPDLOG_WARN("Fast_clock::init - counter did not advance, using clock_gettime");
+		return true;
+	}
+
+	const unsigned __int128 dns  = uint64_t(s1.ns - s0.ns);
+	const unsigned __int128 dctr = s1.ctr - s0.ctr;
+	const uint64_t mult = uint64_t((dns << MULT_SHIFT) / dctr);
+	if(mult == 0)
+	{
+		SPDLOG_WARN("Fast_clock::init - counter is too fast to scale, using clock_gettime");
+		return true;
+	}
+
+	m_params.store(make_params(s1.ctr, s1.ns, mult));
+	m_last_sample     = s1;
+	m_counter_enabled = true;
+
+	return true;
+}
+
+bool Fast_clock::recalibrate(const std::chrono::nanoseconds& slew_dt, const std::chrono::nanoseconds& step_limit)
+{
+	if( ! m_counter_enabled )
+	{
+		return true;
+	}
+
+	if(slew_dt <= std::chrono::nanoseconds::zero())
+	{
+		return false;
+	}
+
+	Sample sn;
+	if( ! take_sample(&sn) )
+	{
+		return false;
+	}
+
+	if((sn.ctr <= m_last_sample.ctr) || (sn.ns <= m_last_sample.ns))
+	{
+		return false;
+	}
+
+	// observed rate since the last true sample
+	const unsigned __int128 dns  = uint64_t(sn.ns - m_last_sample.ns);
+	const unsigned __int128 dctr = sn.ctr - m_last_sample.ctr;
+	const uint64_t obs_mult = uint64_t((dns << MULT_SHIFT) / dctr);
+	if(obs_mult == 0)
+	{
+		return false;
+	}
+
+	m_last_sample = sn;
+
+	// where we think we are right now
+	const int64_t fast_ns = counter_to_ns(sn.ctr);
+	const int64_t err_ns  = sn.ns - fast_ns;
+
+	if(std::chrono::nanoseconds(std::abs(err_ns)) > step_limit)
+	{
+		SPDLOG_DEBUG("Fast_clock::recalibrate - stepping by {:d} ns", err_ns);
+		m_params.store(make_params(sn.ctr, sn.ns, obs_mult));
+		return true;
+	}
+
+	// pick a scale that brings us back to CLOCK_MONOTONIC after slew_dt worth of counts, then run at the observed rate
+	const unsigned __int128 slew_ns  = uint64_t(slew_dt.count());
+	const unsigned __int128 slew_ctr = (slew_ns << MULT_SHIFT) / obs_mult;
+	const int64_t target_dns = int64_t(slew_dt.count()) + err_ns;
+	if((slew_ctr == 0) || (slew_ctr > uint64_t(std::numeric_limits<int64_t>::max())) || (target_dns <= 0))
+	{
+		m_params.store(make_params(sn.ctr, sn.ns, obs_mult));
+		return true;
+	}
+
+	const uint64_t slew_mult = uint64_t((static_cast<unsigned __int128>(target_dns) << MULT_SHIFT) / slew_ctr);
+
+	// anchor at our estimate for a fresh count so time stays continuous and the window where readers may still load the old scale is short
+	const uint64_t ctr_a = read_counter();
+	const int64_t  ns_a  = counter_to_ns(ctr_a);
+
+	Params params;
+	params.ctr0  = ctr_a;
+	params.ns0   = ns_a;
+	params.mult  = slew_mult;
+	params.ctr1  = ctr_a + uint64_t(slew_ctr);
+	params.ns1   = scale(params.ctr1, ctr_a, ns_a, slew_mult);
+	params.mult1 = obs_mult;
+
+	m_params.store(params);
+
+	return true;
+}
+
+bool Fast_clock::get_time(timespec* const out_time) const
+{
+	if( ! m_counter_enabled )
+	{
+		return Chronometer::get_time(out_time);
+	}
+
+	if(out_time)
+	{
+		const int64_t ns = counter_to_ns(read_counter());
+
+		out_time->tv_sec  = ns / 1000000000LL;
+		out_time->tv_nsec = ns % 1000000000LL;
+	}
+
+	return true;
+}
+
+double Fast_clock::get_counter_freq() const
+{
+	Params params = {0, 0, 0, 0, 0, 0};
+	if( ! m_params.load(&params) || (params.mult1 == 0) )
+	{
+		return 0.0;
+	}
+
+	// the rate after any slew
+	return (double(1ULL << MULT_SHIFT) * 1.0e9) / double(params.mult1);
+}
+
+bool Fast_clock::is_counter_invariant()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	// CPUID.80000007H:EDX[8] - invariant TSC
+	unsigned int eax = 0;
+	unsigned int ebx = 0;
+	unsigned int ecx = 0;
+	unsigned int edx = 0;
+	if( ! __get_cpuid(0x80000007U, &eax, &ebx, &ecx, &edx) )
+	{
+		return false;
+	}
+
+	if( ! (edx & (1U << 8)) )
+	{
+		return false;
+	}
+
+	// the kernel drops the tsc from the list if it finds it unstable, eg unsynchronized between sockets
+	std::string clocksources;
+	if(File_util::readSmallFileLine("/sys/devices/system/clocksource/clocksource0/available_clocksource", &clocksources))
+	{
+		if(clocksources.find("tsc") == std::string::npos)
+		{
+			return false;
+		}
+	}
+
+	return true;
+#elif defined(__aarch64__)
+	// the generic timer runs at a fixed frequency and is synchronized between cores
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Fast_clock::take_sample(Sample* const out_sample)
+{
+	// bracket clock_gettime with counter reads and keep the tightest of a few tries
+	uint64_t best_width = std::numeric_limits<uint64_t>::max();
+
+	for(int i = 0; i < 5; i++)
+	{
+		timespec ts;
+
+		const uint64_t c0 = read_counter();
+		if( ! Chronometer::get_time(&ts) )
+		{
+			return false;
+		}
+		const uint64_t c1 = read_counter();
+
+		const uint64_t width = c1 - c0;
+		if(width < best_width)
+		{
+			best_width = width;
+
+			out_sample->ctr = c0 + (width / 2U);
+			out_sample->ns  = Timespec_util::to_chrono<std::chrono::nanoseconds>(ts).count();
+		}
+	}
+
+	return true;
+}
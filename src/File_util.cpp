@@ -11,17 +11,106 @@
 
 #include "emb-lin-util/File_util.hpp"
 
+#include "emb-lin-util/Rate_limiter.hpp"
+
 #include <boost/lexical_cast.hpp>
 
 #include <spdlog/spdlog.h>
 
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <limits>
 
+namespace
+{
+	// the method copy_file falls back to when one is refused
+	File_util::Copy_method get_fallback(const File_util::Copy_method method)
+	{
+		switch(method)
+		{
+			case File_util::Copy_method::CLONE:
+			{
+				return File_util::Copy_method::COPY_FILE_RANGE;
+			}
+			case File_util::Copy_method::COPY_FILE_RANGE:
+			{
+				return File_util::Copy_method::SENDFILE;
+			}
+			case File_util::Copy_method::SENDFILE:
+			case File_util::Copy_method::READ_WRITE:
+			default:
+			{
+				return File_util::Copy_method::READ_WRITE;
+			}
+		}
+	}
+
+	// errors that mean this method does not work for this pair of files, rather than an IO error
+	// copy_file_range gives EXDEV across filesystems before 5.3, and again for many pairs since 5.19
+	bool is_unsupported(const int err)
+	{
+		return (err == EXDEV) || (err == EINVAL) || (err == ENOSYS) || (err == EOPNOTSUPP) || (err == ENOTTY);
+	}
+
+	// one chunk at the current file positions, returns bytes moved, 0 at EOF, or -1 with errno set
+	ssize_t copy_chunk(const File_util::Copy_method method, const int src_fd, const int dst_fd, const size_t len, std::vector<uint8_t>* const buf)
+	{
+		ssize_t ret = -1;
+		switch(method)
+		{
+			case File_util::Copy_method::COPY_FILE_RANGE:
+			{
+				do
+				{
+					ret = copy_file_range(src_fd, nullptr, dst_fd, nullptr, len, 0);
+				} while((ret < 0) && (errno == EINTR));
+				break;
+			}
+			case File_util::Copy_method::SENDFILE:
+			{
+				do
+				{
+					ret = sendfile(dst_fd, src_fd, nullptr, len);
+				} while((ret < 0) && (errno == EINTR));
+				break;
+			}
+			case File_util::Copy_method::CLONE:
+			case File_util::Copy_method::READ_WRITE:
+			default:
+			{
+				buf->resize(len);
+				do
+				{
+					ret = ::read(src_fd, buf->data(), len);
+				} while((ret < 0) && (errno == EINTR));
+
+				if((ret > 0) && ( ! File_util::write_all(dst_fd, buf->data(), size_t(ret)) ))
+				{
+					// a failed write is never a reason to fall back
+					if(is_unsupported(errno))
+					{
+						errno = EIO;
+					}
+					ret = -1;
+				}
+				break;
+			}
+		}
+
+		return ret;
+	}
+}
+
 bool File_util::readSmallFileLine(char const * const filename, std::string* const out_value)
 {
 	if( ! out_value )
@@ -199,27 +288,182 @@ bool File_util::writeSmallFile(const std::string& filename, uint8_t const * cons
 		return false;
 	}
 
+	if( ! write_all(fd, ptr, len) )
+	{
+		SPDLOG_WARN("File_util::writeSmallFile error on write - {:s}", filename);
+		::close(fd);
+		return false;
+	}
+
+	int ret = ::close(fd);
+	if(ret != 0)
 	{
-		ssize_t ret = ::write(fd, ptr, len);
-		if(ret < 0) // we could retry, it might have been interrupted by a signal
+		SPDLOG_WARN("File_util::writeSmallFile close failed");
+	}
+	return ret == 0;
+}
+
+bool File_util::write_all(const int fd, void const * const ptr, const size_t len)
+{
+	uint8_t const * p = static_cast<uint8_t const *>(ptr);
+	size_t rem = len;
+	while(rem > 0)
+	{
+		const ssize_t ret = ::write(fd, p, rem);
+		if(ret < 0)
 		{
-			SPDLOG_WARN("File_util::writeSmallFile error on write - {:s}", "");
+			if(errno == EINTR)
+			{
+				continue;
+			}
 			return false;
 		}
 
-		if(size_t(ret) != len) // we could retry, it might have been interrupted by a signal
+		p   += ret;
+		rem -= size_t(ret);
+	}
+
+	return true;
+}
+
+bool File_util::copy_file(const std::string& src, const std::string& dst, const Copy_options& opt, Copy_method* const out_method)
+{
+	const int src_fd = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+	if(src_fd < 0)
+	{
+		SPDLOG_WARN("File_util::copy_file - Could not open {:s}: {:s}", src, strerror(errno));
+		return false;
+	}
+
+	struct stat st;
+	if((fstat(src_fd, &st) != 0) || ( ! S_ISREG(st.st_mode) ))
+	{
+		SPDLOG_WARN("File_util::copy_file - {:s} is not a regular file", src);
+		::close(src_fd);
+		return false;
+	}
+
+	// O_TRUNC would destroy the source
+	struct stat dst_st;
+	if((stat(dst.c_str(), &dst_st) == 0) && (dst_st.st_dev == st.st_dev) && (dst_st.st_ino == st.st_ino))
+	{
+		SPDLOG_WARN("File_util::copy_file - {:s} and {:s} are the same file", src, dst);
+		::close(src_fd);
+		return false;
+	}
+
+	const int dst_fd = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 07777);
+	if(dst_fd < 0)
+	{
+		SPDLOG_WARN("File_util::copy_file - Could not open {:s}: {:s}", dst, strerror(errno));
+		::close(src_fd);
+		return false;
+	}
+
+	// O_CREAT is subject to the umask
+	bool ret = fchmod(dst_fd, st.st_mode & 07777) == 0;
+
+	posix_fadvise(src_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	const uint64_t total = uint64_t(st.st_size);
+	Copy_method method   = opt.first_method;
+
+	bool is_done = false;
+	if(ret && (method == Copy_method::CLONE))
+	{
+		if(ioctl(dst_fd, FICLONE, src_fd) == 0)
 		{
-			SPDLOG_WARN("File_util::writeSmallFile wrote unexpected amount");
-			return false;
+			is_done = true;
+			if(opt.progress)
+			{
+				opt.progress(total, total);
+			}
+		}
+		else
+		{
+			method = get_fallback(method);
 		}
 	}
 
-	int ret = ::close(fd);
-	if(ret != 0)
+	const size_t chunk = std::max<size_t>(opt.chunk_size, 1);
+	std::vector<uint8_t> buf;
+	uint64_t copied  = 0;
+	bool have_tokens = false;
+	while(ret && ( ! is_done ))
 	{
-		SPDLOG_WARN("File_util::writeSmallFile close failed");
+		// past the size at open we only probe for EOF, or for data appended since
+		const size_t len = (copied < total) ? size_t(std::min<uint64_t>(chunk, total - copied)) : chunk;
+
+		if(opt.rate_limit && (copied < total) && ( ! have_tokens ))
+		{
+			if( ! opt.rate_limit->acquire(len) )
+			{
+				ret = false;
+				break;
+			}
+			have_tokens = true;
+		}
+
+		const ssize_t n = copy_chunk(method, src_fd, dst_fd, len, &buf);
+		if(n < 0)
+		{
+			if((method != Copy_method::READ_WRITE) && is_unsupported(errno))
+			{
+				method = get_fallback(method);
+				continue;
+			}
+
+			SPDLOG_WARN("File_util::copy_file - error copying {:s} to {:s}: {:s}", src, dst, strerror(errno));
+			ret = false;
+			break;
+		}
+
+		if(n == 0)
+		{
+			// some filesystems report 0 rather than an error for copy_file_range they can not do
+			if((copied < total) && (method != Copy_method::READ_WRITE))
+			{
+				method = get_fallback(method);
+				continue;
+			}
+			break;
+		}
+
+		copied     += uint64_t(n);
+		have_tokens = false;
+
+		if(opt.progress && ( ! opt.progress(copied, total) ))
+		{
+			SPDLOG_DEBUG("File_util::copy_file - canceled {:s}", src);
+			ret = false;
+			break;
+		}
 	}
-	return ret == 0;
+
+	if(ret && opt.sync && (fdatasync(dst_fd) != 0))
+	{
+		SPDLOG_WARN("File_util::copy_file - fdatasync failed for {:s}: {:s}", dst, strerror(errno));
+		ret = false;
+	}
+
+	if(::close(dst_fd) != 0)
+	{
+		ret = false;
+	}
+	::close(src_fd);
+
+	if( ! ret )
+	{
+		unlink(dst.c_str());
+		return false;
+	}
+
+	if(out_method)
+	{
+		*out_method = method;
+	}
+
+	return true;
 }
 
 std::string File_util::getenv_or_empty(char const * const env_name)
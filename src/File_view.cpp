@@ -0,0 +1,180 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/File_view.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+File_view::File_view() : m_is_open(false), m_map(nullptr), m_map_len(0)
+{
+
+}
+
+File_view::~File_view()
+{
+	close();
+}
+
+File_view::File_view(File_view&& other) : m_is_open(other.m_is_open), m_map(other.m_map), m_map_len(other.m_map_len), m_buf(std::move(other.m_buf))
+{
+	other.m_is_open = false;
+	other.m_map     = nullptr;
+	other.m_map_len = 0;
+	other.m_buf.clear();
+}
+
+File_view& File_view::operator=(File_view&& other)
+{
+	if(this != &other)
+	{
+		close();
+
+		m_is_open = other.m_is_open;
+		m_map     = other.m_map;
+		m_map_len = other.m_map_len;
+		m_buf     = std::move(other.m_buf);
+
+		other.m_is_open = false;
+		other.m_map     = nullptr;
+		other.m_map_len = 0;
+		other.m_buf.clear();
+	}
+
+	return *this;
+}
+
+bool File_view::open(const std::string& path, const Advice advice, const bool populate)
+{
+	close();
+
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_WARN("File_view::open - Could not open {:s}", path);
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// procfs reports size 0 and sysfs reports a page, neither can be mapped
+	// an empty regular file cannot be mapped either, the read path gives an empty view
+	if(S_ISREG(st.st_mode) && (st.st_size > 0))
+	{
+		const size_t len = size_t(st.st_size);
+
+		void* const map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+		if(map != MAP_FAILED)
+		{
+			int madv = MADV_NORMAL;
+			switch(advice)
+			{
+				case Advice::SEQUENTIAL: { madv = MADV_SEQUENTIAL; break; }
+				case Advice::RANDOM:     { madv = MADV_RANDOM;     break; }
+				case Advice::NORMAL:
+				default:                 { madv = MADV_NORMAL;     break; }
+			}
+
+			// only a hint
+			if(madvise(map, len, madv) != 0)
+			{
+				SPDLOG_DEBUG("File_view::open - madvise failed on {:s}", path);
+			}
+
+			::close(fd);
+
+			m_map     = map;
+			m_map_len = len;
+			m_is_open = true;
+
+			return true;
+		}
+
+		SPDLOG_DEBUG("File_view::open - mmap failed on {:s}, reading instead", path);
+	}
+
+	const bool ret = read_all(fd);
+
+	::close(fd);
+
+	if( ! ret )
+	{
+		SPDLOG_WARN("File_view::open - Could not read {:s}", path);
+		m_buf.clear();
+		return false;
+	}
+
+	m_is_open = true;
+
+	return true;
+}
+
+void File_view::close()
+{
+	if(m_map)
+	{
+		munmap(m_map, m_map_len);
+		m_map     = nullptr;
+		m_map_len = 0;
+	}
+
+	m_buf.clear();
+	m_buf.shrink_to_fit();
+
+	m_is_open = false;
+}
+
+bool File_view::read_all(const int fd)
+{
+	// size is not known up front, grow until EOF
+	m_buf.resize(4096);
+
+	size_t num_read = 0;
+	for(;;)
+	{
+		if(num_read == m_buf.size())
+		{
+			m_buf.resize(m_buf.size() * 2);
+		}
+
+		const ssize_t ret = read(fd, m_buf.data() + num_read, m_buf.size() - num_read);
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+
+		if(ret == 0)
+		{
+			break;
+		}
+
+		num_read += size_t(ret);
+	}
+
+	m_buf.resize(num_read);
+
+	return true;
+}
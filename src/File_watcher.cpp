@@ -0,0 +1,368 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/File_watcher.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+	// epoll data tags
+	constexpr uint64_t TAG_INOTIFY = 0;
+	constexpr uint64_t TAG_TIMER   = 1;
+	constexpr uint64_t TAG_CANCEL  = 2;
+}
+
+File_watcher::File_watcher() : m_debounce(std::chrono::milliseconds(50)), m_inotify_fd(-1), m_timer_fd(-1), m_cancel_fd(-1), m_epoll_fd(-1)
+{
+
+}
+
+File_watcher::~File_watcher()
+{
+	reset();
+}
+
+bool File_watcher::init(const std::chrono::nanoseconds& debounce)
+{
+	reset();
+
+	m_debounce = std::max(debounce, std::chrono::nanoseconds::zero());
+
+	m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	m_timer_fd   = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	m_cancel_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_epoll_fd   = epoll_create1(EPOLL_CLOEXEC);
+	if((m_inotify_fd < 0) || (m_timer_fd < 0) || (m_cancel_fd < 0) || (m_epoll_fd < 0))
+	{
+		SPDLOG_ERROR("File_watcher::init - could not create fds: {:s}", strerror(errno));
+		reset();
+		return false;
+	}
+
+	const std::array<std::pair<int, uint64_t>, 3> fds = {{
+		{m_inotify_fd, TAG_INOTIFY},
+		{m_timer_fd,   TAG_TIMER},
+		{m_cancel_fd,  TAG_CANCEL}
+	}};
+	for(const auto& fd : fds)
+	{
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events   = EPOLLIN;
+		ev.data.u64 = fd.second;
+		if(epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd.first, &ev) != 0)
+		{
+			reset();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void File_watcher::reset()
+{
+	for(int* const fd : {&m_epoll_fd, &m_inotify_fd, &m_timer_fd, &m_cancel_fd})
+	{
+		if(*fd >= 0)
+		{
+			close(*fd);
+			*fd = -1;
+		}
+	}
+
+	m_dirs.clear();
+}
+
+bool File_watcher::add(const std::shared_ptr<Watched_file_base>& file)
+{
+	if(m_inotify_fd < 0)
+	{
+		return false;
+	}
+
+	std::string dir;
+	std::string name;
+	split_path(file->get_path(), &dir, &name);
+
+	// the same directory always maps to the same wd
+	const int wd = inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+	if(wd < 0)
+	{
+		SPDLOG_ERROR("File_watcher::add - could not watch {:s}: {:s}", dir, strerror(errno));
+		return false;
+	}
+
+	Dir_watch& dw = m_dirs[wd];
+	dw.dir = dir;
+	dw.files.emplace(name, file);
+
+	// a missing file is not an error, it is picked up when created
+	if(access(file->get_path().c_str(), F_OK) == 0)
+	{
+		if( ! file->reload() )
+		{
+			SPDLOG_WARN("File_watcher::add - could not load {:s}", file->get_path());
+		}
+	}
+
+	return true;
+}
+
+bool File_watcher::unwatch(const std::shared_ptr<Watched_file_base>& file)
+{
+	for(auto dir_it = m_dirs.begin(); dir_it != m_dirs.end(); ++dir_it)
+	{
+		auto& files = dir_it->second.files;
+		for(auto it = files.begin(); it != files.end(); ++it)
+		{
+			if(it->second != file)
+			{
+				continue;
+			}
+
+			files.erase(it);
+
+			if(files.empty())
+			{
+				inotify_rm_watch(m_inotify_fd, dir_it->first);
+				m_dirs.erase(dir_it);
+			}
+
+			return arm_timer();
+		}
+	}
+
+	return false;
+}
+
+bool File_watcher::process_events()
+{
+	if(m_epoll_fd < 0)
+	{
+		return false;
+	}
+
+	// drain the timer so a stale expiration does not keep the fd readable
+	uint64_t expirations = 0;
+	if(read(m_timer_fd, &expirations, sizeof(expirations)) < 0)
+	{
+		if(errno != EAGAIN)
+		{
+			return false;
+		}
+	}
+
+	const int64_t now_ns = get_now_ns();
+
+	bool ret = read_inotify(now_ns);
+	ret = reload_due(now_ns) && ret;
+	ret = arm_timer() && ret;
+
+	return ret;
+}
+
+bool File_watcher::wait_and_process(const std::chrono::nanoseconds& timeout, bool* const out_canceled)
+{
+	if(out_canceled)
+	{
+		*out_canceled = false;
+	}
+
+	if(m_epoll_fd < 0)
+	{
+		return false;
+	}
+
+	// round up so a short timeout does not spin
+	const int64_t timeout_ms = (timeout == std::chrono::nanoseconds::max()) ? -1 : std::min<int64_t>((timeout.count() + 999999) / 1000000, std::numeric_limits<int>::max());
+
+	std::array<epoll_event, 3> evs;
+	int ret = 0;
+	do
+	{
+		ret = epoll_wait(m_epoll_fd, evs.data(), int(evs.size()), int(timeout_ms));
+	} while((ret < 0) && (errno == EINTR));
+
+	if(ret < 0)
+	{
+		return false;
+	}
+
+	for(int i = 0; i < ret; i++)
+	{
+		// the eventfd is not read, so the cancel latches
+		if((evs[i].data.u64 == TAG_CANCEL) && out_canceled)
+		{
+			*out_canceled = true;
+		}
+	}
+
+	return process_events();
+}
+
+bool File_watcher::notify_cancel()
+{
+	const uint64_t one = 1;
+	ssize_t ret = 0;
+	do
+	{
+		ret = write(m_cancel_fd, &one, sizeof(one));
+	} while((ret < 0) && (errno == EINTR));
+
+	return ret == sizeof(one);
+}
+
+bool File_watcher::read_inotify(const int64_t now_ns)
+{
+	alignas(inotify_event) std::array<char, 4096> buf;
+
+	for(;;)
+	{
+		const ssize_t len = read(m_inotify_fd, buf.data(), buf.size());
+		if(len < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return errno == EAGAIN;
+		}
+
+		for(ssize_t off = 0; off < len; )
+		{
+			const inotify_event* const ev = reinterpret_cast<const inotify_event*>(buf.data() + off);
+			off += ssize_t(sizeof(inotify_event) + ev->len);
+
+			if(ev->mask & IN_Q_OVERFLOW)
+			{
+				// events were lost, assume everything changed
+				SPDLOG_WARN("File_watcher::read_inotify - queue overflow, reloading all files");
+				for(auto& dw : m_dirs)
+				{
+					for(auto& f : dw.second.files)
+					{
+						f.second->m_is_pending = true;
+						f.second->m_due_ns     = now_ns + m_debounce.count();
+					}
+				}
+				continue;
+			}
+
+			if(ev->len == 0)
+			{
+				continue;
+			}
+
+			const auto dir_it = m_dirs.find(ev->wd);
+			if(dir_it == m_dirs.end())
+			{
+				continue;
+			}
+
+			// trailing edge debounce, each event pushes the reload back
+			const auto range = dir_it->second.files.equal_range(std::string(ev->name));
+			for(auto it = range.first; it != range.second; ++it)
+			{
+				it->second->m_is_pending = true;
+				it->second->m_due_ns     = now_ns + m_debounce.count();
+			}
+		}
+	}
+}
+
+bool File_watcher::reload_due(const int64_t now_ns)
+{
+	bool ret = true;
+
+	for(auto& dw : m_dirs)
+	{
+		for(auto& f : dw.second.files)
+		{
+			Watched_file_base& file = *f.second;
+			if(file.m_is_pending && (file.m_due_ns <= now_ns))
+			{
+				file.m_is_pending = false;
+				if( ! file.reload() )
+				{
+					SPDLOG_WARN("File_watcher::reload_due - could not reload {:s}, keeping the previous copy", file.get_path());
+					ret = false;
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+bool File_watcher::arm_timer()
+{
+	int64_t next_ns = std::numeric_limits<int64_t>::max();
+	for(const auto& dw : m_dirs)
+	{
+		for(const auto& f : dw.second.files)
+		{
+			if(f.second->m_is_pending)
+			{
+				next_ns = std::min(next_ns, f.second->m_due_ns);
+			}
+		}
+	}
+
+	itimerspec its;
+	memset(&its, 0, sizeof(its));
+	if(next_ns != std::numeric_limits<int64_t>::max())
+	{
+		// an all zero it_value disarms, so a due time of exactly zero still needs a nanosecond
+		next_ns = std::max<int64_t>(next_ns, 1);
+		its.it_value.tv_sec  = next_ns / 1000000000LL;
+		its.it_value.tv_nsec = next_ns % 1000000000LL;
+	}
+
+	return timerfd_settime(m_timer_fd, TFD_TIMER_ABSTIME, &its, nullptr) == 0;
+}
+
+void File_watcher::split_path(const std::string& path, std::string* const out_dir, std::string* const out_name)
+{
+	const size_t pos = path.find_last_of('/');
+	if(pos == std::string::npos)
+	{
+		*out_dir  = std::string(".");
+		*out_name = path;
+	}
+	else
+	{
+		*out_dir  = (pos == 0) ? std::string("/") : path.substr(0, pos);
+		*out_name = path.substr(pos + 1);
+	}
+}
+
+int64_t File_watcher::get_now_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+}
@@ -0,0 +1,414 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/File_writer.hpp"
+
+#include "emb-lin-util/Stopwatch.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+File_writer::File_writer(const size_t max_jobs, const size_t max_bytes, const Atomic_file_writer::Sync_mode mode) :
+	m_max_jobs(std::max<size_t>(max_jobs, 1)),
+	m_max_bytes(max_bytes),
+	m_coalesce_window(std::chrono::nanoseconds::zero()),
+	m_queue(m_max_jobs, Mpmc_queue<Job*>::Overflow_policy::BLOCK),
+	m_writer(mode),
+	m_pending_jobs(0),
+	m_pending_bytes(0),
+	m_space_seq(0),
+	m_space_waiters(0),
+	m_submitted(std::make_shared<Metric_counter>()),
+	m_written(std::make_shared<Metric_counter>()),
+	m_superseded(std::make_shared<Metric_counter>()),
+	m_failed(std::make_shared<Metric_counter>()),
+	m_rejected(std::make_shared<Metric_counter>()),
+	m_backpressure_waits(std::make_shared<Metric_counter>()),
+	m_pending_bytes_gauge(std::make_shared<Metric_gauge>()),
+	m_commit_ns(std::make_shared<Metric_histogram>())
+{
+
+}
+
+File_writer::~File_writer()
+{
+	interrupt();
+	join();
+
+	drain();
+}
+
+bool File_writer::bind_metrics(Metrics_registry* const registry, const std::string& prefix)
+{
+	if( ! registry )
+	{
+		return false;
+	}
+
+	auto submitted          = registry->get_counter(prefix   + "_submitted_total",          "File_writer jobs submitted");
+	auto written            = registry->get_counter(prefix   + "_written_total",            "File_writer jobs written");
+	auto superseded         = registry->get_counter(prefix   + "_superseded_total",         "File_writer jobs coalesced into a newer write");
+	auto failed             = registry->get_counter(prefix   + "_failed_total",             "File_writer jobs that failed to write");
+	auto rejected           = registry->get_counter(prefix   + "_rejected_total",           "File_writer jobs rejected for lack of room");
+	auto backpressure_waits = registry->get_counter(prefix   + "_backpressure_waits_total", "File_writer submits that waited for room");
+	auto pending_bytes      = registry->get_gauge(prefix     + "_pending_bytes",            "File_writer bytes queued or being written");
+	auto commit_ns          = registry->get_histogram(prefix + "_commit_ns",                "File_writer batch write time in ns");
+
+	if( ! (submitted && written && superseded && failed && rejected && backpressure_waits && pending_bytes && commit_ns) )
+	{
+		SPDLOG_ERROR("File_writer::bind_metrics - could not register metrics with prefix {:s}", prefix);
+		return false;
+	}
+
+	m_submitted           = submitted;
+	m_written             = written;
+	m_superseded          = superseded;
+	m_failed              = failed;
+	m_rejected            = rejected;
+	m_backpressure_waits  = backpressure_waits;
+	m_pending_bytes_gauge = pending_bytes;
+	m_commit_ns           = commit_ns;
+
+	m_pending_bytes_gauge->set(double(m_pending_bytes.load(std::memory_order_relaxed)));
+
+	return true;
+}
+
+std::future<File_writer::Result> File_writer::submit(const std::string& path, std::vector<uint8_t>&& data, const mode_t mode, const std::chrono::nanoseconds& timeout)
+{
+	std::unique_ptr<Job> job = std::make_unique<Job>();
+	job->path = path;
+	job->data = std::move(data);
+	job->mode = mode;
+
+	std::future<Result> fut = job->promise.get_future();
+
+	if( ! enqueue(std::move(job), timeout) )
+	{
+		std::promise<Result> rejected;
+		rejected.set_value(Result::REJECTED);
+		return rejected.get_future();
+	}
+
+	return fut;
+}
+
+bool File_writer::submit(const std::string& path, std::vector<uint8_t>&& data, const Callback& cb, const mode_t mode, const std::chrono::nanoseconds& timeout)
+{
+	std::unique_ptr<Job> job = std::make_unique<Job>();
+	job->path = path;
+	job->data = std::move(data);
+	job->mode = mode;
+	job->cb   = cb;
+
+	return enqueue(std::move(job), timeout);
+}
+
+std::future<File_writer::Result> File_writer::flush(const std::chrono::nanoseconds& timeout)
+{
+	std::unique_ptr<Job> job = std::make_unique<Job>();
+	job->is_barrier = true;
+
+	std::future<Result> fut = job->promise.get_future();
+
+	if( ! enqueue(std::move(job), timeout) )
+	{
+		std::promise<Result> rejected;
+		rejected.set_value(Result::REJECTED);
+		return rejected.get_future();
+	}
+
+	return fut;
+}
+
+File_writer::Stats File_writer::get_stats() const
+{
+	Stats stats;
+	stats.submitted          = m_submitted->get();
+	stats.written            = m_written->get();
+	stats.superseded         = m_superseded->get();
+	stats.failed             = m_failed->get();
+	stats.rejected           = m_rejected->get();
+	stats.backpressure_waits = m_backpressure_waits->get();
+	stats.pending_jobs       = m_pending_jobs.load(std::memory_order_relaxed);
+	stats.pending_bytes      = m_pending_bytes.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+void File_writer::interrupt()
+{
+	Thread_base::interrupt();
+	m_queue.notify_cancel();
+
+	// wake submits blocked on the budget so they see the cancel
+	m_space_seq.fetch_add(1, std::memory_order_release);
+	Futex_util::wake_waiters(&m_space_seq, &m_space_waiters, INT32_MAX);
+}
+
+void File_writer::work()
+{
+	std::vector<Job*> batch;
+	batch.reserve(m_max_jobs);
+
+	// the bounded pop keeps the heartbeat going while idle
+	// exit only once canceled and empty, so everything queued before interrupt is written
+	Job* job = nullptr;
+	for(;;)
+	{
+		heartbeat();
+
+		if( ! m_queue.pop(&job, std::chrono::milliseconds(250)) )
+		{
+			if(m_queue.is_cancel_requested() && m_queue.empty())
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		batch.push_back(job);
+
+		if((m_coalesce_window > std::chrono::nanoseconds::zero()) && ( ! is_interrupted() ))
+		{
+			wait_for_interruption(m_coalesce_window);
+		}
+
+		while(m_queue.try_pop(&job))
+		{
+			batch.push_back(job);
+		}
+
+		write_batch(&batch);
+	}
+}
+
+bool File_writer::enqueue(std::unique_ptr<Job>&& job, const std::chrono::nanoseconds& timeout)
+{
+	const size_t len = job->data.size();
+
+	bool reserved = (! m_queue.is_cancel_requested()) && try_reserve(len);
+	if( ( ! reserved ) && ( ! m_queue.is_cancel_requested() ) && (timeout > std::chrono::nanoseconds::zero()) )
+	{
+		m_backpressure_waits->add();
+
+		timespec deadline;
+		const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+		reserved = Futex_util::wait_for_state(&m_space_seq, &m_space_waiters,
+			[this, len](const uint32_t)
+			{
+				if(m_queue.is_cancel_requested())
+				{
+					return -1;
+				}
+				return try_reserve(len) ? 1 : 0;
+			},
+			has_deadline ? &deadline : nullptr
+		);
+	}
+
+	if( ! reserved )
+	{
+		m_rejected->add();
+		return false;
+	}
+
+	// the reservation leaves room so this does not fail
+	// a cancel may land between the check above and here, the destructor drains anything pushed after the thread exited
+	m_submitted->add();
+
+	Job* const ptr = job.release();
+	if( ! m_queue.try_push(ptr) )
+	{
+		SPDLOG_ERROR("File_writer::enqueue - queue full despite reservation");
+		std::unique_ptr<Job> discard(ptr);
+		release(1, len);
+		m_rejected->add();
+		return false;
+	}
+
+	return true;
+}
+
+bool File_writer::try_reserve(const size_t len)
+{
+	const uint64_t prev_jobs = m_pending_jobs.fetch_add(1, std::memory_order_acq_rel);
+	if(prev_jobs >= m_max_jobs)
+	{
+		m_pending_jobs.fetch_sub(1, std::memory_order_acq_rel);
+		return false;
+	}
+
+	uint64_t prev_bytes = m_pending_bytes.load(std::memory_order_relaxed);
+	do
+	{
+		// an oversize job goes alone
+		if((prev_bytes != 0) && ((prev_bytes + len) > m_max_bytes))
+		{
+			m_pending_jobs.fetch_sub(1, std::memory_order_acq_rel);
+			return false;
+		}
+	} while( ! m_pending_bytes.compare_exchange_weak(prev_bytes, prev_bytes + len, std::memory_order_acq_rel, std::memory_order_relaxed) );
+
+	m_pending_bytes_gauge->add(double(len));
+
+	return true;
+}
+
+void File_writer::release(const size_t jobs, const size_t bytes)
+{
+	m_pending_bytes.fetch_sub(bytes, std::memory_order_acq_rel);
+	m_pending_jobs.fetch_sub(jobs, std::memory_order_acq_rel);
+	m_pending_bytes_gauge->add(-double(bytes));
+
+	m_space_seq.fetch_add(1, std::memory_order_release);
+	Futex_util::wake_waiters(&m_space_seq, &m_space_waiters, INT32_MAX);
+}
+
+void File_writer::write_batch(std::vector<Job*>* const batch)
+{
+	if(batch->empty())
+	{
+		return;
+	}
+
+	Stopwatch sw;
+	sw.start();
+
+	// latest write per path wins
+	std::unordered_map<std::string, size_t> latest;
+	for(size_t i = 0; i < batch->size(); i++)
+	{
+		const Job* const job = (*batch)[i];
+		if( ! job->is_barrier )
+		{
+			latest[job->path] = i;
+		}
+	}
+
+	std::vector<Result> results(batch->size(), Result::WRITTEN);
+
+	bool any_staged = false;
+	for(size_t i = 0; i < batch->size(); i++)
+	{
+		const Job* const job = (*batch)[i];
+		if(job->is_barrier)
+		{
+			continue;
+		}
+
+		if(latest[job->path] != i)
+		{
+			results[i] = Result::SUPERSEDED;
+			continue;
+		}
+
+		if(m_writer.stage(job->path, job->data.data(), job->data.size(), job->mode))
+		{
+			any_staged = true;
+		}
+		else
+		{
+			SPDLOG_WARN("File_writer::write_batch - could not stage {:s}", job->path);
+			results[i] = Result::FAILED;
+		}
+	}
+
+	// one sync barrier for the whole batch
+	if(any_staged && ( ! m_writer.commit() ))
+	{
+		SPDLOG_WARN("File_writer::write_batch - commit failed");
+		for(size_t i = 0; i < batch->size(); i++)
+		{
+			if(( ! (*batch)[i]->is_barrier ) && (results[i] == Result::WRITTEN))
+			{
+				results[i] = Result::FAILED;
+			}
+		}
+	}
+
+	std::chrono::nanoseconds dt;
+	if(sw.get_time(&dt))
+	{
+		m_commit_ns->record(uint64_t(dt.count()));
+	}
+
+	size_t bytes = 0;
+	for(size_t i = 0; i < batch->size(); i++)
+	{
+		Job* const job = (*batch)[i];
+		bytes += job->data.size();
+
+		complete(job, results[i]);
+		delete job;
+	}
+
+	release(batch->size(), bytes);
+
+	batch->clear();
+}
+
+void File_writer::complete(Job* const job, const Result result)
+{
+	if( ! job->is_barrier )
+	{
+		switch(result)
+		{
+			case Result::WRITTEN:
+			{
+				m_written->add();
+				break;
+			}
+			case Result::SUPERSEDED:
+			{
+				m_superseded->add();
+				break;
+			}
+			case Result::FAILED:
+			{
+				m_failed->add();
+				break;
+			}
+			case Result::REJECTED:
+			default:
+			{
+				m_rejected->add();
+				break;
+			}
+		}
+	}
+
+	if(job->cb)
+	{
+		job->cb(job->path, result);
+	}
+	else
+	{
+		job->promise.set_value(result);
+	}
+}
+
+void File_writer::drain()
+{
+	std::vector<Job*> batch;
+
+	Job* job = nullptr;
+	while(m_queue.try_pop(&job))
+	{
+		batch.push_back(job);
+	}
+
+	write_batch(&batch);
+}
@@ -0,0 +1,87 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Futex_util.hpp"
+
+#include "emb-lin-util/Timespec_util.hpp"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32 bit int");
+
+bool Futex_util::wait(std::atomic<uint32_t>* const addr, const uint32_t expected, const timespec* const deadline)
+{
+	// FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, so spurious wakes do not extend the wait
+	const long ret = syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_BITSET_PRIVATE, expected, deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
+	if(ret == 0)
+	{
+		return true;
+	}
+
+	// EAGAIN - value already changed, EINTR - signal
+	return errno != ETIMEDOUT;
+}
+
+int Futex_util::wake(std::atomic<uint32_t>* const addr, const int count)
+{
+	const long ret = syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+	if(ret < 0)
+	{
+		return 0;
+	}
+
+	return int(ret);
+}
+
+int Futex_util::wake_all(std::atomic<uint32_t>* const addr)
+{
+	return wake(addr, INT_MAX);
+}
+
+bool Futex_util::get_deadline(const std::chrono::nanoseconds& dt, timespec* const out_deadline)
+{
+	if(dt == std::chrono::nanoseconds::max())
+	{
+		return false;
+	}
+
+	// the kernel's clock, not Chronometer, which may be virtual in tests
+	timespec now;
+	if(clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+	{
+		return false;
+	}
+
+	*out_deadline = Timespec_util::add_sat(now, Timespec_util::from_chrono(dt));
+
+	return true;
+}
+
+bool Futex_util::is_expired(const timespec* const deadline)
+{
+	if( ! deadline )
+	{
+		return false;
+	}
+
+	timespec now;
+	if(clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+	{
+		return false;
+	}
+
+	return Timespec_util::compare(now, *deadline) >= 0;
+}
@@ -11,11 +11,13 @@
 
 #include "emb-lin-util/Interval_timer.hpp"
 
-#include <functional>
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	#include "emb-lin-util/Virtual_clock.hpp"
+#endif
 
 #include <cstring>
 
-Interval_timer::Interval_timer() : m_pending_event_count(0), m_pending_cancel(false)
+Interval_timer::Interval_timer()
 {
 
 }
@@ -26,6 +28,17 @@ Interval_timer::~Interval_timer()
 
 bool Interval_timer::init()
 {
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int id = -1;
+	if( ! Virtual_clock::timer_create([this](){ handle_event(sigval{}); }, &id) )
+	{
+		return false;
+	}
+
+	m_timer = id;
+
+	return true;
+#else
 	sigevent sig = {};
 
 	sig.sigev_notify            = SIGEV_THREAD;
@@ -45,6 +58,7 @@ bool Interval_timer::init()
 	m_timer = tim;
 
 	return true;
+#endif
 }
 bool Interval_timer::start(const std::chrono::nanoseconds& dt)
 {
@@ -53,10 +67,7 @@ bool Interval_timer::start(const std::chrono::nanoseconds& dt)
 		return false;
 	}
 
-	{
-		m_pending_event_count = 0;
-		m_pending_cancel      = false;
-	}
+	m_events.reset();
 
 	itimerspec new_val;
 	memset(&new_val, 0, sizeof(new_val));
@@ -67,7 +78,11 @@ bool Interval_timer::start(const std::chrono::nanoseconds& dt)
 	// set the first expiration as 1 interval in future
 	new_val.it_value = new_val.it_interval;
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int ret = Virtual_clock::timer_settime(m_timer.value(), dt, dt) ? 0 : -1;
+#else
 	int ret = timer_settime(m_timer.value(), 0, &new_val, nullptr);
+#endif
 	if(ret != 0)
 	{
 		return false;
@@ -80,7 +95,11 @@ bool Interval_timer::stop()
 	itimerspec new_val;
 	memset(&new_val, 0, sizeof(new_val));
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int ret = Virtual_clock::timer_settime(m_timer.value(), std::chrono::nanoseconds::zero(), std::chrono::nanoseconds::zero()) ? 0 : -1;
+#else
 	int ret = timer_settime(m_timer.value(), 0, &new_val, nullptr);
+#endif
 	if(ret != 0)
 	{
 		return false;
@@ -93,30 +112,19 @@ void Interval_timer::reset()
 {
 	if(m_timer.has_value())
 	{
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+		Virtual_clock::timer_delete(m_timer.value());
+#else
 		timer_delete(m_timer.value());
+#endif
 		m_timer.reset();
 
-		m_pending_event_count = 0;
-		m_pending_cancel      = false;
+		m_events.reset();
 	}
 }
 
 bool Interval_timer::wait_for_event()
 {
-	{
-		std::unique_lock<std::mutex> lock(m_mutex);
-		m_cond_var.wait(lock, std::bind(&Interval_timer::should_wake, this));
-	}
-
-	// in the event of cancelation, m_pending_event_count may be 0
-	// check if it was 0 or less, and undo the subtraction if it was
-	bool consumed_event = true;
-	const int prev = m_pending_event_count.fetch_sub(1);
-	if(prev <= 0)
-	{
-		consumed_event = false;
-		m_pending_event_count++;
-	}
-
-	return consumed_event;
+	// after cancelation this still consumes pending events, then returns false
+	return m_events.wait();
 }
@@ -14,12 +14,21 @@
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	#include "emb-lin-util/Virtual_clock.hpp"
+
+	#include <sys/eventfd.h>
+#endif
+
 #include <cerrno>
 #include <cstring>
 
 Interval_timer_fd::Interval_timer_fd() : m_pending_event_count(0), m_pending_cancel(false)
 {
 	m_timer_fd = -1;
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	m_vtimer_id = -1;
+#endif
 	m_epoll_fd = -1;
 	m_pipe_fd.fill(-1);
 }
@@ -32,12 +41,41 @@ bool Interval_timer_fd::init()
 {
 	reset();
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	m_timer_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(m_timer_fd < 0)
+	{
+		reset();
+		return false;
+	}
+
+	// an eventfd counter reads the same as the timerfd expiration count
+	const int timer_fd = m_timer_fd;
+	const bool vtimer_ok = Virtual_clock::timer_create(
+		[timer_fd]()
+		{
+			const uint64_t one = 1;
+			ssize_t ret = 0;
+			do
+			{
+				ret = write(timer_fd, &one, sizeof(one));
+			} while((ret == -1) && (errno == EINTR));
+		},
+		&m_vtimer_id
+	);
+	if( ! vtimer_ok )
+	{
+		reset();
+		return false;
+	}
+#else
 	m_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | O_NONBLOCK);
 	if(m_timer_fd < 0)
 	{
 		reset();
 		return false;
 	}
+#endif
 
 	m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
 	if(m_epoll_fd < 0)
@@ -95,7 +133,11 @@ bool Interval_timer_fd::start(const std::chrono::nanoseconds& dt)
 	// set the first expiration as 1 interval in future
 	new_val.it_value = new_val.it_interval;
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int ret = Virtual_clock::timer_settime(m_vtimer_id, dt, dt) ? 0 : -1;
+#else
 	int ret = timerfd_settime(m_timer_fd, 0, &new_val, nullptr);
+#endif
 	if(ret != 0)
 	{
 		return false;
@@ -108,17 +150,41 @@ bool Interval_timer_fd::stop()
 	itimerspec new_val;
 	memset(&new_val, 0, sizeof(new_val));
 
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	int ret = Virtual_clock::timer_settime(m_vtimer_id, std::chrono::nanoseconds::zero(), std::chrono::nanoseconds::zero()) ? 0 : -1;
+	if(ret != 0)
+	{
+		return false;
+	}
+
+	// timerfd_settime discards unread expirations, do the same to the eventfd
+	uint64_t discard = 0;
+	if( ! read_counter(&discard) )
+	{
+		return false;
+	}
+#else
 	int ret = timerfd_settime(m_timer_fd, 0, &new_val, nullptr);
 	if(ret != 0)
 	{
 		return false;
 	}
+#endif
 
 	return true;
 }
 
 void Interval_timer_fd::reset()
 {
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	// before closing the eventfd the callback writes to
+	if(m_vtimer_id >= 0)
+	{
+		Virtual_clock::timer_delete(m_vtimer_id);
+		m_vtimer_id = -1;
+	}
+#endif
+
 	if(m_timer_fd >= 0)
 	{
 		int ret = close(m_timer_fd);
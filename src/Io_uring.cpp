@@ -0,0 +1,278 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Io_uring.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+	uint32_t load_acquire(uint32_t* const ptr)
+	{
+		return std::atomic_ref<uint32_t>(*ptr).load(std::memory_order_acquire);
+	}
+	void store_release(uint32_t* const ptr, const uint32_t val)
+	{
+		std::atomic_ref<uint32_t>(*ptr).store(val, std::memory_order_release);
+	}
+
+	template<typename T>
+	T* ring_ptr(void* const base, const uint32_t offset)
+	{
+		return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+	}
+}
+
+Io_uring::Io_uring() :
+	m_ring_fd(-1),
+	m_sq_ring_ptr(MAP_FAILED),
+	m_sq_ring_size(0),
+	m_cq_ring_ptr(MAP_FAILED),
+	m_cq_ring_size(0),
+	m_sqes(nullptr),
+	m_sqes_size(0),
+	m_sq_entries(0),
+	m_sq_khead(nullptr),
+	m_sq_ktail(nullptr),
+	m_sq_mask(0),
+	m_sq_array(nullptr),
+	m_sqe_tail(0),
+	m_sqe_submitted(0),
+	m_cq_khead(nullptr),
+	m_cq_ktail(nullptr),
+	m_cq_mask(0),
+	m_cqes(nullptr)
+{
+
+}
+
+Io_uring::~Io_uring()
+{
+	reset();
+}
+
+bool Io_uring::init(const unsigned entries)
+{
+	reset();
+
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	m_ring_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+	if(m_ring_fd < 0)
+	{
+		SPDLOG_DEBUG("Io_uring::init - io_uring_setup failed, errno {:d}", errno);
+		return false;
+	}
+
+	m_sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+	m_cq_ring_size = params.cq_off.cqes  + (params.cq_entries * sizeof(io_uring_cqe));
+
+	// since 5.4 both rings share one mapping
+	const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if(single_mmap)
+	{
+		m_sq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+		m_cq_ring_size = 0;
+	}
+
+	m_sq_ring_ptr = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+	if(m_sq_ring_ptr == MAP_FAILED)
+	{
+		reset();
+		return false;
+	}
+
+	void* cq_base = m_sq_ring_ptr;
+	if( ! single_mmap )
+	{
+		m_cq_ring_ptr = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+		if(m_cq_ring_ptr == MAP_FAILED)
+		{
+			reset();
+			return false;
+		}
+		cq_base = m_cq_ring_ptr;
+	}
+
+	m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	void* const sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+	if(sqes == MAP_FAILED)
+	{
+		reset();
+		return false;
+	}
+	m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+	m_sq_entries = params.sq_entries;
+	m_sq_khead   = ring_ptr<uint32_t>(m_sq_ring_ptr, params.sq_off.head);
+	m_sq_ktail   = ring_ptr<uint32_t>(m_sq_ring_ptr, params.sq_off.tail);
+	m_sq_mask    = *ring_ptr<uint32_t>(m_sq_ring_ptr, params.sq_off.ring_mask);
+	m_sq_array   = ring_ptr<uint32_t>(m_sq_ring_ptr, params.sq_off.array);
+
+	m_cq_khead = ring_ptr<uint32_t>(cq_base, params.cq_off.head);
+	m_cq_ktail = ring_ptr<uint32_t>(cq_base, params.cq_off.tail);
+	m_cq_mask  = *ring_ptr<uint32_t>(cq_base, params.cq_off.ring_mask);
+	m_cqes     = ring_ptr<io_uring_cqe>(cq_base, params.cq_off.cqes);
+
+	// SQEs are used in order, so the indirection array is the identity
+	for(uint32_t i = 0; i < m_sq_entries; i++)
+	{
+		m_sq_array[i] = i;
+	}
+
+	m_sqe_tail      = *m_sq_ktail;
+	m_sqe_submitted = m_sqe_tail;
+
+	return true;
+}
+
+void Io_uring::reset()
+{
+	if(m_sqes)
+	{
+		munmap(m_sqes, m_sqes_size);
+		m_sqes = nullptr;
+	}
+
+	if(m_cq_ring_ptr != MAP_FAILED)
+	{
+		munmap(m_cq_ring_ptr, m_cq_ring_size);
+		m_cq_ring_ptr = MAP_FAILED;
+	}
+
+	if(m_sq_ring_ptr != MAP_FAILED)
+	{
+		munmap(m_sq_ring_ptr, m_sq_ring_size);
+		m_sq_ring_ptr = MAP_FAILED;
+	}
+
+	if(m_ring_fd >= 0)
+	{
+		close(m_ring_fd);
+		m_ring_fd = -1;
+	}
+
+	m_sq_entries = 0;
+}
+
+io_uring_sqe* Io_uring::get_sqe()
+{
+	if( ! is_open() )
+	{
+		return nullptr;
+	}
+
+	const uint32_t head = load_acquire(m_sq_khead);
+	if((m_sqe_tail - head) >= m_sq_entries)
+	{
+		return nullptr;
+	}
+
+	io_uring_sqe* const sqe = &m_sqes[m_sqe_tail & m_sq_mask];
+	m_sqe_tail++;
+
+	memset(sqe, 0, sizeof(*sqe));
+
+	return sqe;
+}
+
+bool Io_uring::submit_and_wait(const unsigned wait_nr)
+{
+	if( ! is_open() )
+	{
+		return false;
+	}
+
+	store_release(m_sq_ktail, m_sqe_tail);
+
+	for(;;)
+	{
+		const unsigned to_submit = m_sqe_tail - m_sqe_submitted;
+		const unsigned flags     = (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0U;
+
+		const int ret = int(syscall(__NR_io_uring_enter, m_ring_fd, to_submit, wait_nr, flags, nullptr, 0));
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+
+		m_sqe_submitted += unsigned(ret);
+
+		return true;
+	}
+}
+
+bool Io_uring::pop_cqe(io_uring_cqe* const out_cqe)
+{
+	if( ! is_open() )
+	{
+		return false;
+	}
+
+	const uint32_t head = *m_cq_khead;
+	if(head == load_acquire(m_cq_ktail))
+	{
+		return false;
+	}
+
+	*out_cqe = m_cqes[head & m_cq_mask];
+	store_release(m_cq_khead, head + 1);
+
+	return true;
+}
+
+bool Io_uring::wait_cqe(io_uring_cqe* const out_cqe)
+{
+	while( ! pop_cqe(out_cqe) )
+	{
+		if( ! submit_and_wait(1) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Io_uring::prep_read(io_uring_sqe* const sqe, const int fd, void* const buf, const unsigned len, const uint64_t offset, const uint64_t user_data)
+{
+	sqe->opcode    = IORING_OP_READ;
+	sqe->fd        = fd;
+	sqe->addr      = reinterpret_cast<uint64_t>(buf);
+	sqe->len       = len;
+	sqe->off       = offset;
+	sqe->user_data = user_data;
+}
+
+void Io_uring::prep_write(io_uring_sqe* const sqe, const int fd, void const * const buf, const unsigned len, const uint64_t offset, const uint64_t user_data)
+{
+	sqe->opcode    = IORING_OP_WRITE;
+	sqe->fd        = fd;
+	sqe->addr      = reinterpret_cast<uint64_t>(buf);
+	sqe->len       = len;
+	sqe->off       = offset;
+	sqe->user_data = user_data;
+}
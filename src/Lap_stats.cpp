@@ -0,0 +1,126 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Lap_stats.hpp"
+
+#include <limits>
+
+Lap_stats::Lap_stats()
+{
+	reset();
+}
+
+Lap_stats::~Lap_stats()
+{
+
+}
+
+void Lap_stats::record(const std::chrono::nanoseconds& dt)
+{
+	const int64_t val = (dt.count() < 0) ? 0 : dt.count();
+
+	int64_t shift = m_shift.load(std::memory_order_relaxed);
+	if(shift == SHIFT_UNSET)
+	{
+		// first sample picks the shift, if we lose the race shift is updated to the winner's value
+		if(m_shift.compare_exchange_strong(shift, val, std::memory_order_relaxed))
+		{
+			shift = val;
+		}
+	}
+
+	const double d = double(val - shift);
+	m_sum.fetch_add(d,        std::memory_order_relaxed);
+	m_sum_sq.fetch_add(d * d, std::memory_order_relaxed);
+
+	int64_t prev_min = m_min.load(std::memory_order_relaxed);
+	while((val < prev_min) && ( ! m_min.compare_exchange_weak(prev_min, val, std::memory_order_relaxed) ))
+	{
+
+	}
+
+	int64_t prev_max = m_max.load(std::memory_order_relaxed);
+	while((val > prev_max) && ( ! m_max.compare_exchange_weak(prev_max, val, std::memory_order_relaxed) ))
+	{
+
+	}
+
+	m_hist.record(uint64_t(val));
+
+	m_count.fetch_add(1, std::memory_order_release);
+}
+
+bool Lap_stats::get_snapshot(Snapshot* const out_snapshot) const
+{
+	if( ! out_snapshot )
+	{
+		return false;
+	}
+
+	const uint64_t count = m_count.load(std::memory_order_acquire);
+
+	out_snapshot->count = count;
+	if(count == 0)
+	{
+		out_snapshot->min      = std::chrono::nanoseconds::zero();
+		out_snapshot->max      = std::chrono::nanoseconds::zero();
+		out_snapshot->mean     = std::chrono::nanoseconds::zero();
+		out_snapshot->variance = 0.0;
+		out_snapshot->p50      = std::chrono::nanoseconds::zero();
+		out_snapshot->p90      = std::chrono::nanoseconds::zero();
+		out_snapshot->p99      = std::chrono::nanoseconds::zero();
+		out_snapshot->p999     = std::chrono::nanoseconds::zero();
+		return true;
+	}
+
+	const double  n      = double(count);
+	const int64_t shift  = m_shift.load(std::memory_order_relaxed);
+	const double  sum    = m_sum.load(std::memory_order_relaxed);
+	const double  sum_sq = m_sum_sq.load(std::memory_order_relaxed);
+
+	out_snapshot->min  = std::chrono::nanoseconds(m_min.load(std::memory_order_relaxed));
+	out_snapshot->max  = std::chrono::nanoseconds(m_max.load(std::memory_order_relaxed));
+	out_snapshot->mean = std::chrono::nanoseconds(shift + int64_t(sum / n));
+
+	if(count > 1)
+	{
+		const double var = (sum_sq - ((sum * sum) / n)) / (n - 1.0);
+		out_snapshot->variance = (var > 0.0) ? var : 0.0;
+	}
+	else
+	{
+		out_snapshot->variance = 0.0;
+	}
+
+	Histogram::Counts counts = {};
+	m_hist.accumulate(&counts);
+
+	out_snapshot->p50  = std::chrono::nanoseconds(Histogram::value_at_quantile(counts, 0.50));
+	out_snapshot->p90  = std::chrono::nanoseconds(Histogram::value_at_quantile(counts, 0.90));
+	out_snapshot->p99  = std::chrono::nanoseconds(Histogram::value_at_quantile(counts, 0.99));
+	out_snapshot->p999 = std::chrono::nanoseconds(Histogram::value_at_quantile(counts, 0.999));
+
+	return true;
+}
+
+void Lap_stats::reset()
+{
+	m_count.store(0, std::memory_order_relaxed);
+
+	m_min.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+	m_max.store(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+
+	m_shift.store(SHIFT_UNSET, std::memory_order_relaxed);
+	m_sum.store(0.0,           std::memory_order_relaxed);
+	m_sum_sq.store(0.0,        std::memory_order_relaxed);
+
+	m_hist.reset();
+}
@@ -0,0 +1,351 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Metrics.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+	void append_double(const double val, std::string* const out_text)
+	{
+		if(std::isnan(val))
+		{
+			out_text->append("NaN");
+		}
+		else if(std::isinf(val))
+		{
+			out_text->append((val > 0.0) ? "+Inf" : "-Inf");
+		}
+		else
+		{
+			fmt::format_to(std::back_inserter(*out_text), "{}", val);
+		}
+	}
+
+	// name{labels} or name{labels,extra}
+	void append_series(const std::string& name, char const * const suffix, const std::string& labels, char const * const extra, std::string* const out_text)
+	{
+		out_text->append(name);
+		out_text->append(suffix);
+
+		if( ( ! labels.empty() ) || extra )
+		{
+			out_text->push_back('{');
+			out_text->append(labels);
+			if(extra)
+			{
+				if( ! labels.empty() )
+				{
+					out_text->push_back(',');
+				}
+				out_text->append(extra);
+			}
+			out_text->push_back('}');
+		}
+
+		out_text->push_back(' ');
+	}
+
+	// HELP text escapes backslash and newline
+	void append_help(const std::string& help, std::string* const out_text)
+	{
+		for(const char c : help)
+		{
+			if(c == '\\')
+			{
+				out_text->append("\\\\");
+			}
+			else if(c == '\n')
+			{
+				out_text->append("\\n");
+			}
+			else
+			{
+				out_text->push_back(c);
+			}
+		}
+	}
+}
+
+Metrics_registry::Metrics_registry()
+{
+
+}
+
+Metrics_registry::~Metrics_registry()
+{
+
+}
+
+std::shared_ptr<Metric_counter> Metrics_registry::get_counter(const std::string& name, const std::string& help, const Labels& labels)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Family::Member* const member = get_member(name, help, labels, Type::COUNTER);
+	if( ! member )
+	{
+		return std::shared_ptr<Metric_counter>();
+	}
+
+	if( ! member->counter )
+	{
+		member->counter = std::make_shared<Metric_counter>();
+	}
+
+	return member->counter;
+}
+
+std::shared_ptr<Metric_gauge> Metrics_registry::get_gauge(const std::string& name, const std::string& help, const Labels& labels)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Family::Member* const member = get_member(name, help, labels, Type::GAUGE);
+	if( ! member )
+	{
+		return std::shared_ptr<Metric_gauge>();
+	}
+
+	if( ! member->gauge )
+	{
+		member->gauge = std::make_shared<Metric_gauge>();
+	}
+
+	return member->gauge;
+}
+
+std::shared_ptr<Metric_histogram> Metrics_registry::get_histogram(const std::string& name, const std::string& help, const Labels& labels)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Family::Member* const member = get_member(name, help, labels, Type::HISTOGRAM);
+	if( ! member )
+	{
+		return std::shared_ptr<Metric_histogram>();
+	}
+
+	if( ! member->histogram )
+	{
+		member->histogram = std::make_shared<Metric_histogram>();
+	}
+
+	return member->histogram;
+}
+
+void Metrics_registry::remove(const std::string& name, const Labels& labels)
+{
+	std::string label_text;
+	if( ! render_labels(labels, &label_text) )
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_families.find(name);
+	if(it == m_families.end())
+	{
+		return;
+	}
+
+	it->second.members.erase(label_text);
+	if(it->second.members.empty())
+	{
+		m_families.erase(it);
+	}
+}
+
+void Metrics_registry::render_prometheus(std::string* const out_text) const
+{
+	static constexpr std::array<std::pair<double, char const *>, 5> QUANTILES = {{
+		{0.5,   "quantile=\"0.5\""},
+		{0.9,   "quantile=\"0.9\""},
+		{0.99,  "quantile=\"0.99\""},
+		{0.999, "quantile=\"0.999\""},
+		{1.0,   "quantile=\"1\""}
+	}};
+
+	// reused between families
+	Metric_histogram::Histogram::Counts counts;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for(const auto& [name, family] : m_families)
+	{
+		char const * type_name = "untyped";
+		switch(family.type)
+		{
+			case Type::COUNTER:   { type_name = "counter"; break; }
+			case Type::GAUGE:     { type_name = "gauge";   break; }
+			case Type::HISTOGRAM: { type_name = "summary"; break; }
+			default:              { break; }
+		}
+
+		if( ! family.help.empty() )
+		{
+			out_text->append("# HELP ");
+			out_text->append(name);
+			out_text->push_back(' ');
+			append_help(family.help, out_text);
+			out_text->push_back('\n');
+		}
+		fmt::format_to(std::back_inserter(*out_text), "# TYPE {:s} {:s}\n", name, type_name);
+
+		for(const auto& [labels, member] : family.members)
+		{
+			switch(family.type)
+			{
+				case Type::COUNTER:
+				{
+					append_series(name, "", labels, nullptr, out_text);
+					fmt::format_to(std::back_inserter(*out_text), "{:d}\n", member.counter->get());
+					break;
+				}
+				case Type::GAUGE:
+				{
+					append_series(name, "", labels, nullptr, out_text);
+					append_double(member.gauge->get(), out_text);
+					out_text->push_back('\n');
+					break;
+				}
+				case Type::HISTOGRAM:
+				{
+					counts.fill(0);
+					const uint64_t sum = member.histogram->accumulate(&counts);
+
+					uint64_t count = 0;
+					for(const uint64_t c : counts)
+					{
+						count += c;
+					}
+
+					for(const auto& [q, q_label] : QUANTILES)
+					{
+						append_series(name, "", labels, q_label, out_text);
+						if(count == 0)
+						{
+							out_text->append("NaN\n");
+						}
+						else
+						{
+							fmt::format_to(std::back_inserter(*out_text), "{:d}\n", Metric_histogram::Histogram::value_at_quantile(counts, q));
+						}
+					}
+
+					append_series(name, "_sum", labels, nullptr, out_text);
+					fmt::format_to(std::back_inserter(*out_text), "{:d}\n", sum);
+
+					append_series(name, "_count", labels, nullptr, out_text);
+					fmt::format_to(std::back_inserter(*out_text), "{:d}\n", count);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool Metrics_registry::is_valid_name(const std::string& name)
+{
+	// [a-zA-Z_:][a-zA-Z0-9_:]*
+	if(name.empty())
+	{
+		return false;
+	}
+
+	for(size_t i = 0; i < name.size(); i++)
+	{
+		const char c = name[i];
+
+		const bool is_alpha = ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_') || (c == ':');
+		const bool is_digit = (c >= '0') && (c <= '9');
+
+		if( ! (is_alpha || ((i > 0) && is_digit)) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+Metrics_registry::Family::Member* Metrics_registry::get_member(const std::string& name, const std::string& help, const Labels& labels, const Type type)
+{
+	if( ! is_valid_name(name) )
+	{
+		SPDLOG_WARN("Metrics_registry - invalid metric name {:s}", name);
+		return nullptr;
+	}
+
+	std::string label_text;
+	if( ! render_labels(labels, &label_text) )
+	{
+		SPDLOG_WARN("Metrics_registry - invalid label name on {:s}", name);
+		return nullptr;
+	}
+
+	auto it = m_families.find(name);
+	if(it == m_families.end())
+	{
+		it = m_families.emplace(name, Family{type, help, {}}).first;
+	}
+	else if(it->second.type != type)
+	{
+		SPDLOG_WARN("Metrics_registry - {:s} is already registered with another type", name);
+		return nullptr;
+	}
+
+	return &(it->second.members[label_text]);
+}
+
+bool Metrics_registry::render_labels(const Labels& labels, std::string* const out_text)
+{
+	for(size_t i = 0; i < labels.size(); i++)
+	{
+		const auto& [key, val] = labels[i];
+
+		// names starting with __ are reserved for Prometheus
+		if( ( ! is_valid_name(key) ) || (key.find(':') != std::string::npos) || (key.rfind("__", 0) == 0) )
+		{
+			return false;
+		}
+
+		if(i > 0)
+		{
+			out_text->push_back(',');
+		}
+
+		out_text->append(key);
+		out_text->append("=\"");
+		for(const char c : val)
+		{
+			switch(c)
+			{
+				case '\\': { out_text->append("\\\\"); break; }
+				case '"':  { out_text->append("\\\""); break; }
+				case '\n': { out_text->append("\\n");  break; }
+				default:   { out_text->push_back(c);   break; }
+			}
+		}
+		out_text->push_back('"');
+	}
+
+	return true;
+}
@@ -0,0 +1,202 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Metrics_exporter.hpp"
+
+#include "emb-lin-util/File_util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+Metrics_exporter::Metrics_exporter()
+{
+
+}
+
+Metrics_exporter::~Metrics_exporter()
+{
+	interrupt();
+	join();
+
+	m_timer.reset();
+}
+
+bool Metrics_exporter::init(const std::shared_ptr<const Metrics_registry>& registry, const std::chrono::nanoseconds& period)
+{
+	if( ( ! registry ) || (period <= std::chrono::nanoseconds::zero()) )
+	{
+		return false;
+	}
+
+	m_registry = registry;
+
+	m_timer.reset();
+	return m_timer.init() && m_timer.start(period);
+}
+
+bool Metrics_exporter::export_now()
+{
+	if( ! m_registry )
+	{
+		return false;
+	}
+
+	m_text.clear();
+	m_registry->render_prometheus(&m_text);
+
+	bool ret = true;
+
+	if( ! m_file_path.empty() )
+	{
+		ret = write_file(m_text) && ret;
+	}
+
+	if( ! m_socket_path.empty() )
+	{
+		ret = write_socket(m_text) && ret;
+	}
+
+	return ret;
+}
+
+void Metrics_exporter::interrupt()
+{
+	Thread_base::interrupt();
+	m_timer.notify_cancel();
+}
+
+void Metrics_exporter::work()
+{
+	while( ! is_interrupted() )
+	{
+		bool got_event = false;
+		if( ! m_timer.wait_for_event(&got_event) )
+		{
+			SPDLOG_ERROR("Metrics_exporter::work - wait_for_event failed");
+			break;
+		}
+
+		if( ( ! got_event ) || is_interrupted() )
+		{
+			continue;
+		}
+
+		if( ! export_now() )
+		{
+			SPDLOG_WARN("Metrics_exporter::work - export failed");
+		}
+	}
+
+	m_timer.stop();
+}
+
+bool Metrics_exporter::write_file(const std::string& text) const
+{
+	const std::string tmp_path = m_file_path + ".tmp";
+
+	const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, (S_IRUSR | S_IWUSR) | (S_IRGRP | S_IROTH));
+	if(fd < 0)
+	{
+		SPDLOG_WARN("Metrics_exporter::write_file - Could not open {:s}", tmp_path);
+		return false;
+	}
+
+	bool ret = File_util::write_all(fd, text.data(), text.size());
+
+	if(::close(fd) != 0)
+	{
+		ret = false;
+	}
+
+	if( ! ret )
+	{
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	if(rename(tmp_path.c_str(), m_file_path.c_str()) != 0)
+	{
+		SPDLOG_WARN("Metrics_exporter::write_file - Could not rename {:s}", tmp_path);
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool Metrics_exporter::write_socket(const std::string& text) const
+{
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	if(m_socket_path.size() >= sizeof(addr.sun_path))
+	{
+		return false;
+	}
+	memcpy(addr.sun_path, m_socket_path.data(), m_socket_path.size());
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	int ret = 0;
+	do
+	{
+		ret = connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+	} while((ret != 0) && (errno == EINTR));
+
+	if(ret != 0)
+	{
+		SPDLOG_DEBUG("Metrics_exporter::write_socket - Could not connect to {:s}", m_socket_path);
+		::close(fd);
+		return false;
+	}
+
+	// no SIGPIPE if the collector hung up
+	bool success = true;
+	char const * ptr = text.data();
+	size_t len = text.size();
+	while(len > 0)
+	{
+		const ssize_t n = send(fd, ptr, len, MSG_NOSIGNAL);
+		if(n < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			success = false;
+			break;
+		}
+
+		ptr += n;
+		len -= size_t(n);
+	}
+
+	if(::close(fd) != 0)
+	{
+		success = false;
+	}
+
+	return success;
+}
@@ -0,0 +1,244 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Profile_flusher.hpp"
+
+#include "emb-lin-util/File_util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fmt/format.h>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+Profile_flusher::Profile_flusher() : m_fd(-1), m_format(Format::CHROME_JSON), m_first_event(true), m_pid(getpid()), m_flush_period(std::chrono::milliseconds(100))
+{
+
+}
+
+Profile_flusher::~Profile_flusher()
+{
+	interrupt();
+	join();
+
+	if(m_fd >= 0)
+	{
+		close();
+	}
+}
+
+bool Profile_flusher::open(const std::string& path, const Format format)
+{
+	if(m_fd >= 0)
+	{
+		return false;
+	}
+
+	m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, (S_IRUSR | S_IWUSR) | (S_IRGRP));
+	if(m_fd < 0)
+	{
+		SPDLOG_WARN("Profile_flusher::open - Could not open {:s}", path);
+		return false;
+	}
+
+	m_format      = format;
+	m_first_event = true;
+	m_name_ids.clear();
+	m_out.clear();
+
+	switch(m_format)
+	{
+		case Format::CHROME_JSON:
+		{
+			m_out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+			break;
+		}
+		case Format::BINARY:
+		{
+			const uint32_t version = 1;
+			m_out.append("EMBPROF", 8);
+			m_out.append(reinterpret_cast<char const *>(&version), sizeof(version));
+			break;
+		}
+		default:
+		{
+			return false;
+		}
+	}
+
+	return write_out();
+}
+
+bool Profile_flusher::flush()
+{
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	Profiler::get_buffers(&m_buffers);
+
+	for(const auto& buf : m_buffers)
+	{
+		m_events.clear();
+		buf->drain(&m_events);
+
+		for(const Profile_event& ev : m_events)
+		{
+			format_event(ev, buf->get_tid());
+		}
+	}
+
+	m_buffers.clear();
+
+	Profiler::prune_buffers();
+
+	return write_out();
+}
+
+bool Profile_flusher::close()
+{
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	bool ret = flush();
+
+	if(m_format == Format::CHROME_JSON)
+	{
+		m_out.append("\n]}\n");
+		ret = write_out() && ret;
+	}
+
+	if(::close(m_fd) != 0)
+	{
+		ret = false;
+	}
+	m_fd = -1;
+
+	return ret;
+}
+
+uint64_t Profile_flusher::get_dropped_count() const
+{
+	return Profiler::get_dropped_count();
+}
+
+void Profile_flusher::work()
+{
+	while( ! is_interrupted() )
+	{
+		if( ! flush() )
+		{
+			SPDLOG_WARN("Profile_flusher::work - flush failed");
+		}
+
+		wait_for_interruption(m_flush_period);
+	}
+
+	flush();
+}
+
+void Profile_flusher::format_event(const Profile_event& ev, const uint32_t tid)
+{
+	switch(m_format)
+	{
+		case Format::CHROME_JSON:
+		{
+			if( ! m_first_event )
+			{
+				m_out.append(",\n");
+			}
+			m_first_event = false;
+
+			// names are expected to be identifiers or short literals, escape the characters JSON requires
+			m_out.append("{\"name\":\"");
+			for(char const * c = ev.name; *c != '\0'; c++)
+			{
+				const uint8_t ch = uint8_t(*c);
+				if((ch == '"') || (ch == '\\'))
+				{
+					m_out.push_back('\\');
+					m_out.push_back(*c);
+				}
+				else if(ch < 0x20U)
+				{
+					// control characters U+0000 - U+001F
+					fmt::format_to(std::back_inserter(m_out), "\\u{:04x}", unsigned(ch));
+				}
+				else
+				{
+					m_out.push_back(*c);
+				}
+			}
+
+			const char ph = (ev.type == Profile_event::Type::BEGIN) ? 'B' : 'E';
+			fmt::format_to(std::back_inserter(m_out), "\",\"ph\":\"{:c}\",\"ts\":{:d}.{:03d},\"pid\":{:d},\"tid\":{:d}}}", ph, ev.t_ns / 1000, ev.t_ns % 1000, m_pid, tid);
+			break;
+		}
+		case Format::BINARY:
+		{
+			const uint32_t name_id = get_name_id(ev.name);
+
+			const uint8_t kind = 1;
+			const uint8_t type = uint8_t(ev.type);
+			m_out.append(reinterpret_cast<char const *>(&kind),    sizeof(kind));
+			m_out.append(reinterpret_cast<char const *>(&type),    sizeof(type));
+			m_out.append(reinterpret_cast<char const *>(&tid),     sizeof(tid));
+			m_out.append(reinterpret_cast<char const *>(&name_id), sizeof(name_id));
+			m_out.append(reinterpret_cast<char const *>(&ev.t_ns), sizeof(ev.t_ns));
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+uint32_t Profile_flusher::get_name_id(char const * const name)
+{
+	auto it = m_name_ids.find(name);
+	if(it != m_name_ids.end())
+	{
+		return it->second;
+	}
+
+	const uint32_t name_id = uint32_t(m_name_ids.size());
+	m_name_ids.emplace(name, name_id);
+
+	// emit the definition before first use
+	const uint8_t  kind = 0;
+	const uint16_t len  = uint16_t(strnlen(name, UINT16_MAX));
+	m_out.append(reinterpret_cast<char const *>(&kind),    sizeof(kind));
+	m_out.append(reinterpret_cast<char const *>(&name_id), sizeof(name_id));
+	m_out.append(reinterpret_cast<char const *>(&len),     sizeof(len));
+	m_out.append(name, len);
+
+	return name_id;
+}
+
+bool Profile_flusher::write_out()
+{
+	const bool ret = File_util::write_all(m_fd, m_out.data(), m_out.size());
+	if( ! ret )
+	{
+		SPDLOG_WARN("Profile_flusher::write_out - write failed: {:s}", strerror(errno));
+	}
+	m_out.clear();
+	return ret;
+}
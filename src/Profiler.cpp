@@ -0,0 +1,132 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Profiler.hpp"
+
+#include "emb-lin-util/Chronometer.hpp"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+	std::mutex& get_registry_mutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::vector<std::shared_ptr<Profile_buffer>>& get_registry()
+	{
+		static std::vector<std::shared_ptr<Profile_buffer>> registry;
+		return registry;
+	}
+
+	// marks the buffer as orphaned when the thread exits so the flusher can drop it once drained
+	struct Thread_buffer_holder
+	{
+		~Thread_buffer_holder()
+		{
+			if(buffer)
+			{
+				buffer->set_thread_exited();
+			}
+		}
+
+		std::shared_ptr<Profile_buffer> buffer;
+	};
+
+	thread_local Thread_buffer_holder t_buffer_holder;
+	thread_local Profile_buffer*      t_buffer = nullptr;
+}
+
+std::atomic<bool>     Profiler::m_enabled(false);
+std::atomic<uint64_t> Profiler::m_pruned_dropped(0);
+
+void Profiler::record(char const * const name, const Profile_event::Type type)
+{
+	if( ! is_enabled() )
+	{
+		return;
+	}
+
+	std::chrono::nanoseconds t_now;
+	if( ! Chronometer::get_time(&t_now) )
+	{
+		return;
+	}
+
+	Profile_buffer* buf = t_buffer;
+	if( ! buf )
+	{
+		buf = register_thread();
+	}
+
+	buf->push({name, t_now.count(), type});
+}
+
+void Profiler::get_buffers(std::vector<std::shared_ptr<Profile_buffer>>* const out_buffers)
+{
+	std::lock_guard<std::mutex> lock(get_registry_mutex());
+	*out_buffers = get_registry();
+}
+
+void Profiler::prune_buffers()
+{
+	std::lock_guard<std::mutex> lock(get_registry_mutex());
+
+	std::vector<std::shared_ptr<Profile_buffer>>& registry = get_registry();
+
+	auto is_done = [](const std::shared_ptr<Profile_buffer>& buf)
+	{
+		return buf->has_thread_exited() && buf->is_empty();
+	};
+
+	// the thread has exited, so its dropped count is final
+	auto first_done = std::partition(registry.begin(), registry.end(), [&is_done](const std::shared_ptr<Profile_buffer>& buf){ return ! is_done(buf); });
+	for(auto it = first_done; it != registry.end(); ++it)
+	{
+		m_pruned_dropped.fetch_add((*it)->get_dropped(), std::memory_order_relaxed);
+	}
+	registry.erase(first_done, registry.end());
+}
+
+uint64_t Profiler::get_dropped_count()
+{
+	// under the lock so a buffer being pruned is counted exactly once
+	std::lock_guard<std::mutex> lock(get_registry_mutex());
+
+	uint64_t dropped = m_pruned_dropped.load(std::memory_order_relaxed);
+	for(const auto& buf : get_registry())
+	{
+		dropped += buf->get_dropped();
+	}
+
+	return dropped;
+}
+
+Profile_buffer* Profiler::register_thread()
+{
+	const uint32_t tid = uint32_t(syscall(SYS_gettid));
+
+	t_buffer_holder.buffer = std::make_shared<Profile_buffer>(tid);
+	t_buffer = t_buffer_holder.buffer.get();
+
+	{
+		std::lock_guard<std::mutex> lock(get_registry_mutex());
+		get_registry().push_back(t_buffer_holder.buffer);
+	}
+
+	return t_buffer;
+}
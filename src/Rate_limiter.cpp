@@ -0,0 +1,184 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Rate_limiter.hpp"
+
+#include "emb-lin-util/Chronometer.hpp"
+#include "emb-lin-util/Timespec_util.hpp"
+
+#include <time.h>
+
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	#include "emb-lin-util/Virtual_clock.hpp"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+
+Gcra_limiter::Gcra_limiter(const Interval& emission_interval, const uint64_t burst) :
+	m_emission_interval(std::max(emission_interval, Interval(1))),
+	m_burst(std::max<uint64_t>(burst, 1)),
+	m_limit_ns(get_cost_ns(m_burst)),
+	m_tat(0)
+{
+
+}
+
+Gcra_limiter::~Gcra_limiter()
+{
+
+}
+
+bool Gcra_limiter::try_acquire(const uint64_t n)
+{
+	int64_t now;
+	if( ! get_time(&now) )
+	{
+		return false;
+	}
+
+	const int64_t inc = get_cost_ns(n);
+
+	int64_t tat = m_tat.load(std::memory_order_relaxed);
+	int64_t new_tat;
+	do
+	{
+		new_tat = std::max(tat, now) + inc;
+		if((new_tat - now) > m_limit_ns)
+		{
+			return false;
+		}
+	} while( ! m_tat.compare_exchange_weak(tat, new_tat, std::memory_order_relaxed) );
+
+	return true;
+}
+
+bool Gcra_limiter::acquire(const uint64_t n)
+{
+	int64_t now;
+	if( ! get_time(&now) )
+	{
+		return false;
+	}
+
+	const int64_t inc = get_cost_ns(n);
+
+	// reserve unconditionally, we then own the slot ending at new_tat
+	int64_t tat = m_tat.load(std::memory_order_relaxed);
+	int64_t new_tat;
+	do
+	{
+		new_tat = std::max(tat, now) + inc;
+	} while( ! m_tat.compare_exchange_weak(tat, new_tat, std::memory_order_relaxed) );
+
+	const int64_t allowed_at = new_tat - m_limit_ns;
+	if(allowed_at > now)
+	{
+		return sleep_until(allowed_at);
+	}
+
+	return true;
+}
+
+bool Gcra_limiter::get_wait_time(const uint64_t n, std::chrono::nanoseconds* const out_dt) const
+{
+	int64_t now;
+	if( ! get_time(&now) )
+	{
+		return false;
+	}
+
+	const int64_t new_tat    = std::max(m_tat.load(std::memory_order_relaxed), now) + get_cost_ns(n);
+	const int64_t allowed_at = new_tat - m_limit_ns;
+
+	if(out_dt)
+	{
+		*out_dt = std::chrono::nanoseconds(std::max<int64_t>(allowed_at - now, 0));
+	}
+
+	return true;
+}
+
+bool Gcra_limiter::get_available(double* const out_tokens) const
+{
+	int64_t now;
+	if( ! get_time(&now) )
+	{
+		return false;
+	}
+
+	const int64_t ahead = std::max(m_tat.load(std::memory_order_relaxed), now) - now;
+
+	if(out_tokens)
+	{
+		*out_tokens = double(m_limit_ns - ahead) / std::chrono::duration<double, std::nano>(m_emission_interval).count();
+	}
+
+	return true;
+}
+
+int64_t Gcra_limiter::get_cost_ns(const uint64_t n) const
+{
+	const unsigned __int128 units = static_cast<unsigned __int128>(n) * uint64_t(m_emission_interval.count());
+	const unsigned __int128 ns    = (units + (INTERVAL_UNITS_PER_NS - 1)) / INTERVAL_UNITS_PER_NS;
+
+	return (ns > static_cast<unsigned __int128>(MAX_COST_NS)) ? MAX_COST_NS : int64_t(ns);
+}
+
+bool Gcra_limiter::get_time(int64_t* const out_ns)
+{
+	std::chrono::nanoseconds t;
+	if( ! Chronometer::get_time(&t) )
+	{
+		return false;
+	}
+
+	*out_ns = t.count();
+
+	return true;
+}
+
+bool Gcra_limiter::sleep_until(const int64_t t_ns)
+{
+#if defined(EMB_LIN_UTIL_VIRTUAL_CLOCK)
+	// t_ns came from Chronometer, so it is a virtual deadline
+	Virtual_clock::sleep_until(std::chrono::nanoseconds(t_ns));
+	return true;
+#else
+	const timespec ts = Timespec_util::from_chrono(std::chrono::nanoseconds(t_ns));
+
+	int ret = 0;
+	do
+	{
+		ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+	} while(ret == EINTR);
+
+	return ret == 0;
+#endif
+}
+
+Gcra_limiter::Interval Token_bucket::rate_to_interval(const double rate)
+{
+	// also false for NaN
+	if( ! (rate > 0.0) )
+	{
+		return Gcra_limiter::Interval::max();
+	}
+
+	const double units = double(Gcra_limiter::Interval::period::den) / rate;
+	if( ! (units < double(Gcra_limiter::Interval::max().count())) )
+	{
+		return Gcra_limiter::Interval::max();
+	}
+
+	return Gcra_limiter::Interval(std::max<int64_t>(std::llround(units), 1));
+}
@@ -0,0 +1,96 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Rate_meter.hpp"
+
+#include <cmath>
+
+namespace
+{
+	// time constants of the averages, in seconds
+	constexpr std::array<double, 3> RATE_TAU = {1.0, 10.0, 60.0};
+}
+
+Rate_meter::Rate_meter() : m_count_at_reset(0), m_last_count(0), m_primed(false)
+{
+	m_rates.fill(0.0);
+
+	m_total_sw.start();
+	m_tick_sw.start();
+}
+
+Rate_meter::~Rate_meter()
+{
+
+}
+
+bool Rate_meter::snapshot(Snapshot* const out_snapshot)
+{
+	std::chrono::nanoseconds tick_dt;
+	if( ! m_tick_sw.lap(nullptr, &tick_dt) )
+	{
+		return false;
+	}
+
+	std::chrono::nanoseconds total_dt;
+	if( ! m_total_sw.get_time(&total_dt) )
+	{
+		return false;
+	}
+
+	const uint64_t count = get_count();
+	const double   dt    = std::chrono::duration<double>(tick_dt).count();
+
+	if(dt > 0.0)
+	{
+		const double inst_rate = double(count - m_last_count) / dt;
+
+		for(size_t i = 0; i < m_rates.size(); i++)
+		{
+			if(m_primed)
+			{
+				// exact decay for the elapsed time, so irregular snapshot periods are handled
+				const double alpha = 1.0 - std::exp(-dt / RATE_TAU[i]);
+				m_rates[i] += alpha * (inst_rate - m_rates[i]);
+			}
+			else
+			{
+				m_rates[i] = inst_rate;
+			}
+		}
+
+		m_primed     = true;
+		m_last_count = count;
+	}
+
+	if(out_snapshot)
+	{
+		const double total_s = std::chrono::duration<double>(total_dt).count();
+
+		out_snapshot->count     = count - m_count_at_reset;
+		out_snapshot->rate_1s   = m_rates[0];
+		out_snapshot->rate_10s  = m_rates[1];
+		out_snapshot->rate_60s  = m_rates[2];
+		out_snapshot->mean_rate = (total_s > 0.0) ? (double(count - m_count_at_reset) / total_s) : 0.0;
+	}
+
+	return true;
+}
+
+bool Rate_meter::reset()
+{
+	m_count_at_reset = get_count();
+	m_last_count     = m_count_at_reset;
+	m_primed         = false;
+	m_rates.fill(0.0);
+
+	return m_total_sw.reset() && m_tick_sw.reset();
+}
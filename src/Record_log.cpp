@@ -0,0 +1,715 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Record_log.hpp"
+
+#include "emb-lin-util/Chronometer.hpp"
+#include "emb-lin-util/Dir_scanner.hpp"
+#include "emb-lin-util/Futex_util.hpp"
+#include "emb-lin-util/Zlib_util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+	constexpr char SEGMENT_SUFFIX[] = ".log";
+	constexpr size_t INDEX_DIGITS   = 10;
+
+	// stale segments a new one may step past, left behind by another writer or a restored backup
+	constexpr unsigned MAX_INDEX_SKIP = 16;
+
+	// scan_segment read size, grown to hold a whole frame when a record is larger
+	constexpr size_t SCAN_CHUNK_SIZE = 64U * 1024U;
+
+	uint32_t get_frame_crc(const uint32_t len, uint8_t const * const ptr)
+	{
+		const uint32_t crc = Zlib_util::crc32(reinterpret_cast<uint8_t const *>(&len), sizeof(len));
+		return Zlib_util::crc32(ptr, len, crc);
+	}
+
+	bool parse_segment_index(const std::string_view& name, const std::string& prefix, uint64_t* const out_index)
+	{
+		// prefix.NNNNNNNNNN.log
+		const size_t suffix_len = sizeof(SEGMENT_SUFFIX) - 1U;
+		if(name.size() != (prefix.size() + 1U + INDEX_DIGITS + suffix_len))
+		{
+			return false;
+		}
+		if(( ! name.starts_with(prefix) ) || (name[prefix.size()] != '.') || ( ! name.ends_with(SEGMENT_SUFFIX) ))
+		{
+			return false;
+		}
+
+		const char* const first = name.data() + prefix.size() + 1U;
+		const char* const last  = first + INDEX_DIGITS;
+		const std::from_chars_result ret = std::from_chars(first, last, *out_index);
+		return (ret.ec == std::errc()) && (ret.ptr == last);
+	}
+}
+
+Record_log::Record_log(const size_t queue_capacity) :
+	m_segment_size(16U * 1024U * 1024U),
+	m_rotate_period(std::chrono::nanoseconds::zero()),
+	m_max_segments(0),
+	m_sync(false),
+	m_max_record_size(1024U * 1024U),
+	m_fd(-1),
+	m_offset(0),
+	m_segment_start_ns(0),
+	m_queue(queue_capacity, Mpmc_queue<std::vector<uint8_t>>::Overflow_policy::DROP_NEWEST),
+	m_processed(0),
+	m_written(0),
+	m_dropped(0),
+	m_write_errors(0),
+	m_written_seq(0),
+	m_written_waiters(0)
+{
+
+}
+
+Record_log::~Record_log()
+{
+	interrupt();
+	join();
+
+	close();
+}
+
+bool Record_log::open(const std::string& dir, const std::string& prefix)
+{
+	close();
+
+	m_dir    = dir;
+	m_prefix = prefix;
+	m_segments.clear();
+
+	Dir_scanner scanner;
+	const bool ret = scanner.for_each(dir, [this](const Dir_scanner::Entry_view& ent)
+	{
+		uint64_t index = 0;
+		if(parse_segment_index(ent.name, m_prefix, &index))
+		{
+			m_segments.push_back(index);
+		}
+		return true;
+	});
+	if( ! ret )
+	{
+		return false;
+	}
+
+	std::sort(m_segments.begin(), m_segments.end());
+
+	// older segments were sealed, only the newest can have a torn tail
+	if(m_segments.empty())
+	{
+		if( ! open_segment(0) )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if( ! recover_segment(m_segments.back()) )
+		{
+			return false;
+		}
+	}
+
+	apply_retention();
+
+	return true;
+}
+
+void Record_log::close()
+{
+	// a segment lost to an earlier error still gets another try for what is queued
+	if((m_fd < 0) && m_queue.empty())
+	{
+		return;
+	}
+
+	std::vector<std::vector<uint8_t>> batch;
+	std::vector<uint8_t> frame;
+	while(m_queue.try_pop(&frame))
+	{
+		batch.push_back(std::move(frame));
+	}
+	write_batch(&batch);
+
+	seal_segment();
+}
+
+bool Record_log::append(uint8_t const * const ptr, const size_t len)
+{
+	if((len == 0) || (len > m_max_record_size) || (len > UINT32_MAX))
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// frame on the caller so the crc work is spread over the producers
+	const uint32_t len32 = uint32_t(len);
+	const uint32_t crc   = get_frame_crc(len32, ptr);
+
+	std::vector<uint8_t> frame(HEADER_SIZE + len);
+	memcpy(frame.data(),                 &len32, sizeof(len32));
+	memcpy(frame.data() + sizeof(len32), &crc,   sizeof(crc));
+	memcpy(frame.data() + HEADER_SIZE,   ptr,    len);
+
+	if( ! m_queue.try_push(std::move(frame)) )
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+bool Record_log::flush(const std::chrono::nanoseconds& timeout)
+{
+	// queue slots are popped in the order they were claimed, so a count is enough
+	// every append that returned true before this call has claimed its slot, dropped records never claim one
+	const uint64_t target = m_queue.get_enqueue_count();
+	if(m_processed.load(std::memory_order_acquire) >= target)
+	{
+		return true;
+	}
+
+	timespec deadline;
+	const bool has_deadline = Futex_util::get_deadline(timeout, &deadline);
+
+	return Futex_util::wait_for_state(&m_written_seq, &m_written_waiters,
+		[this, target](const uint32_t)
+		{
+			if(m_processed.load(std::memory_order_acquire) >= target)
+			{
+				return 1;
+			}
+			if(m_queue.is_cancel_requested())
+			{
+				return -1;
+			}
+			return 0;
+		},
+		has_deadline ? &deadline : nullptr
+	);
+}
+
+void Record_log::interrupt()
+{
+	Thread_base::interrupt();
+	m_queue.notify_cancel();
+
+	// wake flushes so they see the cancel
+	m_written_seq.fetch_add(1, std::memory_order_release);
+	Futex_util::wake_waiters(&m_written_seq, &m_written_waiters, INT32_MAX);
+}
+
+bool Record_log::list_segments(const std::string& dir, const std::string& prefix, std::vector<std::string>* const out_paths)
+{
+	std::vector<uint64_t> indices;
+
+	Dir_scanner scanner;
+	const bool ret = scanner.for_each(dir, [&prefix, &indices](const Dir_scanner::Entry_view& ent)
+	{
+		uint64_t index = 0;
+		if(parse_segment_index(ent.name, prefix, &index))
+		{
+			indices.push_back(index);
+		}
+		return true;
+	});
+	if( ! ret )
+	{
+		return false;
+	}
+
+	std::sort(indices.begin(), indices.end());
+
+	out_paths->clear();
+	for(const uint64_t index : indices)
+	{
+		out_paths->push_back(fmt::format("{:s}/{:s}.{:0{}d}{:s}", dir, prefix, index, INDEX_DIGITS, SEGMENT_SUFFIX));
+	}
+
+	return true;
+}
+
+bool Record_log::scan_segment(const std::string& path, const Record_callback& cb, uint64_t* const out_valid_len, const size_t max_record_size)
+{
+	if(out_valid_len)
+	{
+		*out_valid_len = 0;
+	}
+
+	// read with pread, not File_view - the writer shrinks the live segment with ftruncate when it seals it, and a mapping would SIGBUS
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_ERROR("Record_log::scan_segment - could not open {:s}: {:s}", path, strerror(errno));
+		return false;
+	}
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	// buf[0] is at file_off, frames are parsed from buf_pos and buf_len bytes are valid
+	std::vector<uint8_t> buf(SCAN_CHUNK_SIZE);
+	uint64_t file_off = 0;
+	size_t buf_pos    = 0;
+	size_t buf_len    = 0;
+	bool   is_eof     = false;
+	bool   ret        = true;
+
+	// false if need bytes are not available from buf_pos, at eof or on error
+	auto fill = [&](const size_t need) -> bool
+	{
+		if((buf_len - buf_pos) >= need)
+		{
+			return true;
+		}
+
+		memmove(buf.data(), buf.data() + buf_pos, buf_len - buf_pos);
+		file_off += buf_pos;
+		buf_len  -= buf_pos;
+		buf_pos   = 0;
+
+		if(buf.size() < need)
+		{
+			buf.resize(need);
+		}
+
+		while(( ! is_eof ) && (buf_len < need))
+		{
+			const ssize_t n = pread(fd, buf.data() + buf_len, buf.size() - buf_len, off_t(file_off + buf_len));
+			if(n < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+
+				SPDLOG_ERROR("Record_log::scan_segment - could not read {:s}: {:s}", path, strerror(errno));
+				ret = false;
+				return false;
+			}
+
+			is_eof   = (n == 0);
+			buf_len += size_t(n);
+		}
+
+		return buf_len >= need;
+	};
+
+	while(fill(HEADER_SIZE))
+	{
+		uint32_t len = 0;
+		uint32_t crc = 0;
+		memcpy(&len, buf.data() + buf_pos,               sizeof(len));
+		memcpy(&crc, buf.data() + buf_pos + sizeof(len), sizeof(crc));
+
+		// zero is unwritten preallocation
+		if((len == 0) || (len > max_record_size))
+		{
+			break;
+		}
+
+		if( ! fill(HEADER_SIZE + len) )
+		{
+			break;
+		}
+
+		uint8_t const * const payload = buf.data() + buf_pos + HEADER_SIZE;
+		if(get_frame_crc(len, payload) != crc)
+		{
+			break;
+		}
+
+		buf_pos += HEADER_SIZE + len;
+
+		if(cb && ( ! cb(payload, len) ))
+		{
+			break;
+		}
+	}
+
+	::close(fd);
+
+	if( ! ret )
+	{
+		return false;
+	}
+
+	if(out_valid_len)
+	{
+		*out_valid_len = file_off + buf_pos;
+	}
+
+	return true;
+}
+
+void Record_log::work()
+{
+	std::vector<std::vector<uint8_t>> batch;
+	std::vector<uint8_t> frame;
+
+	for(;;)
+	{
+		heartbeat();
+
+		// wake up in time for age based rotation
+		// the pop timeout is kernel time, on Virtual_clock this only bounds how long after advance the rotation is noticed
+		std::chrono::nanoseconds timeout = std::chrono::milliseconds(250);
+		if(m_rotate_period > std::chrono::nanoseconds::zero())
+		{
+			const int64_t due_ns = m_segment_start_ns + m_rotate_period.count();
+			timeout = std::clamp(std::chrono::nanoseconds(due_ns - get_now_ns()), std::chrono::nanoseconds(std::chrono::milliseconds(1)), timeout);
+		}
+
+		if(m_queue.pop(&frame, timeout))
+		{
+			batch.push_back(std::move(frame));
+			while((batch.size() < size_t(IOV_MAX)) && m_queue.try_pop(&frame))
+			{
+				batch.push_back(std::move(frame));
+			}
+
+			write_batch(&batch);
+		}
+		else if(m_queue.is_cancel_requested() && m_queue.empty())
+		{
+			break;
+		}
+
+		if((m_rotate_period > std::chrono::nanoseconds::zero()) && (m_offset > 0) && ((get_now_ns() - m_segment_start_ns) >= m_rotate_period.count()))
+		{
+			rotate();
+		}
+	}
+}
+
+void Record_log::write_batch(std::vector<std::vector<uint8_t>>* const batch)
+{
+	if(batch->empty())
+	{
+		return;
+	}
+
+	std::array<struct iovec, IOV_MAX> iov;
+
+	uint64_t written = 0;
+	size_t i = 0;
+	while(i < batch->size())
+	{
+		// a failed rotation is retried once per batch, so a transient ENOSPC or EMFILE does not stop the log for good
+		if((m_fd < 0) && ( ! open_next_segment() ))
+		{
+			break;
+		}
+
+		// gather what fits in this segment
+		size_t n = 0;
+		uint64_t bytes = 0;
+		while(((i + n) < batch->size()) && (n < iov.size()))
+		{
+			const std::vector<uint8_t>& frame = (*batch)[i + n];
+			if(((m_offset + bytes + frame.size()) > m_segment_size) && ((m_offset + bytes) > 0))
+			{
+				break;
+			}
+
+			iov[n].iov_base = const_cast<uint8_t*>(frame.data());
+			iov[n].iov_len  = frame.size();
+			bytes += frame.size();
+			n++;
+		}
+
+		if(n == 0)
+		{
+			// current segment is full
+			if( ! rotate() )
+			{
+				break;
+			}
+			continue;
+		}
+
+		if(write_iov(iov.data(), n))
+		{
+			m_offset += bytes;
+			written  += n;
+		}
+		else
+		{
+			m_write_errors.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		i += n;
+	}
+
+	if(i < batch->size())
+	{
+		// no segment to write to
+		SPDLOG_WARN("Record_log::write_batch - no open segment, dropping {:d} records", batch->size() - i);
+		m_dropped.fetch_add(batch->size() - i, std::memory_order_relaxed);
+	}
+
+	// one sync for the whole batch
+	if(m_sync && (m_fd >= 0) && (written != 0))
+	{
+		if(fdatasync(m_fd) != 0)
+		{
+			SPDLOG_WARN("Record_log::write_batch - fdatasync failed: {:s}", strerror(errno));
+			m_write_errors.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	m_written.fetch_add(written, std::memory_order_relaxed);
+	m_processed.fetch_add(batch->size(), std::memory_order_release);
+
+	m_written_seq.fetch_add(1, std::memory_order_release);
+	Futex_util::wake_waiters(&m_written_seq, &m_written_waiters, INT32_MAX);
+
+	batch->clear();
+}
+
+bool Record_log::write_iov(const struct iovec* iov, size_t iovcnt)
+{
+	// copy so a short write can advance into the middle of an entry
+	std::vector<struct iovec> rem(iov, iov + iovcnt);
+	struct iovec* it = rem.data();
+	struct iovec* const end = rem.data() + rem.size();
+
+	uint64_t offset = m_offset;
+	while(it != end)
+	{
+		const ssize_t ret = pwritev(m_fd, it, int(end - it), off_t(offset));
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			SPDLOG_WARN("Record_log::write_iov - pwritev failed: {:s}", strerror(errno));
+			return false;
+		}
+		if(ret == 0)
+		{
+			return false;
+		}
+
+		offset += uint64_t(ret);
+
+		size_t n = size_t(ret);
+		while((it != end) && (n >= it->iov_len))
+		{
+			n -= it->iov_len;
+			++it;
+		}
+		if(it != end)
+		{
+			it->iov_base = static_cast<uint8_t*>(it->iov_base) + n;
+			it->iov_len -= n;
+		}
+	}
+
+	return true;
+}
+
+bool Record_log::open_segment(const uint64_t index)
+{
+	const std::string path = get_segment_path(index);
+
+	const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if(fd < 0)
+	{
+		// keep errno for the caller, so it can tell an existing file apart
+		const int err = errno;
+		SPDLOG_ERROR("Record_log::open_segment - could not create {:s}: {:s}", path, strerror(err));
+		errno = err;
+		return false;
+	}
+
+	// reserve the extent up front so appends do not allocate, a segment is truncated to its data when sealed
+	// not every filesystem supports it, appends still work without
+	if(fallocate(fd, 0, 0, off_t(m_segment_size)) != 0)
+	{
+		SPDLOG_DEBUG("Record_log::open_segment - fallocate failed on {:s}: {:s}", path, strerror(errno));
+	}
+
+	m_fd               = fd;
+	m_offset           = 0;
+	m_segment_start_ns = get_now_ns();
+
+	if(m_segments.empty() || (m_segments.back() != index))
+	{
+		m_segments.push_back(index);
+	}
+
+	return true;
+}
+
+bool Record_log::recover_segment(const uint64_t index)
+{
+	const std::string path = get_segment_path(index);
+
+	uint64_t valid_len = 0;
+	if( ! scan_segment(path, nullptr, &valid_len, m_max_record_size) )
+	{
+		SPDLOG_ERROR("Record_log::recover_segment - could not read {:s}", path);
+		return false;
+	}
+
+	const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		SPDLOG_ERROR("Record_log::recover_segment - could not open {:s}: {:s}", path, strerror(errno));
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// clear a torn tail, so a later crash cannot leave a stale frame looking like it follows the new ones
+	const uint64_t file_size = uint64_t(st.st_size);
+	if(file_size > valid_len)
+	{
+		if(fallocate(fd, FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE, off_t(valid_len), off_t(file_size - valid_len)) != 0)
+		{
+			if(ftruncate(fd, off_t(valid_len)) != 0)
+			{
+				SPDLOG_ERROR("Record_log::recover_segment - could not clear the tail of {:s}: {:s}", path, strerror(errno));
+				::close(fd);
+				return false;
+			}
+		}
+
+		SPDLOG_INFO("Record_log::recover_segment - {:s} has {:d} valid bytes", path, valid_len);
+	}
+
+	if(file_size < m_segment_size)
+	{
+		if(fallocate(fd, 0, 0, off_t(m_segment_size)) != 0)
+		{
+			SPDLOG_DEBUG("Record_log::recover_segment - fallocate failed on {:s}: {:s}", path, strerror(errno));
+		}
+	}
+
+	m_fd               = fd;
+	m_offset           = valid_len;
+	m_segment_start_ns = get_now_ns();
+
+	return true;
+}
+
+bool Record_log::rotate()
+{
+	seal_segment();
+
+	return open_next_segment();
+}
+
+bool Record_log::open_next_segment()
+{
+	if(m_dir.empty())
+	{
+		return false;
+	}
+
+	uint64_t next = m_segments.empty() ? 0 : (m_segments.back() + 1U);
+	for(unsigned i = 0; i < MAX_INDEX_SKIP; i++, next++)
+	{
+		if(open_segment(next))
+		{
+			apply_retention();
+			return true;
+		}
+
+		if(errno != EEXIST)
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+void Record_log::seal_segment()
+{
+	if(m_fd < 0)
+	{
+		return;
+	}
+
+	// drop the unused preallocation so the size marks the end of the data
+	if(ftruncate(m_fd, off_t(m_offset)) != 0)
+	{
+		SPDLOG_WARN("Record_log::seal_segment - ftruncate failed: {:s}", strerror(errno));
+	}
+
+	if(m_sync && (fdatasync(m_fd) != 0))
+	{
+		SPDLOG_WARN("Record_log::seal_segment - fdatasync failed: {:s}", strerror(errno));
+	}
+
+	::close(m_fd);
+	m_fd     = -1;
+	m_offset = 0;
+}
+
+void Record_log::apply_retention()
+{
+	if(m_max_segments == 0)
+	{
+		return;
+	}
+
+	while(m_segments.size() > m_max_segments)
+	{
+		const std::string path = get_segment_path(m_segments.front());
+		if((unlink(path.c_str()) != 0) && (errno != ENOENT))
+		{
+			SPDLOG_WARN("Record_log::apply_retention - could not remove {:s}: {:s}", path, strerror(errno));
+		}
+		m_segments.pop_front();
+	}
+}
+
+std::string Record_log::get_segment_path(const uint64_t index) const
+{
+	return fmt::format("{:s}/{:s}.{:0{}d}{:s}", m_dir, m_prefix, index, INDEX_DIGITS, SEGMENT_SUFFIX);
+}
+
+int64_t Record_log::get_now_ns()
+{
+	// Chronometer so test builds rotate on Virtual_clock
+	std::chrono::nanoseconds t = std::chrono::nanoseconds::zero();
+	Chronometer::get_time(&t);
+	return t.count();
+}
@@ -12,8 +12,9 @@
 #include "emb-lin-util/Stopwatch.hpp"
 
 #include "emb-lin-util/Chronometer.hpp"
+#include "emb-lin-util/Lap_stats.hpp"
 
-Stopwatch::Stopwatch() : m_t0(std::chrono::nanoseconds::zero())
+Stopwatch::Stopwatch() : m_t0(std::chrono::nanoseconds::zero()), m_t_lap(std::chrono::nanoseconds::zero())
 {
 	
 }
@@ -31,7 +32,8 @@ bool Stopwatch::start()
 		return false;
 	}
 
-	m_t0 = t_i;
+	m_t0    = t_i;
+	m_t_lap = t_i;
 
 	return true;
 }
@@ -72,3 +74,64 @@ bool Stopwatch::is_expired(const std::chrono::nanoseconds& alarm_dt, bool* const
 
 	return true;
 }
+
+bool Stopwatch::lap(Lap_stats* const stats, std::chrono::nanoseconds* const out_dt)
+{
+	// only ever advance the lap mark, so concurrent laps tile the timeline without overlap
+	// a lapper that loses the race read the clock before the winner published, so it reads again
+	std::chrono::nanoseconds t_i;
+	std::chrono::nanoseconds t_prev = m_t_lap.load();
+	for(;;)
+	{
+		if( ! Chronometer::get_time(&t_i) )
+		{
+			return false;
+		}
+
+		if(t_i < t_prev)
+		{
+			t_prev = m_t_lap.load();
+			continue;
+		}
+
+		if(m_t_lap.compare_exchange_weak(t_prev, t_i))
+		{
+			break;
+		}
+	}
+
+	const std::chrono::nanoseconds dt = t_i - t_prev;
+
+	if(stats)
+	{
+		stats->record(dt);
+	}
+
+	if(out_dt)
+	{
+		*out_dt = dt;
+	}
+
+	return true;
+}
+
+bool Stopwatch::split(Lap_stats* const stats, std::chrono::nanoseconds* const out_dt)
+{
+	std::chrono::nanoseconds dt;
+	if( ! get_time(&dt) )
+	{
+		return false;
+	}
+
+	if(stats)
+	{
+		stats->record(dt);
+	}
+
+	if(out_dt)
+	{
+		*out_dt = dt;
+	}
+
+	return true;
+}
@@ -0,0 +1,206 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Sysfs_attr.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <charconv>
+
+#include <cerrno>
+
+namespace
+{
+	bool is_space(const char c)
+	{
+		return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r');
+	}
+}
+
+Sysfs_attr::Sysfs_attr() : m_fd(-1)
+{
+
+}
+
+Sysfs_attr::~Sysfs_attr()
+{
+	close();
+}
+
+Sysfs_attr::Sysfs_attr(Sysfs_attr&& other) : m_fd(other.m_fd), m_path(std::move(other.m_path))
+{
+	other.m_fd = -1;
+}
+
+Sysfs_attr& Sysfs_attr::operator=(Sysfs_attr&& other)
+{
+	if(this != &other)
+	{
+		close();
+
+		m_fd   = other.m_fd;
+		m_path = std::move(other.m_path);
+
+		other.m_fd = -1;
+	}
+
+	return *this;
+}
+
+bool Sysfs_attr::open(const std::string& path, const bool writable)
+{
+	if(m_fd >= 0)
+	{
+		return false;
+	}
+
+	m_fd = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+	if(m_fd < 0)
+	{
+		SPDLOG_WARN("Sysfs_attr::open - Could not open {:s}", path);
+		return false;
+	}
+
+	m_path = path;
+
+	return true;
+}
+
+bool Sysfs_attr::close()
+{
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	const int ret = ::close(m_fd);
+	m_fd = -1;
+
+	return ret == 0;
+}
+
+bool Sysfs_attr::read_int(int* const out_value) const
+{
+	return read_number(out_value);
+}
+
+bool Sysfs_attr::read_int64(int64_t* const out_value) const
+{
+	return read_number(out_value);
+}
+
+bool Sysfs_attr::read_double(double* const out_value) const
+{
+	return read_number(out_value);
+}
+
+bool Sysfs_attr::read_string(std::string* const out_value) const
+{
+	std::array<char, MAX_SIZE + 1> buf;
+	std::string_view val;
+	if( ! read_trimmed(buf.data(), buf.size(), &val) )
+	{
+		return false;
+	}
+
+	out_value->assign(val);
+
+	return true;
+}
+
+bool Sysfs_attr::write(const std::string_view& value) const
+{
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	ssize_t ret = 0;
+	do
+	{
+		ret = pwrite(m_fd, value.data(), value.size(), 0);
+	} while((ret < 0) && (errno == EINTR));
+
+	return (ret >= 0) && (size_t(ret) == value.size());
+}
+
+bool Sysfs_attr::read_trimmed(char* const buf, const size_t len, std::string_view* const out_value) const
+{
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	ssize_t ret = 0;
+	do
+	{
+		ret = pread(m_fd, buf, len, 0);
+	} while((ret < 0) && (errno == EINTR));
+
+	if(ret < 0)
+	{
+		return false;
+	}
+
+	// a full buffer may have been truncated
+	if(size_t(ret) >= len)
+	{
+		SPDLOG_WARN("Sysfs_attr::read - {:s} is larger than expected", m_path);
+		return false;
+	}
+
+	size_t begin = 0;
+	size_t end   = size_t(ret);
+	while((begin < end) && is_space(buf[begin]))
+	{
+		begin++;
+	}
+	while((end > begin) && is_space(buf[end - 1]))
+	{
+		end--;
+	}
+
+	*out_value = std::string_view(buf + begin, end - begin);
+
+	return true;
+}
+
+template<typename T>
+bool Sysfs_attr::read_number(T* const out_value) const
+{
+	std::array<char, 64> buf;
+	std::string_view val;
+	if( ! read_trimmed(buf.data(), buf.size(), &val) )
+	{
+		return false;
+	}
+
+	// from_chars does not take a leading +
+	if( ( ! val.empty() ) && (val.front() == '+') )
+	{
+		val.remove_prefix(1);
+	}
+
+	T tmp;
+	const std::from_chars_result res = std::from_chars(val.data(), val.data() + val.size(), tmp);
+	if((res.ec != std::errc()) || (res.ptr != (val.data() + val.size())) || val.empty())
+	{
+		SPDLOG_WARN("Sysfs_attr::read - Could not parse a number from {:s}", m_path);
+		return false;
+	}
+
+	*out_value = tmp;
+
+	return true;
+}
@@ -29,6 +29,7 @@ void Thread_base::launch()
 	if( ! m_thread.joinable() )
 	{
 		m_keep_running = true;
+		m_interrupted_event.reset();
 		m_thread = std::thread(&Thread_base::dispatch_work, this);
 	}
 }
@@ -42,7 +43,7 @@ void Thread_base::work()
 void Thread_base::interrupt()
 {
 	m_keep_running.store(false);
-	m_keep_running_cv.notify_all();
+	m_interrupted_event.set();
 }
 void Thread_base::join()
 {
@@ -58,13 +59,17 @@ bool Thread_base::joinable() const
 
 void Thread_base::wait_for_interruption()
 {
-	std::unique_lock<std::mutex> lock(m_mutex);
-	m_keep_running_cv.wait(lock, std::bind(&Thread_base::is_interrupted, this));
+	while( ! is_interrupted() )
+	{
+		m_interrupted_event.wait();
+	}
 }
 
 void Thread_base::dispatch_work()
 {
 	SPDLOG_DEBUG("Thread started: {}", std::this_thread::get_id());
+	heartbeat();
+
 	try
 	{
 		work();
@@ -80,5 +85,10 @@ void Thread_base::dispatch_work()
 		throw;
 	}
 
+	if(m_heartbeat)
+	{
+		m_heartbeat->pause();
+	}
+
 	SPDLOG_DEBUG("Thread exiting: {}", std::this_thread::get_id());
 }
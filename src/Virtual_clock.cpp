@@ -0,0 +1,189 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Virtual_clock.hpp"
+
+#include "emb-lin-util/Timespec_util.hpp"
+
+#include <cerrno>
+
+std::atomic<int64_t>        Virtual_clock::m_now_ns(0);
+std::mutex                  Virtual_clock::m_sleep_mutex;
+std::condition_variable     Virtual_clock::m_sleep_cv;
+std::mutex                  Virtual_clock::m_advance_mutex;
+std::mutex                  Virtual_clock::m_timer_mutex;
+std::map<int, Virtual_clock::Timer> Virtual_clock::m_timers;
+int                         Virtual_clock::m_next_id = 0;
+
+int Virtual_clock::clock_gettime(const clockid_t clk, timespec* const out_time)
+{
+	int64_t offset_s = 0;
+	switch(clk)
+	{
+		case CLOCK_MONOTONIC:
+		{
+			break;
+		}
+		case CLOCK_REALTIME:
+		{
+			offset_s = REALTIME_OFFSET_S;
+			break;
+		}
+		case CLOCK_TAI:
+		{
+			offset_s = REALTIME_OFFSET_S + TAI_OFFSET_S;
+			break;
+		}
+		default:
+		{
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	if(out_time)
+	{
+		*out_time = Timespec_util::from_chrono(now());
+		out_time->tv_sec += offset_s;
+	}
+
+	return 0;
+}
+
+void Virtual_clock::advance(const std::chrono::nanoseconds& dt)
+{
+	std::lock_guard<std::mutex> advance_lock(m_advance_mutex);
+
+	const int64_t t_end = m_now_ns.load(std::memory_order_relaxed) + dt.count();
+
+	for(;;)
+	{
+		Timer_callback cb;
+
+		{
+			std::lock_guard<std::mutex> lock(m_timer_mutex);
+
+			// earliest armed timer that expires by t_end, ties go to the lowest id
+			auto next_it = m_timers.end();
+			for(auto it = m_timers.begin(); it != m_timers.end(); ++it)
+			{
+				if( ! it->second.armed || (it->second.deadline_ns > t_end) )
+				{
+					continue;
+				}
+
+				if((next_it == m_timers.end()) || (it->second.deadline_ns < next_it->second.deadline_ns))
+				{
+					next_it = it;
+				}
+			}
+
+			if(next_it == m_timers.end())
+			{
+				break;
+			}
+
+			Timer& tim = next_it->second;
+			set_now(tim.deadline_ns);
+
+			if(tim.interval_ns > 0)
+			{
+				tim.deadline_ns += tim.interval_ns;
+			}
+			else
+			{
+				tim.armed = false;
+			}
+
+			cb = tim.cb;
+		}
+
+		// outside of m_timer_mutex so the callback may re-arm or stop timers
+		if(cb)
+		{
+			cb();
+		}
+	}
+
+	set_now(t_end);
+}
+
+void Virtual_clock::sleep_until(const std::chrono::nanoseconds& t)
+{
+	std::unique_lock<std::mutex> lock(m_sleep_mutex);
+	m_sleep_cv.wait(lock, [&t](){ return now() >= t; });
+}
+
+void Virtual_clock::set_now(const int64_t t_ns)
+{
+	{
+		// a sleeper between its check and its wait holds the lock, so it cannot miss this store
+		std::lock_guard<std::mutex> lock(m_sleep_mutex);
+		m_now_ns.store(t_ns, std::memory_order_release);
+	}
+
+	m_sleep_cv.notify_all();
+}
+
+bool Virtual_clock::timer_create(const Timer_callback& cb, int* const out_id)
+{
+	if( ! out_id )
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_timer_mutex);
+
+	const int id = m_next_id++;
+	m_timers.emplace(id, Timer{cb, false, 0, 0});
+
+	*out_id = id;
+
+	return true;
+}
+
+bool Virtual_clock::timer_settime(const int id, const std::chrono::nanoseconds& value, const std::chrono::nanoseconds& interval)
+{
+	if((value.count() < 0) || (interval.count() < 0))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_timer_mutex);
+
+	auto it = m_timers.find(id);
+	if(it == m_timers.end())
+	{
+		return false;
+	}
+
+	Timer& tim = it->second;
+	if(value.count() == 0)
+	{
+		tim.armed = false;
+	}
+	else
+	{
+		tim.armed       = true;
+		tim.deadline_ns = m_now_ns.load(std::memory_order_relaxed) + value.count();
+		tim.interval_ns = interval.count();
+	}
+
+	return true;
+}
+
+bool Virtual_clock::timer_delete(const int id)
+{
+	std::lock_guard<std::mutex> advance_lock(m_advance_mutex);
+	std::lock_guard<std::mutex> lock(m_timer_mutex);
+
+	return m_timers.erase(id) > 0;
+}
@@ -0,0 +1,233 @@
+/**
+ * This file is part of emb-lin-util, a collection of utility code for embedded linux.
+ * 
+ * This software is distrubuted in the hope it will be useful, but without any warranty, including the implied warrranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See LICENSE.txt for details.
+ * 
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the LGPL-3.0 license. See LICENSE.txt for details.
+ * SPDX-License-Identifier: LGPL-3.0-only
+*/
+
+#include "emb-lin-util/Watchdog.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <linux/watchdog.h>
+
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <cerrno>
+
+Watchdog::Watchdog() : m_check_period(std::chrono::milliseconds(100)), m_device_fd(-1), m_stalled_count(0)
+{
+
+}
+
+Watchdog::~Watchdog()
+{
+	interrupt();
+	join();
+
+	if(m_device_fd >= 0)
+	{
+		close_device();
+	}
+
+	m_timer.reset();
+}
+
+bool Watchdog::init(const std::chrono::nanoseconds& check_period)
+{
+	if(check_period <= std::chrono::nanoseconds::zero())
+	{
+		return false;
+	}
+
+	m_check_period = check_period;
+
+	// armed here rather than in work so no period is lost to thread startup
+	m_timer.reset();
+	return m_timer.init() && m_timer.start(m_check_period);
+}
+
+bool Watchdog::open_device(const std::string& path, const std::chrono::seconds& timeout)
+{
+	if(m_device_fd >= 0)
+	{
+		return false;
+	}
+
+	m_device_fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+	if(m_device_fd < 0)
+	{
+		SPDLOG_WARN("Watchdog::open_device - Could not open {:s}", path);
+		return false;
+	}
+
+	if(timeout > std::chrono::seconds::zero())
+	{
+		int timeout_s = int(timeout.count());
+		if(ioctl(m_device_fd, WDIOC_SETTIMEOUT, &timeout_s) != 0)
+		{
+			SPDLOG_WARN("Watchdog::open_device - Could not set timeout on {:s}", path);
+			close_device();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Watchdog::close_device()
+{
+	if(m_device_fd < 0)
+	{
+		return false;
+	}
+
+	// magic close
+	bool ret = true;
+	const char v = 'V';
+	if(write(m_device_fd, &v, 1) != 1)
+	{
+		SPDLOG_WARN("Watchdog::close_device - magic close failed, device stays armed");
+		ret = false;
+	}
+
+	if(::close(m_device_fd) != 0)
+	{
+		ret = false;
+	}
+	m_device_fd = -1;
+
+	return ret;
+}
+
+std::shared_ptr<Heartbeat> Watchdog::add_heartbeat(const std::string& name, const std::chrono::nanoseconds& timeout)
+{
+	std::shared_ptr<Heartbeat> hb = std::make_shared<Heartbeat>(name, timeout);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.push_back({hb, false});
+
+	return hb;
+}
+
+std::shared_ptr<Heartbeat> Watchdog::add_thread(Thread_base* const thread, const std::string& name, const std::chrono::nanoseconds& timeout)
+{
+	std::shared_ptr<Heartbeat> hb = add_heartbeat(name, timeout);
+	thread->set_heartbeat(hb);
+	return hb;
+}
+
+void Watchdog::remove_heartbeat(const std::shared_ptr<Heartbeat>& hb)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&hb](const Entry& e){ return e.hb == hb; }), m_entries.end());
+}
+
+bool Watchdog::check()
+{
+	std::chrono::nanoseconds now;
+	if( ! Chronometer::get_time(&now) )
+	{
+		return false;
+	}
+
+	// callbacks run without the lock so they may add or remove heartbeats
+	std::vector<Stall> new_stalls;
+	size_t stalled_count = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for(Entry& e : m_entries)
+		{
+			std::chrono::nanoseconds age;
+			const bool is_stalled = e.hb->get_age(now, &age) && (age > e.hb->get_timeout());
+
+			if(is_stalled)
+			{
+				stalled_count++;
+				if( ! e.is_stalled )
+				{
+					new_stalls.push_back({e.hb, age});
+				}
+			}
+			else if(e.is_stalled)
+			{
+				SPDLOG_INFO("Watchdog::check - {:s} recovered", e.hb->get_name());
+			}
+
+			e.is_stalled = is_stalled;
+		}
+	}
+
+	m_stalled_count.store(stalled_count, std::memory_order_relaxed);
+
+	for(const Stall& s : new_stalls)
+	{
+		if(m_stall_cb)
+		{
+			m_stall_cb(s.hb->get_name(), s.age);
+		}
+		else
+		{
+			SPDLOG_WARN("Watchdog::check - {:s} stalled, last beat {:d} ms ago", s.hb->get_name(), std::chrono::duration_cast<std::chrono::milliseconds>(s.age).count());
+		}
+	}
+
+	return stalled_count == 0;
+}
+
+void Watchdog::interrupt()
+{
+	Thread_base::interrupt();
+	m_timer.notify_cancel();
+}
+
+void Watchdog::work()
+{
+	while( ! is_interrupted() )
+	{
+		bool got_event = false;
+		if( ! m_timer.wait_for_event(&got_event) )
+		{
+			SPDLOG_ERROR("Watchdog::work - wait_for_event failed");
+			break;
+		}
+
+		if( ( ! got_event ) || is_interrupted() )
+		{
+			continue;
+		}
+
+		if(check() && (m_device_fd >= 0))
+		{
+			if( ! pet_device() )
+			{
+				SPDLOG_WARN("Watchdog::work - could not pet device");
+			}
+		}
+	}
+
+	m_timer.stop();
+}
+
+bool Watchdog::pet_device()
+{
+	// any write other than the magic 'V' is a keepalive, and unlike WDIOC_KEEPALIVE also works on a plain file
+	const char c = '\0';
+
+	ssize_t ret = 0;
+	do
+	{
+		ret = write(m_device_fd, &c, 1);
+	} while((ret < 0) && (errno == EINTR));
+
+	return ret == 1;
+}
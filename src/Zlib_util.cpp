@@ -15,6 +15,9 @@
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <limits>
+
 Zlib_util::Zlib_util()
 {
 
@@ -215,7 +218,7 @@ bool Zlib_util::deflate(uint8_t* in_data, const size_t in_data_len, const Block_
 	return true;
 }
 
-bool Zlib_util::inflate(uint8_t* in_data, const size_t in_data_len, const Block_callback& cb)
+bool Zlib_util::inflate(uint8_t const * in_data, const size_t in_data_len, const Block_callback& cb)
 {
 	std::vector<uint8_t> inflate_block;
 	inflate_block.resize(inflate_block_size);
@@ -224,7 +227,8 @@ bool Zlib_util::inflate(uint8_t* in_data, const size_t in_data_len, const Block_
 	memset(stream.get(), 0, sizeof(stream));
 	stream->zalloc    = Z_NULL;
 	stream->zfree     = Z_NULL;
-	stream->next_in   = in_data;
+	// inflate does not write to next_in, it is only non-const without ZLIB_CONST
+	stream->next_in   = const_cast<uint8_t*>(in_data);
 	stream->avail_in  = in_data_len;
 	stream->next_out  = inflate_block.data();
 	stream->avail_out = inflate_block.size();
@@ -286,3 +290,17 @@ bool Zlib_util::inflate(uint8_t* in_data, const size_t in_data_len, const Block_
 
 	return true;
 }
+
+uint32_t Zlib_util::crc32(uint8_t const * const ptr, const size_t len, const uint32_t crc)
+{
+	// uInt may be narrower than size_t
+	uLong ret = crc;
+	for(size_t off = 0; off < len; )
+	{
+		const size_t n = std::min<size_t>(len - off, std::numeric_limits<uInt>::max());
+		ret = ::crc32(ret, ptr + off, uInt(n));
+		off += n;
+	}
+
+	return uint32_t(ret);
+}
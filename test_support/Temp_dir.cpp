@@ -0,0 +1,62 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "test_support/Temp_dir.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <system_error>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+Temp_dir::Temp_dir()
+{
+
+}
+
+Temp_dir::~Temp_dir()
+{
+	remove();
+}
+
+bool Temp_dir::create(const std::string& prefix, const std::string& base)
+{
+	remove();
+
+	std::string path = base + "/" + prefix + "-XXXXXX";
+	if( ! mkdtemp(path.data()) )
+	{
+		SPDLOG_WARN("Temp_dir::create - Could not create {:s}: {:s}", path, strerror(errno));
+		return false;
+	}
+
+	m_path = path;
+
+	return true;
+}
+
+bool Temp_dir::remove()
+{
+	if(m_path.empty())
+	{
+		return true;
+	}
+
+	std::error_code ec;
+	std::filesystem::remove_all(m_path, ec);
+	if(ec)
+	{
+		SPDLOG_WARN("Temp_dir::remove - Could not remove {:s}: {:s}", m_path, ec.message());
+	}
+
+	m_path.clear();
+
+	return ! ec;
+}
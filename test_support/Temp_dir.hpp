@@ -0,0 +1,52 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <string>
+
+//
+// Scratch directory from mkdtemp, removed with everything in it on destruction
+// Test support only, linked by the tests and benchmarks and not part of the library
+//
+class Temp_dir
+{
+public:
+
+	Temp_dir();
+	~Temp_dir();
+
+	Temp_dir(const Temp_dir&) = delete;
+	Temp_dir& operator=(const Temp_dir&) = delete;
+
+	// NOT MT safe
+	// Creates base/prefix-XXXXXX, removing the previous directory if any
+	bool create(const std::string& prefix, const std::string& base = "/tmp");
+
+	// NOT MT safe
+	// Removes the directory and everything below it
+	bool remove();
+
+	bool is_valid() const
+	{
+		return ! m_path.empty();
+	}
+
+	const std::string& get_path() const
+	{
+		return m_path;
+	}
+
+	// name inside the directory
+	std::string get_path(const std::string& name) const
+	{
+		return m_path + "/" + name;
+	}
+
+protected:
+	std::string m_path;
+};
@@ -0,0 +1,193 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Atomic_file_writer.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <array>
+#include <string>
+#include <thread>
+
+class Atomic_file_writer_test : public ::testing::TestWithParam<Atomic_file_writer::Sync_mode>
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-atomic"));
+		m_dir = m_tmp.get_path();
+	}
+
+	std::vector<std::string> list_dir() const
+	{
+		std::vector<std::string> names;
+
+		DIR* const dir = opendir(m_dir.c_str());
+		if(dir)
+		{
+			for(dirent* ent = readdir(dir); ent; ent = readdir(dir))
+			{
+				const std::string name = ent->d_name;
+				if((name != ".") && (name != ".."))
+				{
+					names.push_back(name);
+				}
+			}
+			closedir(dir);
+		}
+
+		std::sort(names.begin(), names.end());
+		return names;
+	}
+
+	std::string read(const std::string& name) const
+	{
+		std::vector<uint8_t> data;
+		EXPECT_TRUE(File_util::readSmallFile(m_dir + "/" + name, &data));
+		return std::string(data.begin(), data.end());
+	}
+
+	Temp_dir m_tmp;
+	std::string m_dir;
+};
+
+TEST_F(Atomic_file_writer_test, write_file)
+{
+	const std::string path = m_dir + "/state.json";
+
+	ASSERT_TRUE(Atomic_file_writer::write_file(path, "v1", 0600));
+	EXPECT_EQ(read("state.json"), "v1");
+
+	struct stat st;
+	ASSERT_EQ(stat(path.c_str(), &st), 0);
+	EXPECT_EQ(st.st_mode & 0777, 0600U);
+
+	ASSERT_TRUE(Atomic_file_writer::write_file(path, "version 2"));
+	EXPECT_EQ(read("state.json"), "version 2");
+
+	// no temp files left behind
+	EXPECT_EQ(list_dir(), std::vector<std::string>({"state.json"}));
+
+	EXPECT_FALSE(Atomic_file_writer::write_file("/nonexistent-emb-lin-util/x", "v"));
+}
+
+TEST_P(Atomic_file_writer_test, group_commit)
+{
+	Atomic_file_writer writer(GetParam());
+
+	ASSERT_TRUE(Atomic_file_writer::write_file(m_dir + "/a", "old a"));
+
+	// staged files are invisible until commit
+	ASSERT_TRUE(writer.stage(m_dir + "/a", "new a"));
+	ASSERT_TRUE(writer.stage(m_dir + "/b", "b1"));
+	ASSERT_TRUE(writer.stage(m_dir + "/b", "b2"));
+	// restaging b replaced b1
+	EXPECT_EQ(writer.get_staged_count(), 2U);
+	EXPECT_EQ(read("a"), "old a");
+	EXPECT_NE(access((m_dir + "/b").c_str(), F_OK), 0);
+
+	ASSERT_TRUE(writer.commit());
+	EXPECT_EQ(writer.get_staged_count(), 0U);
+	EXPECT_EQ(read("a"), "new a");
+	EXPECT_EQ(read("b"), "b2");
+	EXPECT_EQ(list_dir(), std::vector<std::string>({"a", "b"}));
+
+	// abort drops temp files and leaves the targets alone
+	ASSERT_TRUE(writer.stage(m_dir + "/a", "aborted"));
+	writer.abort();
+	EXPECT_EQ(read("a"), "new a");
+	EXPECT_EQ(list_dir(), std::vector<std::string>({"a", "b"}));
+
+	EXPECT_TRUE(writer.commit());
+}
+
+TEST_P(Atomic_file_writer_test, stage_from_threads)
+{
+	Atomic_file_writer writer(GetParam());
+
+	std::array<std::thread, 4> threads;
+	for(size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i] = std::thread([this, &writer, i]()
+		{
+			for(int j = 0; j < 25; j++)
+			{
+				const std::string name = std::to_string(i) + "_" + std::to_string(j);
+				EXPECT_TRUE(writer.stage(m_dir + "/" + name, name));
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	ASSERT_TRUE(writer.commit());
+
+	const std::vector<std::string> names = list_dir();
+	ASSERT_EQ(names.size(), 100U);
+	for(const std::string& name : names)
+	{
+		EXPECT_EQ(read(name), name);
+	}
+}
+
+TEST_F(Atomic_file_writer_test, skip_unchanged)
+{
+	const std::string path = m_dir + "/cfg";
+	ASSERT_TRUE(Atomic_file_writer::write_file(path, "same"));
+
+	struct stat st0;
+	ASSERT_EQ(stat(path.c_str(), &st0), 0);
+
+	Atomic_file_writer writer;
+	writer.set_skip_unchanged(true);
+
+	ASSERT_TRUE(writer.stage(path, "same"));
+	EXPECT_EQ(writer.get_staged_count(), 0U);
+	ASSERT_TRUE(writer.commit());
+
+	// not replaced, same inode
+	struct stat st1;
+	ASSERT_EQ(stat(path.c_str(), &st1), 0);
+	EXPECT_EQ(st0.st_ino, st1.st_ino);
+
+	ASSERT_TRUE(writer.stage(path, "diff"));
+	EXPECT_EQ(writer.get_staged_count(), 1U);
+	ASSERT_TRUE(writer.commit());
+	EXPECT_EQ(read("cfg"), "diff");
+}
+
+TEST_F(Atomic_file_writer_test, skip_unchanged_restage_wins)
+{
+	const std::string path = m_dir + "/cfg";
+	ASSERT_TRUE(Atomic_file_writer::write_file(path, "original"));
+
+	Atomic_file_writer writer;
+	writer.set_skip_unchanged(true);
+
+	// the second stage matches the disk, it must still replace the first
+	ASSERT_TRUE(writer.stage(path, "changed"));
+	EXPECT_EQ(writer.get_staged_count(), 1U);
+	ASSERT_TRUE(writer.stage(path, "original"));
+	EXPECT_EQ(writer.get_staged_count(), 0U);
+	ASSERT_TRUE(writer.commit());
+
+	EXPECT_EQ(read("cfg"), "original");
+
+	// the dropped temp file was removed
+	EXPECT_EQ(list_dir(), std::vector<std::string>({"cfg"}));
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, Atomic_file_writer_test, ::testing::Values(Atomic_file_writer::Sync_mode::FDATASYNC_EACH, Atomic_file_writer::Sync_mode::SYNCFS));
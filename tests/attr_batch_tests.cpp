@@ -0,0 +1,133 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Attr_batch.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+
+class Attr_batch_test : public ::testing::TestWithParam<bool>
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-attr-batch"));
+		m_dir = m_tmp.get_path();
+
+		for(int i = 0; i < NUM_ATTRS; i++)
+		{
+			set(i, std::to_string(i * 1000) + "\n");
+		}
+	}
+	std::string get_name(const int i) const
+	{
+		return "attr" + std::to_string(i);
+	}
+	std::string get_path(const int i) const
+	{
+		return m_dir + "/" + get_name(i);
+	}
+	void set(const int i, const std::string& val)
+	{
+		ASSERT_TRUE(File_util::writeSmallFile(get_path(i), val));
+	}
+
+	// more than the ring holds at once, to cover chunked submission
+	static constexpr int NUM_ATTRS = 300;
+
+	Temp_dir m_tmp;
+	std::string m_dir;
+};
+
+TEST_P(Attr_batch_test, sweeps)
+{
+	const bool use_io_uring = GetParam();
+
+	Attr_batch batch;
+
+	size_t dir_idx = 0;
+	ASSERT_TRUE(batch.add_dir(m_dir, &dir_idx));
+
+	for(int i = 0; i < NUM_ATTRS; i++)
+	{
+		size_t attr_idx = 0;
+		ASSERT_TRUE(batch.add_attr(dir_idx, get_name(i), &attr_idx));
+		ASSERT_EQ(attr_idx, size_t(i));
+	}
+
+	size_t abs_idx = 0;
+	ASSERT_TRUE(batch.add_attr(get_path(0), &abs_idx));
+	EXPECT_EQ(abs_idx, size_t(NUM_ATTRS));
+
+	ASSERT_TRUE(batch.init(3, 16, use_io_uring));
+	if( ! use_io_uring )
+	{
+		EXPECT_FALSE(batch.is_using_io_uring());
+	}
+
+	ASSERT_TRUE(batch.sample());
+
+	set(1, "3.5\n");
+	set(2, std::string(20, '9'));
+	ASSERT_TRUE(batch.sample());
+
+	ASSERT_TRUE(batch.sample());
+	EXPECT_FALSE(batch.sample());
+	ASSERT_EQ(batch.get_sample_count(), 3U);
+
+	for(int i = 0; i < NUM_ATTRS; i++)
+	{
+		int64_t val = 0;
+		ASSERT_TRUE(batch.get_int64(0, i, &val));
+		EXPECT_EQ(val, i * 1000);
+	}
+
+	int64_t val = 0;
+	ASSERT_TRUE(batch.get_int64(0, NUM_ATTRS, &val));
+	EXPECT_EQ(val, 0);
+
+	double dval = 0.0;
+	ASSERT_TRUE(batch.get_double(1, 1, &dval));
+	EXPECT_EQ(dval, 3.5);
+	EXPECT_FALSE(batch.get_int64(1, 1, &val));
+
+	// does not fit in a 16 byte slot
+	EXPECT_EQ(batch.get_length(1, 2), -EOVERFLOW);
+	EXPECT_FALSE(batch.get_int64(1, 2, &val));
+
+	std::string_view sval;
+	ASSERT_TRUE(batch.get_string(2, 3, &sval));
+	EXPECT_EQ(sval, "3000");
+
+	EXPECT_LE(batch.get_time(0), batch.get_time(1));
+	EXPECT_LE(batch.get_time(1), batch.get_time(2));
+
+	batch.clear();
+	EXPECT_EQ(batch.get_sample_count(), 0U);
+	EXPECT_FALSE(batch.get_string(0, 0, &sval));
+	EXPECT_TRUE(batch.sample());
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, Attr_batch_test, ::testing::Values(false, true));
+
+TEST(Attr_batch, setup_errors)
+{
+	Attr_batch batch;
+
+	size_t idx = 0;
+	EXPECT_FALSE(batch.add_dir("/nonexistent-emb-lin-util", &idx));
+	EXPECT_FALSE(batch.add_attr(0, "x", &idx));
+	EXPECT_FALSE(batch.init(1));
+	EXPECT_FALSE(batch.sample());
+}
@@ -0,0 +1,140 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Chunk_reader.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+// prefetch mode x O_DIRECT
+class Chunk_reader_test : public ::testing::TestWithParam<std::tuple<Chunk_reader::Prefetch, bool>>
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-chunk"));
+		m_path = m_tmp.get_path("data");
+	}
+
+	void write_pattern(const size_t len)
+	{
+		m_data.resize(len);
+		for(size_t i = 0; i < len; i++)
+		{
+			m_data[i] = uint8_t((i * 7U) + (i >> 12));
+		}
+		ASSERT_TRUE(File_util::writeSmallFile(m_path, m_data));
+	}
+
+	Temp_dir m_tmp;
+	std::string m_path;
+	std::vector<uint8_t> m_data;
+};
+
+TEST_P(Chunk_reader_test, streams_in_order)
+{
+	Chunk_reader reader(64 * 1024, 3);
+	reader.set_prefetch(std::get<0>(GetParam()));
+	reader.set_direct(std::get<1>(GetParam()));
+	reader.set_drop_behind(true);
+
+	// a partial last chunk
+	write_pattern((40U * 64U * 1024U) + 123U);
+
+	std::vector<uint8_t> out;
+	std::vector<size_t> lens;
+	ASSERT_TRUE(reader.read_file(m_path, [&](uint8_t const * const ptr, const size_t len)
+	{
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % Chunk_reader::ALIGNMENT, 0U);
+		out.insert(out.end(), ptr, ptr + len);
+		lens.push_back(len);
+		return true;
+	}));
+
+	EXPECT_EQ(reader.get_bytes_read(), m_data.size());
+	EXPECT_TRUE(out == m_data);
+	ASSERT_EQ(lens.size(), 41U);
+	EXPECT_EQ(lens.front(), 64U * 1024U);
+	EXPECT_EQ(lens.back(), 123U);
+
+	// an exact multiple of the chunk size ends without an empty chunk
+	write_pattern(4U * 64U * 1024U);
+
+	lens.clear();
+	ASSERT_TRUE(reader.read_file(m_path, [&](uint8_t const * const, const size_t len)
+	{
+		lens.push_back(len);
+		return true;
+	}));
+	EXPECT_EQ(lens.size(), 4U);
+}
+
+TEST_P(Chunk_reader_test, callback_stops)
+{
+	Chunk_reader reader(4096, 3);
+	reader.set_prefetch(std::get<0>(GetParam()));
+	reader.set_direct(std::get<1>(GetParam()));
+
+	write_pattern(100U * 4096U);
+
+	int calls = 0;
+	EXPECT_FALSE(reader.read_file(m_path, [&calls](uint8_t const * const, const size_t)
+	{
+		calls++;
+		return calls < 5;
+	}));
+	EXPECT_EQ(calls, 5);
+	EXPECT_EQ(reader.get_bytes_read(), 4U * 4096U);
+
+	// and the reader is reusable after an early stop
+	size_t total = 0;
+	EXPECT_TRUE(reader.read_file(m_path, [&total](uint8_t const * const, const size_t len)
+	{
+		total += len;
+		return true;
+	}));
+	EXPECT_EQ(total, m_data.size());
+}
+
+TEST_P(Chunk_reader_test, empty_and_missing)
+{
+	Chunk_reader reader(4096, 2);
+	reader.set_prefetch(std::get<0>(GetParam()));
+	reader.set_direct(std::get<1>(GetParam()));
+
+	int calls = 0;
+	const Chunk_reader::Block_callback cb = [&calls](uint8_t const * const, const size_t)
+	{
+		calls++;
+		return true;
+	};
+
+	write_pattern(0);
+	EXPECT_TRUE(reader.read_file(m_path, cb));
+	EXPECT_EQ(calls, 0);
+
+	EXPECT_FALSE(reader.read_file(m_path + ".missing", cb));
+	EXPECT_EQ(calls, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, Chunk_reader_test, ::testing::Combine(
+	::testing::Values(Chunk_reader::Prefetch::NONE, Chunk_reader::Prefetch::THREAD, Chunk_reader::Prefetch::IO_URING),
+	::testing::Bool()
+));
+
+TEST(Chunk_reader, chunk_size_is_aligned)
+{
+	EXPECT_EQ(Chunk_reader(1).get_chunk_size(), Chunk_reader::ALIGNMENT);
+	EXPECT_EQ(Chunk_reader(Chunk_reader::ALIGNMENT + 1).get_chunk_size(), 2U * Chunk_reader::ALIGNMENT);
+	EXPECT_EQ(Chunk_reader(1024U * 1024U).get_chunk_size(), 1024U * 1024U);
+}
@@ -0,0 +1,83 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Chronometer.hpp>
+#include <emb-lin-util/Clock_correlator.hpp>
+#include <emb-lin-util/Timespec_util.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(Clock_correlator, invalid_before_update)
+{
+	Clock_correlator corr;
+
+	std::chrono::nanoseconds t_real;
+	EXPECT_FALSE(corr.mono_to_real(std::chrono::nanoseconds(0), &t_real));
+}
+
+TEST(Clock_correlator, matches_syscall)
+{
+	Clock_correlator corr;
+	ASSERT_TRUE(corr.update());
+
+	timespec t_mono;
+	timespec t_real;
+	timespec t_tai;
+	ASSERT_TRUE(Chronometer::get_mono_time(&t_mono));
+	ASSERT_TRUE(Chronometer::get_real_time(&t_real));
+	ASSERT_TRUE(Chronometer::get_tai_time(&t_tai));
+
+	std::chrono::nanoseconds t_real_est;
+	std::chrono::nanoseconds t_tai_est;
+	ASSERT_TRUE(corr.mono_to_real(Timespec_util::to_chrono<std::chrono::nanoseconds>(t_mono), &t_real_est));
+	ASSERT_TRUE(corr.mono_to_tai(Timespec_util::to_chrono<std::chrono::nanoseconds>(t_mono), &t_tai_est));
+
+	EXPECT_LE(std::chrono::abs(t_real_est - Timespec_util::to_chrono<std::chrono::nanoseconds>(t_real)), std::chrono::microseconds(100));
+	EXPECT_LE(std::chrono::abs(t_tai_est  - Timespec_util::to_chrono<std::chrono::nanoseconds>(t_tai)),  std::chrono::microseconds(100));
+}
+
+TEST(Clock_correlator, batch_matches_single)
+{
+	Clock_correlator corr;
+	ASSERT_TRUE(corr.update());
+
+	std::vector<std::chrono::nanoseconds> t_mono(1000);
+	for(size_t i = 0; i < t_mono.size(); i++)
+	{
+		t_mono[i] = std::chrono::milliseconds(i);
+	}
+
+	std::vector<std::chrono::nanoseconds> t_tai(t_mono.size());
+	ASSERT_TRUE(corr.mono_to_tai(t_mono.data(), t_mono.size(), t_tai.data()));
+
+	for(size_t i = 0; i < t_mono.size(); i++)
+	{
+		std::chrono::nanoseconds t_i;
+		ASSERT_TRUE(corr.mono_to_tai(t_mono[i], &t_i));
+		EXPECT_EQ(t_i, t_tai[i]);
+	}
+}
+
+TEST(Clock_correlator, thread_refresh)
+{
+	Clock_correlator corr;
+	corr.set_update_period(std::chrono::milliseconds(10));
+	corr.launch();
+
+	Clock_correlator::Offsets offsets;
+	for(int i = 0; (i < 100) && ( ! corr.get_offsets(&offsets) ); i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	EXPECT_TRUE(corr.get_offsets(&offsets));
+
+	corr.interrupt();
+	corr.join();
+}
@@ -0,0 +1,141 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Dir_scanner.hpp>
+#include <emb-lin-util/File_util.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+class Dir_scanner_test : public ::testing::Test
+{
+protected:
+	static constexpr int NUM_FILES = 1500;
+
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-scan"));
+		m_dir = m_tmp.get_path();
+
+		// file i is i bytes, every third one is a .log
+		for(int i = 0; i < NUM_FILES; i++)
+		{
+			ASSERT_TRUE(File_util::writeSmallFile(m_dir + "/" + get_name(i), std::string(size_t(i), 'x')));
+		}
+		ASSERT_EQ(mkdir((m_dir + "/sub").c_str(), 0755), 0);
+		ASSERT_EQ(symlink("rec_0.bin", (m_dir + "/link").c_str()), 0);
+	}
+
+	static std::string get_name(const int i)
+	{
+		return "rec_" + std::to_string(i) + (((i % 3) == 0) ? ".log" : ".bin");
+	}
+
+	Temp_dir m_tmp;
+	std::string m_dir;
+};
+
+TEST_F(Dir_scanner_test, visits_everything)
+{
+	// small buffer, many getdents64 calls
+	Dir_scanner scanner(4096);
+
+	int n_reg  = 0;
+	int n_dir  = 0;
+	int n_link = 0;
+	int n_other = 0;
+	ASSERT_TRUE(scanner.for_each(m_dir, [&](const Dir_scanner::Entry_view& ent)
+	{
+		EXPECT_NE(ent.name, ".");
+		EXPECT_NE(ent.name, "..");
+		switch(ent.type)
+		{
+			case Dir_scanner::Type::REGULAR:   { n_reg++;   break; }
+			case Dir_scanner::Type::DIRECTORY: { n_dir++;   break; }
+			case Dir_scanner::Type::SYMLINK:   { n_link++;  break; }
+			default:                           { n_other++; break; }
+		}
+		return true;
+	}));
+
+	// d_type may be unknown on some filesystems, the total still holds
+	EXPECT_EQ(n_reg + n_dir + n_link + n_other, NUM_FILES + 2);
+	if(n_other == 0)
+	{
+		EXPECT_EQ(n_reg, NUM_FILES);
+		EXPECT_EQ(n_dir, 1);
+		EXPECT_EQ(n_link, 1);
+	}
+
+	// stops early
+	int n = 0;
+	ASSERT_TRUE(scanner.for_each(m_dir, [&n](const Dir_scanner::Entry_view&)
+	{
+		n++;
+		return n < 10;
+	}));
+	EXPECT_EQ(n, 10);
+
+	EXPECT_FALSE(scanner.for_each(m_dir + "/missing", [](const Dir_scanner::Entry_view&){ return true; }));
+}
+
+TEST_F(Dir_scanner_test, filter_and_stat)
+{
+	Dir_scanner scanner;
+
+	std::vector<Dir_scanner::Entry> entries;
+	ASSERT_TRUE(scanner.scan(m_dir, [](const Dir_scanner::Entry_view& ent)
+	{
+		return ent.name.ends_with(".log");
+	}, &entries));
+	ASSERT_EQ(entries.size(), size_t(NUM_FILES / 3));
+
+	for(const size_t n_threads : {size_t(1), size_t(4)})
+	{
+		for(auto& e : entries)
+		{
+			e.has_stat = false;
+			e.size     = 0;
+		}
+
+		ASSERT_TRUE(Dir_scanner::stat_entries(m_dir, &entries, n_threads));
+
+		for(const auto& e : entries)
+		{
+			ASSERT_TRUE(e.has_stat) << e.name;
+			EXPECT_EQ(e.type, Dir_scanner::Type::REGULAR);
+			EXPECT_GT(e.mtime_ns, 0);
+
+			// rec_<size>.log
+			EXPECT_EQ(std::to_string(e.size), e.name.substr(4, e.name.size() - 8));
+		}
+	}
+
+	// a file removed between scan and stat is skipped, not an error
+	std::vector<Dir_scanner::Entry> all;
+	ASSERT_TRUE(scanner.scan(m_dir, nullptr, &all));
+	EXPECT_EQ(all.size(), size_t(NUM_FILES + 2));
+
+	Dir_scanner::Entry gone;
+	gone.name = "gone";
+	all.push_back(gone);
+	EXPECT_TRUE(Dir_scanner::stat_entries(m_dir, &all, 4));
+	EXPECT_FALSE(all.back().has_stat);
+
+	// the symlink itself, not its target
+	const auto link = std::find_if(all.begin(), all.end(), [](const Dir_scanner::Entry& e){ return e.name == "link"; });
+	ASSERT_NE(link, all.end());
+	EXPECT_EQ(link->type, Dir_scanner::Type::SYMLINK);
+}
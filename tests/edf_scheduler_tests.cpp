@@ -0,0 +1,193 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Dary_heap.hpp>
+#include <emb-lin-util/Edf_scheduler.hpp>
+#include <emb-lin-util/Virtual_clock.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+// These tests link emb-lin-util-vclock, time only moves on Virtual_clock::advance
+// The scheduler thread still runs in real time, so wait for it to catch up before the next advance
+static bool wait_until(const std::function<bool()>& pred)
+{
+	const std::chrono::steady_clock::time_point t_end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while( ! pred() )
+	{
+		if(std::chrono::steady_clock::now() > t_end)
+		{
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+static uint64_t get_run_count(const Edf_scheduler& sched, const Edf_scheduler::Task_id id)
+{
+	Edf_scheduler::Task_stats stats;
+	if( ! sched.get_stats(id, &stats) )
+	{
+		return 0;
+	}
+
+	return stats.run_count;
+}
+
+TEST(Dary_heap, sorts)
+{
+	std::mt19937 rng(1234);
+
+	Dary_heap<int> heap;
+	std::vector<int> ref;
+	for(int i = 0; i < 10000; i++)
+	{
+		const int val = int(rng() % 1000);
+		heap.push(val);
+		ref.push_back(val);
+	}
+
+	std::sort(ref.begin(), ref.end());
+
+	for(const int val : ref)
+	{
+		ASSERT_FALSE(heap.empty());
+		ASSERT_EQ(heap.top(), val);
+		heap.pop();
+	}
+	EXPECT_TRUE(heap.empty());
+}
+
+TEST(Edf_scheduler, periodic_and_oneshot)
+{
+	Edf_scheduler sched;
+	ASSERT_TRUE(sched.init());
+	sched.launch();
+
+	std::atomic<int> fast_cnt(0);
+	std::atomic<int> slow_cnt(0);
+	std::atomic<int> once_cnt(0);
+
+	Edf_scheduler::Task_id fast_id;
+	Edf_scheduler::Task_id slow_id;
+	Edf_scheduler::Task_id once_id;
+	ASSERT_TRUE(sched.add_periodic(std::chrono::milliseconds(10), std::chrono::nanoseconds::zero(), [&fast_cnt](){ fast_cnt++; }, &fast_id));
+	ASSERT_TRUE(sched.add_periodic(std::chrono::milliseconds(50), std::chrono::nanoseconds::zero(), [&slow_cnt](){ slow_cnt++; }, &slow_id));
+	ASSERT_TRUE(sched.add_oneshot(std::chrono::milliseconds(30), std::chrono::nanoseconds::zero(), [&once_cnt](){ once_cnt++; }, &once_id));
+
+	// one fast period per step, the stats are updated after the callback so they show the job is done
+	for(int step = 1; step <= 20; step++)
+	{
+		Virtual_clock::advance(std::chrono::milliseconds(10));
+
+		ASSERT_TRUE(wait_until([&](){ return (get_run_count(sched, fast_id) == uint64_t(step)) && (get_run_count(sched, slow_id) == uint64_t(step / 5)) && (once_cnt == ((step >= 3) ? 1 : 0)); })) << step;
+	}
+
+	ASSERT_TRUE(sched.remove(fast_id));
+
+	for(int step = 21; step <= 25; step++)
+	{
+		Virtual_clock::advance(std::chrono::milliseconds(10));
+	}
+	ASSERT_TRUE(wait_until([&](){ return get_run_count(sched, slow_id) == 5U; }));
+
+	Edf_scheduler::Task_stats stats;
+	EXPECT_FALSE(sched.get_stats(fast_id, &stats));
+	EXPECT_FALSE(sched.get_stats(once_id, &stats));
+	ASSERT_TRUE(sched.get_stats(slow_id, &stats));
+	EXPECT_EQ(stats.run_count, uint64_t(slow_cnt.load()));
+
+	sched.interrupt();
+	sched.join();
+
+	EXPECT_EQ(fast_cnt, 20);
+	EXPECT_EQ(slow_cnt, 5);
+	EXPECT_EQ(once_cnt, 1);
+}
+
+TEST(Edf_scheduler, add_before_init_fails)
+{
+	Edf_scheduler sched;
+
+	Edf_scheduler::Task_id id = 12345;
+	EXPECT_FALSE(sched.add_periodic(std::chrono::milliseconds(10), std::chrono::nanoseconds::zero(), [](){ }, &id));
+	EXPECT_FALSE(sched.add_oneshot(std::chrono::milliseconds(10), std::chrono::nanoseconds::zero(), [](){ }, &id));
+	EXPECT_EQ(id, 12345U);
+
+	// nothing was left behind by the failed adds
+	ASSERT_TRUE(sched.init());
+	ASSERT_TRUE(sched.add_oneshot(std::chrono::milliseconds(10), std::chrono::nanoseconds::zero(), [](){ }, &id));
+	EXPECT_TRUE(sched.get_stats(id, nullptr));
+	for(Edf_scheduler::Task_id i = 0; i < id; i++)
+	{
+		EXPECT_FALSE(sched.get_stats(i, nullptr)) << i;
+	}
+}
+
+TEST(Edf_scheduler, runs_earliest_deadline_first)
+{
+	Edf_scheduler sched;
+	ASSERT_TRUE(sched.init());
+
+	std::vector<int> order;
+	std::atomic<int> done(0);
+
+	// all released at the same time, deadlines in reverse order of creation
+	Edf_scheduler::Task_id id;
+	for(int i = 0; i < 5; i++)
+	{
+		ASSERT_TRUE(sched.add_oneshot(std::chrono::milliseconds(10), std::chrono::milliseconds(50 - (10 * i)), [&order, &done, i](){ order.push_back(i); done++; }, &id));
+	}
+
+	Virtual_clock::advance(std::chrono::milliseconds(20));
+	sched.launch();
+	EXPECT_TRUE(wait_until([&done](){ return done == 5; }));
+
+	sched.interrupt();
+	sched.join();
+
+	EXPECT_EQ(order, std::vector<int>({4, 3, 2, 1, 0}));
+}
+
+TEST(Edf_scheduler, counts_deadline_misses)
+{
+	Edf_scheduler sched;
+	ASSERT_TRUE(sched.init());
+	sched.launch();
+
+	// each job takes 2ms of virtual time against a 1ms deadline
+	const std::chrono::nanoseconds t_add = Virtual_clock::now();
+	Edf_scheduler::Task_id id;
+	ASSERT_TRUE(sched.add_periodic(std::chrono::milliseconds(10), std::chrono::milliseconds(1), [](){ Virtual_clock::advance(std::chrono::milliseconds(2)); }, &id));
+
+	for(int step = 1; step <= 5; step++)
+	{
+		// to the next release, the jobs have already moved time 2ms past the last one
+		Virtual_clock::advance(t_add + (step * std::chrono::milliseconds(10)) - Virtual_clock::now());
+		ASSERT_TRUE(wait_until([&](){ return get_run_count(sched, id) == uint64_t(step); })) << step;
+	}
+
+	Edf_scheduler::Task_stats stats;
+	ASSERT_TRUE(sched.get_stats(id, &stats));
+
+	sched.interrupt();
+	sched.join();
+
+	EXPECT_EQ(stats.run_count, 5U);
+	EXPECT_EQ(stats.deadline_misses, 5U);
+	EXPECT_EQ(stats.skipped_releases, 0U);
+	EXPECT_GE(stats.max_runtime, std::chrono::milliseconds(2));
+}
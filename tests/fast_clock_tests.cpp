@@ -0,0 +1,103 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Chronometer.hpp>
+#include <emb-lin-util/Fast_clock.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace
+{
+	// lets a test put the clock off by a known amount
+	class Fast_clock_offset : public Fast_clock
+	{
+	public:
+		void add_offset(const std::chrono::nanoseconds& dt)
+		{
+			Params params;
+			ASSERT_TRUE(m_params.load(&params));
+			params.ns0 += dt.count();
+			params.ns1 += dt.count();
+			m_params.store(params);
+		}
+	};
+}
+
+TEST(Fast_clock, tracks_monotonic)
+{
+	Fast_clock clk;
+	ASSERT_TRUE(clk.init());
+
+	for(size_t i = 0; i < 10; i++)
+	{
+		std::chrono::nanoseconds t_mono;
+		std::chrono::nanoseconds t_fast;
+		ASSERT_TRUE(Chronometer::get_time(&t_mono));
+		ASSERT_TRUE(clk.get_time(&t_fast));
+
+		std::chrono::microseconds err = std::chrono::floor<std::chrono::microseconds>(std::chrono::abs(t_fast - t_mono));
+		EXPECT_LE(err, std::chrono::microseconds(100));
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		ASSERT_TRUE(clk.recalibrate());
+	}
+}
+
+TEST(Fast_clock, is_monotonic)
+{
+	Fast_clock clk;
+	ASSERT_TRUE(clk.init());
+
+	std::chrono::nanoseconds t_prev;
+	ASSERT_TRUE(clk.get_time(&t_prev));
+
+	for(size_t i = 0; i < 1000000; i++)
+	{
+		std::chrono::nanoseconds t_i;
+		ASSERT_TRUE(clk.get_time(&t_i));
+		ASSERT_GE(t_i, t_prev);
+		t_prev = t_i;
+
+		if((i % 100000) == 0)
+		{
+			ASSERT_TRUE(clk.recalibrate());
+		}
+	}
+}
+
+TEST(Fast_clock, slew_ends)
+{
+	Fast_clock_offset clk;
+	ASSERT_TRUE(clk.init(std::chrono::milliseconds(100)));
+	if( ! clk.is_counter_enabled() )
+	{
+		GTEST_SKIP() << "counter not usable, Fast_clock is clock_gettime";
+	}
+
+	const double freq = clk.get_counter_freq();
+
+	// recalibrate measures the rate since the last sample
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	// removed over 10 ms, the slew rate is 5%
+	clk.add_offset(std::chrono::microseconds(500));
+	ASSERT_TRUE(clk.recalibrate(std::chrono::milliseconds(10)));
+
+	// long after the slew, still on CLOCK_MONOTONIC and back to the counter rate
+	// had the slew rate stuck, the clock would be about 10 ms off by now
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	std::chrono::nanoseconds t_mono;
+	std::chrono::nanoseconds t_fast;
+	ASSERT_TRUE(Chronometer::get_time(&t_mono));
+	ASSERT_TRUE(clk.get_time(&t_fast));
+
+	EXPECT_LE(std::chrono::abs(t_fast - t_mono), std::chrono::milliseconds(1));
+	EXPECT_NEAR(clk.get_counter_freq(), freq, freq * 1.0e-3);
+}
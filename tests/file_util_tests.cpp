@@ -0,0 +1,148 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/Rate_limiter.hpp>
+#include <emb-lin-util/Stopwatch.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+class Copy_file_test : public ::testing::TestWithParam<File_util::Copy_method>
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-copy"));
+		m_src = m_tmp.get_path("src");
+		m_dst = m_tmp.get_path("dst");
+
+		m_data.resize((3U * 1024U * 1024U) + 17U);
+		for(size_t i = 0; i < m_data.size(); i++)
+		{
+			m_data[i] = uint8_t((i * 13U) + (i >> 16));
+		}
+		ASSERT_TRUE(File_util::writeSmallFile(m_src, m_data));
+		ASSERT_EQ(chmod(m_src.c_str(), 0640), 0);
+	}
+
+	File_util::Copy_options get_options() const
+	{
+		File_util::Copy_options opt;
+		opt.first_method = GetParam();
+		opt.chunk_size   = 256U * 1024U;
+		opt.sync         = false;
+		return opt;
+	}
+
+	Temp_dir m_tmp;
+	std::string m_src;
+	std::string m_dst;
+	std::vector<uint8_t> m_data;
+};
+
+TEST_P(Copy_file_test, copies)
+{
+	File_util::Copy_options opt = get_options();
+
+	std::vector<uint64_t> progress;
+	opt.progress = [&progress](const uint64_t copied, const uint64_t total)
+	{
+		EXPECT_LE(copied, total);
+		progress.push_back(copied);
+		return true;
+	};
+
+	// dst is truncated
+	ASSERT_TRUE(File_util::writeSmallFile(m_dst, std::string(4U * 1024U * 1024U, 'x')));
+
+	File_util::Copy_method method = File_util::Copy_method::READ_WRITE;
+	ASSERT_TRUE(File_util::copy_file(m_src, m_dst, opt, &method));
+
+	// the method used is the requested one or a fallback after it
+	EXPECT_GE(int(method), int(GetParam()));
+
+	std::vector<uint8_t> out;
+	ASSERT_TRUE(File_util::readSmallFile(m_dst, &out));
+	EXPECT_TRUE(out == m_data);
+
+	struct stat st;
+	ASSERT_EQ(stat(m_dst.c_str(), &st), 0);
+	EXPECT_EQ(st.st_mode & 07777, 0640U);
+
+	ASSERT_FALSE(progress.empty());
+	EXPECT_EQ(progress.back(), m_data.size());
+	if(method != File_util::Copy_method::CLONE)
+	{
+		EXPECT_EQ(progress.size(), 13U);
+	}
+}
+
+TEST_P(Copy_file_test, cancel_removes_dst)
+{
+	File_util::Copy_options opt = get_options();
+	opt.first_method = std::max(GetParam(), File_util::Copy_method::COPY_FILE_RANGE);
+	opt.progress = [](const uint64_t copied, const uint64_t)
+	{
+		return copied < (512U * 1024U);
+	};
+
+	EXPECT_FALSE(File_util::copy_file(m_src, m_dst, opt));
+	EXPECT_NE(access(m_dst.c_str(), F_OK), 0);
+}
+
+TEST_P(Copy_file_test, rate_limited)
+{
+	// 3 MiB at 10 MiB/s with a 256 KiB burst
+	Token_bucket bucket(10.0 * 1024.0 * 1024.0, 256U * 1024U);
+
+	File_util::Copy_options opt = get_options();
+	opt.first_method = std::max(GetParam(), File_util::Copy_method::COPY_FILE_RANGE);
+	opt.rate_limit   = &bucket;
+
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+	ASSERT_TRUE(File_util::copy_file(m_src, m_dst, opt));
+
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(sw.get_time(&dt));
+	EXPECT_GE(dt, std::chrono::milliseconds(250));
+}
+
+INSTANTIATE_TEST_SUITE_P(Methods, Copy_file_test, ::testing::Values(
+	File_util::Copy_method::CLONE,
+	File_util::Copy_method::COPY_FILE_RANGE,
+	File_util::Copy_method::SENDFILE,
+	File_util::Copy_method::READ_WRITE
+));
+
+TEST(File_util, copy_file_errors)
+{
+	Temp_dir tmp;
+	ASSERT_TRUE(tmp.create("emb-lin-util-copy"));
+	const std::string src = tmp.get_path("src");
+
+	EXPECT_FALSE(File_util::copy_file(src, tmp.get_path("dst")));
+
+	// not a regular file
+	EXPECT_FALSE(File_util::copy_file(tmp.get_path(), tmp.get_path("dst")));
+
+	// copying onto itself must not truncate it
+	ASSERT_TRUE(File_util::writeSmallFile(src, std::string("abc")));
+	EXPECT_FALSE(File_util::copy_file(src, src));
+
+	std::string line;
+	ASSERT_TRUE(File_util::readSmallFileLine(src, &line));
+	EXPECT_EQ(line, "abc");
+}
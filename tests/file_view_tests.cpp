@@ -0,0 +1,218 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/File_view.hpp>
+#include <emb-lin-util/JSON_CBOR_helper.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace
+{
+	struct Config : public JSON_CBOR_helper<Config>
+	{
+		std::string name;
+		std::vector<int> vals;
+	};
+
+	void to_json(nlohmann::json& j, const Config& x)
+	{
+		j = nlohmann::json{{"name", x.name}, {"vals", x.vals}};
+	}
+	void from_json(const nlohmann::json& j, Config& x)
+	{
+		j.at("name").get_to(x.name);
+		j.at("vals").get_to(x.vals);
+	}
+}
+
+class File_view_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-file-view"));
+	}
+
+	Temp_dir m_tmp;
+};
+
+TEST_F(File_view_test, maps_regular_file)
+{
+	const std::string path = m_tmp.get_path("data");
+
+	std::vector<uint8_t> data(3 * 4096 + 17);
+	for(size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = uint8_t(i * 31);
+	}
+	ASSERT_TRUE(File_util::writeSmallFile(path, data));
+
+	File_view view;
+	ASSERT_TRUE(view.open(path));
+	EXPECT_TRUE(view.is_open());
+	EXPECT_TRUE(view.is_mapped());
+	ASSERT_EQ(view.size(), data.size());
+	EXPECT_TRUE(std::equal(view.get_span().begin(), view.get_span().end(), data.begin()));
+
+	File_view moved(std::move(view));
+	EXPECT_FALSE(view.is_open());
+	EXPECT_EQ(view.size(), 0U);
+	ASSERT_EQ(moved.size(), data.size());
+	EXPECT_EQ(moved.data()[100], data[100]);
+
+	moved.close();
+	EXPECT_FALSE(moved.is_open());
+}
+
+TEST_F(File_view_test, reads_unmappable_and_empty)
+{
+	// procfs reports a size of 0
+	File_view proc;
+	ASSERT_TRUE(proc.open("/proc/self/status"));
+	EXPECT_FALSE(proc.is_mapped());
+	ASSERT_GT(proc.size(), 0U);
+	EXPECT_EQ(std::string(reinterpret_cast<char const *>(proc.data()), 5), "Name:");
+
+	const std::string path = m_tmp.get_path("empty");
+	ASSERT_TRUE(File_util::writeSmallFile(path, std::string()));
+	File_view empty;
+	ASSERT_TRUE(empty.open(path));
+	EXPECT_TRUE(empty.is_open());
+	EXPECT_EQ(empty.size(), 0U);
+
+	File_view missing;
+	EXPECT_FALSE(missing.open("/nonexistent-emb-lin-util"));
+	EXPECT_FALSE(missing.is_open());
+}
+
+TEST_F(File_view_test, json_cbor_helper_reads)
+{
+	const std::string path = m_tmp.get_path("cfg");
+
+	Config cfg;
+	cfg.name = "map";
+	cfg.vals = {1, 2, 3};
+
+	Config out;
+
+	ASSERT_TRUE(cfg.write_json(path));
+	ASSERT_TRUE(out.read_json(path));
+	EXPECT_EQ(out.name, cfg.name);
+	EXPECT_EQ(out.vals, cfg.vals);
+
+	out = Config();
+	ASSERT_TRUE(cfg.write_cbor(path, false));
+	ASSERT_TRUE(out.read_cbor(path, false));
+	EXPECT_EQ(out.name, cfg.name);
+	EXPECT_EQ(out.vals, cfg.vals);
+
+	out = Config();
+	ASSERT_TRUE(cfg.write_cbor(path, true));
+	ASSERT_TRUE(out.read_cbor(path, true));
+	EXPECT_EQ(out.name, cfg.name);
+	EXPECT_EQ(out.vals, cfg.vals);
+}
+
+TEST_F(File_view_test, json_cbor_helper_reads_during_rewrite)
+{
+	const std::string json_path = m_tmp.get_path("cfg.json");
+	const std::string cbor_path = m_tmp.get_path("cfg.cbor");
+
+	// alternate sizes so an in place rewrite would shrink the file under a reader's mapping
+	Config small;
+	small.name = "small";
+	small.vals = {1};
+
+	Config large;
+	large.name = "large";
+	large.vals.assign(8192, 7);
+
+	ASSERT_TRUE(large.write_json(json_path));
+	ASSERT_TRUE(large.write_cbor(cbor_path, false));
+
+	std::atomic<bool> done(false);
+	std::thread writer([&]()
+	{
+		for(int i = 0; i < 100; i++)
+		{
+			const Config& cfg = (i % 2) ? large : small;
+			EXPECT_TRUE(cfg.write_json(json_path));
+			EXPECT_TRUE(cfg.write_cbor(cbor_path, false));
+		}
+		done.store(true);
+	});
+
+	// every read sees one whole version
+	size_t reads = 0;
+	while( ! done.load() )
+	{
+		Config out;
+		EXPECT_NO_THROW(EXPECT_TRUE(out.read_json(json_path)));
+		EXPECT_TRUE((out.name == "small") ? (out.vals == small.vals) : (out.vals == large.vals));
+
+		out = Config();
+		EXPECT_NO_THROW(EXPECT_TRUE(out.read_cbor(cbor_path, false)));
+		EXPECT_TRUE((out.name == "small") ? (out.vals == small.vals) : (out.vals == large.vals));
+
+		reads++;
+	}
+	writer.join();
+
+	EXPECT_GT(reads, 0U);
+}
+
+TEST_F(File_view_test, json_helper_reads_during_in_place_rewrite)
+{
+	const std::string path = m_tmp.get_path("cfg");
+
+	Config small;
+	small.name = "small";
+	small.vals = {1};
+
+	Config large;
+	large.name = "large";
+	large.vals.assign(8192, 7);
+
+	// writeSmallFile truncates and rewrites in place, as an editor or `echo > cfg.json` would
+	std::atomic<bool> done(false);
+	std::thread writer([&]()
+	{
+		for(int i = 0; i < 200; i++)
+		{
+			const Config& cfg = (i % 2) ? large : small;
+			EXPECT_TRUE(File_util::writeSmallFile(path, cfg.to_json_string()));
+		}
+		done.store(true);
+	});
+
+	// a torn read may fail or not parse, but must not crash the process
+	size_t reads = 0;
+	while( ! done.load() )
+	{
+		Config out;
+		try
+		{
+			out.read_json(path);
+		}
+		catch(const nlohmann::json::exception&)
+		{
+
+		}
+
+		reads++;
+	}
+	writer.join();
+
+	EXPECT_GT(reads, 0U);
+}
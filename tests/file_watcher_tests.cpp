@@ -0,0 +1,208 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Atomic_file_writer.hpp>
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/File_watcher.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace
+{
+	struct Calibration
+	{
+		double gain;
+		double offset;
+	};
+
+	bool parse_calibration(std::span<const uint8_t> data, Calibration* const out)
+	{
+		const nlohmann::json j = nlohmann::json::parse(data.begin(), data.end(), nullptr, false);
+		if(j.is_discarded() || ( ! j.is_object() ))
+		{
+			return false;
+		}
+		out->gain   = j.value("gain", 1.0);
+		out->offset = j.value("offset", 0.0);
+		return true;
+	}
+
+	std::string make_calibration(const double gain)
+	{
+		return nlohmann::json{{"gain", gain}, {"offset", 0.5}}.dump();
+	}
+}
+
+class File_watcher_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-watch"));
+		m_dir  = m_tmp.get_path();
+		m_path = m_tmp.get_path("cal.json");
+	}
+
+	// run the loop until pred holds or timeout
+	template <typename Pred>
+	static bool pump(File_watcher* const watcher, const Pred& pred, const std::chrono::milliseconds& timeout = std::chrono::seconds(5))
+	{
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		while( ! pred() )
+		{
+			if(std::chrono::steady_clock::now() > deadline)
+			{
+				return false;
+			}
+			watcher->wait_and_process(std::chrono::milliseconds(10));
+		}
+		return true;
+	}
+
+	Temp_dir m_tmp;
+	std::string m_dir;
+	std::string m_path;
+};
+
+TEST_F(File_watcher_test, reloads_on_replace)
+{
+	ASSERT_TRUE(File_util::writeSmallFile(m_path, make_calibration(2.0)));
+
+	File_watcher watcher;
+	ASSERT_TRUE(watcher.init(std::chrono::milliseconds(10)));
+
+	auto cal = watcher.watch<Calibration>(m_path, parse_calibration);
+	ASSERT_TRUE(cal);
+
+	// loaded at watch
+	ASSERT_TRUE(cal->get());
+	EXPECT_EQ(cal->get()->gain, 2.0);
+	EXPECT_EQ(cal->get_generation(), 1U);
+
+	// rename over, IN_MOVED_TO
+	ASSERT_TRUE(Atomic_file_writer::write_file(m_path, make_calibration(3.0)));
+	ASSERT_TRUE(pump(&watcher, [&cal](){ return cal->get_generation() == 2U; }));
+	EXPECT_EQ(cal->get()->gain, 3.0);
+
+	// rewrite in place, IN_CLOSE_WRITE
+	ASSERT_TRUE(File_util::writeSmallFile(m_path, make_calibration(4.0)));
+	ASSERT_TRUE(pump(&watcher, [&cal](){ return cal->get_generation() == 3U; }));
+	EXPECT_EQ(cal->get()->gain, 4.0);
+
+	// a bad file keeps the last good copy
+	ASSERT_TRUE(File_util::writeSmallFile(m_path, std::string("{not json")));
+	ASSERT_TRUE(pump(&watcher, [&cal](){ return cal->get_error_count() == 1U; }));
+	EXPECT_EQ(cal->get_generation(), 3U);
+	EXPECT_EQ(cal->get()->gain, 4.0);
+}
+
+TEST_F(File_watcher_test, debounces_bursts)
+{
+	File_watcher watcher;
+	ASSERT_TRUE(watcher.init(std::chrono::milliseconds(100)));
+
+	int changes = 0;
+	double last_gain = 0.0;
+	auto cal = watcher.watch<Calibration>(m_path, parse_calibration, [&](const std::shared_ptr<const Calibration>& val)
+	{
+		changes++;
+		last_gain = val->gain;
+	});
+	ASSERT_TRUE(cal);
+
+	// not there yet
+	EXPECT_FALSE(cal->get());
+
+	for(int i = 1; i <= 5; i++)
+	{
+		ASSERT_TRUE(File_util::writeSmallFile(m_path, make_calibration(double(i))));
+		watcher.process_events();
+	}
+
+	ASSERT_TRUE(pump(&watcher, [&changes](){ return changes > 0; }));
+
+	// and nothing else trickles in
+	pump(&watcher, [](){ return false; }, std::chrono::milliseconds(200));
+
+	EXPECT_EQ(changes, 1);
+	EXPECT_EQ(last_gain, 5.0);
+	EXPECT_EQ(cal->get_generation(), 1U);
+}
+
+TEST_F(File_watcher_test, joins_epoll_loop)
+{
+	File_watcher watcher;
+	ASSERT_TRUE(watcher.init(std::chrono::nanoseconds::zero()));
+
+	auto cal = watcher.watch<Calibration>(m_path, parse_calibration);
+	ASSERT_TRUE(cal);
+
+	// an unrelated file in the same directory is ignored
+	const std::string other = m_dir + "/other.json";
+	ASSERT_TRUE(File_util::writeSmallFile(other, make_calibration(9.0)));
+
+	const int epfd = epoll_create1(EPOLL_CLOEXEC);
+	ASSERT_GE(epfd, 0);
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ASSERT_EQ(epoll_ctl(epfd, EPOLL_CTL_ADD, watcher.get_fd(), &ev), 0);
+
+	ASSERT_TRUE(File_util::writeSmallFile(m_path, make_calibration(7.0)));
+
+	for(int i = 0; (i < 100) && (cal->get_generation() == 0U); i++)
+	{
+		if(epoll_wait(epfd, &ev, 1, 50) > 0)
+		{
+			watcher.process_events();
+		}
+	}
+	ASSERT_TRUE(cal->get());
+	EXPECT_EQ(cal->get()->gain, 7.0);
+	EXPECT_EQ(cal->get_generation(), 1U);
+
+	close(epfd);
+	unlink(other.c_str());
+
+	// unwatched files stop reloading
+	ASSERT_TRUE(watcher.unwatch(cal));
+	ASSERT_TRUE(File_util::writeSmallFile(m_path, make_calibration(8.0)));
+	pump(&watcher, [](){ return false; }, std::chrono::milliseconds(50));
+	EXPECT_EQ(cal->get_generation(), 1U);
+}
+
+TEST_F(File_watcher_test, cancel_wakes_waiter)
+{
+	File_watcher watcher;
+	ASSERT_TRUE(watcher.init());
+
+	std::thread t([&watcher]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		watcher.notify_cancel();
+	});
+
+	bool canceled = false;
+	EXPECT_TRUE(watcher.wait_and_process(std::chrono::seconds(5), &canceled));
+	EXPECT_TRUE(canceled);
+
+	t.join();
+
+	// latched
+	EXPECT_TRUE(watcher.wait_and_process(std::chrono::seconds(5), &canceled));
+	EXPECT_TRUE(canceled);
+}
@@ -0,0 +1,227 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/File_writer.hpp>
+#include <emb-lin-util/Heartbeat.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class File_writer_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-writer"));
+		m_dir = m_tmp.get_path();
+	}
+
+	static std::vector<uint8_t> to_vec(const std::string& str)
+	{
+		return std::vector<uint8_t>(str.begin(), str.end());
+	}
+
+	std::string read(const std::string& name) const
+	{
+		std::vector<uint8_t> data;
+		if( ! File_util::readSmallFile(m_dir + "/" + name, &data) )
+		{
+			return std::string();
+		}
+		return std::string(data.begin(), data.end());
+	}
+
+	Temp_dir m_tmp;
+	std::string m_dir;
+};
+
+TEST_F(File_writer_test, latest_write_wins)
+{
+	File_writer writer;
+	writer.set_coalesce_window(std::chrono::milliseconds(50));
+	writer.launch();
+
+	std::vector<std::future<File_writer::Result>> futs;
+	for(int i = 0; i < 10; i++)
+	{
+		futs.push_back(writer.submit(m_dir + "/a", to_vec("a" + std::to_string(i))));
+	}
+	std::future<File_writer::Result> fut_b = writer.submit(m_dir + "/b", to_vec("b"));
+
+	EXPECT_EQ(futs.back().get(), File_writer::Result::WRITTEN);
+	EXPECT_EQ(fut_b.get(), File_writer::Result::WRITTEN);
+
+	// the first job may be written on its own before the rest arrive, the others all coalesce
+	for(size_t i = 1; (i + 1) < futs.size(); i++)
+	{
+		EXPECT_EQ(futs[i].get(), File_writer::Result::SUPERSEDED);
+	}
+
+	EXPECT_EQ(read("a"), "a9");
+	EXPECT_EQ(read("b"), "b");
+
+	const File_writer::Stats stats = writer.get_stats();
+	EXPECT_EQ(stats.submitted, 11U);
+	EXPECT_EQ(stats.written + stats.superseded, 11U);
+	EXPECT_GE(stats.superseded, 8U);
+	EXPECT_EQ(stats.failed, 0U);
+	EXPECT_EQ(stats.pending_jobs, 0U);
+	EXPECT_EQ(stats.pending_bytes, 0U);
+
+	writer.interrupt();
+	writer.join();
+}
+
+TEST_F(File_writer_test, callback_and_flush)
+{
+	File_writer writer;
+	writer.launch();
+
+	std::atomic<int> written(0);
+	const File_writer::Callback cb = [&written](const std::string&, const File_writer::Result result)
+	{
+		if(result == File_writer::Result::WRITTEN)
+		{
+			written++;
+		}
+	};
+
+	for(int i = 0; i < 5; i++)
+	{
+		ASSERT_TRUE(writer.submit(m_dir + "/f" + std::to_string(i), to_vec(std::to_string(i)), cb));
+	}
+
+	// everything before the flush is complete when it is
+	EXPECT_EQ(writer.flush().get(), File_writer::Result::WRITTEN);
+	EXPECT_EQ(written.load(), 5);
+	EXPECT_EQ(read("f4"), "4");
+
+	// a failed write reports through the callback
+	std::atomic<bool> failed(false);
+	ASSERT_TRUE(writer.submit(m_dir + "/missing/f", to_vec("x"), [&failed](const std::string&, const File_writer::Result result)
+	{
+		failed = (result == File_writer::Result::FAILED);
+	}));
+	EXPECT_EQ(writer.flush().get(), File_writer::Result::WRITTEN);
+	EXPECT_TRUE(failed.load());
+	EXPECT_EQ(writer.get_stats().failed, 1U);
+
+	writer.interrupt();
+	writer.join();
+}
+
+TEST_F(File_writer_test, backpressure)
+{
+	// nothing drains until launch
+	File_writer writer(2, 10);
+
+	EXPECT_EQ(writer.submit(m_dir + "/a", to_vec("12345678"), 0644, std::chrono::nanoseconds::zero()).wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+
+	// over the byte budget
+	EXPECT_EQ(writer.submit(m_dir + "/b", to_vec("12345678"), 0644, std::chrono::nanoseconds::zero()).get(), File_writer::Result::REJECTED);
+
+	// over the job count
+	std::future<File_writer::Result> fut_c = writer.submit(m_dir + "/c", to_vec("1"), 0644, std::chrono::nanoseconds::zero());
+	EXPECT_EQ(writer.submit(m_dir + "/d", to_vec("1"), 0644, std::chrono::milliseconds(20)).get(), File_writer::Result::REJECTED);
+
+	File_writer::Stats stats = writer.get_stats();
+	EXPECT_EQ(stats.rejected, 2U);
+	EXPECT_EQ(stats.backpressure_waits, 1U);
+	EXPECT_EQ(stats.pending_jobs, 2U);
+	EXPECT_EQ(stats.pending_bytes, 9U);
+
+	// a blocked submit goes through once the writer makes room
+	std::future<File_writer::Result> fut_e;
+	std::thread t([&]()
+	{
+		fut_e = writer.submit(m_dir + "/e", to_vec("e"));
+	});
+
+	writer.launch();
+	t.join();
+
+	EXPECT_EQ(fut_c.get(), File_writer::Result::WRITTEN);
+	EXPECT_EQ(fut_e.get(), File_writer::Result::WRITTEN);
+
+	// a job bigger than the whole budget still goes alone
+	EXPECT_EQ(writer.submit(m_dir + "/big", to_vec(std::string(100, 'x'))).get(), File_writer::Result::WRITTEN);
+	EXPECT_EQ(read("big").size(), 100U);
+
+	writer.interrupt();
+	writer.join();
+}
+
+TEST_F(File_writer_test, interrupt_writes_queued)
+{
+	File_writer writer;
+
+	// queued before the thread runs, written on the way out
+	std::future<File_writer::Result> fut = writer.submit(m_dir + "/a", to_vec("a"));
+
+	writer.launch();
+	writer.interrupt();
+	writer.join();
+
+	EXPECT_EQ(fut.get(), File_writer::Result::WRITTEN);
+	EXPECT_EQ(read("a"), "a");
+
+	EXPECT_EQ(writer.submit(m_dir + "/b", to_vec("b")).get(), File_writer::Result::REJECTED);
+}
+
+TEST_F(File_writer_test, beats_while_idle)
+{
+	File_writer writer;
+	std::shared_ptr<Heartbeat> hb = std::make_shared<Heartbeat>("writer", std::chrono::seconds(1));
+	writer.set_heartbeat(hb);
+	writer.launch();
+
+	// nothing submitted, the last beat still stays within the idle pop timeout
+	for(int i = 0; i < 4; i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+		std::chrono::nanoseconds now;
+		ASSERT_TRUE(Chronometer::get_time(&now));
+		std::chrono::nanoseconds age;
+		ASSERT_TRUE(hb->get_age(now, &age));
+		EXPECT_LT(age, std::chrono::milliseconds(500));
+	}
+
+	writer.interrupt();
+	writer.join();
+	EXPECT_TRUE(hb->is_paused());
+}
+
+TEST_F(File_writer_test, metrics)
+{
+	Metrics_registry registry;
+
+	File_writer writer;
+	ASSERT_TRUE(writer.bind_metrics(&registry, "state_writer"));
+	EXPECT_FALSE(writer.bind_metrics(&registry, "bad name"));
+	writer.launch();
+
+	EXPECT_EQ(writer.submit(m_dir + "/a", to_vec("a")).get(), File_writer::Result::WRITTEN);
+
+	std::string text;
+	registry.render_prometheus(&text);
+	EXPECT_NE(text.find("state_writer_written_total 1\n"), std::string::npos);
+	EXPECT_NE(text.find("state_writer_pending_bytes 0\n"), std::string::npos);
+	EXPECT_NE(text.find("state_writer_commit_ns_count 1\n"), std::string::npos);
+
+	writer.interrupt();
+	writer.join();
+}
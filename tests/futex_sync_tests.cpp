@@ -0,0 +1,257 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Futex_sync.hpp>
+#include <emb-lin-util/Stopwatch.hpp>
+#include <emb-lin-util/Thread_base.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <thread>
+
+TEST(Futex_event, auto_reset_wakes_one)
+{
+	Futex_event ev(Futex_event::Reset_mode::AUTO);
+	EXPECT_FALSE(ev.try_wait());
+	EXPECT_FALSE(ev.wait(std::chrono::milliseconds(1)));
+
+	ev.set();
+	EXPECT_TRUE(ev.is_set());
+	EXPECT_TRUE(ev.try_wait());
+	EXPECT_FALSE(ev.is_set());
+
+	// one set per waiter, each set releases exactly one of them
+	std::atomic<int> woken(0);
+	std::array<std::thread, 4> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&ev, &woken]()
+		{
+			EXPECT_TRUE(ev.wait(std::chrono::seconds(10)));
+			woken++;
+		});
+	}
+
+	for(size_t i = 0; i < threads.size(); i++)
+	{
+		// wait for the previous set to be consumed so sets do not collapse
+		while(ev.is_set())
+		{
+			std::this_thread::yield();
+		}
+		ev.set();
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	EXPECT_EQ(woken, 4);
+	EXPECT_FALSE(ev.is_set());
+}
+
+TEST(Futex_event, manual_reset_wakes_all)
+{
+	Futex_event ev(Futex_event::Reset_mode::MANUAL);
+
+	std::array<std::thread, 4> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&ev]()
+		{
+			EXPECT_TRUE(ev.wait(std::chrono::seconds(10)));
+		});
+	}
+
+	ev.set();
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	// stays set until reset
+	EXPECT_TRUE(ev.try_wait());
+	EXPECT_TRUE(ev.wait(std::chrono::nanoseconds::zero()));
+	ev.reset();
+	EXPECT_FALSE(ev.try_wait());
+}
+
+TEST(Futex_event, wait_times_out)
+{
+	Futex_event ev;
+
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+	EXPECT_FALSE(ev.wait(std::chrono::milliseconds(20)));
+
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(sw.get_time(&dt));
+	EXPECT_GE(dt, std::chrono::milliseconds(20));
+}
+
+TEST(Futex_semaphore, counts)
+{
+	Futex_semaphore sem(2);
+	EXPECT_EQ(sem.get_count(), 2U);
+	EXPECT_TRUE(sem.try_wait());
+	EXPECT_TRUE(sem.wait(std::chrono::milliseconds(1)));
+	EXPECT_FALSE(sem.try_wait());
+	EXPECT_FALSE(sem.wait(std::chrono::milliseconds(1)));
+
+	sem.post(3);
+	EXPECT_EQ(sem.get_count(), 3U);
+}
+
+TEST(Futex_semaphore, producer_consumer)
+{
+	Futex_semaphore sem;
+
+	constexpr int N_PER_THREAD = 10000;
+	std::atomic<int> taken(0);
+
+	std::array<std::thread, 4> consumers;
+	for(auto& t : consumers)
+	{
+		t = std::thread([&sem, &taken]()
+		{
+			while(sem.wait())
+			{
+				taken++;
+			}
+		});
+	}
+
+	std::array<std::thread, 2> producers;
+	for(auto& t : producers)
+	{
+		t = std::thread([&sem]()
+		{
+			for(int i = 0; i < N_PER_THREAD; i++)
+			{
+				sem.post();
+			}
+		});
+	}
+	for(auto& t : producers)
+	{
+		t.join();
+	}
+
+	// cancel lets consumers drain the remaining count, then they exit
+	sem.notify_cancel();
+	for(auto& t : consumers)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(taken, 2 * N_PER_THREAD);
+	EXPECT_EQ(sem.get_count(), 0U);
+	EXPECT_TRUE(sem.is_cancel_requested());
+	EXPECT_FALSE(sem.wait());
+
+	sem.reset(1);
+	EXPECT_FALSE(sem.is_cancel_requested());
+	EXPECT_TRUE(sem.try_wait());
+}
+
+TEST(Futex_latch, releases_at_zero)
+{
+	Futex_latch latch(3);
+	EXPECT_FALSE(latch.try_wait());
+	EXPECT_FALSE(latch.wait(std::chrono::milliseconds(1)));
+
+	std::array<std::thread, 3> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&latch]()
+		{
+			EXPECT_TRUE(latch.arrive_and_wait(std::chrono::seconds(10)));
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_TRUE(latch.try_wait());
+	EXPECT_TRUE(latch.wait());
+}
+
+TEST(Futex_barrier, phases)
+{
+	constexpr uint32_t N_THREADS = 4;
+	constexpr int      N_PHASES  = 100;
+
+	Futex_barrier barrier(N_THREADS);
+
+	// every thread must see all writes from the previous phase
+	std::array<std::atomic<int>, N_THREADS> progress;
+	for(auto& p : progress)
+	{
+		p = 0;
+	}
+
+	std::array<std::thread, N_THREADS> threads;
+	for(size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i] = std::thread([&, i]()
+		{
+			for(int phase = 0; phase < N_PHASES; phase++)
+			{
+				progress[i].store(phase + 1, std::memory_order_relaxed);
+				EXPECT_TRUE(barrier.arrive_and_wait(std::chrono::seconds(10)));
+
+				for(const auto& p : progress)
+				{
+					EXPECT_GE(p.load(std::memory_order_relaxed), phase + 1);
+				}
+
+				EXPECT_TRUE(barrier.arrive_and_wait(std::chrono::seconds(10)));
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(barrier.get_phase(), uint32_t(2 * N_PHASES));
+}
+
+TEST(Thread_base, wait_for_interruption)
+{
+	class Waiter : public Thread_base
+	{
+	public:
+		void work() override
+		{
+			// short timed waits return false until interrupted
+			while( ! wait_for_interruption(std::chrono::milliseconds(1)) )
+			{
+				m_timeouts++;
+			}
+			wait_for_interruption();
+		}
+
+		std::atomic<int> m_timeouts{0};
+	};
+
+	Waiter waiter;
+	waiter.launch();
+
+	while(waiter.m_timeouts == 0)
+	{
+		std::this_thread::yield();
+	}
+
+	waiter.interrupt();
+	waiter.join();
+
+	EXPECT_TRUE(waiter.is_interrupted());
+	EXPECT_TRUE(waiter.wait_for_interruption(std::chrono::hours::max()));
+}
@@ -8,11 +8,33 @@
 #include <emb-lin-util/Interval_timer.hpp>
 #include <emb-lin-util/Stopwatch.hpp>
 #include <emb-lin-util/Thread_base.hpp>
+#include <emb-lin-util/Virtual_clock.hpp>
 
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <random>
 #include <thread>
 
+// These tests link emb-lin-util-vclock, time only moves on Virtual_clock::advance
+// Waiter threads still run in real time, so wait for them to catch up before canceling
+// Stopwatch runs on virtual time here, so the timeout uses steady_clock
+static bool wait_until(const std::function<bool()>& pred)
+{
+	const std::chrono::steady_clock::time_point t_end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while( ! pred() )
+	{
+		if(std::chrono::steady_clock::now() > t_end)
+		{
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
 TEST(Interval_timer, basic_sync_wait)
 {
 	Interval_timer m_ival;
@@ -27,6 +49,10 @@ TEST(Interval_timer, basic_sync_wait)
 	{
 		EXPECT_FALSE(m_ival.is_cancel_requested());
 
+		Virtual_clock::advance(std::chrono::milliseconds(499));
+		EXPECT_EQ(m_ival.pending_event_count(), 0);
+
+		Virtual_clock::advance(std::chrono::milliseconds(1));
 		bool got_event = m_ival.wait_for_event();
 
 		EXPECT_TRUE(got_event);
@@ -35,17 +61,15 @@ TEST(Interval_timer, basic_sync_wait)
 	std::chrono::nanoseconds dt;
 	ASSERT_TRUE(timer.get_time(&dt));
 
-	std::chrono::microseconds err = std::chrono::floor<std::chrono::microseconds>(std::chrono::abs(dt - std::chrono::milliseconds(2500)));
-	ASSERT_LE(err, std::chrono::microseconds(1000));
+	EXPECT_EQ(dt, std::chrono::milliseconds(2500));
 }
 
 class Interval_timer_waiters : public Thread_base
 {
 public:
-	Interval_timer_waiters(const std::shared_ptr<Interval_timer>& ival, int wait_us = 0) : m_loop_cnt(0), m_event_cnt(0)
+	Interval_timer_waiters(const std::shared_ptr<Interval_timer>& ival) : m_loop_cnt(0), m_event_cnt(0)
 	{
 		m_ival = ival;
-		m_wait_us = wait_us;
 	}
 	~Interval_timer_waiters() override
 	{
@@ -77,11 +101,6 @@ protected:
 			// if we woke spuriously or due to cancelation, don't count event
 			if(got_event)
 			{
-				if(m_wait_us)
-				{
-					std::this_thread::sleep_for(std::chrono::microseconds(m_wait_us));
-				}
-
 				m_event_cnt++;
 			}
 
@@ -95,13 +114,23 @@ protected:
 		}
 	}
 
-	int m_wait_us;
-
 	std::atomic<int> m_loop_cnt;
 	std::atomic<int> m_event_cnt;
 	std::shared_ptr<Interval_timer> m_ival;
 };
 
+template<size_t N>
+static void sum_counts(const std::array<std::shared_ptr<Interval_timer_waiters>, N>& waiters, size_t* const out_event_cnt, size_t* const out_loop_cnt)
+{
+	*out_event_cnt = 0;
+	*out_loop_cnt  = 0;
+	for(auto& val : waiters)
+	{
+		*out_event_cnt += val->get_event_count();
+		*out_loop_cnt  += val->get_loop_count();
+	}
+}
+
 TEST(Interval_timer, single_async_waiter_cancel)
 {
 	std::shared_ptr<Interval_timer> m_ival = std::make_shared<Interval_timer>();
@@ -110,11 +139,15 @@ TEST(Interval_timer, single_async_waiter_cancel)
 	Interval_timer_waiters m_async_waiter(m_ival);
 	m_async_waiter.launch();
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	// not started yet
+	Virtual_clock::advance(std::chrono::milliseconds(1000));
+	EXPECT_EQ(m_ival->pending_event_count(), 0);
 
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(100)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2510));
+	Virtual_clock::advance(std::chrono::milliseconds(2510));
+
+	EXPECT_TRUE(wait_until([&m_async_waiter](){ return m_async_waiter.get_loop_count() >= 25; }));
 
 	m_ival->notify_cancel();
 	m_async_waiter.join();
@@ -131,14 +164,16 @@ TEST(Interval_timer, single_async_waiter_stop)
 	Interval_timer_waiters m_async_waiter(m_ival);
 	m_async_waiter.launch();
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(100)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2510));
+	Virtual_clock::advance(std::chrono::milliseconds(2510));
+
+	EXPECT_TRUE(wait_until([&m_async_waiter](){ return m_async_waiter.get_loop_count() >= 25; }));
 
+	// no more events after stop
 	ASSERT_TRUE(m_ival->stop());
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	Virtual_clock::advance(std::chrono::milliseconds(1000));
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
 	m_ival->notify_cancel();
 	m_async_waiter.join();
@@ -159,11 +194,13 @@ TEST(Interval_timer, multiple_async_waiters)
 		val->launch();
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(100)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2510));
+	Virtual_clock::advance(std::chrono::milliseconds(2510));
+
+	size_t total_event_cnt = 0;
+	size_t total_loop_cnt = 0;
+	EXPECT_TRUE(wait_until([&](){ sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt); return (total_event_cnt >= 25U) && (total_loop_cnt >= 25U); }));
 
 	// send async cancel, we expect 25 events to be handled across all of the waiters
 	m_ival->notify_cancel();
@@ -173,13 +210,7 @@ TEST(Interval_timer, multiple_async_waiters)
 		val->join();
 	}
 
-	size_t total_event_cnt = 0;
-	size_t total_loop_cnt = 0;
-	for(auto& val : m_async_waiters)
-	{
-		total_event_cnt += val->get_event_count();
-		total_loop_cnt  += val->get_loop_count();
-	}
+	sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt);
 	EXPECT_EQ(total_event_cnt, 25U);
 
 	EXPECT_LE(total_loop_cnt, 25U * m_async_waiters.size());
@@ -198,13 +229,14 @@ TEST(Interval_timer, multiple_async_waiters_fast)
 		val->launch();
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(1)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
+	Virtual_clock::advance(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
+
+	size_t total_event_cnt = 0;
+	size_t total_loop_cnt = 0;
+	EXPECT_TRUE(wait_until([&](){ sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt); return (total_event_cnt >= 2500U) && (total_loop_cnt >= 2500U); }));
 
-	// send async cancel, we expect 25 events to be handled across all of the waiters
 	m_ival->notify_cancel();
 
 	for(auto& val : m_async_waiters)
@@ -212,41 +244,39 @@ TEST(Interval_timer, multiple_async_waiters_fast)
 		val->join();
 	}
 
-	size_t total_event_cnt = 0;
-	size_t total_loop_cnt = 0;
-	for(auto& val : m_async_waiters)
-	{
-		total_event_cnt += val->get_event_count();
-		total_loop_cnt  += val->get_loop_count();
-	}
+	sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt);
 	EXPECT_EQ(total_event_cnt, 2500U);
 
 	EXPECT_LE(total_loop_cnt, 2500U * m_async_waiters.size());
 	EXPECT_GE(total_loop_cnt, 2500U);
 }
 
-
 TEST(Interval_timer, multiple_async_waiters_fast_backlog)
 {
 	std::shared_ptr<Interval_timer> m_ival = std::make_shared<Interval_timer>();
 	ASSERT_TRUE(m_ival->init());
 
+	// build a backlog with nobody waiting
+	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(1)));
+
+	Virtual_clock::advance(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
+
+	ASSERT_TRUE(m_ival->stop());
+
+	EXPECT_EQ(m_ival->pending_event_count(), 2500);
+
+	// then drain it
 	std::array<std::shared_ptr<Interval_timer_waiters>, 8> m_async_waiters;
 	for(auto& val : m_async_waiters)
 	{
-		val = std::make_shared<Interval_timer_waiters>(m_ival, 50000);
+		val = std::make_shared<Interval_timer_waiters>(m_ival);
 		val->launch();
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(1)));
-
-	std::this_thread::sleep_for(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
-
-	ASSERT_TRUE(m_ival->stop());
+	size_t total_event_cnt = 0;
+	size_t total_loop_cnt = 0;
+	EXPECT_TRUE(wait_until([&](){ sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt); return (total_event_cnt >= 2500U) && (total_loop_cnt >= 2500U); }));
 
-	// send async cancel, we expect 25 events to be handled across all of the waiters
 	m_ival->notify_cancel();
 
 	for(auto& val : m_async_waiters)
@@ -254,19 +284,36 @@ TEST(Interval_timer, multiple_async_waiters_fast_backlog)
 		val->join();
 	}
 
-	int total_event_cnt = 0;
-	int total_loop_cnt = 0;
-	for(auto& val : m_async_waiters)
+	sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt);
+	EXPECT_EQ(total_event_cnt, 2500U);
+	EXPECT_EQ(m_ival->pending_event_count(), 0);
+}
+
+TEST(Interval_timer, many_periods)
+{
+	Interval_timer m_ival;
+	ASSERT_TRUE(m_ival.init());
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int64_t> period_dist(1, 1000000);
+	std::uniform_int_distribution<int64_t> step_dist(0, 10000000);
+
+	for(int i = 0; i < 2000; i++)
 	{
-		total_event_cnt      += val->get_event_count();
-		total_loop_cnt       += val->get_loop_count();
+		const std::chrono::nanoseconds period(period_dist(rng));
+		ASSERT_TRUE(m_ival.start(period));
+
+		// advance in a few uneven steps, expirations must not depend on how time was sliced
+		std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+		for(int j = 0; j < 4; j++)
+		{
+			const std::chrono::nanoseconds step(step_dist(rng));
+			Virtual_clock::advance(step);
+			total += step;
+		}
+
+		ASSERT_TRUE(m_ival.stop());
+
+		ASSERT_EQ(m_ival.pending_event_count(), int(total / period)) << "period " << period.count() << " total " << total.count();
 	}
-	EXPECT_GE(total_loop_cnt, 49 * (int)m_async_waiters.size()); // per thread 2500 / 50 - 1
-	EXPECT_LE(total_loop_cnt, 50 * (int)m_async_waiters.size()); // per thread 2500 / 50
-	
-	EXPECT_GE(total_event_cnt, 49 * (int)m_async_waiters.size());
-	EXPECT_LE(total_event_cnt, 50 * (int)m_async_waiters.size());
-	
-	EXPECT_GE(m_ival->pending_event_count(), 2500 - total_event_cnt-(int)m_async_waiters.size());
-	EXPECT_LE(m_ival->pending_event_count(), 2500 - total_event_cnt);
 }
@@ -8,11 +8,33 @@
 #include <emb-lin-util/Interval_timer_fd.hpp>
 #include <emb-lin-util/Stopwatch.hpp>
 #include <emb-lin-util/Thread_base.hpp>
+#include <emb-lin-util/Virtual_clock.hpp>
 
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <random>
 #include <thread>
 
+// These tests link emb-lin-util-vclock, time only moves on Virtual_clock::advance
+// Waiter threads still run in real time, so wait for them to catch up before canceling
+// Stopwatch runs on virtual time here, so the timeout uses steady_clock
+static bool wait_until(const std::function<bool()>& pred)
+{
+	const std::chrono::steady_clock::time_point t_end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while( ! pred() )
+	{
+		if(std::chrono::steady_clock::now() > t_end)
+		{
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
 TEST(Interval_timer_fd, basic_sync_wait)
 {
 	Interval_timer_fd m_ival;
@@ -27,6 +49,8 @@ TEST(Interval_timer_fd, basic_sync_wait)
 	{
 		EXPECT_FALSE(m_ival.is_cancel_requested());
 
+		Virtual_clock::advance(std::chrono::milliseconds(500));
+
 		bool got_event = false;
 		bool got_no_error = m_ival.wait_for_event(&got_event);
 
@@ -37,17 +61,15 @@ TEST(Interval_timer_fd, basic_sync_wait)
 	std::chrono::nanoseconds dt;
 	ASSERT_TRUE(timer.get_time(&dt));
 
-	std::chrono::microseconds err = std::chrono::floor<std::chrono::microseconds>(std::chrono::abs(dt - std::chrono::milliseconds(2500)));
-	ASSERT_LE(err, std::chrono::microseconds(1000));
+	EXPECT_EQ(dt, std::chrono::milliseconds(2500));
 }
 
 class Interval_timer_fd_waiters : public Thread_base
 {
 public:
-	Interval_timer_fd_waiters(const std::shared_ptr<Interval_timer_fd>& ival, int wait_us = 0) : m_loop_cnt(0), m_event_cnt(0)
+	Interval_timer_fd_waiters(const std::shared_ptr<Interval_timer_fd>& ival) : m_loop_cnt(0), m_event_cnt(0)
 	{
 		m_ival = ival;
-		m_wait_us = wait_us;
 	}
 	~Interval_timer_fd_waiters() override
 	{
@@ -82,10 +104,6 @@ protected:
 			// if we woke spuriously or due to cancelation, don't count event
 			if(got_event)
 			{
-				if(m_wait_us)
-				{
-					std::this_thread::sleep_for(std::chrono::microseconds(m_wait_us));
-				}
 				m_event_cnt++;
 			}
 
@@ -99,13 +117,23 @@ protected:
 		}
 	}
 
-	int m_wait_us;
-
 	std::atomic<int> m_loop_cnt;
 	std::atomic<int> m_event_cnt;
 	std::shared_ptr<Interval_timer_fd> m_ival;
 };
 
+template<size_t N>
+static void sum_counts(const std::array<std::shared_ptr<Interval_timer_fd_waiters>, N>& waiters, size_t* const out_event_cnt, size_t* const out_loop_cnt)
+{
+	*out_event_cnt = 0;
+	*out_loop_cnt  = 0;
+	for(auto& val : waiters)
+	{
+		*out_event_cnt += val->get_event_count();
+		*out_loop_cnt  += val->get_loop_count();
+	}
+}
+
 TEST(Interval_timer_fd, single_async_waiter_cancel)
 {
 	std::shared_ptr<Interval_timer_fd> m_ival = std::make_shared<Interval_timer_fd>();
@@ -114,11 +142,15 @@ TEST(Interval_timer_fd, single_async_waiter_cancel)
 	Interval_timer_fd_waiters m_async_waiter(m_ival);
 	m_async_waiter.launch();
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	// not started yet
+	Virtual_clock::advance(std::chrono::milliseconds(1000));
+	EXPECT_EQ(m_ival->pending_event_count(), 0);
 
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(100)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2510));
+	Virtual_clock::advance(std::chrono::milliseconds(2510));
+
+	EXPECT_TRUE(wait_until([&m_async_waiter](){ return m_async_waiter.get_loop_count() >= 25; }));
 
 	ASSERT_TRUE(m_ival->notify_cancel());
 	m_async_waiter.join();
@@ -135,14 +167,16 @@ TEST(Interval_timer_fd, single_async_waiter_stop)
 	Interval_timer_fd_waiters m_async_waiter(m_ival);
 	m_async_waiter.launch();
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(100)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2510));
+	Virtual_clock::advance(std::chrono::milliseconds(2510));
 
+	EXPECT_TRUE(wait_until([&m_async_waiter](){ return m_async_waiter.get_loop_count() >= 25; }));
+
+	// no more events after stop
 	ASSERT_TRUE(m_ival->stop());
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	Virtual_clock::advance(std::chrono::milliseconds(1000));
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
 	ASSERT_TRUE(m_ival->notify_cancel());
 	m_async_waiter.join();
@@ -163,11 +197,13 @@ TEST(Interval_timer_fd, multiple_async_waiters)
 		val->launch();
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(100)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2510));
+	Virtual_clock::advance(std::chrono::milliseconds(2510));
+
+	size_t total_event_cnt = 0;
+	size_t total_loop_cnt = 0;
+	EXPECT_TRUE(wait_until([&](){ sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt); return (total_event_cnt >= 25U) && (total_loop_cnt >= 25U); }));
 
 	// send async cancel, we expect 25 events to be handled across all of the waiters
 	ASSERT_TRUE(m_ival->notify_cancel());
@@ -177,13 +213,7 @@ TEST(Interval_timer_fd, multiple_async_waiters)
 		val->join();
 	}
 
-	size_t total_event_cnt = 0;
-	size_t total_loop_cnt = 0;
-	for(auto& val : m_async_waiters)
-	{
-		total_event_cnt += val->get_event_count();
-		total_loop_cnt  += val->get_loop_count();
-	}
+	sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt);
 	EXPECT_EQ(total_event_cnt, 25U);
 
 	EXPECT_LE(total_loop_cnt, 25U * m_async_waiters.size());
@@ -202,13 +232,14 @@ TEST(Interval_timer_fd, multiple_async_waiters_fast)
 		val->launch();
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
 	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(1)));
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
+	Virtual_clock::advance(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
+
+	size_t total_event_cnt = 0;
+	size_t total_loop_cnt = 0;
+	EXPECT_TRUE(wait_until([&](){ sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt); return (total_event_cnt >= 2500U) && (total_loop_cnt >= 2500U); }));
 
-	// send async cancel, we expect 25 events to be handled across all of the waiters
 	ASSERT_TRUE(m_ival->notify_cancel());
 
 	for(auto& val : m_async_waiters)
@@ -216,13 +247,7 @@ TEST(Interval_timer_fd, multiple_async_waiters_fast)
 		val->join();
 	}
 
-	size_t total_event_cnt = 0;
-	size_t total_loop_cnt = 0;
-	for(auto& val : m_async_waiters)
-	{
-		total_event_cnt += val->get_event_count();
-		total_loop_cnt  += val->get_loop_count();
-	}
+	sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt);
 	EXPECT_EQ(total_event_cnt, 2500U);
 
 	EXPECT_LE(total_loop_cnt, 2500U * m_async_waiters.size());
@@ -234,20 +259,30 @@ TEST(Interval_timer_fd, multiple_async_waiters_fast_backlog)
 	std::shared_ptr<Interval_timer_fd> m_ival = std::make_shared<Interval_timer_fd>();
 	ASSERT_TRUE(m_ival->init());
 
+	// build a backlog with nobody waiting
+	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(1)));
+
+	Virtual_clock::advance(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
+
+	// the first wait pulls the whole backlog from the fd and takes one event
+	bool got_event = false;
+	ASSERT_TRUE(m_ival->wait_for_event(&got_event));
+	EXPECT_TRUE(got_event);
+	EXPECT_EQ(m_ival->pending_event_count(), 2499);
+
+	ASSERT_TRUE(m_ival->stop());
+
+	// then drain it
 	std::array<std::shared_ptr<Interval_timer_fd_waiters>, 8> m_async_waiters;
 	for(auto& val : m_async_waiters)
 	{
-		val = std::make_shared<Interval_timer_fd_waiters>(m_ival, 50000);
+		val = std::make_shared<Interval_timer_fd_waiters>(m_ival);
 		val->launch();
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-	ASSERT_TRUE(m_ival->start(std::chrono::milliseconds(1)));
-
-	std::this_thread::sleep_for(std::chrono::milliseconds(2500) + std::chrono::microseconds(300));
-
-	ASSERT_TRUE(m_ival->stop());
+	size_t total_event_cnt = 0;
+	size_t total_loop_cnt = 0;
+	EXPECT_TRUE(wait_until([&](){ sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt); return (total_event_cnt >= 2499U) && (total_loop_cnt >= 2499U); }));
 
 	ASSERT_TRUE(m_ival->notify_cancel());
 
@@ -256,19 +291,44 @@ TEST(Interval_timer_fd, multiple_async_waiters_fast_backlog)
 		val->join();
 	}
 
-	int total_event_cnt = 0;
-	int total_loop_cnt = 0;
-	for(auto& val : m_async_waiters)
+	sum_counts(m_async_waiters, &total_event_cnt, &total_loop_cnt);
+	EXPECT_EQ(total_event_cnt, 2499U);
+	EXPECT_EQ(m_ival->pending_event_count(), 0);
+}
+
+TEST(Interval_timer_fd, many_periods)
+{
+	Interval_timer_fd m_ival;
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int64_t> period_dist(1, 1000000);
+	std::uniform_int_distribution<int64_t> step_dist(0, 10000000);
+
+	for(int i = 0; i < 2000; i++)
 	{
-		total_event_cnt += val->get_event_count();
-		total_loop_cnt  += val->get_loop_count();
-	}
-	EXPECT_GE(total_loop_cnt, 49 * (int)m_async_waiters.size()); // per thread 2500 / 50 - 1
-	EXPECT_LE(total_loop_cnt, 50 * (int)m_async_waiters.size()); // per thread 2500 / 50
+		const std::chrono::nanoseconds period(period_dist(rng));
+		ASSERT_TRUE(m_ival.init());
+		ASSERT_TRUE(m_ival.start(period));
 
-	EXPECT_GE(total_event_cnt, 49 * (int)m_async_waiters.size());
-	EXPECT_LE(total_event_cnt, 50 * (int)m_async_waiters.size());
+		// advance in a few uneven steps, expirations must not depend on how time was sliced
+		std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+		for(int j = 0; j < 4; j++)
+		{
+			const std::chrono::nanoseconds step(step_dist(rng));
+			Virtual_clock::advance(step);
+			total += step;
+		}
+
+		const int expected = int(total / period);
+		if(expected > 0)
+		{
+			bool got_event = false;
+			ASSERT_TRUE(m_ival.wait_for_event(&got_event));
+			ASSERT_TRUE(got_event);
+		}
+
+		ASSERT_EQ(m_ival.pending_event_count(), std::max(expected - 1, 0)) << "period " << period.count() << " total " << total.count();
 
-	// EXPECT_GE(m_ival->pending_event_count(), 0); // this is not very accurate, since the app's version is only synced with the the kernel if it expires
-	EXPECT_LE(m_ival->pending_event_count(), 2500 - total_event_cnt);
-}
\ No newline at end of file
+		m_ival.reset();
+	}
+}
@@ -0,0 +1,224 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Chronometer.hpp>
+#include <emb-lin-util/Lap_stats.hpp>
+#include <emb-lin-util/Stopwatch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+TEST(Log_linear_histogram, bucket_bounds)
+{
+	typedef Log_linear_histogram<4> Hist;
+
+	for(uint64_t v = 0; v < 100000; v++)
+	{
+		const size_t idx = Hist::bucket_index(v);
+		ASSERT_LT(idx, Hist::NUM_BUCKETS);
+		ASSERT_LE(Hist::bucket_lower(idx), v);
+		ASSERT_GE(Hist::bucket_upper(idx), v);
+	}
+
+	EXPECT_EQ(Hist::bucket_index(UINT64_MAX), Hist::NUM_BUCKETS - 1);
+	EXPECT_EQ(Hist::bucket_upper(Hist::NUM_BUCKETS - 1), UINT64_MAX);
+
+	// relative error is bounded by the sub bucket count
+	for(size_t idx = Hist::NUM_SUB; idx < Hist::NUM_BUCKETS; idx++)
+	{
+		const double lo = double(Hist::bucket_lower(idx));
+		const double hi = double(Hist::bucket_upper(idx));
+		ASSERT_LE((hi - lo) / lo, 1.0 / double(Hist::NUM_SUB));
+	}
+}
+
+TEST(Lap_stats, moments)
+{
+	Lap_stats stats;
+	for(int i = 1; i <= 1000; i++)
+	{
+		stats.record(std::chrono::microseconds(i));
+	}
+
+	Lap_stats::Snapshot snap;
+	ASSERT_TRUE(stats.get_snapshot(&snap));
+
+	EXPECT_EQ(snap.count, 1000U);
+	EXPECT_EQ(snap.min, std::chrono::microseconds(1));
+	EXPECT_EQ(snap.max, std::chrono::microseconds(1000));
+	EXPECT_EQ(snap.mean, std::chrono::nanoseconds(500500));
+
+	// variance of 1..N is N(N+1)/12 in units^2
+	const double var_us2 = (1000.0 * 1001.0) / 12.0;
+	EXPECT_NEAR(snap.variance, var_us2 * 1.0e6, var_us2 * 1.0e6 * 1.0e-9);
+
+	EXPECT_NEAR(double(snap.p50.count()), 500000.0, 500000.0 / 16.0);
+	EXPECT_NEAR(double(snap.p99.count()), 990000.0, 990000.0 / 16.0);
+}
+
+TEST(Stopwatch, concurrent_laps)
+{
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+
+	Lap_stats stats;
+
+	std::array<std::thread, 4> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&sw, &stats]()
+		{
+			for(int i = 0; i < 10000; i++)
+			{
+				sw.lap(&stats, nullptr);
+			}
+		});
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	std::chrono::nanoseconds split;
+	ASSERT_TRUE(sw.split(nullptr, &split));
+
+	Lap_stats::Snapshot snap;
+	ASSERT_TRUE(stats.get_snapshot(&snap));
+
+	EXPECT_EQ(snap.count, 40000U);
+	EXPECT_GE(snap.min, std::chrono::nanoseconds::zero());
+
+	EXPECT_LE(snap.max, split);
+}
+
+TEST(Stopwatch, concurrent_laps_tile_elapsed_time)
+{
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+
+	std::atomic<int64_t> sum_ns(0);
+	std::atomic<bool> is_negative(false);
+
+	auto do_lap = [&sw, &sum_ns, &is_negative]()
+	{
+		std::chrono::nanoseconds dt;
+		if(sw.lap(nullptr, &dt))
+		{
+			if(dt < std::chrono::nanoseconds::zero())
+			{
+				is_negative.store(true);
+			}
+			sum_ns.fetch_add(dt.count());
+		}
+	};
+
+	std::array<std::thread, 4> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&do_lap]()
+		{
+			for(int i = 0; i < 10000; i++)
+			{
+				do_lap();
+			}
+		});
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	// laps are contiguous from start, so with one last lap they sum to the elapsed time at that lap
+	std::chrono::nanoseconds before;
+	ASSERT_TRUE(sw.split(nullptr, &before));
+	do_lap();
+	std::chrono::nanoseconds after;
+	ASSERT_TRUE(sw.split(nullptr, &after));
+
+	EXPECT_FALSE(is_negative.load());
+	EXPECT_GE(sum_ns.load(), before.count());
+	EXPECT_LE(sum_ns.load(), after.count());
+}
+
+TEST(Stopwatch, laps_racing_start_are_never_negative)
+{
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+
+	// start publishes a newer lap mark than a lapper may have just read, the lapper must read the clock again
+	std::atomic<bool> done(false);
+	std::thread starter([&sw, &done]()
+	{
+		while( ! done )
+		{
+			sw.start();
+		}
+	});
+
+	std::atomic<bool> is_negative(false);
+	std::array<std::thread, 3> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&sw, &is_negative]()
+		{
+			for(int i = 0; i < 20000; i++)
+			{
+				std::chrono::nanoseconds dt;
+				if(sw.lap(nullptr, &dt) && (dt < std::chrono::nanoseconds::zero()))
+				{
+					is_negative.store(true);
+				}
+			}
+		});
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	done = true;
+	starter.join();
+
+	EXPECT_FALSE(is_negative.load());
+}
+
+namespace
+{
+	// lets a test publish a lap mark the clock has not reached yet, as a racing start() on a faster read would
+	class Stopwatch_mark : public Stopwatch
+	{
+	public:
+		void set_lap_mark(const std::chrono::nanoseconds& t)
+		{
+			m_t_lap = t;
+		}
+	};
+}
+
+TEST(Stopwatch, lap_behind_the_mark_reads_again)
+{
+	Stopwatch_mark sw;
+	ASSERT_TRUE(sw.start());
+
+	std::chrono::nanoseconds now;
+	ASSERT_TRUE(Chronometer::get_time(&now));
+	sw.set_lap_mark(now + std::chrono::milliseconds(5));
+
+	// the lap waits for the clock to pass the mark instead of moving it back
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(sw.lap(nullptr, &dt));
+	EXPECT_GE(dt, std::chrono::nanoseconds::zero());
+
+	std::chrono::nanoseconds after;
+	ASSERT_TRUE(Chronometer::get_time(&after));
+	EXPECT_GE(after, now + std::chrono::milliseconds(5));
+}
@@ -0,0 +1,168 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/Metrics.hpp>
+#include <emb-lin-util/Metrics_exporter.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstring>
+#include <thread>
+
+TEST(Metrics, striped_counter_sums_threads)
+{
+	Metrics_registry reg;
+	std::shared_ptr<Metric_counter> ctr = reg.get_counter("events_total", "Events");
+	ASSERT_TRUE(ctr);
+
+	std::array<std::thread, 16> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&ctr]()
+		{
+			for(int i = 0; i < 10000; i++)
+			{
+				ctr->add();
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(ctr->get(), 160000U);
+
+	// same name and labels is the same counter
+	EXPECT_EQ(reg.get_counter("events_total", "Events"), ctr);
+}
+
+TEST(Metrics, registration_errors)
+{
+	Metrics_registry reg;
+	ASSERT_TRUE(reg.get_counter("a_total", ""));
+
+	EXPECT_FALSE(reg.get_gauge("a_total", ""));
+	EXPECT_FALSE(reg.get_counter("0bad", ""));
+	EXPECT_FALSE(reg.get_counter("bad-name", ""));
+	EXPECT_FALSE(reg.get_counter("b_total", "", {{"__reserved", "x"}}));
+	EXPECT_FALSE(reg.get_counter("b_total", "", {{"a:b", "x"}}));
+}
+
+TEST(Metrics, render_prometheus)
+{
+	Metrics_registry reg;
+
+	reg.get_counter("rx_total", "Received\nframes", {{"if", "can0"}})->add(3);
+	reg.get_counter("rx_total", "Received\nframes", {{"if", "a\"b\\c"}})->add(1);
+	reg.get_gauge("temp_c", "")->set(21.5);
+
+	std::shared_ptr<Metric_histogram> hist = reg.get_histogram("latency_ns", "Latency");
+	for(uint64_t i = 1; i <= 4; i++)
+	{
+		hist->record(i);
+	}
+
+	std::shared_ptr<Metric_histogram> empty = reg.get_histogram("idle_ns", "", {{"q", "x"}});
+
+	std::string text;
+	reg.render_prometheus(&text);
+
+	EXPECT_EQ(text,
+		"# TYPE idle_ns summary\n"
+		"idle_ns{q=\"x\",quantile=\"0.5\"} NaN\n"
+		"idle_ns{q=\"x\",quantile=\"0.9\"} NaN\n"
+		"idle_ns{q=\"x\",quantile=\"0.99\"} NaN\n"
+		"idle_ns{q=\"x\",quantile=\"0.999\"} NaN\n"
+		"idle_ns{q=\"x\",quantile=\"1\"} NaN\n"
+		"idle_ns_sum{q=\"x\"} 0\n"
+		"idle_ns_count{q=\"x\"} 0\n"
+		"# HELP latency_ns Latency\n"
+		"# TYPE latency_ns summary\n"
+		"latency_ns{quantile=\"0.5\"} 2\n"
+		"latency_ns{quantile=\"0.9\"} 4\n"
+		"latency_ns{quantile=\"0.99\"} 4\n"
+		"latency_ns{quantile=\"0.999\"} 4\n"
+		"latency_ns{quantile=\"1\"} 4\n"
+		"latency_ns_sum 10\n"
+		"latency_ns_count 4\n"
+		"# HELP rx_total Received\\nframes\n"
+		"# TYPE rx_total counter\n"
+		"rx_total{if=\"a\\\"b\\\\c\"} 1\n"
+		"rx_total{if=\"can0\"} 3\n"
+		"# TYPE temp_c gauge\n"
+		"temp_c 21.5\n"
+	);
+
+	reg.remove("rx_total", {{"if", "can0"}});
+	reg.remove("rx_total", {{"if", "a\"b\\c"}});
+	reg.remove("idle_ns", {{"q", "x"}});
+	reg.remove("latency_ns");
+
+	text.clear();
+	reg.render_prometheus(&text);
+	EXPECT_EQ(text, "# TYPE temp_c gauge\ntemp_c 21.5\n");
+}
+
+TEST(Metrics_exporter, file_and_socket)
+{
+	std::shared_ptr<Metrics_registry> reg = std::make_shared<Metrics_registry>();
+	reg->get_counter("x_total", "")->add(7);
+
+	Temp_dir tmp;
+	ASSERT_TRUE(tmp.create("emb-lin-util-metrics"));
+	const std::string file_path   = tmp.get_path("metrics.prom");
+	const std::string socket_path = tmp.get_path("metrics.sock");
+
+	const int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ASSERT_GE(listen_fd, 0);
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+	ASSERT_EQ(bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)), 0);
+	ASSERT_EQ(listen(listen_fd, 1), 0);
+
+	Metrics_exporter exporter;
+	ASSERT_TRUE(exporter.init(reg, std::chrono::seconds(1)));
+	exporter.set_file_path(file_path);
+	exporter.set_socket_path(socket_path);
+
+	// the snapshot fits in the socket buffer, so export completes before accept
+	ASSERT_TRUE(exporter.export_now());
+
+	const std::string expected = "# TYPE x_total counter\nx_total 7\n";
+
+	std::vector<uint8_t> file_data;
+	ASSERT_TRUE(File_util::readSmallFile(file_path, &file_data));
+	EXPECT_EQ(std::string(file_data.begin(), file_data.end()), expected);
+	EXPECT_NE(access((file_path + ".tmp").c_str(), F_OK), 0);
+
+	const int conn_fd = accept(listen_fd, nullptr, nullptr);
+	ASSERT_GE(conn_fd, 0);
+
+	std::string sock_data;
+	std::array<char, 256> buf;
+	ssize_t n = 0;
+	while((n = read(conn_fd, buf.data(), buf.size())) > 0)
+	{
+		sock_data.append(buf.data(), size_t(n));
+	}
+	EXPECT_EQ(sock_data, expected);
+
+	close(conn_fd);
+	close(listen_fd);
+}
@@ -0,0 +1,310 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Mpmc_queue.hpp>
+#include <emb-lin-util/Stopwatch.hpp>
+#include <emb-lin-util/Thread_base.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+TEST(Mpmc_queue, fifo_and_full)
+{
+	Mpmc_queue<int> queue(3);
+	ASSERT_EQ(queue.capacity(), 4U);
+
+	for(int lap = 0; lap < 10; lap++)
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			EXPECT_TRUE(queue.try_push(lap * 4 + i));
+		}
+		EXPECT_FALSE(queue.try_push(-1));
+		EXPECT_EQ(queue.size(), 4U);
+
+		int val = 0;
+		for(int i = 0; i < 4; i++)
+		{
+			ASSERT_TRUE(queue.try_pop(&val));
+			EXPECT_EQ(val, lap * 4 + i);
+		}
+		EXPECT_FALSE(queue.try_pop(&val));
+	}
+}
+
+TEST(Mpmc_queue, drop_newest)
+{
+	Mpmc_queue<int> queue(4, Mpmc_queue<int>::Overflow_policy::DROP_NEWEST);
+
+	for(int i = 0; i < 10; i++)
+	{
+		EXPECT_EQ(queue.push(i), i < 4);
+	}
+	EXPECT_EQ(queue.get_dropped_count(), 6U);
+
+	int val = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		ASSERT_TRUE(queue.try_pop(&val));
+		EXPECT_EQ(val, i);
+	}
+}
+
+TEST(Mpmc_queue, drop_oldest)
+{
+	Mpmc_queue<int> queue(4, Mpmc_queue<int>::Overflow_policy::DROP_OLDEST);
+
+	for(int i = 0; i < 10; i++)
+	{
+		EXPECT_TRUE(queue.push(i));
+	}
+	EXPECT_EQ(queue.get_dropped_count(), 6U);
+
+	int val = 0;
+	for(int i = 6; i < 10; i++)
+	{
+		ASSERT_TRUE(queue.try_pop(&val));
+		EXPECT_EQ(val, i);
+	}
+}
+
+TEST(Mpmc_queue, timeout)
+{
+	Mpmc_queue<int> queue(2);
+
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+
+	int val = 0;
+	EXPECT_FALSE(queue.pop(&val, std::chrono::milliseconds(20)));
+
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(sw.get_time(&dt));
+	EXPECT_GE(dt, std::chrono::milliseconds(20));
+
+	EXPECT_TRUE(queue.push(1));
+	EXPECT_TRUE(queue.push(2));
+	EXPECT_FALSE(queue.push(3, std::chrono::milliseconds(1)));
+}
+
+// Assignment from a value holding a closed gate blocks until the gate opens
+// This holds a producer between claiming a cell and publishing it, or a consumer between claiming and releasing it
+struct Gated_val
+{
+	Gated_val() : val(0), gate(nullptr)
+	{
+
+	}
+	Gated_val(const int v, std::atomic<bool>* const g) : val(v), gate(g)
+	{
+
+	}
+	Gated_val(const Gated_val&) = default;
+
+	Gated_val& operator=(const Gated_val& rhs)
+	{
+		val  = rhs.val;
+		gate = rhs.gate;
+		while(gate && ! gate->load())
+		{
+			std::this_thread::yield();
+		}
+		return *this;
+	}
+
+	int val;
+	std::atomic<bool>* gate;
+};
+
+TEST(Mpmc_queue, pop_waits_on_unpublished_push)
+{
+	Mpmc_queue<Gated_val> queue(2);
+
+	std::atomic<bool> gate(false);
+	const Gated_val held(1, &gate);
+	std::thread producer([&queue, &held](){ EXPECT_TRUE(queue.push(held)); });
+
+	// producer has claimed the cell but not published it
+	while(queue.get_enqueue_count() == 0)
+	{
+		std::this_thread::yield();
+	}
+	EXPECT_FALSE(queue.empty());
+
+	// must time out and observe cancel, not spin on size()
+	Gated_val val;
+	EXPECT_FALSE(queue.pop(&val, std::chrono::milliseconds(20)));
+
+	queue.notify_cancel();
+	EXPECT_FALSE(queue.pop(&val));
+
+	gate = true;
+	producer.join();
+
+	ASSERT_TRUE(queue.try_pop(&val));
+	EXPECT_EQ(val.val, 1);
+}
+
+TEST(Mpmc_queue, push_waits_on_unfinished_pop)
+{
+	Mpmc_queue<Gated_val> queue(2);
+
+	std::atomic<bool> gate(true);
+	EXPECT_TRUE(queue.try_push(Gated_val(1, &gate)));
+	EXPECT_TRUE(queue.try_push(Gated_val(2, &gate)));
+	gate = false;
+
+	std::thread consumer([&queue](){ Gated_val val; EXPECT_TRUE(queue.try_pop(&val)); EXPECT_EQ(val.val, 1); });
+
+	// consumer has claimed the head but not released its cell
+	while(queue.size() == 2U)
+	{
+		std::this_thread::yield();
+	}
+
+	// must time out and observe cancel, not spin on size()
+	EXPECT_FALSE(queue.push(Gated_val(3, nullptr), std::chrono::milliseconds(20)));
+
+	queue.notify_cancel();
+	EXPECT_FALSE(queue.push(Gated_val(3, nullptr)));
+
+	gate = true;
+	consumer.join();
+
+	EXPECT_TRUE(queue.try_push(Gated_val(3, nullptr)));
+}
+
+TEST(Mpmc_queue, many_producers_many_consumers)
+{
+	constexpr int N_PROD    = 4;
+	constexpr int N_CONS    = 4;
+	constexpr int N_PER     = 100000;
+
+	// small queue so both sides block
+	Mpmc_queue<uint32_t> queue(8);
+
+	std::array<std::atomic<uint32_t>, N_PROD * N_PER> seen;
+	for(auto& val : seen)
+	{
+		val = 0;
+	}
+
+	std::vector<std::thread> threads;
+	for(int p = 0; p < N_PROD; p++)
+	{
+		threads.emplace_back([&queue, p]()
+		{
+			for(int i = 0; i < N_PER; i++)
+			{
+				ASSERT_TRUE(queue.push(uint32_t(p * N_PER + i)));
+			}
+		});
+	}
+
+	std::atomic<int> total(0);
+	for(int c = 0; c < N_CONS; c++)
+	{
+		threads.emplace_back([&queue, &seen, &total]()
+		{
+			uint32_t val = 0;
+			while(queue.pop(&val))
+			{
+				seen[val]++;
+				total++;
+			}
+		});
+	}
+
+	for(int p = 0; p < N_PROD; p++)
+	{
+		threads[p].join();
+	}
+
+	while(total < N_PROD * N_PER)
+	{
+		std::this_thread::yield();
+	}
+
+	queue.notify_cancel();
+	for(int c = 0; c < N_CONS; c++)
+	{
+		threads[N_PROD + c].join();
+	}
+
+	// each element exactly once
+	for(auto& val : seen)
+	{
+		ASSERT_EQ(val.load(), 1U);
+	}
+}
+
+class Mpmc_queue_consumer : public Thread_base
+{
+public:
+	Mpmc_queue_consumer(Mpmc_queue<int>* const queue) : m_queue(queue), m_count(0)
+	{
+
+	}
+
+	void interrupt() override
+	{
+		Thread_base::interrupt();
+		m_queue->notify_cancel();
+	}
+
+	int get_count() const
+	{
+		return m_count;
+	}
+
+protected:
+	void work() override
+	{
+		int val = 0;
+		while(m_queue->pop(&val))
+		{
+			m_count++;
+		}
+	}
+
+	Mpmc_queue<int>* m_queue;
+	std::atomic<int> m_count;
+};
+
+TEST(Mpmc_queue, interrupt_wakes_consumers)
+{
+	Mpmc_queue<int> queue(16);
+
+	std::array<std::shared_ptr<Mpmc_queue_consumer>, 3> consumers;
+	for(auto& val : consumers)
+	{
+		val = std::make_shared<Mpmc_queue_consumer>(&queue);
+		val->launch();
+	}
+
+	for(int i = 0; i < 10; i++)
+	{
+		ASSERT_TRUE(queue.push(i));
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	// any one interrupt cancels the shared queue for all of them
+	consumers[0]->interrupt();
+
+	int total = 0;
+	for(auto& val : consumers)
+	{
+		val->join();
+		total += val->get_count();
+	}
+
+	EXPECT_EQ(total, 10);
+}
@@ -0,0 +1,152 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/Profile_flusher.hpp>
+#include <emb-lin-util/Profiler.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <thread>
+
+static void profiled_work(const int depth)
+{
+	EMB_PROFILE_ZONE("profiled_work");
+
+	if(depth > 0)
+	{
+		profiled_work(depth - 1);
+	}
+}
+
+class Profiler_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-profiler"));
+	}
+
+	Temp_dir m_tmp;
+};
+
+TEST_F(Profiler_test, chrome_json)
+{
+	const std::string path = m_tmp.get_path("trace.json");
+
+	// the count is process wide
+	const uint64_t dropped_before = Profiler::get_dropped_count();
+
+	Profile_flusher flusher;
+	flusher.set_flush_period(std::chrono::milliseconds(1));
+	ASSERT_TRUE(flusher.open(path, Profile_flusher::Format::CHROME_JSON));
+	flusher.launch();
+
+	Profiler::set_enabled(true);
+
+	std::thread t0([](){ for(int i = 0; i < 1000; i++) { profiled_work(3); } });
+	std::thread t1([](){ for(int i = 0; i < 1000; i++) { profiled_work(3); } });
+	t0.join();
+	t1.join();
+
+	Profiler::set_enabled(false);
+
+	flusher.interrupt();
+	flusher.join();
+	ASSERT_TRUE(flusher.close());
+
+	EXPECT_EQ(flusher.get_dropped_count(), dropped_before);
+
+	std::vector<uint8_t> file_data;
+	ASSERT_TRUE(File_util::readSmallFile(path, &file_data));
+
+	const nlohmann::json j = nlohmann::json::parse(file_data);
+	const nlohmann::json& events = j.at("traceEvents");
+
+	ASSERT_EQ(events.size(), 2U * 2U * 1000U * 4U);
+
+	std::map<int, int> depth_by_tid;
+	for(const auto& ev : events)
+	{
+		EXPECT_EQ(ev.at("name").get<std::string>(), "profiled_work");
+
+		int& depth = depth_by_tid[ev.at("tid").get<int>()];
+		if(ev.at("ph").get<std::string>() == "B")
+		{
+			depth++;
+		}
+		else
+		{
+			depth--;
+			ASSERT_GE(depth, 0);
+		}
+	}
+
+	// exited threads were pruned once drained
+	std::vector<std::shared_ptr<Profile_buffer>> buffers;
+	Profiler::get_buffers(&buffers);
+	EXPECT_EQ(buffers.size(), 0U);
+}
+
+TEST_F(Profiler_test, chrome_json_escapes_names)
+{
+	const std::string path = m_tmp.get_path("trace.json");
+
+	Profile_flusher flusher;
+	ASSERT_TRUE(flusher.open(path, Profile_flusher::Format::CHROME_JSON));
+
+	Profiler::set_enabled(true);
+	std::thread t0([](){ EMB_PROFILE_ZONE("q\" b\\ n\n t\t c\x01\x1f"); });
+	t0.join();
+	Profiler::set_enabled(false);
+
+	// drains without launching
+	ASSERT_TRUE(flusher.close());
+
+	std::vector<uint8_t> file_data;
+	ASSERT_TRUE(File_util::readSmallFile(path, &file_data));
+
+	const nlohmann::json j = nlohmann::json::parse(file_data);
+	const nlohmann::json& events = j.at("traceEvents");
+
+	ASSERT_EQ(events.size(), 2U);
+	for(const auto& ev : events)
+	{
+		EXPECT_EQ(ev.at("name").get<std::string>(), "q\" b\\ n\n t\t c\x01\x1f");
+	}
+}
+
+TEST_F(Profiler_test, drops_survive_pruning)
+{
+	const uint64_t dropped_before = Profiler::get_dropped_count();
+
+	// not launched, nothing drains the ring while the thread runs
+	Profile_flusher flusher;
+	ASSERT_TRUE(flusher.open(m_tmp.get_path("trace.json"), Profile_flusher::Format::CHROME_JSON));
+
+	constexpr size_t NUM_ZONES = Profile_buffer::CAPACITY;
+
+	Profiler::set_enabled(true);
+	std::thread t0([](){ for(size_t i = 0; i < NUM_ZONES; i++) { profiled_work(0); } });
+	t0.join();
+	Profiler::set_enabled(false);
+
+	// drains and prunes the exited thread's buffer
+	ASSERT_TRUE(flusher.close());
+
+	std::vector<std::shared_ptr<Profile_buffer>> buffers;
+	Profiler::get_buffers(&buffers);
+	EXPECT_EQ(buffers.size(), 0U);
+
+	// two events per zone, one ring's worth were kept
+	EXPECT_EQ(flusher.get_dropped_count() - dropped_before, (2U * NUM_ZONES) - Profile_buffer::CAPACITY);
+}
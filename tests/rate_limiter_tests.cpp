@@ -0,0 +1,107 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Rate_limiter.hpp>
+#include <emb-lin-util/Stopwatch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <limits>
+#include <thread>
+
+TEST(Gcra_limiter, burst_then_deny)
+{
+	Gcra_limiter limiter(std::chrono::seconds(10), 5);
+
+	for(int i = 0; i < 5; i++)
+	{
+		EXPECT_TRUE(limiter.try_acquire(1));
+	}
+	EXPECT_FALSE(limiter.try_acquire(1));
+
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(limiter.get_wait_time(1, &dt));
+	EXPECT_GT(dt, std::chrono::seconds(9));
+	EXPECT_LE(dt, std::chrono::seconds(10));
+}
+
+TEST(Gcra_limiter, oversize_request_denied)
+{
+	Gcra_limiter limiter(std::chrono::seconds(10), 5);
+	EXPECT_FALSE(limiter.try_acquire(6));
+	EXPECT_TRUE(limiter.try_acquire(5));
+}
+
+TEST(Token_bucket, byte_rates_are_exact)
+{
+	// 2.5 ns and 0.67 ns per byte, whole ns intervals would give 500 MB/s and 1 GB/s
+	const std::array<double, 2> rates = {400.0e6, 1.5e9};
+	for(const double rate : rates)
+	{
+		Token_bucket bucket(rate, 1500);
+		ASSERT_TRUE(bucket.try_acquire(1500));
+
+		// only the few us since the burst was taken come off
+		const uint64_t n = 1500000;
+		const std::chrono::nanoseconds expected(int64_t(double(n) * 1.0e9 / rate));
+
+		std::chrono::nanoseconds dt;
+		ASSERT_TRUE(bucket.get_wait_time(n, &dt));
+		EXPECT_LE(dt, expected) << rate;
+		EXPECT_GT(dt, expected - std::chrono::microseconds(200)) << rate;
+	}
+}
+
+TEST(Token_bucket, bad_rates_never_refill)
+{
+	const std::array<double, 4> rates = {0.0, -5.0, std::numeric_limits<double>::quiet_NaN(), 1.0e-30};
+	for(const double rate : rates)
+	{
+		EXPECT_EQ(Token_bucket::rate_to_interval(rate), Gcra_limiter::Interval::max()) << rate;
+
+		Token_bucket bucket(rate, 2);
+		EXPECT_TRUE(bucket.try_acquire(2)) << rate;
+		EXPECT_FALSE(bucket.try_acquire(1)) << rate;
+
+		std::chrono::nanoseconds dt;
+		ASSERT_TRUE(bucket.get_wait_time(1, &dt));
+		EXPECT_GT(dt, std::chrono::hours(24)) << rate;
+	}
+}
+
+TEST(Token_bucket, acquire_paces_threads)
+{
+	// 1000 tokens/s, 1 token burst, 4 threads x 25 tokens
+	Token_bucket bucket(1000.0, 1);
+
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+
+	std::array<std::thread, 4> threads;
+	for(auto& t : threads)
+	{
+		t = std::thread([&bucket]()
+		{
+			for(int i = 0; i < 25; i++)
+			{
+				EXPECT_TRUE(bucket.acquire(1));
+			}
+		});
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(sw.get_time(&dt));
+
+	// the first token is free, the other 99 are paced
+	EXPECT_GE(dt, std::chrono::milliseconds(99));
+}
@@ -0,0 +1,171 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Rate_meter.hpp>
+#include <emb-lin-util/Virtual_clock.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include <cmath>
+
+// These tests link emb-lin-util-vclock, time only moves on Virtual_clock::advance
+
+namespace
+{
+	// value of an average with time constant tau, dt seconds after the input stepped from r0 to r1
+	double step_response(const double r0, const double r1, const double tau, const double dt)
+	{
+		return r1 + ((r0 - r1) * std::exp(-dt / tau));
+	}
+}
+
+TEST(Rate_meter, mark_across_threads)
+{
+	Rate_meter meter;
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 8; t++)
+	{
+		threads.emplace_back([&meter]()
+		{
+			for(int i = 0; i < 100000; i++)
+			{
+				meter.mark();
+			}
+			meter.mark(5);
+		});
+	}
+	for(std::thread& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(meter.get_count(), 8U * 100005U);
+
+	Virtual_clock::advance(std::chrono::seconds(1));
+
+	Rate_meter::Snapshot snap;
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_EQ(snap.count, 8U * 100005U);
+	EXPECT_DOUBLE_EQ(snap.rate_1s, 8.0 * 100005.0);
+}
+
+TEST(Rate_meter, ewma_converges)
+{
+	Rate_meter meter;
+	Rate_meter::Snapshot snap;
+
+	// the first snapshot primes every average with the rate so far
+	meter.mark(100);
+	Virtual_clock::advance(std::chrono::seconds(1));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_DOUBLE_EQ(snap.rate_1s,  100.0);
+	EXPECT_DOUBLE_EQ(snap.rate_10s, 100.0);
+	EXPECT_DOUBLE_EQ(snap.rate_60s, 100.0);
+
+	// step to 1000/s, sampled at irregular periods the averages follow the exact step response
+	const std::vector<std::chrono::milliseconds> periods = {
+		std::chrono::milliseconds(250),
+		std::chrono::milliseconds(750),
+		std::chrono::milliseconds(3000),
+		std::chrono::milliseconds(6000),
+		std::chrono::milliseconds(50000),
+		std::chrono::milliseconds(120000)
+	};
+
+	double t = 0.0;
+	for(const std::chrono::milliseconds& dt : periods)
+	{
+		meter.mark(uint64_t(dt.count()));
+		Virtual_clock::advance(dt);
+		t += std::chrono::duration<double>(dt).count();
+
+		ASSERT_TRUE(meter.snapshot(&snap));
+		EXPECT_NEAR(snap.rate_1s,  step_response(100.0, 1000.0,  1.0, t), 1.0e-6) << t;
+		EXPECT_NEAR(snap.rate_10s, step_response(100.0, 1000.0, 10.0, t), 1.0e-6) << t;
+		EXPECT_NEAR(snap.rate_60s, step_response(100.0, 1000.0, 60.0, t), 1.0e-6) << t;
+	}
+
+	// 180s in, the short averages have converged and the 60s one is within 5%
+	EXPECT_NEAR(snap.rate_1s,  1000.0, 1.0e-6);
+	EXPECT_NEAR(snap.rate_10s, 1000.0, 1.0e-3);
+	EXPECT_NEAR(snap.rate_60s, 1000.0, 50.0);
+}
+
+TEST(Rate_meter, mean_rate)
+{
+	Rate_meter meter;
+	Rate_meter::Snapshot snap;
+
+	// bursty input, the mean only depends on the total
+	meter.mark(300);
+	Virtual_clock::advance(std::chrono::milliseconds(500));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_DOUBLE_EQ(snap.mean_rate, 600.0);
+
+	Virtual_clock::advance(std::chrono::milliseconds(2500));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_DOUBLE_EQ(snap.mean_rate, 100.0);
+
+	meter.mark(700);
+	Virtual_clock::advance(std::chrono::seconds(7));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_EQ(snap.count, 1000U);
+	EXPECT_DOUBLE_EQ(snap.mean_rate, 100.0);
+}
+
+TEST(Rate_meter, reset)
+{
+	Rate_meter meter;
+	Rate_meter::Snapshot snap;
+
+	meter.mark(5000);
+	Virtual_clock::advance(std::chrono::seconds(1));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_DOUBLE_EQ(snap.rate_60s, 5000.0);
+
+	ASSERT_TRUE(meter.reset());
+
+	// reset restarts the snapshot count, the averages and the mean, the running total is kept
+	meter.mark(20);
+	Virtual_clock::advance(std::chrono::seconds(2));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_EQ(meter.get_count(), 5020U);
+	EXPECT_EQ(snap.count, 20U);
+	EXPECT_DOUBLE_EQ(snap.rate_1s,   10.0);
+	EXPECT_DOUBLE_EQ(snap.rate_10s,  10.0);
+	EXPECT_DOUBLE_EQ(snap.rate_60s,  10.0);
+	EXPECT_DOUBLE_EQ(snap.mean_rate, 10.0);
+}
+
+TEST(Throughput_meter, msgs_and_bytes)
+{
+	Throughput_meter meter;
+
+	for(int i = 0; i < 50; i++)
+	{
+		meter.mark(1, 1500);
+	}
+	Virtual_clock::advance(std::chrono::seconds(5));
+
+	Throughput_meter::Snapshot snap;
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_EQ(snap.msgs.count, 50U);
+	EXPECT_EQ(snap.bytes.count, 50U * 1500U);
+	EXPECT_DOUBLE_EQ(snap.msgs.rate_1s, 10.0);
+	EXPECT_DOUBLE_EQ(snap.bytes.mean_rate, 15000.0);
+
+	ASSERT_TRUE(meter.reset());
+	Virtual_clock::advance(std::chrono::seconds(1));
+	ASSERT_TRUE(meter.snapshot(&snap));
+	EXPECT_EQ(snap.msgs.count, 0U);
+	EXPECT_EQ(snap.bytes.count, 0U);
+	EXPECT_DOUBLE_EQ(snap.bytes.rate_1s, 0.0);
+}
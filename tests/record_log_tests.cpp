@@ -0,0 +1,499 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Record_log.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstring>
+
+namespace
+{
+	std::vector<uint8_t> make_record(const uint32_t i)
+	{
+		// varying lengths so frames land at odd offsets
+		std::vector<uint8_t> rec(8U + (i % 97U));
+		memcpy(rec.data(), &i, sizeof(i));
+		for(size_t j = sizeof(i); j < rec.size(); j++)
+		{
+			rec[j] = uint8_t(i + j);
+		}
+		return rec;
+	}
+
+	// all records of every segment in order
+	std::vector<std::vector<uint8_t>> read_all(const std::string& dir, const std::string& prefix)
+	{
+		std::vector<std::vector<uint8_t>> out;
+
+		std::vector<std::string> paths;
+		EXPECT_TRUE(Record_log::list_segments(dir, prefix, &paths));
+		for(const std::string& path : paths)
+		{
+			EXPECT_TRUE(Record_log::scan_segment(path, [&out](uint8_t const * const ptr, const size_t len)
+			{
+				out.emplace_back(ptr, ptr + len);
+				return true;
+			}));
+		}
+
+		return out;
+	}
+}
+
+class Record_log_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-record-log"));
+		m_dir = m_tmp.get_path();
+	}
+
+	Temp_dir m_tmp;
+	std::string m_dir;
+};
+
+TEST_F(Record_log_test, round_trip)
+{
+	constexpr uint32_t N = 2000;
+
+	{
+		Record_log log;
+		ASSERT_TRUE(log.open(m_dir, "telem"));
+		log.launch();
+
+		// several producers, each in order
+		std::vector<std::thread> producers;
+		for(uint32_t t = 0; t < 4; t++)
+		{
+			producers.emplace_back([&log, t]()
+			{
+				for(uint32_t i = t; i < N; i += 4)
+				{
+					EXPECT_TRUE(log.append(make_record(i)));
+				}
+			});
+		}
+		for(std::thread& t : producers)
+		{
+			t.join();
+		}
+
+		EXPECT_TRUE(log.flush(std::chrono::seconds(5)));
+		EXPECT_EQ(log.get_written_count(), N);
+		EXPECT_EQ(log.get_dropped_count(), 0U);
+
+		log.interrupt();
+		log.join();
+		log.close();
+	}
+
+	const std::vector<std::vector<uint8_t>> recs = read_all(m_dir, "telem");
+	ASSERT_EQ(recs.size(), N);
+
+	std::vector<uint32_t> next(4, 0);
+	for(uint32_t t = 0; t < 4; t++)
+	{
+		next[t] = t;
+	}
+	for(const std::vector<uint8_t>& rec : recs)
+	{
+		uint32_t i = 0;
+		memcpy(&i, rec.data(), sizeof(i));
+		ASSERT_LT(i, N);
+		EXPECT_EQ(i, next[i % 4]);
+		next[i % 4] += 4;
+		EXPECT_TRUE(rec == make_record(i));
+	}
+
+	// sealed to exactly its data
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	ASSERT_EQ(paths.size(), 1U);
+
+	uint64_t valid_len = 0;
+	ASSERT_TRUE(Record_log::scan_segment(paths[0], nullptr, &valid_len));
+	struct stat st;
+	ASSERT_EQ(stat(paths[0].c_str(), &st), 0);
+	EXPECT_EQ(uint64_t(st.st_size), valid_len);
+}
+
+TEST_F(Record_log_test, flush_covers_own_appends)
+{
+	Record_log log;
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+	log.launch();
+
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	ASSERT_EQ(paths.size(), 1U);
+	const std::string path = paths[0];
+
+	// each producer must find its own record on disk once its flush returns, whatever the others are doing
+	std::vector<std::thread> producers;
+	for(uint32_t t = 0; t < 4; t++)
+	{
+		producers.emplace_back([&log, &path, t]()
+		{
+			for(uint32_t i = t; i < 400; i += 4)
+			{
+				const std::vector<uint8_t> rec = make_record(i);
+				ASSERT_TRUE(log.append(rec));
+				ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+
+				bool found = false;
+				ASSERT_TRUE(Record_log::scan_segment(path, [&rec, &found](uint8_t const * const ptr, const size_t len)
+				{
+					found = (len == rec.size()) && std::equal(ptr, ptr + len, rec.begin());
+					return ! found;
+				}));
+				ASSERT_TRUE(found) << "record " << i;
+			}
+		});
+	}
+	for(std::thread& t : producers)
+	{
+		t.join();
+	}
+}
+
+TEST_F(Record_log_test, counts_records_abandoned_without_a_segment)
+{
+	Record_log log;
+	log.set_segment_size(256);
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+
+	for(uint32_t i = 0; i < 20; i++)
+	{
+		ASSERT_TRUE(log.append(make_record(i)));
+	}
+
+	// the next segment cannot be created
+	const std::string moved = m_dir + "-moved";
+	ASSERT_EQ(rename(m_dir.c_str(), moved.c_str()), 0);
+	log.close();
+	ASSERT_EQ(rename(moved.c_str(), m_dir.c_str()), 0);
+
+	EXPECT_GT(log.get_written_count(), 0U);
+	EXPECT_GT(log.get_dropped_count(), 0U);
+	EXPECT_EQ(log.get_written_count() + log.get_dropped_count(), 20U);
+}
+
+TEST_F(Record_log_test, retries_the_segment_after_a_failed_rotation)
+{
+	Record_log log;
+	log.set_segment_size(256);
+	log.set_max_segments(2);
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+	log.launch();
+
+	// the open segment survives the rename, the next one cannot be created
+	const std::string moved = m_dir + "-moved";
+	ASSERT_EQ(rename(m_dir.c_str(), moved.c_str()), 0);
+	for(uint32_t i = 0; i < 20; i++)
+	{
+		ASSERT_TRUE(log.append(make_record(i)));
+	}
+	ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+	ASSERT_EQ(rename(moved.c_str(), m_dir.c_str()), 0);
+
+	const uint64_t dropped = log.get_dropped_count();
+	EXPECT_GT(dropped, 0U);
+
+	// the next batch opens a new segment, and retention runs again
+	std::vector<std::vector<uint8_t>> expected;
+	for(uint32_t i = 20; i < 60; i++)
+	{
+		expected.push_back(make_record(i));
+		ASSERT_TRUE(log.append(expected.back()));
+		ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+	}
+
+	EXPECT_EQ(log.get_dropped_count(), dropped);
+	EXPECT_EQ(log.get_written_count() + log.get_dropped_count(), 60U);
+
+	log.interrupt();
+	log.join();
+	log.close();
+
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	EXPECT_EQ(paths.size(), 2U);
+
+	const std::vector<std::vector<uint8_t>> recs = read_all(m_dir, "telem");
+	ASSERT_LE(recs.size(), expected.size());
+	EXPECT_TRUE(std::equal(recs.begin(), recs.end(), expected.end() - ptrdiff_t(recs.size())));
+	EXPECT_EQ(recs.back(), expected.back());
+}
+
+TEST_F(Record_log_test, rotation_steps_past_a_stale_segment)
+{
+	Record_log log;
+	log.set_segment_size(256);
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+
+	// something else already holds the next index
+	const std::string stale = m_dir + "/telem.0000000001.log";
+	const int fd = ::open(stale.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+	ASSERT_GE(fd, 0);
+	::close(fd);
+
+	std::vector<std::vector<uint8_t>> expected;
+	for(uint32_t i = 0; i < 20; i++)
+	{
+		expected.push_back(make_record(i));
+		ASSERT_TRUE(log.append(expected.back()));
+	}
+	log.close();
+
+	EXPECT_EQ(log.get_written_count(), 20U);
+	EXPECT_EQ(log.get_dropped_count(), 0U);
+
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	ASSERT_GE(paths.size(), 3U);
+	EXPECT_EQ(paths[1], stale);
+	EXPECT_EQ(read_all(m_dir, "telem"), expected);
+}
+
+TEST_F(Record_log_test, rotates_by_size_and_keeps_max_segments)
+{
+	constexpr uint32_t N = 1000;
+
+	{
+		Record_log log;
+		log.set_segment_size(4096);
+		log.set_max_segments(3);
+		ASSERT_TRUE(log.open(m_dir, "telem"));
+		log.launch();
+
+		for(uint32_t i = 0; i < N; i++)
+		{
+			ASSERT_TRUE(log.append(make_record(i)));
+			if((i % 64) == 0)
+			{
+				ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+			}
+		}
+		ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+	}
+
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	ASSERT_EQ(paths.size(), 3U);
+
+	for(const std::string& path : paths)
+	{
+		struct stat st;
+		ASSERT_EQ(stat(path.c_str(), &st), 0);
+		EXPECT_LE(st.st_size, 4096);
+	}
+
+	// the newest records survive, contiguous up to the last
+	const std::vector<std::vector<uint8_t>> recs = read_all(m_dir, "telem");
+	ASSERT_FALSE(recs.empty());
+	uint32_t first = 0;
+	memcpy(&first, recs.front().data(), sizeof(first));
+	ASSERT_EQ(recs.size(), N - first);
+	for(size_t k = 0; k < recs.size(); k++)
+	{
+		EXPECT_TRUE(recs[k] == make_record(uint32_t(first + k)));
+	}
+}
+
+TEST_F(Record_log_test, scans_live_segments_during_rotation)
+{
+	constexpr uint32_t N = 4000;
+
+	Record_log log;
+	log.set_segment_size(4096);
+	log.set_max_segments(1000);
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+	log.launch();
+
+	// each rotation shrinks the live segment the reader may be scanning
+	std::atomic<bool> done(false);
+	std::thread reader([this, &done]()
+	{
+		while( ! done )
+		{
+			std::vector<std::string> paths;
+			ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+			for(const std::string& path : paths)
+			{
+				EXPECT_TRUE(Record_log::scan_segment(path, [](uint8_t const * const ptr, const size_t len)
+				{
+					uint32_t i = 0;
+					memcpy(&i, ptr, sizeof(i));
+					EXPECT_TRUE(std::vector<uint8_t>(ptr, ptr + len) == make_record(i));
+					return true;
+				}));
+			}
+		}
+	});
+
+	for(uint32_t i = 0; i < N; i++)
+	{
+		ASSERT_TRUE(log.append(make_record(i)));
+		if((i % 16) == 0)
+		{
+			ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+		}
+	}
+	ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+
+	done = true;
+	reader.join();
+
+	log.interrupt();
+	log.join();
+	log.close();
+
+	EXPECT_EQ(read_all(m_dir, "telem").size(), N);
+}
+
+TEST_F(Record_log_test, scans_records_larger_than_a_read)
+{
+	std::vector<uint8_t> big(300U * 1024U);
+	for(size_t j = 0; j < big.size(); j++)
+	{
+		big[j] = uint8_t(j * 7U);
+	}
+
+	{
+		Record_log log;
+		log.set_max_record_size(big.size());
+		ASSERT_TRUE(log.open(m_dir, "telem"));
+		log.launch();
+
+		ASSERT_TRUE(log.append(make_record(1)));
+		ASSERT_TRUE(log.append(big));
+		ASSERT_TRUE(log.append(make_record(2)));
+		ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+
+		log.interrupt();
+		log.join();
+		log.close();
+	}
+
+	const std::vector<std::vector<uint8_t>> recs = read_all(m_dir, "telem");
+	ASSERT_EQ(recs.size(), 3U);
+	EXPECT_TRUE(recs[0] == make_record(1));
+	EXPECT_TRUE(recs[1] == big);
+	EXPECT_TRUE(recs[2] == make_record(2));
+}
+
+TEST_F(Record_log_test, rotates_by_age)
+{
+	Record_log log;
+	log.set_rotate_period(std::chrono::milliseconds(50));
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+	log.launch();
+
+	ASSERT_TRUE(log.append(make_record(0)));
+	ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	ASSERT_TRUE(log.append(make_record(1)));
+	ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+
+	log.interrupt();
+	log.join();
+	log.close();
+
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	EXPECT_GE(paths.size(), 2U);
+	EXPECT_EQ(read_all(m_dir, "telem").size(), 2U);
+}
+
+TEST_F(Record_log_test, recovers_torn_tail)
+{
+	{
+		Record_log log;
+		ASSERT_TRUE(log.open(m_dir, "telem"));
+		for(uint32_t i = 0; i < 10; i++)
+		{
+			ASSERT_TRUE(log.append(make_record(i)));
+		}
+		// not launched, close writes the queue
+		log.close();
+	}
+
+	std::vector<std::string> paths;
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	ASSERT_EQ(paths.size(), 1U);
+
+	// a crash mid record, a header promising more than was written
+	{
+		const int fd = open(paths[0].c_str(), O_WRONLY | O_APPEND);
+		ASSERT_GE(fd, 0);
+
+		const uint32_t hdr[2] = {1000U, 0x12345678U};
+		ASSERT_EQ(write(fd, hdr, sizeof(hdr)), ssize_t(sizeof(hdr)));
+		const std::vector<uint8_t> partial(100, 0xAA);
+		ASSERT_EQ(write(fd, partial.data(), partial.size()), ssize_t(partial.size()));
+		close(fd);
+	}
+
+	{
+		Record_log log;
+		ASSERT_TRUE(log.open(m_dir, "telem"));
+		for(uint32_t i = 10; i < 15; i++)
+		{
+			ASSERT_TRUE(log.append(make_record(i)));
+		}
+		log.close();
+	}
+
+	// the new records follow the last good one in the same segment
+	ASSERT_TRUE(Record_log::list_segments(m_dir, "telem", &paths));
+	ASSERT_EQ(paths.size(), 1U);
+
+	const std::vector<std::vector<uint8_t>> recs = read_all(m_dir, "telem");
+	ASSERT_EQ(recs.size(), 15U);
+	for(uint32_t i = 0; i < 15; i++)
+	{
+		EXPECT_TRUE(recs[i] == make_record(i));
+	}
+}
+
+TEST_F(Record_log_test, rejects_bad_records)
+{
+	Record_log log(4);
+	log.set_max_record_size(64);
+	ASSERT_TRUE(log.open(m_dir, "telem"));
+
+	EXPECT_FALSE(log.append(nullptr, 0));
+	EXPECT_FALSE(log.append(std::vector<uint8_t>(65, 1)));
+	EXPECT_TRUE(log.append(std::vector<uint8_t>(64, 1)));
+
+	// not launched, the staging queue fills
+	while(log.append(std::vector<uint8_t>(8, 2)))
+	{
+
+	}
+	EXPECT_GE(log.get_dropped_count(), 3U);
+
+	log.close();
+	EXPECT_EQ(log.get_written_count(), 4U);
+}
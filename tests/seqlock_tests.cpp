@@ -0,0 +1,188 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Seqlock.hpp>
+#include <emb-lin-util/Seqlock_cbor_codec.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+struct Pose
+{
+	// every field is written with the same value, a torn read shows up as a mismatch
+	std::array<uint64_t, 7> v;
+};
+
+class Battery_state : public JSON_CBOR_helper<Battery_state>
+{
+public:
+	uint64_t    seq = 0;
+	std::string seq_str;
+	std::vector<double> cells;
+};
+
+void to_json(nlohmann::json& j, const Battery_state& x)
+{
+	j["seq"]     = x.seq;
+	j["seq_str"] = x.seq_str;
+	j["cells"]   = x.cells;
+}
+void from_json(const nlohmann::json& j, Battery_state& x)
+{
+	j.at("seq").get_to(x.seq);
+	j.at("seq_str").get_to(x.seq_str);
+	j.at("cells").get_to(x.cells);
+}
+
+TEST(Seqlock, empty_then_value)
+{
+	Seqlock<Pose> lock;
+
+	Pose p;
+	EXPECT_FALSE(lock.load(&p));
+	EXPECT_FALSE(lock.try_load(&p));
+	EXPECT_EQ(lock.get_version(), 0U);
+
+	p.v.fill(42);
+	ASSERT_TRUE(lock.store(p));
+	EXPECT_EQ(lock.get_version(), 1U);
+
+	Pose q;
+	ASSERT_TRUE(lock.load(&q));
+	EXPECT_EQ(q.v, p.v);
+}
+
+TEST(Seqlock, trivial_codec_checks_length)
+{
+	typedef Seqlock_trivial_codec<uint32_t> Codec;
+
+	const std::array<uint8_t, 8> buf = {0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A};
+
+	uint32_t val = 0;
+	EXPECT_FALSE(Codec::decode(buf.data(), 3, &val));
+	EXPECT_FALSE(Codec::decode(buf.data(), 8, &val));
+	EXPECT_EQ(val, 0U);
+
+	ASSERT_TRUE(Codec::decode(buf.data(), 4, &val));
+	EXPECT_EQ(val, 0x5A5A5A5AU);
+}
+
+namespace
+{
+	// skips ahead to where a 32 bit sequence would wrap
+	class Seqlock_skip : public Seqlock<Pose>
+	{
+	public:
+		void set_seq(const uint64_t seq)
+		{
+			m_seq.store(seq);
+		}
+	};
+}
+
+TEST(Seqlock, version_does_not_wrap_to_empty)
+{
+	Seqlock_skip lock;
+
+	Pose p;
+	p.v.fill(7);
+	ASSERT_TRUE(lock.store(p));
+
+	lock.set_seq(0xFFFFFFFEULL);
+	ASSERT_TRUE(lock.store(p));
+	EXPECT_EQ(lock.get_version(), 0x80000000ULL);
+
+	Pose q;
+	ASSERT_TRUE(lock.load(&q));
+	EXPECT_EQ(q.v, p.v);
+	ASSERT_TRUE(lock.try_load(&q));
+}
+
+TEST(Seqlock, readers_never_see_torn_values)
+{
+	Seqlock<Pose> lock(Pose{});
+
+	std::atomic<bool> done(false);
+	std::vector<std::thread> readers;
+	for(int i = 0; i < 3; i++)
+	{
+		readers.emplace_back([&lock, &done]()
+		{
+			uint64_t last = 0;
+			while( ! done )
+			{
+				Pose p;
+				ASSERT_TRUE(lock.load(&p));
+				for(const uint64_t x : p.v)
+				{
+					ASSERT_EQ(x, p.v[0]);
+				}
+
+				// single writer, values only go up
+				ASSERT_GE(p.v[0], last);
+				last = p.v[0];
+			}
+		});
+	}
+
+	for(uint64_t i = 1; i <= 200000; i++)
+	{
+		Pose p;
+		p.v.fill(i);
+		ASSERT_TRUE(lock.store(p));
+	}
+
+	done = true;
+	for(auto& t : readers)
+	{
+		t.join();
+	}
+}
+
+TEST(Seqlock, cbor_codec)
+{
+	typedef Seqlock<Battery_state, Seqlock_cbor_codec<Battery_state, 256>> Battery_lock;
+	Battery_lock lock;
+
+	std::atomic<bool> done(false);
+	std::thread reader([&lock, &done]()
+	{
+		while( ! done )
+		{
+			Battery_state b;
+			if(lock.load(&b))
+			{
+				ASSERT_EQ(std::to_string(b.seq), b.seq_str);
+				ASSERT_EQ(b.cells.size(), b.seq % 8);
+			}
+		}
+	});
+
+	for(uint64_t i = 0; i < 20000; i++)
+	{
+		Battery_state b;
+		b.seq     = i;
+		b.seq_str = std::to_string(i);
+		b.cells.assign(i % 8, 3.7);
+		ASSERT_TRUE(lock.store(b));
+	}
+
+	done = true;
+	reader.join();
+
+	// too large for 256 bytes
+	Battery_state big;
+	big.cells.assign(100, 3.7);
+	EXPECT_FALSE(lock.store(big));
+
+	Battery_state last;
+	ASSERT_TRUE(lock.load(&last));
+	EXPECT_EQ(last.seq, 19999U);
+}
@@ -0,0 +1,173 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Spsc_ring.hpp>
+#include <emb-lin-util/Stopwatch.hpp>
+#include <emb-lin-util/Thread_base.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <numeric>
+#include <thread>
+
+TEST(Spsc_ring, capacity_and_wrap)
+{
+	Spsc_ring<int> ring(5);
+	ASSERT_EQ(ring.capacity(), 8U);
+
+	int val = 0;
+	EXPECT_FALSE(ring.try_pop(&val));
+
+	// walk the indices around the ring a few times with uneven batches
+	int next_in  = 0;
+	int next_out = 0;
+	std::array<int, 8> buf;
+	for(int round = 0; round < 100; round++)
+	{
+		const size_t n_in = (round % 7) + 1;
+		for(size_t i = 0; i < n_in; i++)
+		{
+			buf[i] = next_in + int(i);
+		}
+		const size_t pushed = ring.push_n(buf.data(), n_in);
+		EXPECT_LE(ring.size(), ring.capacity());
+		next_in += int(pushed);
+
+		const size_t popped = ring.pop_n(buf.data(), (round % 5) + 1);
+		for(size_t i = 0; i < popped; i++)
+		{
+			ASSERT_EQ(buf[i], next_out++);
+		}
+	}
+
+	while(ring.try_pop(&val))
+	{
+		ASSERT_EQ(val, next_out++);
+	}
+	EXPECT_EQ(next_in, next_out);
+
+	for(int i = 0; i < 8; i++)
+	{
+		EXPECT_TRUE(ring.try_push(i));
+	}
+	EXPECT_FALSE(ring.try_push(8));
+	EXPECT_EQ(ring.push_n(buf.data(), 4), 0U);
+}
+
+TEST(Spsc_ring, blocking_transfer)
+{
+	constexpr uint64_t N = 1000000;
+
+	for(const uint32_t spin : {0U, Spsc_ring<uint64_t>::DEFAULT_SPIN_COUNT})
+	{
+		// small ring so both sides block often
+		Spsc_ring<uint64_t> ring(16);
+		ring.set_spin_count(spin);
+
+		std::thread producer([&ring]()
+		{
+			for(uint64_t i = 0; i < N; i++)
+			{
+				ASSERT_TRUE(ring.push(i));
+			}
+		});
+
+		uint64_t expected = 0;
+		std::array<uint64_t, 8> buf;
+		while(expected < N)
+		{
+			ASSERT_TRUE(ring.wait_for_data());
+
+			const size_t n = ring.pop_n(buf.data(), buf.size());
+			for(size_t i = 0; i < n; i++)
+			{
+				ASSERT_EQ(buf[i], expected++);
+			}
+		}
+
+		producer.join();
+		EXPECT_TRUE(ring.empty());
+	}
+}
+
+TEST(Spsc_ring, timeout)
+{
+	Spsc_ring<int> ring(2);
+
+	Stopwatch sw;
+	ASSERT_TRUE(sw.start());
+
+	int val = 0;
+	EXPECT_FALSE(ring.pop(&val, std::chrono::milliseconds(20)));
+
+	std::chrono::nanoseconds dt;
+	ASSERT_TRUE(sw.get_time(&dt));
+	EXPECT_GE(dt, std::chrono::milliseconds(20));
+
+	EXPECT_TRUE(ring.try_push(1));
+	EXPECT_TRUE(ring.try_push(2));
+	EXPECT_FALSE(ring.push(3, std::chrono::milliseconds(1)));
+}
+
+class Spsc_ring_consumer : public Thread_base
+{
+public:
+	Spsc_ring_consumer(Spsc_ring<int>* const ring) : m_ring(ring), m_sum(0)
+	{
+
+	}
+
+	void interrupt() override
+	{
+		Thread_base::interrupt();
+		m_ring->notify_cancel();
+	}
+
+	int get_sum() const
+	{
+		return m_sum;
+	}
+
+protected:
+	void work() override
+	{
+		int val = 0;
+		while(m_ring->pop(&val))
+		{
+			m_sum += val;
+		}
+	}
+
+	Spsc_ring<int>* m_ring;
+	std::atomic<int> m_sum;
+};
+
+TEST(Spsc_ring, interrupt_drains_then_exits)
+{
+	Spsc_ring<int> ring(64);
+
+	Spsc_ring_consumer consumer(&ring);
+	consumer.launch();
+
+	for(int i = 1; i <= 10; i++)
+	{
+		ASSERT_TRUE(ring.push(i));
+	}
+
+	// consumer is blocked in the futex once it catches up
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	consumer.interrupt();
+	consumer.join();
+
+	EXPECT_EQ(consumer.get_sum(), 55);
+	// canceled and empty, does not block
+	int val = 0;
+	EXPECT_TRUE(ring.is_cancel_requested());
+	EXPECT_FALSE(ring.pop(&val));
+}
@@ -0,0 +1,126 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/File_util.hpp>
+#include <emb-lin-util/Sysfs_attr.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+class Sysfs_attr_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(m_tmp.create("emb-lin-util-sysfs"));
+		m_path = m_tmp.get_path("attr");
+
+		// opened before the first set in some tests
+		set("");
+	}
+
+	void set(const std::string& val)
+	{
+		ASSERT_TRUE(File_util::writeSmallFile(m_path, val));
+	}
+
+	Temp_dir m_tmp;
+	std::string m_path;
+};
+
+TEST_F(Sysfs_attr_test, rereads_without_reopen)
+{
+	set("42000\n");
+
+	Sysfs_attr attr;
+	ASSERT_TRUE(attr.open(m_path));
+
+	int val = 0;
+	ASSERT_TRUE(attr.read_int(&val));
+	EXPECT_EQ(val, 42000);
+
+	// the writer truncates and rewrites the same inode, like sysfs regenerating the value
+	set("-17\n");
+	ASSERT_TRUE(attr.read_int(&val));
+	EXPECT_EQ(val, -17);
+
+	set(" +9000000000000 \n");
+	int64_t val64 = 0;
+	ASSERT_TRUE(attr.read_int64(&val64));
+	EXPECT_EQ(val64, 9000000000000LL);
+	EXPECT_FALSE(attr.read_int(&val));
+
+	set("3.25\n");
+	double dval = 0.0;
+	ASSERT_TRUE(attr.read_double(&dval));
+	EXPECT_EQ(dval, 3.25);
+
+	std::string sval;
+	ASSERT_TRUE(attr.read_string(&sval));
+	EXPECT_EQ(sval, "3.25");
+}
+
+TEST_F(Sysfs_attr_test, parse_errors)
+{
+	Sysfs_attr attr;
+	ASSERT_TRUE(attr.open(m_path));
+
+	int val = 0;
+
+	set("\n");
+	EXPECT_FALSE(attr.read_int(&val));
+
+	set("12abc\n");
+	EXPECT_FALSE(attr.read_int(&val));
+
+	// too large for the number buffer, not truncated to a different number
+	set(std::string(100, '1'));
+	EXPECT_FALSE(attr.read_int(&val));
+
+	std::string sval;
+	set(std::string(Sysfs_attr::MAX_SIZE + 1, 'x'));
+	EXPECT_FALSE(attr.read_string(&sval));
+
+	Sysfs_attr closed;
+	EXPECT_FALSE(closed.read_int(&val));
+}
+
+TEST_F(Sysfs_attr_test, enum_and_write)
+{
+	enum class Dir
+	{
+		IN,
+		OUT
+	};
+	static constexpr std::array<std::pair<std::string_view, Dir>, 2> DIRS = {{
+		{"in",  Dir::IN},
+		{"out", Dir::OUT}
+	}};
+
+	set("out\n");
+
+	Sysfs_attr attr;
+	ASSERT_TRUE(attr.open(m_path, true));
+
+	Dir dir = Dir::IN;
+	ASSERT_TRUE(attr.read_enum(DIRS, &dir));
+	EXPECT_EQ(dir, Dir::OUT);
+
+	ASSERT_TRUE(attr.write("in\n"));
+	ASSERT_TRUE(attr.read_enum(DIRS, &dir));
+	EXPECT_EQ(dir, Dir::IN);
+
+	set("sideways\n");
+	EXPECT_FALSE(attr.read_enum(DIRS, &dir));
+
+	Sysfs_attr moved(std::move(attr));
+	EXPECT_FALSE(attr.is_open());
+	EXPECT_TRUE(moved.is_open());
+}
@@ -0,0 +1,78 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Timespec_util.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+static constexpr timespec make_ts(const time_t sec, const long nsec)
+{
+	timespec out{};
+	out.tv_sec  = sec;
+	out.tv_nsec = nsec;
+	return out;
+}
+
+// conversions of constants are folded at compile time
+static_assert(Timespec_util::from_chrono_v<std::chrono::milliseconds, 1500> == make_ts(1, 500000000L));
+static_assert(Timespec_util::from_chrono(std::chrono::microseconds(-1)) == make_ts(-1, 999999000L));
+static_assert(Timespec_util::from_chrono(std::chrono::minutes(2)) == make_ts(120, 0));
+static_assert(Timespec_util::from_chrono(std::chrono::duration<double>(1.25)) == make_ts(1, 250000000L));
+static_assert(Timespec_util::to_chrono<std::chrono::milliseconds>(make_ts(-1, 999999999L)) == std::chrono::milliseconds(-1));
+static_assert(Timespec_util::to_chrono<std::chrono::minutes>(make_ts(-1, 0)) == std::chrono::minutes(-1));
+static_assert(Timespec_util::add(make_ts(1, 999999999L), make_ts(0, 1)) == make_ts(2, 0));
+static_assert(Timespec_util::sub(make_ts(1, 0), make_ts(0, 1)) == make_ts(0, 999999999L));
+static_assert(Timespec_util::normalize(make_ts(0, -1)) == make_ts(-1, 999999999L));
+static_assert(make_ts(1, 0) < make_ts(1, 1));
+static_assert(make_ts(-1, 999999999L) < make_ts(0, 0));
+
+TEST(Timespec_util, saturating)
+{
+	const timespec t_max = Timespec_util::max_value();
+	const timespec t_min = Timespec_util::min_value();
+
+	EXPECT_EQ(Timespec_util::add_sat(t_max, make_ts(0, 1)), t_max);
+	EXPECT_EQ(Timespec_util::add_sat(t_max, make_ts(1, 0)), t_max);
+	EXPECT_EQ(Timespec_util::sub_sat(t_min, make_ts(0, 1)), t_min);
+	EXPECT_EQ(Timespec_util::sub_sat(t_min, make_ts(1, 0)), t_min);
+	EXPECT_EQ(Timespec_util::sub_sat(make_ts(0, 0), t_min), t_max);
+
+	EXPECT_EQ(Timespec_util::to_chrono_sat<std::chrono::nanoseconds>(t_max), std::chrono::nanoseconds::max());
+	EXPECT_EQ(Timespec_util::to_chrono_sat<std::chrono::nanoseconds>(t_min), std::chrono::nanoseconds::min());
+	EXPECT_EQ(Timespec_util::to_ns_sat(t_max), INT64_MAX);
+
+	// 1000 years in seconds is fine without saturation
+	const timespec t_1000y = make_ts(time_t(1000) * 365 * 86400, 0);
+	EXPECT_EQ(Timespec_util::to_chrono<std::chrono::seconds>(t_1000y).count(), t_1000y.tv_sec);
+	EXPECT_EQ(Timespec_util::to_chrono_sat<std::chrono::seconds>(t_1000y).count(), t_1000y.tv_sec);
+}
+
+TEST(Timespec_util, matches_i128_reference)
+{
+	std::mt19937_64 rng(42);
+
+	for(int i = 0; i < 100000; i++)
+	{
+		const timespec a = make_ts(time_t(int64_t(rng()) >> 34), long(rng() % 1000000000ULL));
+		const timespec b = make_ts(time_t(int64_t(rng()) >> 34), long(rng() % 1000000000ULL));
+
+		const __int128 a_ns = Timespec_util::to_ns_i128(a);
+		const __int128 b_ns = Timespec_util::to_ns_i128(b);
+
+		ASSERT_EQ(Timespec_util::add(a, b), Timespec_util::from_ns_i128(a_ns + b_ns));
+		ASSERT_EQ(Timespec_util::sub(a, b), Timespec_util::from_ns_i128(a_ns - b_ns));
+		ASSERT_EQ(Timespec_util::compare(a, b), (a_ns < b_ns) ? -1 : ((a_ns > b_ns) ? 1 : 0));
+
+		const std::chrono::microseconds a_us = Timespec_util::to_chrono<std::chrono::microseconds>(a);
+		const __int128 a_us_ref = (a_ns >= 0) ? (a_ns / 1000) : -((-a_ns + 999) / 1000);
+		ASSERT_EQ(__int128(a_us.count()), a_us_ref);
+
+		ASSERT_EQ(Timespec_util::from_chrono(Timespec_util::to_chrono<std::chrono::nanoseconds>(a)), a);
+	}
+}
@@ -0,0 +1,102 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Triple_buffer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(Triple_buffer, latest_value)
+{
+	Triple_buffer<int> buf;
+
+	int val = -1;
+	EXPECT_FALSE(buf.read(&val));
+	EXPECT_FALSE(buf.has_data());
+	EXPECT_EQ(val, -1);
+
+	buf.write(1);
+	buf.write(2);
+	buf.write(3);
+
+	// only the newest survives
+	EXPECT_TRUE(buf.read(&val));
+	EXPECT_EQ(val, 3);
+
+	// unchanged, still readable
+	EXPECT_FALSE(buf.read(&val));
+	EXPECT_EQ(val, 3);
+
+	buf.get_write_buffer() = 4;
+	buf.publish();
+	EXPECT_TRUE(buf.update());
+	EXPECT_EQ(buf.get_read_buffer(), 4);
+}
+
+struct Sample
+{
+	uint64_t seq;
+	std::string seq_str;
+	std::vector<uint64_t> data;
+};
+
+// copies only the header fields and reuses the destination's vector storage
+struct Sample_copy
+{
+	static void copy(const Sample& src, Sample* const dst)
+	{
+		dst->seq     = src.seq;
+		dst->seq_str = src.seq_str;
+		dst->data.assign(src.data.begin(), src.data.end());
+	}
+};
+
+TEST(Triple_buffer, concurrent_non_trivial)
+{
+	Triple_buffer<Sample, Sample_copy> buf;
+
+	std::atomic<bool> done(false);
+	std::thread reader([&buf, &done]()
+	{
+		uint64_t last = 0;
+		Sample s;
+		while( ! done )
+		{
+			if(buf.read(&s))
+			{
+				ASSERT_EQ(std::to_string(s.seq), s.seq_str);
+				ASSERT_EQ(s.data.size(), s.seq % 16);
+				for(const uint64_t x : s.data)
+				{
+					ASSERT_EQ(x, s.seq);
+				}
+
+				ASSERT_GT(s.seq, last);
+				last = s.seq;
+			}
+		}
+	});
+
+	for(uint64_t i = 1; i <= 200000; i++)
+	{
+		Sample& s = buf.get_write_buffer();
+		s.seq     = i;
+		s.seq_str = std::to_string(i);
+		s.data.assign(i % 16, i);
+		buf.publish();
+	}
+
+	done = true;
+	reader.join();
+
+	Sample s;
+	buf.read(&s);
+	EXPECT_EQ(s.seq, 200000U);
+}
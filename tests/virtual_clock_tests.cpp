@@ -0,0 +1,148 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Edf_scheduler.hpp>
+#include <emb-lin-util/Rate_limiter.hpp>
+#include <emb-lin-util/Record_log.hpp>
+#include <emb-lin-util/Virtual_clock.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// These tests link emb-lin-util-vclock, time only moves on Virtual_clock::advance
+// The worker threads still run in real time, so give them a moment to show they are waiting
+static bool wait_until(const std::function<bool()>& pred)
+{
+	const std::chrono::steady_clock::time_point t_end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while( ! pred() )
+	{
+		if(std::chrono::steady_clock::now() > t_end)
+		{
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+TEST(Virtual_clock, sleep_until_waits_for_advance)
+{
+	const std::chrono::nanoseconds t = Virtual_clock::now() + std::chrono::milliseconds(100);
+
+	std::atomic<bool> done(false);
+	std::thread sleeper([&t, &done]()
+	{
+		Virtual_clock::sleep_until(t);
+		done = true;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_FALSE(done);
+
+	Virtual_clock::advance(std::chrono::milliseconds(99));
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_FALSE(done);
+
+	Virtual_clock::advance(std::chrono::milliseconds(1));
+	EXPECT_TRUE(wait_until([&done](){ return done.load(); }));
+
+	sleeper.join();
+}
+
+TEST(Edf_scheduler, releases_on_virtual_time)
+{
+	Edf_scheduler sched;
+	ASSERT_TRUE(sched.init());
+	sched.launch();
+
+	std::atomic<int> cnt(0);
+	Edf_scheduler::Task_id id;
+	ASSERT_TRUE(sched.add_periodic(std::chrono::milliseconds(100), std::chrono::nanoseconds::zero(), [&cnt](){ cnt++; }, &id));
+
+	for(int i = 1; i <= 5; i++)
+	{
+		Virtual_clock::advance(std::chrono::milliseconds(99));
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		EXPECT_EQ(cnt, i - 1);
+
+		Virtual_clock::advance(std::chrono::milliseconds(1));
+		EXPECT_TRUE(wait_until([&cnt, i](){ return cnt == i; }));
+	}
+
+	Edf_scheduler::Task_stats stats;
+	ASSERT_TRUE(sched.get_stats(id, &stats));
+	EXPECT_EQ(stats.run_count, 5U);
+	EXPECT_EQ(stats.deadline_misses, 0U);
+	EXPECT_EQ(stats.skipped_releases, 0U);
+
+	sched.interrupt();
+	sched.join();
+}
+
+TEST(Gcra_limiter, acquire_sleeps_on_virtual_time)
+{
+	Gcra_limiter lim(std::chrono::milliseconds(10), 1);
+
+	// the burst is free
+	ASSERT_TRUE(lim.acquire());
+
+	std::atomic<bool> done(false);
+	std::thread waiter([&lim, &done]()
+	{
+		EXPECT_TRUE(lim.acquire());
+		done = true;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_FALSE(done);
+
+	Virtual_clock::advance(std::chrono::milliseconds(10));
+	EXPECT_TRUE(wait_until([&done](){ return done.load(); }));
+
+	waiter.join();
+}
+
+TEST(Record_log, rotates_on_virtual_time)
+{
+	Temp_dir tmp;
+	ASSERT_TRUE(tmp.create("emb-lin-util-vclock-record-log"));
+
+	Record_log log;
+	log.set_rotate_period(std::chrono::seconds(60));
+	ASSERT_TRUE(log.open(tmp.get_path(), "telem"));
+	log.launch();
+
+	ASSERT_TRUE(log.append(std::vector<uint8_t>(16, 0xA5)));
+	ASSERT_TRUE(log.flush(std::chrono::seconds(5)));
+
+	const auto segment_count = [&tmp]()
+	{
+		std::vector<std::string> paths;
+		EXPECT_TRUE(Record_log::list_segments(tmp.get_path(), "telem", &paths));
+		return paths.size();
+	};
+
+	// a minute of virtual time has not passed, however long the worker polls
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	EXPECT_EQ(segment_count(), 1U);
+
+	Virtual_clock::advance(std::chrono::seconds(60));
+	EXPECT_TRUE(wait_until([&segment_count](){ return segment_count() == 2U; }));
+
+	log.interrupt();
+	log.join();
+	log.close();
+}
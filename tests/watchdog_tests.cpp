@@ -0,0 +1,196 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanmarine.io>
+ * @copyright Copyright (c) 2024 Suburban Marine, Inc. All rights reserved.
+ * @license Licensed under the 3-Clause BSD LICENSE. See LICENSE.txt for details.
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <emb-lin-util/Thread_base.hpp>
+#include <emb-lin-util/Virtual_clock.hpp>
+#include <emb-lin-util/Watchdog.hpp>
+
+#include <test_support/Temp_dir.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs on Virtual_clock, see interval_timerfd_tests.cpp
+static bool wait_until(const std::function<bool()>& pred)
+{
+	const std::chrono::steady_clock::time_point t_end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while( ! pred() )
+	{
+		if(std::chrono::steady_clock::now() > t_end)
+		{
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+static off_t get_file_size(const std::string& path)
+{
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0)
+	{
+		return -1;
+	}
+	return st.st_size;
+}
+
+TEST(Watchdog, check_reports_stall_once)
+{
+	Watchdog wd;
+
+	std::vector<std::pair<std::string, std::chrono::nanoseconds>> stalls;
+	wd.set_stall_callback([&stalls](const std::string& name, const std::chrono::nanoseconds& age)
+	{
+		stalls.emplace_back(name, age);
+	});
+
+	std::shared_ptr<Heartbeat> a = wd.add_heartbeat("a", std::chrono::milliseconds(100));
+	std::shared_ptr<Heartbeat> b = wd.add_heartbeat("b", std::chrono::milliseconds(100));
+
+	// paused heartbeats are never stalled
+	Virtual_clock::advance(std::chrono::seconds(1));
+	EXPECT_TRUE(wd.check());
+
+	a->beat();
+	b->beat();
+	Virtual_clock::advance(std::chrono::milliseconds(100));
+	EXPECT_TRUE(wd.check());
+
+	b->beat();
+	Virtual_clock::advance(std::chrono::milliseconds(50));
+	EXPECT_FALSE(wd.check());
+	EXPECT_FALSE(wd.check());
+	EXPECT_EQ(wd.get_stalled_count(), 1U);
+
+	ASSERT_EQ(stalls.size(), 1U);
+	EXPECT_EQ(stalls[0].first, "a");
+	EXPECT_EQ(stalls[0].second, std::chrono::milliseconds(150));
+
+	// recovers, then stalls again and is reported again
+	a->beat();
+	EXPECT_TRUE(wd.check());
+	EXPECT_EQ(wd.get_stalled_count(), 0U);
+
+	b->pause();
+	Virtual_clock::advance(std::chrono::milliseconds(200));
+	EXPECT_FALSE(wd.check());
+	ASSERT_EQ(stalls.size(), 2U);
+	EXPECT_EQ(stalls[1].first, "a");
+
+	wd.remove_heartbeat(a);
+	EXPECT_TRUE(wd.check());
+}
+
+class Beating_worker : public Thread_base
+{
+public:
+	Beating_worker() : m_stall(false)
+	{
+
+	}
+
+	void work() override
+	{
+		while( ! is_interrupted() )
+		{
+			if( ! m_stall )
+			{
+				heartbeat();
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	std::atomic<bool> m_stall;
+};
+
+TEST(Watchdog, thread_stall_and_device)
+{
+	// stands in for /dev/watchdog, removed even if an assert fails
+	Temp_dir tmp;
+	ASSERT_TRUE(tmp.create("emb-lin-util-watchdog"));
+	const std::string path = tmp.get_path("watchdog");
+	const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+	ASSERT_GE(fd, 0);
+	close(fd);
+
+	std::mutex stalls_mutex;
+	std::vector<std::string> stalls;
+	std::vector<std::chrono::nanoseconds> stall_ages;
+
+	Watchdog wd;
+	ASSERT_TRUE(wd.init(std::chrono::milliseconds(10)));
+	ASSERT_TRUE(wd.open_device(path, std::chrono::seconds::zero()));
+	wd.set_stall_callback([&](const std::string& name, const std::chrono::nanoseconds& age)
+	{
+		std::lock_guard<std::mutex> lock(stalls_mutex);
+		stalls.push_back(name);
+		stall_ages.push_back(age);
+	});
+
+	Beating_worker worker;
+	std::shared_ptr<Heartbeat> hb = wd.add_thread(&worker, "worker", std::chrono::milliseconds(50));
+	worker.launch();
+	ASSERT_TRUE(wait_until([&hb](){ return ! hb->is_paused(); }));
+
+	wd.launch();
+
+	// healthy, every check pets the device
+	for(int i = 0; i < 5; i++)
+	{
+		Virtual_clock::advance(std::chrono::milliseconds(10));
+		ASSERT_TRUE(wait_until([&](){ return get_file_size(path) == off_t(i + 1); }));
+	}
+
+	worker.m_stall = true;
+
+	// the last beat is at most one period old, so the stall shows within 70 ms
+	for(int i = 0; i < 7; i++)
+	{
+		Virtual_clock::advance(std::chrono::milliseconds(10));
+	}
+	ASSERT_TRUE(wait_until([&wd](){ return wd.get_stalled_count() == 1; }));
+	{
+		std::lock_guard<std::mutex> lock(stalls_mutex);
+		ASSERT_EQ(stalls.size(), 1U);
+		EXPECT_EQ(stalls[0], "worker");
+		// reported once the beat is older than the timeout, and by the first check after that
+		ASSERT_EQ(stall_ages.size(), 1U);
+		EXPECT_GE(stall_ages[0], std::chrono::milliseconds(50));
+		EXPECT_LE(stall_ages[0], std::chrono::milliseconds(70));
+	}
+
+	// no more pets while stalled
+	const off_t stalled_size = get_file_size(path);
+	Virtual_clock::advance(std::chrono::milliseconds(10));
+	Virtual_clock::advance(std::chrono::milliseconds(10));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_EQ(get_file_size(path), stalled_size);
+
+	// an exited thread pauses its heartbeat
+	worker.interrupt();
+	worker.join();
+	EXPECT_TRUE(hb->is_paused());
+
+	wd.interrupt();
+	wd.join();
+
+	// magic close
+	EXPECT_TRUE(wd.close_device());
+	EXPECT_EQ(get_file_size(path), stalled_size + 1);
+}